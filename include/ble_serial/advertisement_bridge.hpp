@@ -0,0 +1,173 @@
+#ifndef BLE_SERIAL_INCLUDE_ADVERTISEMENT_BRIDGE_HPP_
+#define BLE_SERIAL_INCLUDE_ADVERTISEMENT_BRIDGE_HPP_
+
+#include <ble_serial/bluetooth.hpp>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace BLE_Serial::Bridge
+{
+    /**
+     * @brief How the forwarded advertisements are framed.
+     */
+    enum class AdvertisementFormat
+    {
+        /**
+         * Binary records, all integers little-endian:
+         * 0xA5, length of the rest (2 bytes), address (6 bytes), RSSI in dBm (signed byte), flags (bit 0 set for
+         * extended advertisements), company id (2 bytes) and the manufacturer data.
+         */
+        Binary,
+
+        /**
+         * One JSON object per line, i.e.
+         * {"address":"AA:BB:CC:DD:EE:FF","rssi":-61,"extended":false,"company":76,"data":"0215..."}
+         */
+        Json
+    };
+
+    /**
+     * @brief Selects the advertisements that are forwarded, empty lists match everything.
+     */
+    struct AdvertisementFilter
+    {
+        /**
+         * Addresses of the devices to forward.
+         */
+        std::vector<Bluetooth::BluetoothAddress> addresses {};
+
+        /**
+         * Company ids of the manufacturer data sections to forward.
+         */
+        std::vector<uint16_t> companyIds {};
+    };
+
+    /**
+     * @brief Settings of an @link AdvertisementBridge @endlink.
+     */
+    struct AdvertisementBridgeOptions
+    {
+        /**
+         * Which advertisements are forwarded.
+         */
+        AdvertisementFilter filter {};
+
+        /**
+         * Minimal time between two records of the same device and company, zero disables the rate limit.
+         */
+        std::chrono::milliseconds minInterval { 0 };
+
+        /**
+         * An unchanged payload is forwarded again only after this long, zero never repeats it.
+         */
+        std::chrono::milliseconds repeatInterval { 0 };
+
+        /**
+         * How many devices are tracked for deduplication and rate limiting, the least recently forwarded ones are
+         * forgotten first.
+         */
+        size_t maxDevices = 4096;
+
+        /**
+         * Framing of the records.
+         */
+        AdvertisementFormat format = AdvertisementFormat::Binary;
+    };
+
+    /**
+     * @brief Counters of an @link AdvertisementBridge @endlink.
+     */
+    struct AdvertisementBridgeMetrics
+    {
+        uint64_t received;      ///< manufacturer data sections received
+        uint64_t filtered;      ///< sections rejected by the filter
+        uint64_t duplicates;    ///< sections dropped because their payload did not change
+        uint64_t rateLimited;   ///< sections dropped by the rate limit
+        uint64_t forwarded;     ///< records written to the sink
+        uint64_t devices;       ///< devices currently tracked
+        uint64_t evicted;       ///< devices forgotten because of @link AdvertisementBridgeOptions::maxDevices @endlink
+    };
+
+    /**
+     * @brief Forwards the manufacturer data of advertisements, without connecting to the devices, as framed records.
+     *
+     * Every manufacturer data section is a separate record. Per device and company only a 64-bit hash of the last
+     * forwarded payload and its time are kept, so unchanged payloads are dropped and chatty devices are rate limited
+     * at a constant cost per device. The table is split into shards with their own locks, so the advertisement
+     * watcher may offer from many threads at once.
+     */
+    class AdvertisementBridge
+    {
+    public:
+        /**
+         * @brief Constructs a new bridge.
+         *
+         * @param options settings of the bridge
+         * @param sink receives the encoded records, may be called from multiple threads at once
+         */
+        AdvertisementBridge(AdvertisementBridgeOptions options, std::function<void(const std::vector<uint8_t> &)> sink);
+
+        /**
+         * @brief Filters, deduplicates and forwards an advertisement.
+         *
+         * @param advertisement the advertisement
+         */
+        void Offer(const Bluetooth::BluetoothAdvertisement &advertisement);
+
+        /**
+         * @brief Copies the counters of the bridge.
+         *
+         * @return copy of the counters
+         */
+        [[nodiscard]] AdvertisementBridgeMetrics Metrics() const noexcept;
+
+        /**
+         * @brief Appends a single record to a buffer.
+         *
+         * @param format framing of the record
+         * @param advertisement advertisement the section belongs to
+         * @param section the manufacturer data section
+         * @param output buffer the record is appended to
+         */
+        static void EncodeRecord(AdvertisementFormat format, const Bluetooth::BluetoothAdvertisement &advertisement, const Bluetooth::BluetoothManufacturerData &section,
+                                 std::vector<uint8_t> &output);
+
+    private:
+        static constexpr size_t ShardCount = 16; ///< must match the shift in Admit
+
+        struct DeviceState
+        {
+            uint64_t hash;
+            std::chrono::steady_clock::time_point lastForward;
+        };
+
+        struct Shard
+        {
+            std::mutex mutex {};
+            std::unordered_map<uint64_t, DeviceState> devices {};
+        };
+
+        bool Admit(const Bluetooth::BluetoothAdvertisement &advertisement, const Bluetooth::BluetoothManufacturerData &section);
+
+        AdvertisementBridgeOptions m_options;
+        std::function<void(const std::vector<uint8_t> &)> m_sink;
+        std::array<Shard, ShardCount> m_shards {};
+
+        std::atomic<uint64_t> m_received { 0 };
+        std::atomic<uint64_t> m_filtered { 0 };
+        std::atomic<uint64_t> m_duplicates { 0 };
+        std::atomic<uint64_t> m_rateLimited { 0 };
+        std::atomic<uint64_t> m_forwarded { 0 };
+        std::atomic<uint64_t> m_devices { 0 };
+        std::atomic<uint64_t> m_evicted { 0 };
+    };
+}
+
+#endif // BLE_SERIAL_INCLUDE_ADVERTISEMENT_BRIDGE_HPP_
@@ -0,0 +1,315 @@
+#ifndef BLE_SERIAL_INCLUDE_AGGREGATION_HPP_
+#define BLE_SERIAL_INCLUDE_AGGREGATION_HPP_
+
+#include <ble_serial/bridge.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace BLE_Serial::Bridge
+{
+    /**
+     * @brief Size of the header in front of every segment of an aggregated stream, a 16-bit little-endian sequence number.
+     */
+    constexpr size_t c_segmentHeaderSize = 2;
+
+    /**
+     * @brief Counters of a @link ReorderBuffer @endlink.
+     */
+    struct ReorderMetrics
+    {
+        uint64_t delivered;    ///< segments delivered in order
+        uint64_t reordered;    ///< segments that arrived ahead of a missing one and had to wait
+        uint64_t duplicates;   ///< segments dropped because they were already delivered or held
+        uint64_t lost;         ///< missing segments skipped after the gap timeout or when the window overflowed
+        uint64_t maxDepth;     ///< most segments held at once
+    };
+
+    /**
+     * @brief Restores the order of segments that were striped across several links.
+     *
+     * Segments are held in a ring of slots indexed by their sequence number, so pushing and delivering never allocates
+     * beyond the payloads themselves. A missing segment is given up on once a segment beyond the window arrives or when
+     * @link Expire @endlink finds it missing for longer than the gap timeout.
+     *
+     * The buffer synchronizes to the sequence number of the first segment it receives, so a stream that was joined in
+     * the middle is not taken for duplicates. A segment that overtook the first one is dropped as a duplicate.
+     *
+     * Not thread-safe, the owner serializes the calls.
+     */
+    class ReorderBuffer
+    {
+    public:
+        /**
+         * @brief Constructs a new buffer expecting the sequence number of the first pushed segment first.
+         *
+         * @param window how many segments can be held, rounded up to a power of two and at most 32768
+         * @param deliver receives the payloads in order
+         */
+        ReorderBuffer(size_t window, std::function<void(std::vector<uint8_t>)> deliver);
+
+        /**
+         * @brief Accepts a segment and delivers everything that became contiguous.
+         *
+         * @param sequence sequence number of the segment
+         * @param payload payload of the segment, without the header
+         * @param now current time
+         */
+        void Push(uint16_t sequence, std::vector<uint8_t> payload, std::chrono::steady_clock::time_point now);
+
+        /**
+         * @brief Skips the missing segments that held the buffer back for longer than the timeout.
+         *
+         * @param now current time
+         * @param gapTimeout how long a missing segment is waited for
+         */
+        void Expire(std::chrono::steady_clock::time_point now, std::chrono::milliseconds gapTimeout);
+
+        /**
+         * @brief Returns how many segments are held.
+         *
+         * @return number of held segments
+         */
+        [[nodiscard]] size_t GetHeldCount() const noexcept;
+
+        /**
+         * @brief Copies the counters of the buffer.
+         *
+         * @return copy of the counters
+         */
+        [[nodiscard]] ReorderMetrics Metrics() const noexcept;
+
+    private:
+        void DeliverContiguous(std::chrono::steady_clock::time_point now);
+
+        void SkipGap();
+
+        std::vector<std::optional<std::vector<uint8_t>>> m_slots;
+        std::function<void(std::vector<uint8_t>)> m_deliver;
+        uint16_t m_next = 0;
+        bool m_synchronized = false;
+        size_t m_held = 0;
+        std::chrono::steady_clock::time_point m_waitingSince {};
+        ReorderMetrics m_metrics {};
+    };
+
+    /**
+     * @brief Single link of an @link AggregatedBridge @endlink, a characteristic that is written to and notifies.
+     */
+    struct AggregationLink
+    {
+        std::shared_ptr<Bluetooth::IBluetoothConnection> connection;  ///< connection that owns the characteristic
+        Bluetooth::IBluetoothGattCharacteristic *characteristic;      ///< the characteristic, must outlive the bridge
+    };
+
+    /**
+     * @brief Settings of an @link AggregatedBridge @endlink.
+     */
+    struct AggregationOptions
+    {
+        /**
+         * Payload bytes of a single segment, zero uses the largest write that fits every link.
+         */
+        size_t segmentSize = 0;
+
+        /**
+         * How many segments the receiving side holds while waiting for a missing one.
+         */
+        size_t reorderWindow = 256;
+
+        /**
+         * How long a missing segment is waited for before it is skipped.
+         */
+        std::chrono::milliseconds gapTimeout { 200 };
+
+        /**
+         * How many segments may be queued per link before reading from the port waits for the links.
+         */
+        size_t linkQueueLimit = 32;
+
+        /**
+         * How many times a failed write is retried on the same link before the segment moves to another one.
+         */
+        unsigned int writeRetries = 1;
+
+        /**
+         * After how many consecutive failed segments a link is taken out of the stripe.
+         */
+        unsigned int maxConsecutiveErrors = 3;
+
+        /**
+         * Context attached to the log records of the bridge.
+         */
+        Log::LogContext logContext {};
+    };
+
+    /**
+     * @brief Counters of an @link AggregatedBridge @endlink.
+     */
+    struct AggregationMetrics
+    {
+        uint64_t segmentsSent;     ///< segments written to any link
+        uint64_t redispatched;     ///< segments moved to another link after failing on theirs
+        uint64_t dropped;          ///< segments lost because no link was left
+        size_t activeLinks;        ///< links still part of the stripe
+        ReorderMetrics reorder;    ///< state of the receiving side
+    };
+
+    /**
+     * @brief Tunnel between a COM port and several links at once, for more throughput than a single connection gives.
+     *
+     * Data read from the port is cut into segments that carry a 16-bit sequence number (see
+     * @link c_segmentHeaderSize @endlink) and each segment goes to the link with the shortest queue. Every link has
+     * its own writer thread writing without response where the characteristic allows it, so the links transmit in
+     * parallel and the throughput adds up. Notifications of all links are expected in the same format and pass
+     * through a @link ReorderBuffer @endlink before they are written to the port.
+     *
+     * A link whose writes keep failing, or whose connection is lost, is taken out of the stripe and its queued
+     * segments are moved to the others. The bridge is reported as disconnected once no link is left.
+     */
+    class AggregatedBridge
+    {
+    public:
+        /**
+         * @brief Constructs a new bridge, the bridge does nothing until @link Start @endlink is called.
+         *
+         * @param links links to stripe across, in the same order on the peer
+         * @param port port to be bridged, must outlive the bridge
+         * @param options settings of the bridge
+         *
+         * @throw std::invalid_argument when no link is given or the segment size leaves no room for a payload
+         */
+        AggregatedBridge(std::vector<AggregationLink> links, COM::COMPort &port, AggregationOptions options = {});
+
+        /**
+         * @brief Stops the bridge.
+         */
+        ~AggregatedBridge();
+
+        AggregatedBridge(const AggregatedBridge &) = delete;
+        AggregatedBridge &operator=(const AggregatedBridge &) = delete;
+
+        /**
+         * @brief Subscribes to all links and the port and starts the writer threads.
+         *
+         * @throw BluetoothException when subscribing to a characteristic fails
+         */
+        void Start();
+
+        /**
+         * @brief Unsubscribes from all links and the port and stops the writer threads.
+         *
+         * Segments still queued are discarded. The connections and the port are left open.
+         */
+        void Stop();
+
+        /**
+         * @brief Checks whether any link is still part of the stripe.
+         *
+         * @return false once every link was taken out
+         */
+        [[nodiscard]] bool IsAlive() const noexcept;
+
+        /**
+         * @brief Registers a listener called once when the last link is taken out.
+         *
+         * @param listener listener receiving the reason of the disconnection
+         */
+        void OnDisconnected(std::function<void(const std::string &)> listener);
+
+        /**
+         * @brief Returns the payload size of a single segment.
+         *
+         * @return payload bytes per segment
+         */
+        [[nodiscard]] size_t GetSegmentSize() const noexcept;
+
+        /**
+         * @brief Returns the number of links.
+         *
+         * @return number of links, active or not
+         */
+        [[nodiscard]] size_t GetLinkCount() const noexcept;
+
+        /**
+         * @brief Returns the link quality counters of a single link.
+         *
+         * @param index index of the link, as passed to the constructor
+         *
+         * @return the counters
+         */
+        [[nodiscard]] const LinkQualityMetrics &GetLinkMetrics(size_t index) const;
+
+        /**
+         * @brief Copies the counters of the bridge.
+         *
+         * @return copy of the counters
+         */
+        [[nodiscard]] AggregationMetrics Metrics();
+
+    private:
+        struct LinkState
+        {
+            AggregationLink link {};
+            Bluetooth::GattWriteMode writeMode = Bluetooth::GattWriteMode::WithResponse;
+            LinkQualityMetrics metrics {};
+            std::deque<std::vector<uint8_t>> queue {};
+            bool active = true;
+            unsigned int consecutiveErrors = 0;
+            size_t subscription = 0;
+            size_t statusSubscription = 0;
+            std::thread writerThread {};
+        };
+
+        void Stripe(const std::vector<uint8_t> &data);
+
+        bool Dispatch(std::vector<uint8_t> segment, std::unique_lock<std::mutex> &lock);
+
+        void DrainLink(LinkState &state);
+
+        void Deactivate(LinkState &state, const std::string &reason, std::unique_lock<std::mutex> &lock);
+
+        void Receive(std::vector<uint8_t> data);
+
+        void ExpireGaps();
+
+        void ReportDisconnected(const std::string &reason);
+
+        std::vector<std::unique_ptr<LinkState>> m_links;
+        COM::COMPort &m_port;
+        AggregationOptions m_options;
+        size_t m_segmentSize;
+
+        std::mutex m_sendMutex {};
+        std::condition_variable m_sendCondition {};
+        uint16_t m_nextSequence = 0;
+        size_t m_nextLink = 0;
+        size_t m_activeLinks;
+        bool m_exiting = false;
+        uint64_t m_segmentsSent = 0;
+        uint64_t m_redispatched = 0;
+        uint64_t m_dropped = 0;
+
+        std::mutex m_receiveMutex {};
+        ReorderBuffer m_reorder;
+        std::thread m_expiryThread {};
+        std::condition_variable m_expiryCondition {};
+        bool m_expiryExiting = false;
+
+        bool m_running = false;
+        size_t m_portSubscription = 0;
+        std::atomic<bool> m_alive { true };
+        std::function<void(const std::string &)> m_disconnectedListener {};
+        std::mutex m_listenerMutex {};
+    };
+}
+
+#endif // BLE_SERIAL_INCLUDE_AGGREGATION_HPP_
@@ -0,0 +1,88 @@
+#ifndef BLE_SERIAL_INCLUDE_ASYNC_WRITER_HPP_
+#define BLE_SERIAL_INCLUDE_ASYNC_WRITER_HPP_
+
+#include <ble_serial/mapped_file.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace BLE_Serial::IO
+{
+    /**
+     * @brief Writes a stream of data to a file from a background thread.
+     *
+     * @link Append @endlink only copies the data into a memory buffer, the buffer is swapped with the writer thread's
+     * one and written out once it grows over the buffer size or at least every flush interval. The producer blocks
+     * only when the disk falls behind by more than two buffers.
+     */
+    class AsyncFileWriter
+    {
+    public:
+        /**
+         * @brief Creates (or truncates) the file and starts the writer thread.
+         *
+         * @param path path to the file
+         * @param bufferSize size of a single buffer in bytes
+         * @param flushInterval longest time the appended data stay in memory
+         *
+         * @throw IOException when the file cannot be created
+         */
+        explicit AsyncFileWriter(const std::string &path, size_t bufferSize = 1 << 20, std::chrono::milliseconds flushInterval = std::chrono::milliseconds(200));
+
+        /**
+         * @brief Writes out the remaining data and closes the file, errors are ignored.
+         */
+        ~AsyncFileWriter();
+
+        AsyncFileWriter(const AsyncFileWriter &) = delete;
+        AsyncFileWriter &operator=(const AsyncFileWriter &) = delete;
+
+        /**
+         * @brief Appends data to the file.
+         *
+         * @param data data to append
+         * @param size number of bytes
+         *
+         * @throw IOException when a previous write failed
+         */
+        void Append(const uint8_t *data, size_t size);
+
+        /**
+         * @brief Writes out the remaining data, stops the writer thread and closes the file.
+         *
+         * @throw IOException when any of the writes failed
+         */
+        void Close();
+
+        /**
+         * @return number of bytes already written to the file
+         */
+        [[nodiscard]] uint64_t Written() const noexcept;
+
+    private:
+        void Run();
+
+        std::ofstream m_file;
+        std::string m_path;
+        size_t m_bufferSize;
+        std::chrono::milliseconds m_flushInterval;
+
+        std::mutex m_mutex {};
+        std::condition_variable m_condition {};
+        std::vector<uint8_t> m_pending {};
+        bool m_closing = false;
+        bool m_failed = false;
+
+        std::atomic<uint64_t> m_written { 0 };
+        std::thread m_thread {};
+    };
+}
+
+#endif // BLE_SERIAL_INCLUDE_ASYNC_WRITER_HPP_
@@ -1,12 +1,17 @@
 #ifndef BLE_SERIAL_INCLUDE_BLUETOOTH_HPP_
 #define BLE_SERIAL_INCLUDE_BLUETOOTH_HPP_
 
+#include <atomic>
 #include <exception>
 #include <chrono>
 #include <memory>
 #include <functional>
+#include <future>
+#include <mutex>
 #include <string>
+#include <string_view>
 #include <optional>
+#include <unordered_map>
 #include <vector>
 
 /**
@@ -19,6 +24,7 @@ namespace BLE_Serial::Bluetooth
     class IBluetoothConnection;
     class IBluetoothGattService;
     class IBluetoothGattCharacteristic;
+    class BondStore;
     enum class GattRegisteredService : uint32_t;
     enum class GattRegisteredCharacteristic : uint32_t;
 
@@ -43,17 +49,118 @@ namespace BLE_Serial::Bluetooth
         /**
          * @return error details
          */
-        [[nodiscard]]  const char *what() const override;
+        [[nodiscard]]  const char *what() const noexcept override;
 
     private:
         std::string m_message;
     };
 
+    /**
+     * @brief Thrown when the device refuses an operation until the link is paired and encrypted.
+     */
+    class BluetoothSecurityException : public BluetoothException
+    {
+    public:
+        /**
+         * @brief Construct new @link BluetoothSecurityException @endlink
+         *
+         * @param message error details
+         */
+        explicit BluetoothSecurityException(std::string message);
+    };
+
     /**
      * @brief Represents an address of a Bluetooth device.
      */
     using BluetoothAddress = uint64_t;
 
+    /**
+     * @brief Represents the properties of a GATT characteristic, as defined by the Bluetooth Core Specification.
+     *
+     * The values are bit flags and may be combined.
+     */
+    enum class GattCharacteristicProperty : uint32_t
+    {
+        None = 0x00,
+        Broadcast = 0x01,
+        Read = 0x02,
+        WriteWithoutResponse = 0x04,
+        Write = 0x08,
+        Notify = 0x10,
+        Indicate = 0x20,
+        AuthenticatedSignedWrites = 0x40,
+        ExtendedProperties = 0x80
+    };
+
+    /**
+     * @brief Checks whether the given properties contain the given property.
+     *
+     * @param properties properties to check
+     * @param property property to look for
+     *
+     * @return true if the property is present
+     */
+    constexpr bool HasProperty(GattCharacteristicProperty properties, GattCharacteristicProperty property) noexcept
+    {
+        return (static_cast<uint32_t>(properties) & static_cast<uint32_t>(property)) != 0;
+    }
+
+    /**
+     * @brief Represents how a value is written to a characteristic.
+     */
+    enum class GattWriteMode
+    {
+        /**
+         * The write is acknowledged by the remote device, slower but reliable.
+         */
+        WithResponse,
+
+        /**
+         * The write is not acknowledged, multiple writes fit into a single connection event. Requires the
+         * @link GattCharacteristicProperty::WriteWithoutResponse @endlink property.
+         */
+        WithoutResponse
+    };
+
+    /**
+     * @brief Represents whether a read may be answered from a cache.
+     */
+    enum class GattReadMode
+    {
+        /**
+         * A fresh value from the connection's @link GattValueCache @endlink or the cache of the platform is returned
+         * without going over the air.
+         */
+        Cached,
+
+        /**
+         * The value is always read from the remote device, the caches are only updated with it. Used where the read
+         * itself matters, i.e. to prove the link is alive or to see a value change that was not notified.
+         */
+        Uncached
+    };
+
+    /**
+     * @brief Contents of a Characteristic Presentation Format descriptor (0x2904), describing how a value is encoded.
+     */
+    struct GattPresentationFormat
+    {
+        uint8_t format;        ///< format type, i.e. 0x06 for a 16-bit unsigned integer
+        int8_t exponent;       ///< the value is multiplied by 10 to the power of the exponent
+        uint16_t unit;         ///< assigned number of the unit, i.e. 0x272F for degrees Celsius
+        uint8_t nameSpace;     ///< namespace of the description, 0x01 for Bluetooth SIG
+        uint16_t description;  ///< which part of an aggregate the format describes
+    };
+
+    /**
+     * @brief Security a pairing must establish.
+     */
+    enum class PairingProtection : uint8_t
+    {
+        Encryption = 1,                  ///< encrypted link, i.e. Just Works pairing
+        EncryptionAndAuthentication = 2  ///< encrypted link with keys protected against man-in-the-middle attacks
+    };
+
     /**
      * @brief Represents a bluetooth UUID.
      */
@@ -65,6 +172,37 @@ namespace BLE_Serial::Bluetooth
         uint8_t part4[8]; ///< @private
     };
 
+    /**
+     * @brief Describes a local Bluetooth adapter (radio controller).
+     */
+    struct BluetoothAdapterInfo
+    {
+        std::string id;           ///< platform-specific identifier of the adapter
+        BluetoothAddress address; ///< address of the adapter
+        std::wstring name;        ///< human-readable name of the adapter
+        bool isDefault;           ///< whether the OS treats this adapter as the default one
+    };
+
+    /**
+     * @brief Single manufacturer specific data section of an advertisement.
+     */
+    struct BluetoothManufacturerData
+    {
+        uint16_t companyId;         ///< company identifier assigned by the Bluetooth SIG
+        std::vector<uint8_t> data;  ///< data following the company identifier
+    };
+
+    /**
+     * @brief Advertisement received from a device, without connecting to it.
+     */
+    struct BluetoothAdvertisement
+    {
+        BluetoothAddress address;                                ///< address of the advertising device
+        int16_t rssi;                                            ///< signal strength in dBm
+        bool extended;                                           ///< whether it was an extended (Bluetooth 5) advertisement
+        std::vector<BluetoothManufacturerData> manufacturerData; ///< manufacturer specific data sections
+    };
+
     /**
      * @brief Compare two @link BluetoothUUID BluetoothUUIDs @endlink
      *
@@ -115,6 +253,24 @@ namespace BLE_Serial::Bluetooth
      */
     std::optional<std::string> GetCharacteristicName(GattRegisteredCharacteristic characteristic);
 
+    /**
+     * @brief Finds the @link GattRegisteredService @endlink with the given name, ignoring the case.
+     *
+     * @param name name of the service, i.e. "Heart Rate"
+     *
+     * @return the service or an empty optional if no registered service has the name
+     */
+    std::optional<GattRegisteredService> FindServiceByName(std::string_view name);
+
+    /**
+     * @brief Finds the @link GattRegisteredCharacteristic @endlink with the given name, ignoring the case.
+     *
+     * @param name name of the characteristic, i.e. "Heart Rate Measurement"
+     *
+     * @return the characteristic or an empty optional if no registered characteristic has the name
+     */
+    std::optional<GattRegisteredCharacteristic> FindCharacteristicByName(std::string_view name);
+
     /**
      * @brief Gets a full @link BluetoothUUID @endlink for a @link GattRegisteredService @endlink.
      *
@@ -135,6 +291,12 @@ namespace BLE_Serial::Bluetooth
 
     /**
      * @brief Represents an intermediate service used to communicate with the native OS Bluetooth API.
+     *
+     * All services, devices, connections, GATT services and GATT characteristics are safe to use from multiple threads
+     * at once. Every scan runs on its own watcher, so concurrent calls to @link ScanDevices @endlink and
+     * @link FindDevice @endlink do not serialize each other. Objects returned by reference (i.e. from
+     * @link IBluetoothConnection::GetService @endlink) stay valid until their owner is closed, closing an object while
+     * another thread is still using it is not supported.
      */
     class IBluetoothService
     {
@@ -200,19 +362,258 @@ namespace BLE_Serial::Bluetooth
          */
         virtual std::optional<std::unique_ptr<IBluetoothDevice>> FindDevice(BluetoothAddress address, std::chrono::seconds timelimit) = 0;
 
+        /**
+         * @brief Passes every received advertisement, legacy and extended, to a listener until stopped.
+         *
+         * This function in blocking. The listener may be called from multiple threads at once.
+         *
+         * @param listener listener receiving the advertisements
+         * @param stop flag that ends the watch once set
+         *
+         * @throw BluetoothException when the watcher cannot be started
+         */
+        virtual void WatchAdvertisements(const std::function<void(const BluetoothAdvertisement &)> &listener, const std::atomic_bool &stop) = 0;
+
+        /**
+         * @brief Returns the identifier of the adapter this service is bound to.
+         *
+         * @return identifier of the adapter, as reported by @link GetAdapters @endlink, or an empty string for the default adapter
+         */
+        [[nodiscard]] virtual const std::string &GetAdapterId() const noexcept = 0;
+
+        /**
+         * @brief Returns the number of connections currently opened through this service.
+         *
+         * @return number of open connections
+         */
+        [[nodiscard]] virtual size_t GetActiveConnectionCount() const noexcept = 0;
+
+        /**
+         * @brief Returns the total number of bytes read, written and received through this service's connections.
+         *
+         * The counter is monotonic and is meant to be sampled to estimate the airtime load of the adapter.
+         *
+         * @return number of transferred bytes
+         */
+        [[nodiscard]] virtual uint64_t GetTransferredBytes() const noexcept = 0;
+
+        /**
+         * @brief Returns how many concurrent connections this adapter should handle at most.
+         *
+         * @return maximum number of connections
+         */
+        [[nodiscard]] virtual size_t GetMaxConnectionCount() const noexcept = 0;
+
+        /**
+         * @brief Sets how many concurrent connections this adapter should handle at most.
+         *
+         * The limit is used by @link BluetoothAdapterBalancer @endlink, it is not enforced by the service itself.
+         *
+         * @param count maximum number of connections
+         */
+        virtual void SetMaxConnectionCount(size_t count) noexcept = 0;
+
     public:
         /**
          * @brief Gets the @link IBluetoothService @endlink for the current platform.
          *
+         * The returned service is bound to the default adapter.
+         *
          * @return the implementation
          */
         static IBluetoothService &GetService();
 
+        /**
+         * @brief Gets the @link IBluetoothService @endlink bound to the given adapter.
+         *
+         * Every adapter has exactly one service instance, subsequent calls with the same id return the same service.
+         * The default adapter (or an empty id) is always served by the service returned from @link GetService() @endlink.
+         * Platforms that cannot pin a connection to an adapter serve every adapter by that service as well, so distinct
+         * services always stand for distinct radios.
+         *
+         * @param adapterId identifier of the adapter, as reported by @link GetAdapters @endlink
+         *
+         * @return the implementation
+         *
+         * @throw BluetoothException when no such adapter exists
+         */
+        static IBluetoothService &GetService(const std::string &adapterId);
+
+        /**
+         * @brief Enumerates all local Bluetooth LE capable adapters.
+         *
+         * @return information about all adapters
+         *
+         * @throw BluetoothException when the enumeration fails
+         */
+        static std::vector<BluetoothAdapterInfo> GetAdapters();
+
+        /**
+         * @brief Sets the store remembering the bonds of all services.
+         *
+         * With a store set, connections to bonded devices resume their bond right away and operations the device
+         * refuses on an unencrypted link pair it and are retried once. Without a store such operations throw
+         * @link BluetoothSecurityException @endlink.
+         *
+         * @param store the store or nullptr to disable it
+         */
+        static void SetBondStore(std::shared_ptr<BondStore> store);
+
+        /**
+         * @brief Returns the store set with @link SetBondStore @endlink.
+         *
+         * @return the store or nullptr when none is set
+         */
+        static std::shared_ptr<BondStore> GetBondStore();
+
     protected:
         IBluetoothService() = default;
 
     };
 
+    /**
+     * @brief Spreads connections across multiple local adapters.
+     *
+     * Every call to @link SelectService @endlink picks the adapter with the lowest load, where the load is the ratio
+     * of open connections to the adapter's connection limit plus the adapter's share of the traffic transferred since
+     * the previous selection.
+     *
+     * The balancer may be shared between threads.
+     */
+    class BluetoothAdapterBalancer
+    {
+    public:
+        /**
+         * @brief Constructs a new balancer over the given services.
+         *
+         * @param services services to balance between, must not be empty
+         */
+        explicit BluetoothAdapterBalancer(std::vector<IBluetoothService *> services);
+
+        /**
+         * @brief Constructs a new balancer over the services of all local adapters.
+         *
+         * Adapters served by the same service are balanced as one. All services are initialized before being
+         * returned.
+         *
+         * @return the balancer
+         *
+         * @throw BluetoothException when no adapter is available
+         */
+        static BluetoothAdapterBalancer ForAllAdapters();
+
+        /**
+         * @brief Selects the least loaded service.
+         *
+         * @return the selected service
+         *
+         * @throw BluetoothException when all adapters reached their connection limit
+         */
+        IBluetoothService &SelectService();
+
+        /**
+         * @brief Returns all services balanced by this balancer.
+         *
+         * @return all services
+         */
+        [[nodiscard]] const std::vector<IBluetoothService *> &GetServices() const noexcept;
+
+    private:
+        std::mutex m_mutex {};
+        std::vector<IBluetoothService *> m_services;
+        std::vector<uint64_t> m_lastTransferredBytes;
+    };
+
+    /**
+     * @brief Point-in-time state of a @link GattValueCache @endlink.
+     */
+    struct GattValueCacheMetrics
+    {
+        uint64_t hits;           ///< number of reads answered from the cache
+        uint64_t misses;         ///< number of reads that had to go over the air
+        uint64_t changes;        ///< number of stored values that differed from the cached ones
+        uint64_t invalidations;  ///< number of entries dropped because of a write
+        size_t entries;          ///< number of currently cached values
+        size_t bytes;            ///< memory held by the cached values
+    };
+
+    /**
+     * @brief Caches the last known values of characteristics of a single connection.
+     *
+     * Values are keyed by the attribute handle and updated from both reads and notifications, so a value that was
+     * notified or read less than the time to live ago is returned without going over the air. A write to a
+     * characteristic drops its cached value. The cache is disabled until a non-zero time to live is set.
+     *
+     * The cache may be shared between threads.
+     */
+    class GattValueCache
+    {
+    public:
+        /**
+         * @brief Sets how long a cached value stays valid.
+         *
+         * @param ttl time to live of the values, zero disables the cache and drops all cached values
+         */
+        void SetTimeToLive(std::chrono::milliseconds ttl);
+
+        /**
+         * @return time to live of the values, zero if the cache is disabled
+         */
+        [[nodiscard]] std::chrono::milliseconds GetTimeToLive() const noexcept;
+
+        /**
+         * @brief Looks up a fresh value of a characteristic.
+         *
+         * @param handle attribute handle of the characteristic
+         *
+         * @return the cached value or an empty optional if it is missing, expired or the cache is disabled
+         */
+        [[nodiscard]] std::optional<std::vector<uint8_t>> Lookup(uint16_t handle);
+
+        /**
+         * @brief Stores a value that was just read or notified.
+         *
+         * @param handle attribute handle of the characteristic
+         * @param value the new value
+         *
+         * @return whether the value differs from the previously cached one, always true when nothing was cached
+         */
+        bool Store(uint16_t handle, const std::vector<uint8_t> &value);
+
+        /**
+         * @brief Drops the cached value of a characteristic.
+         *
+         * @param handle attribute handle of the characteristic
+         */
+        void Invalidate(uint16_t handle);
+
+        /**
+         * @brief Drops all cached values.
+         */
+        void Clear();
+
+        /**
+         * @return the current state of the cache
+         */
+        [[nodiscard]] GattValueCacheMetrics Metrics() const;
+
+    private:
+        struct Entry
+        {
+            std::vector<uint8_t> value;
+            std::chrono::steady_clock::time_point updated;
+        };
+
+        mutable std::mutex m_mutex {};
+        std::chrono::milliseconds m_ttl { 0 };
+        std::unordered_map<uint16_t, Entry> m_entries {};
+
+        std::atomic<uint64_t> m_hits { 0 };
+        std::atomic<uint64_t> m_misses { 0 };
+        std::atomic<uint64_t> m_changes { 0 };
+        std::atomic<uint64_t> m_invalidations { 0 };
+    };
+
     /**
      * @brief Represents a BLE device.
      */
@@ -233,6 +634,13 @@ namespace BLE_Serial::Bluetooth
          */
         [[nodiscard]] virtual const std::wstring &GetDeviceName() const noexcept = 0;
 
+        /**
+         * @brief Returns the signal strength of the advertisement the device was discovered with.
+         *
+         * @return signal strength in dBm
+         */
+        [[nodiscard]] virtual int16_t GetSignalStrength() const noexcept = 0;
+
         /**
          * @brief Gets an open connection.
          *
@@ -254,6 +662,9 @@ namespace BLE_Serial::Bluetooth
         /**
          * @brief Opens a new connection with the given timeout.
          *
+         * Concurrent users of a device share one connection, every user closes it once when done and the link is torn
+         * down by the last @link IBluetoothConnection::Close @endlink.
+         *
          * @param timeout timeout for the connection, this timeout will also be used for subsequent calls to @link IBluetoothConnection IBluetoothConnection's@endlink methods.
          * @return the newly opened connection.
          *
@@ -261,6 +672,30 @@ namespace BLE_Serial::Bluetooth
          */
         [[nodiscard]] virtual std::shared_ptr<IBluetoothConnection> OpenConnection(std::chrono::seconds timeout) = 0;
 
+        /**
+         * @brief Checks whether the OS holds a bond with the device.
+         *
+         * @param timeout timeout for the query
+         *
+         * @return whether the device is paired
+         *
+         * @throw BluetoothException when the operation fails
+         */
+        [[nodiscard]] virtual bool IsPaired(std::chrono::seconds timeout) = 0;
+
+        /**
+         * @brief Pairs with the device and lets the OS keep the keys, so that later connections are encrypted without
+         * pairing again.
+         *
+         * Succeeds right away when the device is already paired.
+         *
+         * @param protection security the pairing must establish
+         * @param timeout timeout for the pairing, including any user interaction the OS asks for
+         *
+         * @throw BluetoothException when the pairing fails
+         */
+        virtual void Pair(PairingProtection protection, std::chrono::seconds timeout) = 0;
+
     protected:
         IBluetoothDevice() = default;
     };
@@ -281,28 +716,166 @@ namespace BLE_Serial::Bluetooth
         /**
          * @brief Closes the connection.
          *
+         * A connection shared between several users stays open until the last of them closes it, see
+         * @link SharedBluetoothConnection @endlink.
+         *
          * @throw BluetoothException when the operation fails
          */
         virtual void Close() = 0;
 
+        /**
+         * @brief Returns the last known signal strength of the link.
+         *
+         * @return signal strength in dBm or an empty optional if it is unknown
+         */
+        [[nodiscard]] virtual std::optional<int16_t> GetSignalStrength() const noexcept = 0;
+
+        /**
+         * @brief Subscribes to changes of the connection status reported by the OS.
+         *
+         * @param listener listener to be called with the new status every time the connection is established or lost
+         *
+         * @return id of the listener, used for the @link UnsubscribeStatusChanged @endlink function.
+         *
+         * @throw BluetoothException when the operation fails
+         */
+        virtual size_t SubscribeStatusChanged(std::function<void(bool)> listener) = 0;
+
+        /**
+         * @brief Unsubscribes a listener previously registered with @link SubscribeStatusChanged @endlink
+         *
+         * @param id id of the listener
+         */
+        virtual void UnsubscribeStatusChanged(size_t id) = 0;
+
+        /**
+         * @brief Returns the largest value that fits into a single write, that is the negotiated ATT MTU minus the
+         * header.
+         *
+         * @return maximum size of a single write in bytes
+         */
+        [[nodiscard]] virtual size_t GetMaxWriteSize() const noexcept = 0;
+
+        /**
+         * @brief Returns the value cache shared by all characteristics of this connection.
+         *
+         * The cache is disabled by default, see @link GattValueCache::SetTimeToLive @endlink.
+         *
+         * @return the value cache
+         */
+        [[nodiscard]] virtual GattValueCache &GetValueCache() noexcept = 0;
+
         /**
          * @brief Gets all @link IBluetoothGattService IBluetoothGattServices @endlink registered to this device.
          *
-         * @return all registered services.
+         * @return a snapshot of all registered services, empty once the connection was closed.
          */
-        [[nodiscard]] virtual std::vector<std::unique_ptr<IBluetoothGattService>> &GetServices() = 0;
+        [[nodiscard]] virtual std::vector<std::shared_ptr<IBluetoothGattService>> GetServices() = 0;
 
         /**
          * @brief Gets an @link IBluetoothGattService @endlink registered to this device that matches the given UUID.
          *
-         * @return service that matches the given UUID or an empty unique_ptr if no such service is found.
+         * @return service that matches the given UUID or nullptr if no such service is found.
          */
-        [[nodiscard]] virtual std::unique_ptr<IBluetoothGattService> &GetService(BluetoothUUID uuid) = 0;
+        [[nodiscard]] virtual std::shared_ptr<IBluetoothGattService> GetService(BluetoothUUID uuid) = 0;
 
     protected:
         IBluetoothConnection() = default;
     };
 
+    /**
+     * @brief Base of the connections a device shares between its concurrent users.
+     *
+     * Every user that got the connection from @link SharedConnectionSlot::Open @endlink holds one reference to it and
+     * drops it with @link Close @endlink. The link and its services are only closed by the last user, so one user never
+     * closes the services another one is still working with.
+     */
+    class SharedBluetoothConnection : public IBluetoothConnection
+    {
+    public:
+        /**
+         * @brief Drops the reference of the caller, the last one closes the link.
+         *
+         * @throw BluetoothException when closing the link fails
+         */
+        void Close() final;
+
+        [[nodiscard]] std::vector<std::shared_ptr<IBluetoothGattService>> GetServices() final;
+
+        [[nodiscard]] std::shared_ptr<IBluetoothGattService> GetService(BluetoothUUID uuid) final;
+
+        /**
+         * @brief Counts one more user of the connection.
+         *
+         * @return false when the last user already closed the connection, it must not be handed out anymore
+         */
+        bool Retain() noexcept;
+
+        /**
+         * @return number of users that have not closed the connection yet
+         */
+        [[nodiscard]] size_t GetUserCount() const noexcept;
+
+    protected:
+        /**
+         * @brief Constructs a connection with a single user and no services.
+         */
+        SharedBluetoothConnection() = default;
+
+        /**
+         * @brief Sets the services of the connection, called once by the constructor of the implementation.
+         *
+         * @param services the services
+         */
+        void SetServices(std::vector<std::shared_ptr<IBluetoothGattService>> services);
+
+        /**
+         * @brief Closes the link, called by the @link Close @endlink of the last user.
+         *
+         * @throw BluetoothException when the operation fails
+         */
+        virtual void CloseLink() = 0;
+
+    private:
+        mutable std::mutex m_usersMutex {};
+        size_t m_users = 1;
+        std::vector<std::shared_ptr<IBluetoothGattService>> m_services {};
+    };
+
+    /**
+     * @brief Holds the connection of a device and hands it out to all of its concurrent users.
+     *
+     * The slot may be shared between threads.
+     */
+    class SharedConnectionSlot
+    {
+    public:
+        /**
+         * @brief Returns the open connection, counting the caller as one more user, or opens a new one.
+         *
+         * The slot stays locked for the whole connection attempt, so that concurrent callers share a single
+         * connection.
+         *
+         * @param open opens a new connection
+         *
+         * @return the connection, the caller must close it once
+         *
+         * @throw BluetoothException when opening the connection fails
+         */
+        std::shared_ptr<IBluetoothConnection> Open(const std::function<std::shared_ptr<SharedBluetoothConnection>()> &open);
+
+        /**
+         * @brief Gets the connection without counting a user.
+         *
+         * @return the connection or an empty optional if it is closed or was never opened
+         */
+        [[nodiscard]] std::optional<std::shared_ptr<IBluetoothConnection>> Get() const noexcept;
+
+    private:
+        mutable std::mutex m_mutex {};
+        std::shared_ptr<SharedBluetoothConnection> m_connection {};
+    };
+
     /**
      * @brief Represents a GATT service.
      */
@@ -346,6 +919,9 @@ namespace BLE_Serial::Bluetooth
          *
          * The characteristics can be then iterated via @link GetCachedCharacteristics @endlink
          *
+         * Characteristics that were already fetched before are kept, so pointers to them obtained from a previous call
+         * stay valid. References to the owning unique_ptrs may however be invalidated by this call.
+         *
          * @throw BluetoothException when the operation fails
          */
         virtual void FetchCharacteristics() = 0;
@@ -375,36 +951,113 @@ namespace BLE_Serial::Bluetooth
          */
         [[nodiscard]] virtual GattRegisteredCharacteristic GetRegisteredCharacteristicType() const = 0;
 
+        /**
+         * @brief Returns the properties of this characteristic.
+         *
+         * @return the properties, combined as bit flags
+         */
+        [[nodiscard]] virtual GattCharacteristicProperty GetProperties() const = 0;
+
+        /**
+         * @brief Returns the attribute handle of this characteristic.
+         *
+         * @return the attribute handle, unique within the connection
+         */
+        [[nodiscard]] virtual uint16_t GetHandle() const = 0;
+
+        /**
+         * @brief Returns the formats declared by the Characteristic Presentation Format descriptors of this characteristic.
+         *
+         * The default implementation declares none.
+         *
+         * @return the formats in the order of the descriptors, empty when the characteristic has no such descriptor
+         */
+        [[nodiscard]] virtual std::vector<GattPresentationFormat> GetPresentationFormats() const;
+
         /**
          * @brief Reads data from this characteristic.
          *
+         * Calling the function is equivalent to calling @code Read(GattReadMode::Cached) @endcode
+         *
          * @return vector containing the read data
          *
          * @throw BluetoothException when the operation fails
          */
-        [[nodiscard]] virtual std::vector<uint8_t> Read() = 0;
+        [[nodiscard]] virtual std::vector<uint8_t> Read();
+
+        /**
+         * @brief Reads data from this characteristic.
+         *
+         * @param mode whether a cached value may be returned
+         *
+         * @return vector containing the read data
+         *
+         * @throw BluetoothException when the operation fails
+         */
+        [[nodiscard]] virtual std::vector<uint8_t> Read(GattReadMode mode) = 0;
+
+        /**
+         * @brief Starts reading data from this characteristic without waiting for the result.
+         *
+         * Calling the function is equivalent to calling @code ReadAsync(GattReadMode::Cached) @endcode
+         *
+         * @return future that will contain the read data or a BluetoothException when the operation fails
+         */
+        [[nodiscard]] virtual std::future<std::vector<uint8_t>> ReadAsync();
+
+        /**
+         * @brief Starts reading data from this characteristic without waiting for the result.
+         *
+         * Multiple reads may be in flight at once, so reads of several characteristics on the same connection can be
+         * pipelined. The default implementation runs @link Read @endlink on a separate thread, its future waits for the
+         * read when destroyed.
+         *
+         * @param mode whether a cached value may be returned
+         *
+         * @return future that will contain the read data or a BluetoothException when the operation fails
+         */
+        [[nodiscard]] virtual std::future<std::vector<uint8_t>> ReadAsync(GattReadMode mode);
+
+        /**
+         * @brief Writes data to this characteristic with a response.
+         *
+         * Calling the function is equivalent to calling @code Write(data, GattWriteMode::WithResponse) @endcode
+         *
+         * @param data vector containing the data to be written
+         *
+         * @throw BluetoothException when the operation fails
+         */
+        virtual void Write(const std::vector<uint8_t> &data);
 
         /**
          * @brief Writes data to this characteristic.
          *
+         * The cached value of this characteristic is invalidated.
+         *
          * @param data vector containing the data to be written
+         * @param mode whether the write should be acknowledged by the remote device
          *
          * @throw BluetoothException when the operation fails
          */
-        virtual void Write(const std::vector<uint8_t> &data) = 0;
+        virtual void Write(const std::vector<uint8_t> &data, GattWriteMode mode) = 0;
 
         /**
          * @brief Subscribes to all changes of this characteristic's data.
          *
          * @param listener listener to be called every time the characteristic's data changes
          *
-         * @return id of the listener, used for the @link Unsubscribe @endlink function.
+         * The listener is called from a platform-specific thread, possibly concurrently with other listeners.
+         *
+         * @return id of the listener, used for the @link Unsubscribe @endlink function. Ids stay valid until the listener is unsubscribed.
          */
         virtual size_t Subscribe(std::function<void(std::vector<uint8_t>)> listener) = 0;
 
         /**
          * @brief Unsubscribes a listener previously registered with @link Subscribe @endlink
          *
+         * Waits for the calls of the listener that are in progress, so it is never called once this returns. Called
+         * from a listener it returns right away.
+         *
          * @param id id of the listener
          */
         virtual void Unsubscribe(size_t id) = 0;
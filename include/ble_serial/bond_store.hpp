@@ -0,0 +1,147 @@
+#ifndef BLE_SERIAL_INCLUDE_BOND_STORE_HPP_
+#define BLE_SERIAL_INCLUDE_BOND_STORE_HPP_
+
+#include <ble_serial/bluetooth.hpp>
+#include <ble_serial/log.hpp>
+#include <ble_serial/mapped_file.hpp>
+
+#include <chrono>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace BLE_Serial::Bluetooth
+{
+    /**
+     * @brief A device the application paired with.
+     */
+    struct BondRecord
+    {
+        BluetoothAddress address;                          ///< address of the device
+        PairingProtection protection;                      ///< security the pairing established
+        std::chrono::system_clock::time_point pairedAt;    ///< when the device was paired last
+        std::chrono::milliseconds pairingTime;             ///< how long the last pairing took, user interaction included
+    };
+
+    /**
+     * @brief Persistent list of the devices the application paired with.
+     *
+     * The keys themselves stay in the OS, which encrypts the link of a bonded device on its own as soon as it
+     * connects. The store remembers which devices need a bond and with what protection, so a connection to such a
+     * device never runs into a refused operation first: the bond is resumed as is, or when the OS lost it (i.e. the
+     * user removed the device) the device is paired again before anything else is sent.
+     *
+     * The store is a small text file rewritten atomically on every change. Every change locks the file, reads it
+     * again and writes it under the lock, so that several processes may share it without losing each other's bonds.
+     * All methods are safe to use from multiple threads at once.
+     */
+    class BondStore
+    {
+    public:
+        /**
+         * @brief Returns the default location of the store, ble_serial/bonds in the local application data of the user
+         * on Windows or .ble_serial/bonds in the home directory elsewhere.
+         *
+         * @return path to the store
+         */
+        static std::string GetDefaultPath();
+
+        /**
+         * @brief Opens a store, a missing file is an empty store.
+         *
+         * @param path path to the store
+         *
+         * @throw IOException when the file exists but cannot be read or is malformed
+         */
+        explicit BondStore(std::string path);
+
+        BondStore(const BondStore &) = delete;
+        BondStore &operator=(const BondStore &) = delete;
+
+        /**
+         * @brief Looks a device up.
+         *
+         * @param address address of the device
+         *
+         * @return the bond or an empty optional when the device was never paired through the store
+         */
+        [[nodiscard]] std::optional<BondRecord> Find(BluetoothAddress address) const;
+
+        /**
+         * @brief Lists all bonds.
+         *
+         * @return the bonds ordered by the address
+         */
+        [[nodiscard]] std::vector<BondRecord> List() const;
+
+        /**
+         * @brief Adds or replaces a bond and writes the store.
+         *
+         * @param record the bond
+         *
+         * @throw IOException when the store cannot be written
+         */
+        void Save(const BondRecord &record);
+
+        /**
+         * @brief Forgets a bond and writes the store, the OS keeps its keys.
+         *
+         * @param address address of the device
+         *
+         * @return false when the device was not in the store
+         *
+         * @throw IOException when the store cannot be written
+         */
+        bool Remove(BluetoothAddress address);
+
+        /**
+         * @brief Resumes the bond of a device that was just connected.
+         *
+         * Nothing is sent when the OS still holds the bond. When it lost it, the device is paired again with the
+         * recorded protection; a failure is logged and left to the operations that need the bond.
+         *
+         * @param device the device
+         * @param timeout timeout for the pairing
+         * @param context context attached to the log records
+         *
+         * @return false when the device has no bond in the store
+         */
+        bool Resume(IBluetoothDevice &device, std::chrono::seconds timeout, const Log::LogContext &context = {});
+
+        /**
+         * @brief Pairs with a device and records the bond.
+         *
+         * Pairings are serialized, so operations failing at once on the same link pair only once. A device the OS
+         * already holds a bond for is only recorded. A store that cannot be written is logged, the pairing stands.
+         *
+         * @param device the device
+         * @param protection security the pairing must establish
+         * @param timeout timeout for the pairing, including any user interaction the OS asks for
+         * @param context context attached to the log records
+         *
+         * @throw BluetoothException when the pairing fails
+         */
+        void Pair(IBluetoothDevice &device, PairingProtection protection, std::chrono::seconds timeout, const Log::LogContext &context = {});
+
+        /**
+         * @return path to the store
+         */
+        [[nodiscard]] const std::string &GetPath() const noexcept;
+
+    private:
+        void Load();
+
+        [[nodiscard]] IO::FileLock LockFile() const;
+
+        void Store() const;
+
+        std::string m_path;
+        mutable std::mutex m_mutex {};
+        std::mutex m_pairingMutex {};
+        std::unordered_map<BluetoothAddress, BondRecord> m_bonds {};
+    };
+}
+
+#endif // BLE_SERIAL_INCLUDE_BOND_STORE_HPP_
@@ -0,0 +1,500 @@
+#ifndef BLE_SERIAL_INCLUDE_BRIDGE_HPP_
+#define BLE_SERIAL_INCLUDE_BRIDGE_HPP_
+
+#include <ble_serial/bluetooth.hpp>
+#include <ble_serial/com.hpp>
+#include <ble_serial/conflation.hpp>
+#include <ble_serial/cpu_usage.hpp>
+#include <ble_serial/l2cap.hpp>
+#include <ble_serial/log.hpp>
+#include <ble_serial/poller.hpp>
+#include <ble_serial/scheduler.hpp>
+#include <ble_serial/spill_queue.hpp>
+#include <ble_serial/traffic_monitor.hpp>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Bidirectional tunnels between BLE characteristics and COM ports
+ */
+namespace BLE_Serial::Bridge
+{
+    /**
+     * @brief Settings of the link health monitor.
+     *
+     * The monitor runs on its own thread and checks the link every @link checkInterval @endlink, so a dead link is
+     * reported at most one interval (plus one heartbeat read timeout) after it died.
+     */
+    struct LinkHealthOptions
+    {
+        /**
+         * Whether the health monitor should run at all.
+         */
+        bool enabled = false;
+
+        /**
+         * How often the link should be checked.
+         */
+        std::chrono::milliseconds checkInterval { 500 };
+
+        /**
+         * Whether every check should perform a read of the bound characteristic as a heartbeat.
+         */
+        bool readHeartbeat = false;
+
+        /**
+         * After how long without any notification the link should be considered dead, zero disables the check.
+         */
+        std::chrono::milliseconds inactivityTimeout { 0 };
+
+        /**
+         * After how many consecutive failed heartbeats or writes the link should be considered dead.
+         */
+        unsigned int maxConsecutiveErrors = 3;
+    };
+
+    /**
+     * @brief Settings of a @link Bridge @endlink.
+     */
+    struct BridgeOptions
+    {
+        /**
+         * How many times a failed characteristic write should be retried immediately.
+         */
+        unsigned int writeRetries = 0;
+
+        /**
+         * How long to wait before a frame that failed all immediate retries is attempted again.
+         */
+        std::chrono::milliseconds retryInterval { 500 };
+
+        /**
+         * Settings of the queues that buffer the data coming from the COM port during outages. The limits are shared
+         * by all priority lanes.
+         */
+        SpillQueueOptions queue {};
+
+        /**
+         * Settings of the priority lanes in front of the characteristic writes.
+         */
+        SchedulerOptions scheduler {};
+
+        /**
+         * At how many bytes per second should the backlog be replayed after an outage, zero means no pacing.
+         */
+        size_t replayRate = 0;
+
+        /**
+         * Policy used to thin out the notifications before they are written to the port.
+         */
+        ConflationOptions conflation {};
+
+        /**
+         * Settings used when the characteristic is polled instead of subscribed to.
+         */
+        PollingOptions polling {};
+
+        /**
+         * Time to live of the connection's value cache, zero leaves the cache as it is.
+         */
+        std::chrono::milliseconds valueCacheTtl { 0 };
+
+        /**
+         * Settings of the link health monitor.
+         */
+        LinkHealthOptions health {};
+
+        /**
+         * Context attached to the log records of the bridge.
+         */
+        Log::LogContext logContext {};
+    };
+
+    /**
+     * @brief Point-in-time copy of @link LinkQualityMetrics @endlink.
+     */
+    struct LinkQualitySnapshot
+    {
+        int16_t rssi;                                  ///< last known signal strength in dBm, 0 when unknown
+        uint64_t notifications;                        ///< number of received notifications
+        uint64_t bytesReceived;                        ///< payload bytes of all received notifications
+        uint64_t writes;                               ///< number of successful characteristic writes
+        uint64_t bytesSent;                            ///< payload bytes of all successful characteristic writes
+        uint64_t writeErrors;                          ///< number of failed characteristic write attempts
+        uint64_t retries;                              ///< number of retried characteristic writes
+        uint64_t heartbeats;                           ///< number of successful heartbeats
+        uint64_t heartbeatErrors;                      ///< number of failed heartbeats
+        uint64_t recoveries;                           ///< number of times the link came back after it went down
+        std::chrono::microseconds writeLatencyP50;     ///< median duration of successful writes
+        std::chrono::microseconds writeLatencyP90;     ///< 90th percentile of the duration of successful writes
+        std::chrono::microseconds writeLatencyP99;     ///< 99th percentile of the duration of successful writes
+        std::chrono::milliseconds sinceLastActivity;   ///< time elapsed since the last successful operation on the link
+
+        /**
+         * @return ratio of retried writes to all write attempts
+         */
+        [[nodiscard]] double RetryRate() const noexcept;
+    };
+
+    /**
+     * @brief CPU time and memory spent on a single bridge.
+     */
+    struct BridgeResourceUsage
+    {
+        std::chrono::nanoseconds threadCpuTime;    ///< CPU time of the threads owned by the bridge (writer, health monitor, flusher and poller sinks)
+        std::chrono::nanoseconds callbackCpuTime;  ///< CPU time attributed to the bridge on shared threads (notification and port callbacks)
+        size_t queueMemoryBytes;                   ///< payload bytes queued in memory
+        size_t queueDiskBytes;                     ///< payload bytes spilled to the disk
+        size_t bufferBytes;                        ///< memory held by the conflation buffers
+        size_t cacheBytes;                         ///< memory held by the value cache of the connection
+
+        /**
+         * @return CPU time spent on the bridge on all threads
+         */
+        [[nodiscard]] std::chrono::nanoseconds CpuTime() const noexcept;
+
+        /**
+         * @return memory held by the bridge, spilled bytes excluded
+         */
+        [[nodiscard]] size_t MemoryBytes() const noexcept;
+    };
+
+    /**
+     * @brief Link quality counters of a single bridge.
+     *
+     * All counters are lock-free atomics, updating and reading them never allocates. Write latencies are kept in a
+     * log-linear histogram (four buckets per power of two microseconds), so the percentiles are accurate to 25%.
+     */
+    class LinkQualityMetrics
+    {
+    public:
+        /**
+         * @brief Records the last known signal strength.
+         *
+         * @param rssi signal strength in dBm
+         */
+        void SetSignalStrength(int16_t rssi) noexcept;
+
+        /**
+         * @brief Records any successful operation on the link.
+         */
+        void MarkActivity() noexcept;
+
+        /**
+         * @brief Records a received notification.
+         *
+         * @param size payload size of the notification
+         */
+        void NotificationReceived(size_t size) noexcept;
+
+        /**
+         * @brief Records a characteristic write attempt.
+         *
+         * @param success whether the write succeeded
+         * @param retry whether the write was a retry of a previously failed write
+         * @param size payload size of the write
+         */
+        void WriteAttempted(bool success, bool retry, size_t size) noexcept;
+
+        /**
+         * @brief Records how long a successful write took.
+         *
+         * @param latency duration of the write
+         */
+        void WriteCompleted(std::chrono::steady_clock::duration latency) noexcept;
+
+        /**
+         * @brief Records that writes succeed again after the link went down.
+         */
+        void LinkRecovered() noexcept;
+
+        /**
+         * @brief Records a heartbeat.
+         *
+         * @param success whether the heartbeat succeeded
+         */
+        void HeartbeatAttempted(bool success) noexcept;
+
+        /**
+         * @brief Returns the time of the last successful operation on the link.
+         *
+         * @return time of the last activity
+         */
+        [[nodiscard]] std::chrono::steady_clock::time_point GetLastActivity() const noexcept;
+
+        /**
+         * @brief Copies all the counters.
+         *
+         * @return copy of the counters
+         */
+        [[nodiscard]] LinkQualitySnapshot Snapshot() const noexcept;
+
+    private:
+        static constexpr size_t LatencyBucketCount = 104;
+
+        std::atomic<int16_t> m_rssi { 0 };
+        std::atomic<uint64_t> m_notifications { 0 };
+        std::atomic<uint64_t> m_bytesReceived { 0 };
+        std::atomic<uint64_t> m_writes { 0 };
+        std::atomic<uint64_t> m_bytesSent { 0 };
+        std::atomic<uint64_t> m_writeErrors { 0 };
+        std::atomic<uint64_t> m_retries { 0 };
+        std::atomic<uint64_t> m_heartbeats { 0 };
+        std::atomic<uint64_t> m_heartbeatErrors { 0 };
+        std::atomic<uint64_t> m_recoveries { 0 };
+        std::array<std::atomic<uint64_t>, LatencyBucketCount> m_writeLatency {};
+        std::atomic<std::chrono::steady_clock::rep> m_lastActivity { std::chrono::steady_clock::now().time_since_epoch().count() };
+    };
+
+    /**
+     * @brief Bidirectional tunnel between a BLE characteristic and a COM port.
+     *
+     * Any data written to the port is written to the characteristic and every notification of the characteristic is
+     * written to the port.
+     *
+     * Data read from the port goes through a @link WriteScheduler @endlink drained by a writer thread, so control frames
+     * overtake queued bulk data. When the link is down the writer keeps retrying the next packet, and once it succeeds
+     * the backlog is replayed in order.
+     *
+     * Notifications go through a @link Conflator @endlink, so high-rate sensors may be thinned out to what the consumer
+     * on the port actually needs.
+     *
+     * Characteristics without the notify or indicate property (or all of them with @link PollingOptions::force @endlink)
+     * are bridged by a @link Poller @endlink instead, which writes only changed values to the port.
+     *
+     * A bridge may carry an @link Bluetooth::L2CAPChannel @endlink instead of a characteristic, then the received SDUs
+     * take the place of the notifications and consecutive packets of a lane are merged into SDUs as large as the
+     * channel allows.
+     */
+    class Bridge
+    {
+    public:
+        /**
+         * @brief Constructs a new bridge, the bridge does nothing until @link Start @endlink is called.
+         *
+         * @param connection connection that owns the characteristic
+         * @param characteristic characteristic to be bridged, must outlive the bridge
+         * @param port port to be bridged, must outlive the bridge
+         * @param options settings of the bridge
+         */
+        Bridge(std::shared_ptr<Bluetooth::IBluetoothConnection> connection, Bluetooth::IBluetoothGattCharacteristic &characteristic, COM::COMPort &port, BridgeOptions options = {});
+
+        /**
+         * @brief Constructs a new bridge over an L2CAP channel, the bridge does nothing until @link Start @endlink is called.
+         *
+         * Polling, read heartbeats and the value cache do not apply to channels and are ignored.
+         *
+         * @param connection connection the channel belongs to, may be nullptr when the channel was opened on its own
+         * @param channel channel to be bridged, must outlive the bridge
+         * @param port port to be bridged, must outlive the bridge
+         * @param options settings of the bridge
+         */
+        Bridge(std::shared_ptr<Bluetooth::IBluetoothConnection> connection, Bluetooth::L2CAPChannel &channel, COM::COMPort &port, BridgeOptions options = {});
+
+        /**
+         * @brief Stops the bridge.
+         */
+        ~Bridge();
+
+        Bridge(const Bridge &) = delete;
+        Bridge &operator=(const Bridge &) = delete;
+
+        /**
+         * @brief Adds another characteristic whose changed values should be written to the port.
+         *
+         * Additional characteristics are always polled, together with the bridged characteristic itself, so that all
+         * reads are pipelined. Must be called before @link Start @endlink.
+         *
+         * @param characteristic characteristic to poll, must outlive the bridge
+         */
+        void AddPolledCharacteristic(Bluetooth::IBluetoothGattCharacteristic &characteristic);
+
+        /**
+         * @brief Checks whether the bridge polls the characteristic instead of subscribing to it.
+         *
+         * @return true if the characteristic is polled
+         */
+        [[nodiscard]] bool IsPolling() const noexcept;
+
+        /**
+         * @brief Subscribes to the characteristic (or the channel) and the port and starts the health monitor.
+         *
+         * @throw BluetoothException when subscribing to the characteristic fails
+         */
+        void Start();
+
+        /**
+         * @brief Unsubscribes from the characteristic and the port and stops the health monitor.
+         *
+         * The connection and the port are left open.
+         */
+        void Stop();
+
+        /**
+         * @brief Checks whether the link is currently considered alive.
+         *
+         * @return false from a detected disconnection until the link is detected to work again
+         */
+        [[nodiscard]] bool IsAlive() const noexcept;
+
+        /**
+         * @brief Registers a listener called every time the link is detected to be dead.
+         *
+         * The listener is called from the thread that detected the disconnection.
+         *
+         * @param listener listener receiving the reason of the disconnection
+         */
+        void OnDisconnected(std::function<void(const std::string &)> listener);
+
+        /**
+         * @brief Registers a listener called every time a link that was detected to be dead works again.
+         *
+         * A dead link recovers once it is open again and, with heartbeats, a heartbeat went through. Without them a
+         * closed connection recovers when it is open again, an inactive link once data arrives and failed writes once a
+         * write goes through. The listener is called from the thread that detected the recovery.
+         *
+         * @param listener the listener
+         */
+        void OnRecovered(std::function<void()> listener);
+
+        /**
+         * @brief Returns the link quality counters of this bridge.
+         *
+         * @return the counters
+         */
+        [[nodiscard]] const LinkQualityMetrics &GetMetrics() const noexcept;
+
+        /**
+         * @brief Returns the link quality counters of this bridge.
+         *
+         * @return the counters
+         */
+        [[nodiscard]] LinkQualityMetrics &GetMetrics() noexcept;
+
+        /**
+         * @brief Returns the combined state of the queues buffering the data coming from the COM port.
+         *
+         * @return state of the queues
+         */
+        [[nodiscard]] SpillQueueMetrics GetQueueMetrics();
+
+        /**
+         * @brief Returns the state of a single priority lane.
+         *
+         * @param lane lane to inspect
+         *
+         * @return state of the lane
+         */
+        [[nodiscard]] SpillQueueMetrics GetQueueMetrics(Priority lane);
+
+        /**
+         * @brief Returns how many notifications were forwarded to the port and how many were conflated away.
+         *
+         * @return state of the conflator
+         */
+        [[nodiscard]] ConflationMetrics GetConflationMetrics() const noexcept;
+
+        /**
+         * @brief Returns the state of the poller, all zeroes when the characteristic is not polled.
+         *
+         * @return state of the poller
+         */
+        [[nodiscard]] PollingMetrics GetPollingMetrics() const noexcept;
+
+        /**
+         * @brief Returns how much CPU time and memory the bridge has been using.
+         *
+         * The CPU time is measured with per-thread CPU clocks: the threads the bridge owns are metered as a whole and
+         * the callbacks running on threads shared with other bridges are charged for the time they took.
+         *
+         * @return resources used by the bridge
+         */
+        [[nodiscard]] BridgeResourceUsage GetResourceUsage();
+
+        /**
+         * @brief Attaches a monitor that is shown every notification and every write of the bridge.
+         *
+         * @param monitor monitor to attach, must outlive the bridge or be detached first; nullptr detaches the current one
+         */
+        void AttachMonitor(TrafficMonitor *monitor) noexcept;
+
+    private:
+        Bridge(std::shared_ptr<Bluetooth::IBluetoothConnection> connection, Bluetooth::IBluetoothGattCharacteristic *characteristic, Bluetooth::L2CAPChannel *channel,
+               COM::COMPort &port, BridgeOptions options);
+
+        bool WriteToLink(const std::vector<uint8_t> &data);
+
+        bool IsLinkOpen() const noexcept;
+
+        void DrainQueue();
+
+        bool WaitForWriter(std::chrono::steady_clock::duration duration);
+
+        void MonitorHealth();
+
+        /**
+         * What made the link considered dead, decides what proves that it works again
+         */
+        enum class LinkFailure
+        {
+            Connection,
+            Writes,
+            Heartbeats,
+            Inactivity
+        };
+
+        void ReportDisconnected(LinkFailure failure, const std::string &reason);
+
+        void ReportRecovered();
+
+        bool Heartbeat();
+
+        std::shared_ptr<Bluetooth::IBluetoothConnection> m_connection;
+        Bluetooth::IBluetoothGattCharacteristic *m_characteristic;
+        Bluetooth::L2CAPChannel *m_channel;
+        COM::COMPort &m_port;
+        BridgeOptions m_options;
+        LinkQualityMetrics m_metrics {};
+        CpuUsage m_threadCpu {};
+        CpuUsage m_callbackCpu {};
+
+        std::atomic<bool> m_alive { true };
+        std::atomic<LinkFailure> m_failure { LinkFailure::Connection };
+        std::atomic<unsigned int> m_consecutiveErrors { 0 };
+        std::function<void(const std::string &)> m_disconnectedListener {};
+        std::function<void()> m_recoveredListener {};
+        std::atomic<TrafficMonitor *> m_trafficMonitor { nullptr };
+        std::mutex m_listenerMutex {};
+
+        bool m_running = false;
+        size_t m_characteristicSubscription = 0;
+        size_t m_portSubscription = 0;
+        size_t m_statusSubscription = 0;
+
+        WriteScheduler m_scheduler;
+        Conflator m_conflator;
+        Poller m_poller;
+        std::vector<Bluetooth::IBluetoothGattCharacteristic *> m_polledCharacteristics {};
+        bool m_polling = false;
+        std::thread m_writerThread {};
+        std::mutex m_writerMutex {};
+        std::condition_variable m_writerCondition {};
+        bool m_writerExiting = false;
+
+        std::thread m_monitorThread {};
+        std::mutex m_monitorMutex {};
+        std::condition_variable m_monitorCondition {};
+        bool m_monitorExiting = false;
+    };
+}
+
+#endif // BLE_SERIAL_INCLUDE_BRIDGE_HPP_
@@ -1,10 +1,13 @@
 #ifndef BLE_SERIAL_INCLUDE_COM_HPP_
 #define BLE_SERIAL_INCLUDE_COM_HPP_
 
-#include <string>
+#include <ble_serial/listeners.hpp>
+
+#include <chrono>
+#include <exception>
 #include <functional>
 #include <mutex>
-#include <thread>
+#include <string>
 #include <vector>
 
 /**
@@ -28,7 +31,7 @@ namespace BLE_Serial::COM
         /**
          * @return error details
          */
-        [[nodiscard]]  const char *what() const override;
+        [[nodiscard]]  const char *what() const noexcept override;
 
     private:
         std::string m_message;
@@ -88,6 +91,9 @@ namespace BLE_Serial::COM
 
     /**
      * @brief Represents a serial connection over a COM port.
+     *
+     * All methods are safe to call from multiple threads. Listeners are called from a single subscriber thread and
+     * may themselves subscribe or unsubscribe.
      */
     class COMPort
     {
@@ -117,7 +123,7 @@ namespace BLE_Serial::COM
          *
          * @return how many bytes were actually written
          */
-        size_t Write(std::vector<uint8_t> data);
+        size_t Write(const std::vector<uint8_t> &data);
 
         /**
          * @brief Reads data from this serial port.
@@ -134,13 +140,16 @@ namespace BLE_Serial::COM
          *
          * @param listener listener to be called every time there is new data in the serial port
          *
-         * @return id of the listener, used for the @link Unsubscribe @endlink function.
+         * @return id of the listener, used for the @link Unsubscribe @endlink function. Ids stay valid until the listener is unsubscribed.
          */
         size_t Subscribe(std::function<void(std::vector<uint8_t>)> listener);
 
         /**
          * Unsubscribes a listener previously registered with @link Subscribe @endlink
          *
+         * Waits for a call of the listeners that is in progress, so the listener is never called once this returns.
+         * Called from a listener it returns right away, the other listeners of that call still run.
+         *
          * @param id id of the listener
          */
         void Unsubscribe(size_t id);
@@ -170,14 +179,14 @@ namespace BLE_Serial::COM
         std::chrono::milliseconds GetRefreshRate() noexcept;
 
     private:
+        bool ReadForListeners(std::vector<uint8_t> &data);
+
         void *m_handle;
 
-        std::thread m_subscriberThread {};
         std::chrono::milliseconds m_refreshRate { 100 };
         std::mutex m_mutex {};
-        std::condition_variable m_condition {};
-        bool m_exiting = false;
-        std::vector<std::function<void(std::vector<uint8_t>)>> m_callbacks {};
+        std::mutex m_writeMutex {};
+        IO::SubscriberThread m_subscribers { [this](std::vector<uint8_t> &data) { return ReadForListeners(data); } };
     };
 
 }
@@ -0,0 +1,152 @@
+#ifndef BLE_SERIAL_INCLUDE_CONFLATION_HPP_
+#define BLE_SERIAL_INCLUDE_CONFLATION_HPP_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <vector>
+
+namespace BLE_Serial::Bridge
+{
+    /**
+     * @brief Represents how notifications are thinned out before being written to the port.
+     */
+    enum class ConflationMode
+    {
+        /**
+         * Every notification is forwarded.
+         */
+        None,
+
+        /**
+         * At most one notification per @link ConflationOptions::interval @endlink is forwarded, always the latest one
+         * received by the end of the interval.
+         */
+        LatestOnly,
+
+        /**
+         * A notification is forwarded only if at least @link ConflationOptions::interval @endlink elapsed since the
+         * previously forwarded one, notifications in between are dropped.
+         */
+        MinInterval
+    };
+
+    /**
+     * @brief Settings of a @link Conflator @endlink.
+     */
+    struct ConflationOptions
+    {
+        /**
+         * How notifications are thinned out.
+         */
+        ConflationMode mode = ConflationMode::None;
+
+        /**
+         * Interval used by @link ConflationMode::LatestOnly @endlink and @link ConflationMode::MinInterval @endlink.
+         */
+        std::chrono::milliseconds interval { 100 };
+
+        /**
+         * Only every N-th notification is considered at all, 1 considers all of them.
+         */
+        unsigned int everyNth = 1;
+
+        /**
+         * Whether a payload identical to the previously forwarded one should be dropped.
+         */
+        bool deduplicate = false;
+    };
+
+    /**
+     * @brief Point-in-time state of a @link Conflator @endlink.
+     */
+    struct ConflationMetrics
+    {
+        uint64_t received;   ///< number of offered notifications
+        uint64_t forwarded;  ///< number of notifications written to the sink
+        uint64_t dropped;    ///< number of notifications that were conflated away
+        size_t bufferBytes;  ///< memory held by the triple buffer, zero when notifications are passed through directly
+    };
+
+    /**
+     * @brief Thins out a stream of notifications according to a @link ConflationOptions conflation policy @endlink.
+     *
+     * @link Offer @endlink never blocks and never allocates: the latest payload is published to a lock-free triple
+     * buffer and a flusher thread forwards it to the sink. With @link ConflationMode::None @endlink the sink is called
+     * directly from @link Offer @endlink.
+     *
+     * @link Offer @endlink must not be called concurrently with itself, which holds for the notifications of a single
+     * characteristic.
+     */
+    class Conflator
+    {
+    public:
+        /**
+         * @brief Constructs a new conflator, nothing is forwarded until @link Start @endlink is called.
+         *
+         * @param options conflation policy
+         * @param sink function receiving the forwarded payloads
+         */
+        Conflator(ConflationOptions options, std::function<void(const std::vector<uint8_t> &)> sink);
+
+        /**
+         * @brief Stops the conflator.
+         */
+        ~Conflator();
+
+        Conflator(const Conflator &) = delete;
+        Conflator &operator=(const Conflator &) = delete;
+
+        /**
+         * @brief Starts the flusher thread if the policy needs it.
+         */
+        void Start();
+
+        /**
+         * @brief Stops the flusher thread, a pending payload is dropped.
+         */
+        void Stop();
+
+        /**
+         * @brief Offers a new notification payload.
+         *
+         * @param data payload, its buffer may be swapped with a previously used one
+         */
+        void Offer(std::vector<uint8_t> &&data);
+
+        /**
+         * @return the current state of the conflator
+         */
+        [[nodiscard]] ConflationMetrics Metrics() const noexcept;
+
+    private:
+        static constexpr uint8_t IndexMask = 0x03;
+        static constexpr uint8_t FreshBit = 0x04;
+        static constexpr uint8_t ExitBit = 0x08;
+
+        void Flush();
+
+        void Forward(const std::vector<uint8_t> &data);
+
+        bool IsDuplicate(const std::vector<uint8_t> &data) noexcept;
+
+        ConflationOptions m_options;
+        std::function<void(const std::vector<uint8_t> &)> m_sink;
+
+        std::array<std::vector<uint8_t>, 3> m_buffers {};
+        std::atomic<uint8_t> m_state { 1 };
+        uint8_t m_back = 0;
+        uint8_t m_front = 2;
+
+        std::atomic<uint64_t> m_lastHash { 0 };
+        std::atomic<uint64_t> m_received { 0 };
+        std::atomic<uint64_t> m_forwarded { 0 };
+        std::atomic<size_t> m_largestPayload { 0 };
+        std::thread m_flusherThread {};
+    };
+}
+
+#endif // BLE_SERIAL_INCLUDE_CONFLATION_HPP_
@@ -0,0 +1,107 @@
+#ifndef BLE_SERIAL_INCLUDE_CPU_USAGE_HPP_
+#define BLE_SERIAL_INCLUDE_CPU_USAGE_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace BLE_Serial::Bridge
+{
+    /**
+     * @brief Accumulates the CPU time spent on behalf of a single owner, i.e. a bridge.
+     *
+     * Time is measured with the per-thread CPU clock of the operating system, so only the time the threads actually ran
+     * is counted. Threads owned by the owner are metered as a whole with a @link ThreadMeter @endlink, work done on
+     * threads shared with others (callbacks from the OS thread pool) is attributed with a @link Scope @endlink.
+     */
+    class CpuUsage
+    {
+    public:
+        /**
+         * @brief Charges the CPU time the calling thread spends between construction and destruction.
+         */
+        class Scope
+        {
+        public:
+            /**
+             * @param usage account to charge, must outlive the scope
+             */
+            explicit Scope(CpuUsage &usage) noexcept;
+
+            ~Scope();
+
+            Scope(const Scope &) = delete;
+            Scope &operator=(const Scope &) = delete;
+
+        private:
+            CpuUsage &m_usage;
+            std::chrono::nanoseconds m_start;
+        };
+
+        /**
+         * @brief Charges all the CPU time of the thread that owns the meter.
+         *
+         * Must be created at the start of the thread's function, @link Update @endlink should be called regularly so the
+         * account does not lag behind, the rest is charged on destruction.
+         */
+        class ThreadMeter
+        {
+        public:
+            /**
+             * @param usage account to charge, must outlive the meter
+             */
+            explicit ThreadMeter(CpuUsage &usage) noexcept;
+
+            ~ThreadMeter();
+
+            ThreadMeter(const ThreadMeter &) = delete;
+            ThreadMeter &operator=(const ThreadMeter &) = delete;
+
+            /**
+             * @brief Charges the time used since the previous update.
+             */
+            void Update() noexcept;
+
+        private:
+            CpuUsage &m_usage;
+            std::chrono::nanoseconds m_last;
+        };
+
+        /**
+         * @brief Returns the CPU time consumed by the calling thread so far.
+         *
+         * Precise enough for short callbacks: Windows on x86 counts the cycles of the thread, converted with the measured
+         * rate of the time stamp counter, POSIX systems read the CPU clock of the thread. Windows on other processors
+         * falls back to the thread times, which only advance every clock tick (15.6 ms by default).
+         *
+         * @return user and kernel time of the thread, zero when the platform cannot measure it
+         */
+        [[nodiscard]] static std::chrono::nanoseconds ThreadTime() noexcept;
+
+        /**
+         * @brief Prepares @link ThreadTime @endlink ahead of its first use.
+         *
+         * Windows on x86 measures the rate of the time stamp counter once per process, which sleeps the calling thread
+         * for 10 ms. Should be called on a thread of the owner before the first callback can be charged, otherwise that
+         * callback blocks a thread pool thread for the measurement. Does nothing on the other platforms.
+         */
+        static void Calibrate() noexcept;
+
+        /**
+         * @brief Adds time to the account.
+         *
+         * @param time time to add
+         */
+        void Charge(std::chrono::nanoseconds time) noexcept;
+
+        /**
+         * @return all the time charged so far
+         */
+        [[nodiscard]] std::chrono::nanoseconds Total() const noexcept;
+
+    private:
+        std::atomic<int64_t> m_total { 0 };
+    };
+}
+
+#endif // BLE_SERIAL_INCLUDE_CPU_USAGE_HPP_
@@ -0,0 +1,353 @@
+#ifndef BLE_SERIAL_INCLUDE_DFU_HPP_
+#define BLE_SERIAL_INCLUDE_DFU_HPP_
+
+#include <ble_serial/bluetooth.hpp>
+#include <ble_serial/log.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Firmware updates over the Nordic Secure DFU protocol
+ */
+namespace BLE_Serial::Dfu
+{
+    /**
+     * @brief UUID of the Secure DFU service.
+     */
+    constexpr const char *SecureDfuServiceUuid = "0000FE59-0000-1000-8000-00805F9B34FB";
+
+    /**
+     * @brief UUID of the control point characteristic, written with response and notifying the responses.
+     */
+    constexpr const char *SecureDfuControlPointUuid = "8EC90001-F315-4F60-9FB8-838830DAEA50";
+
+    /**
+     * @brief UUID of the packet characteristic, the object data is written to it without response.
+     */
+    constexpr const char *SecureDfuPacketUuid = "8EC90002-F315-4F60-9FB8-838830DAEA50";
+
+    /**
+     * @brief Requests of the control point.
+     */
+    enum class DfuOpCode : uint8_t
+    {
+        Create = 0x01,                  ///< type (1 byte), size (4 bytes)
+        SetReceiptNotification = 0x02,  ///< packets between receipt notifications (2 bytes), 0 disables them
+        CalculateChecksum = 0x03,       ///< answered with the offset and CRC-32 received so far
+        Execute = 0x04,                 ///< validates and stores the current object
+        Select = 0x06,                  ///< type (1 byte), answered with the maximum size, offset and CRC-32
+        Response = 0x60                 ///< first byte of every notification, followed by the request and the result
+    };
+
+    /**
+     * @brief Kinds of objects a firmware update consists of.
+     */
+    enum class DfuObjectType : uint8_t
+    {
+        Command = 0x01,  ///< the init packet, signed metadata of the firmware
+        Data = 0x02      ///< the firmware image
+    };
+
+    /**
+     * @brief Result codes of the control point responses.
+     */
+    enum class DfuResult : uint8_t
+    {
+        Invalid = 0x00,
+        Success = 0x01,
+        OpCodeNotSupported = 0x02,
+        InvalidParameter = 0x03,
+        InsufficientResources = 0x04,
+        InvalidObject = 0x05,
+        UnsupportedType = 0x07,
+        OperationNotPermitted = 0x08,
+        OperationFailed = 0x0A,
+        ExtendedError = 0x0B            ///< followed by an extended error code, i.e. 0x07 for a rejected signature
+    };
+
+    /**
+     * @brief Calculates the CRC-32 used by Secure DFU (IEEE 802.3, the one of zlib).
+     *
+     * Uses the CRC-32 instructions on ARMv8 builds that have them. x86 builds fold the data with PCLMULQDQ when the
+     * processor has it (the SSE 4.2 CRC-32 instruction computes CRC-32C, a different polynomial) and fall back to
+     * slicing-by-8 tables, which also checksum the tail of fewer than 16 bytes.
+     *
+     * @param data data to checksum
+     * @param size size of the data
+     * @param crc CRC of the preceding data, to checksum in parts
+     *
+     * @return the CRC
+     */
+    uint32_t Crc32(const uint8_t *data, size_t size, uint32_t crc = 0) noexcept;
+
+    /**
+     * @brief Progress of a @link SecureDfuClient::Upload @endlink.
+     */
+    struct DfuProgress
+    {
+        size_t sent;             ///< bytes of the firmware the target confirmed
+        size_t total;            ///< size of the firmware
+        size_t resumed;          ///< bytes a previous, interrupted update had already transferred
+        uint64_t objects;        ///< data objects executed
+        uint64_t retries;        ///< objects sent again after a checksum mismatch
+    };
+
+    /**
+     * @brief Settings of a @link SecureDfuClient @endlink.
+     */
+    struct DfuOptions
+    {
+        /**
+         * Bytes per write to the packet characteristic, the maximum write size of the connection.
+         */
+        size_t packetSize = 20;
+
+        /**
+         * Packets between the receipt notifications of the target, every notification carries the CRC-32 of what the
+         * target received. Zero disables them, the checksum is then only checked at the end of every object.
+         */
+        uint16_t receiptInterval = 12;
+
+        /**
+         * How many receipt intervals may be sent before the target confirms the oldest one, two or more keep the
+         * packet queue of the link busy while a notification is on its way.
+         */
+        size_t receiptWindow = 2;
+
+        /**
+         * Sends the next object right after executing the current one instead of waiting for the target to store it
+         * first, the results still arrive in order and a failed one ends the update.
+         */
+        bool pipelineObjects = true;
+
+        /**
+         * How long the target may take to answer a request or confirm a receipt interval.
+         */
+        std::chrono::milliseconds responseTimeout { 5000 };
+
+        /**
+         * How often an object whose checksum does not match is sent again before the update fails.
+         */
+        size_t maxRetries = 3;
+
+        /**
+         * Called from the uploading thread every time an object was executed, and once when an interrupted update is
+         * resumed.
+         */
+        std::function<void(const DfuProgress &)> progress {};
+
+        /**
+         * Context attached to the log records of the client.
+         */
+        Log::LogContext logContext {};
+    };
+
+    /**
+     * @brief Uploads a firmware to a target running the Nordic Secure DFU bootloader.
+     *
+     * The init packet goes first as a command object, then the firmware in data objects of the size the target
+     * announces. The data is written without response; receipt notifications pace the writes and their CRC-32 is
+     * checked against the image as it is sent, so a corrupted packet is caught within one receipt interval instead of
+     * at the end of the object. An update interrupted earlier resumes from where the target stopped when the CRC-32 of
+     * what it holds matches the image.
+     */
+    class SecureDfuClient
+    {
+    public:
+        /**
+         * @brief Constructs a new client and subscribes to the control point.
+         *
+         * @param controlPoint the control point characteristic
+         * @param packet the packet characteristic
+         * @param options settings of the client
+         *
+         * @throw BluetoothException when the subscription fails
+         */
+        SecureDfuClient(Bluetooth::IBluetoothGattCharacteristic &controlPoint, Bluetooth::IBluetoothGattCharacteristic &packet, DfuOptions options);
+
+        /**
+         * @brief Unsubscribes from the control point.
+         */
+        ~SecureDfuClient();
+
+        SecureDfuClient(const SecureDfuClient &) = delete;
+        SecureDfuClient &operator=(const SecureDfuClient &) = delete;
+
+        /**
+         * @brief Runs the update.
+         *
+         * @param initPacket the init packet, i.e. the .dat file of a DFU package
+         * @param initPacketSize size of the init packet
+         * @param firmware the firmware image, i.e. the .bin file of a DFU package
+         * @param firmwareSize size of the firmware image
+         * @param stop flag that interrupts the update when set, it can be resumed later
+         *
+         * @return false when the update was interrupted
+         *
+         * @throw BluetoothException when the target rejects a request, does not respond in time or a checksum keeps
+         * mismatching
+         * @throw std::invalid_argument when an image is empty or larger than 4 GiB
+         */
+        bool Upload(const uint8_t *initPacket, size_t initPacketSize, const uint8_t *firmware, size_t firmwareSize, const std::atomic_bool &stop);
+
+    private:
+        struct Response
+        {
+            DfuOpCode request;
+            DfuResult result;
+            std::vector<uint8_t> payload;
+        };
+
+        struct Checksum
+        {
+            uint32_t offset;
+            uint32_t crc;
+
+            bool operator==(const Checksum &other) const noexcept
+            {
+                return offset == other.offset && crc == other.crc;
+            }
+        };
+
+        struct Selection
+        {
+            uint32_t maxSize;
+            Checksum checksum;
+        };
+
+        void OnNotification(std::vector<uint8_t> data);
+
+        void Request(const std::vector<uint8_t> &request);
+
+        Response WaitForResponse(DfuOpCode request, bool allowRefusal = false);
+
+        Checksum WaitForChecksum();
+
+        Selection Select(DfuObjectType type);
+
+        void Create(DfuObjectType type, uint32_t size);
+
+        void Execute();
+
+        bool TryExecute();
+
+        Checksum CalculateChecksum();
+
+        void WritePacket(const std::vector<uint8_t> &packet);
+
+        bool SendObject(const uint8_t *image, uint32_t begin, uint32_t end, uint32_t &crc, const std::atomic_bool &stop);
+
+        bool SendInitPacket(const uint8_t *initPacket, size_t initPacketSize, const std::atomic_bool &stop);
+
+        bool SendFirmware(const uint8_t *firmware, uint32_t firmwareSize, uint32_t maxObjectSize, uint32_t start, const std::atomic_bool &stop);
+
+        Bluetooth::IBluetoothGattCharacteristic &m_controlPoint;
+        Bluetooth::IBluetoothGattCharacteristic &m_packet;
+        DfuOptions m_options;
+        size_t m_subscription;
+
+        std::mutex m_mutex {};
+        std::condition_variable m_condition {};
+        std::deque<Response> m_responses {};
+        std::deque<Checksum> m_checksums {};
+        std::optional<std::string> m_protocolError {};
+
+        DfuProgress m_progress {};
+    };
+
+    /**
+     * @brief In-process Secure DFU target for testing clients and measuring them without a device.
+     *
+     * Implements the control point and packet characteristics with the object handling of the Nordic bootloader:
+     * objects of at most the announced size, cumulative CRC-32, receipt notifications and resuming. Notifications are
+     * delivered from a thread of the target, as they would be by the Bluetooth stack.
+     */
+    class SimulatedDfuTarget
+    {
+    public:
+        /**
+         * @brief Constructs a new target.
+         *
+         * @param maxDataObjectSize size of the data objects, 4096 bytes on the nRF52 bootloader
+         * @param maxCommandObjectSize size of the command object
+         */
+        explicit SimulatedDfuTarget(uint32_t maxDataObjectSize = 4096, uint32_t maxCommandObjectSize = 256);
+
+        /**
+         * @brief Stops the notification thread.
+         */
+        ~SimulatedDfuTarget();
+
+        SimulatedDfuTarget(const SimulatedDfuTarget &) = delete;
+        SimulatedDfuTarget &operator=(const SimulatedDfuTarget &) = delete;
+
+        /**
+         * @return the control point characteristic
+         */
+        Bluetooth::IBluetoothGattCharacteristic &GetControlPoint() noexcept;
+
+        /**
+         * @return the packet characteristic
+         */
+        Bluetooth::IBluetoothGattCharacteristic &GetPacket() noexcept;
+
+        /**
+         * @return the executed init packet
+         */
+        [[nodiscard]] std::vector<uint8_t> GetInitPacket() const;
+
+        /**
+         * @return the executed part of the firmware
+         */
+        [[nodiscard]] std::vector<uint8_t> GetFirmware() const;
+
+    private:
+        class Characteristic;
+
+        struct Object
+        {
+            std::vector<uint8_t> received {};   ///< everything received for objects of this type, executed or not
+            uint32_t executed = 0;              ///< bytes of executed objects
+            uint32_t objectBegin = 0;           ///< offset of the current object
+            uint32_t objectSize = 0;            ///< size of the current object, zero when there is none
+            uint32_t crc = 0;                   ///< CRC-32 of everything received
+        };
+
+        void OnControlPoint(const std::vector<uint8_t> &request);
+
+        void OnPacket(const std::vector<uint8_t> &data);
+
+        void Notify(std::vector<uint8_t> notification);
+
+        void Run();
+
+        uint32_t m_maxDataObjectSize;
+        uint32_t m_maxCommandObjectSize;
+
+        mutable std::mutex m_mutex {};
+        std::condition_variable m_condition {};
+        Object m_command {};
+        Object m_data {};
+        Object *m_current = nullptr;
+        uint16_t m_receiptInterval = 0;
+        uint32_t m_packetsSinceReceipt = 0;
+        std::deque<std::vector<uint8_t>> m_notifications {};
+        std::function<void(std::vector<uint8_t>)> m_listener {};
+        bool m_exiting = false;
+
+        std::unique_ptr<Characteristic> m_controlPoint;
+        std::unique_ptr<Characteristic> m_packet;
+        std::thread m_thread {};
+    };
+}
+
+#endif // BLE_SERIAL_INCLUDE_DFU_HPP_
@@ -0,0 +1,83 @@
+#ifndef BLE_SERIAL_INCLUDE_FORMAT_HPP_
+#define BLE_SERIAL_INCLUDE_FORMAT_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Helpers for presenting binary payloads to humans
+ */
+namespace BLE_Serial::Format
+{
+    /**
+     * @brief Encodes bytes as upper-case hex digits without any separators.
+     *
+     * Blocks of 16 bytes are encoded with SIMD instructions where available.
+     *
+     * @param data bytes to encode
+     * @param size number of bytes
+     * @param output buffer for at least 2 * size characters, no terminator is written
+     */
+    void EncodeHex(const uint8_t *data, size_t size, char *output) noexcept;
+
+    /**
+     * @brief Formats bytes as space separated hex pairs, i.e. "01 A2 FF".
+     *
+     * @param data bytes to format
+     *
+     * @return the formatted string
+     */
+    std::string ToHexString(const std::vector<uint8_t> &data);
+
+    /**
+     * @brief Parses a hex string into bytes.
+     *
+     * Whitespace, ':' and ',' separators and "0x" prefixes are ignored, so "01A2FF", "01 a2 ff" and "0x01,0xA2,0xFF"
+     * are all accepted.
+     *
+     * @param text hex string
+     *
+     * @return the parsed bytes
+     *
+     * @throw std::invalid_argument when the string contains a non-hex character or an odd number of digits
+     */
+    std::vector<uint8_t> ParseHex(std::string_view text);
+
+    /**
+     * @brief Formats a string as a quoted JSON string literal, escaping it as needed.
+     *
+     * @param text string to format
+     *
+     * @return the JSON string literal
+     */
+    std::string ToJsonString(std::string_view text);
+
+    /**
+     * @brief Writes a classic hexdump of the bytes, 16 bytes per line with the offset and the printable characters.
+     *
+     * @param output stream to write to
+     * @param data bytes to dump
+     * @param size number of bytes
+     * @param indent string written at the beginning of every line
+     */
+    void HexDump(std::ostream &output, const uint8_t *data, size_t size, std::string_view indent = "");
+
+    /**
+     * @brief Appends a classic hexdump of the bytes to a string, see the stream overload.
+     *
+     * Reusing the same string for many dumps avoids any allocation once it grew large enough.
+     *
+     * @param output string to append to
+     * @param data bytes to dump
+     * @param size number of bytes
+     * @param indent string written at the beginning of every line
+     * @param baseOffset offset printed for the first byte
+     */
+    void HexDump(std::string &output, const uint8_t *data, size_t size, std::string_view indent = "", size_t baseOffset = 0);
+}
+
+#endif // BLE_SERIAL_INCLUDE_FORMAT_HPP_
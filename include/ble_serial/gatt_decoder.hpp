@@ -0,0 +1,243 @@
+#ifndef BLE_SERIAL_INCLUDE_GATT_DECODER_HPP_
+#define BLE_SERIAL_INCLUDE_GATT_DECODER_HPP_
+
+#include <ble_serial/bluetooth.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+/**
+ * @brief Decoding of standard GATT characteristic values into typed records
+ */
+namespace BLE_Serial::Gatt
+{
+    /**
+     * @brief Value formats of the Characteristic Presentation Format descriptor.
+     */
+    enum class GattFormat : uint8_t
+    {
+        Boolean = 0x01,
+        UInt2 = 0x02,
+        UInt4 = 0x03,
+        UInt8 = 0x04,
+        UInt12 = 0x05,
+        UInt16 = 0x06,
+        UInt24 = 0x07,
+        UInt32 = 0x08,
+        UInt48 = 0x09,
+        UInt64 = 0x0A,
+        UInt128 = 0x0B,
+        SInt8 = 0x0C,
+        SInt12 = 0x0D,
+        SInt16 = 0x0E,
+        SInt24 = 0x0F,
+        SInt32 = 0x10,
+        SInt48 = 0x11,
+        SInt64 = 0x12,
+        SInt128 = 0x13,
+        Float32 = 0x14,      ///< IEEE 754 single precision
+        Float64 = 0x15,      ///< IEEE 754 double precision
+        SFloat = 0x16,       ///< IEEE 11073 16-bit, 12-bit mantissa and 4-bit exponent
+        Float = 0x17,        ///< IEEE 11073 32-bit, 24-bit mantissa and 8-bit exponent
+        DUInt16 = 0x18,
+        Utf8String = 0x19,   ///< takes the rest of the value
+        Utf16String = 0x1A,  ///< takes the rest of the value
+        Struct = 0x1B        ///< opaque, takes the rest of the value
+    };
+
+    /**
+     * @brief Describes a single field of a characteristic value.
+     */
+    struct GattFieldLayout
+    {
+        std::string name;              ///< key of the field in the decoded output
+        GattFormat format;             ///< encoding of the field
+        double scale = 1.0;            ///< numeric values are multiplied by it, anything but 1 makes the value a double
+        int8_t exponent = 0;           ///< numeric values are multiplied by 10 to the power of it, anything but 0 makes the value a double
+        uint16_t unit = 0x2700;        ///< assigned number of the unit, unitless by default
+        uint32_t presenceMask = 0;     ///< flag bits deciding whether the field is present, 0 for a mandatory field
+        uint32_t presenceValue = 0;    ///< the field is present when the masked flags equal this value
+        bool repeated = false;         ///< the field repeats until the end of the value, only allowed for the last field
+    };
+
+    /**
+     * @brief Describes the whole value of a characteristic.
+     */
+    struct GattCharacteristicLayout
+    {
+        size_t flagsSize = 0;                  ///< bytes of little-endian flags in front of the fields, 0 for none
+        std::vector<GattFieldLayout> fields;   ///< the fields in the order they are encoded
+    };
+
+    /**
+     * @brief Decoded value of a single field.
+     */
+    using GattValue = std::variant<bool, int64_t, uint64_t, double, std::string>;
+
+    /**
+     * @brief A decoded field together with its layout.
+     */
+    struct GattField
+    {
+        const GattFieldLayout *layout;  ///< layout of the field, owned by the decoder
+        uint8_t index;                  ///< position of the layout in @link GattCharacteristicLayout::fields @endlink
+        GattValue value;                ///< the decoded value
+    };
+
+    /**
+     * @brief Decoded characteristic value.
+     */
+    struct GattRecord
+    {
+        Bluetooth::GattRegisteredCharacteristic characteristic;  ///< characteristic the value belongs to
+        std::vector<GattField> fields;                           ///< fields present in the value, in the encoded order
+    };
+
+    /**
+     * @brief Decodes the values of a single characteristic type.
+     *
+     * The size of every fixed-size field is worked out when the decoder is constructed, so decoding is a single pass
+     * over the value without any lookups. Decoding into the same @link GattRecord @endlink again reuses its memory.
+     */
+    class GattDecoder
+    {
+    public:
+        /**
+         * @brief Constructs a new decoder.
+         *
+         * @param characteristic characteristic type the decoder is for
+         * @param layout layout of the values
+         *
+         * @throw std::invalid_argument when a field taking the rest of the value or a repeated field is not the last
+         * one, there are more than 255 fields or the flags are wider than 4 bytes
+         */
+        GattDecoder(Bluetooth::GattRegisteredCharacteristic characteristic, GattCharacteristicLayout layout);
+
+        /**
+         * @brief Constructs a decoder from the Characteristic Presentation Format descriptors of a characteristic.
+         *
+         * A single descriptor gives a field named "value", several describe an aggregate with fields "value0",
+         * "value1" and so on. The exponents and units of the descriptors are kept in the layouts.
+         *
+         * @param characteristic characteristic type the decoder is for
+         * @param formats formats declared by the characteristic
+         *
+         * @return the decoder
+         *
+         * @throw std::invalid_argument when no format is given, one of them is unknown or the layout is invalid
+         */
+        static GattDecoder FromPresentationFormats(Bluetooth::GattRegisteredCharacteristic characteristic, const std::vector<Bluetooth::GattPresentationFormat> &formats);
+
+        /**
+         * @brief Decodes a value.
+         *
+         * @param data the value
+         * @param size size of the value
+         * @param record record that will be overwritten with the decoded fields
+         *
+         * @return false when the value is too short for its mandatory fields or for the fields its flags announce
+         */
+        bool Decode(const uint8_t *data, size_t size, GattRecord &record) const;
+
+        /**
+         * @brief Returns the characteristic type the decoder is for.
+         *
+         * @return the characteristic type
+         */
+        [[nodiscard]] Bluetooth::GattRegisteredCharacteristic GetCharacteristic() const noexcept;
+
+        /**
+         * @brief Returns the layout of the values.
+         *
+         * @return the layout
+         */
+        [[nodiscard]] const GattCharacteristicLayout &GetLayout() const noexcept;
+
+    private:
+        Bluetooth::GattRegisteredCharacteristic m_characteristic;
+        GattCharacteristicLayout m_layout;
+        std::vector<size_t> m_sizes;     ///< encoded size of every field, 0 for the ones taking the rest of the value
+        size_t m_minimumSize;            ///< flags and mandatory fields
+    };
+
+    /**
+     * @brief Set of decoders keyed by the characteristic type.
+     */
+    class GattDecoderRegistry
+    {
+    public:
+        /**
+         * @brief Constructs an empty registry.
+         */
+        GattDecoderRegistry() = default;
+
+        /**
+         * @brief Returns the registry holding the decoders of the standard characteristics, i.e. Heart Rate
+         * Measurement, Temperature Measurement or Battery Level.
+         *
+         * @return the standard registry
+         */
+        static const GattDecoderRegistry &GetStandard();
+
+        /**
+         * @brief Adds a decoder, replacing the one registered for the same characteristic type.
+         *
+         * @param decoder the decoder
+         */
+        void Register(GattDecoder decoder);
+
+        /**
+         * @brief Looks a decoder up.
+         *
+         * @param characteristic characteristic type
+         *
+         * @return the decoder, nullptr when none is registered
+         */
+        [[nodiscard]] std::shared_ptr<const GattDecoder> Find(Bluetooth::GattRegisteredCharacteristic characteristic) const;
+
+        /**
+         * @brief Picks the decoder for a characteristic.
+         *
+         * A registered decoder wins, the layouts of standard characteristics are fixed by the specification. Other
+         * characteristics are decoded as declared by their Characteristic Presentation Format descriptors.
+         *
+         * @param characteristic the characteristic
+         *
+         * @return the decoder, nullptr when none is registered and the characteristic declares no usable format
+         */
+        [[nodiscard]] std::shared_ptr<const GattDecoder> Resolve(const Bluetooth::IBluetoothGattCharacteristic &characteristic) const;
+
+    private:
+        std::unordered_map<Bluetooth::GattRegisteredCharacteristic, std::shared_ptr<const GattDecoder>> m_decoders {};
+    };
+
+    /**
+     * @brief Appends a record as a single line of JSON terminated by a newline, i.e.
+     * {"characteristic":"2A37","heart_rate":72}.
+     *
+     * Repeated fields become arrays, values that are not a number become null.
+     *
+     * @param output string to append to, reusing it avoids any allocation once it grew large enough
+     * @param record the record
+     */
+    void AppendJson(std::string &output, const GattRecord &record);
+
+    /**
+     * @brief Appends a record in the compact binary format.
+     *
+     * A record is 0xA5, the length of the rest of the record (2 bytes), the characteristic type (2 bytes) and the
+     * fields. Every field is the index of its layout (1 byte), a type tag (1 byte) and the value: 0 for a boolean
+     * (1 byte), 1 for a signed integer (zigzag varint), 2 for an unsigned integer (varint), 3 for a double (8 bytes)
+     * and 4 for a string (varint length and the bytes). All little-endian.
+     *
+     * @param output buffer to append to
+     * @param record the record
+     */
+    void AppendBinary(std::vector<uint8_t> &output, const GattRecord &record);
+}
+
+#endif // BLE_SERIAL_INCLUDE_GATT_DECODER_HPP_
@@ -0,0 +1,172 @@
+#ifndef BLE_SERIAL_INCLUDE_INSTRUMENTATION_HPP_
+#define BLE_SERIAL_INCLUDE_INSTRUMENTATION_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+/**
+ * @brief Scoped timers and counters for profile builds
+ *
+ * The probes are only compiled in when the library is configured with the BLE_SERIAL_INSTRUMENTATION CMake option,
+ * otherwise @link BLE_SERIAL_TIMED_SCOPE @endlink and @link BLE_SERIAL_COUNT @endlink expand to nothing and their
+ * arguments are not even evaluated.
+ */
+namespace BLE_Serial::Instrumentation
+{
+    /**
+     * @brief What a @link Probe @endlink measures.
+     */
+    enum class ProbeKind : uint8_t
+    {
+        Timer,   ///< durations of a scope
+        Counter  ///< sum of reported values
+    };
+
+    /**
+     * @brief Statistics of a single instrumented site.
+     *
+     * Probes are created as function-local statics by the macros and register themselves in a global lock-free list,
+     * updating them only touches relaxed atomics.
+     */
+    class Probe
+    {
+    public:
+        /**
+         * @brief Constructs and registers a new probe.
+         *
+         * @param name name of the measured phase, sites sharing a name are reported together; must be a literal
+         * @param kind what the probe measures
+         */
+        Probe(const char *name, ProbeKind kind) noexcept;
+
+        Probe(const Probe &) = delete;
+        Probe &operator=(const Probe &) = delete;
+
+        /**
+         * @brief Records a single event.
+         *
+         * @param value duration in nanoseconds for timers, the counted amount for counters
+         */
+        void Record(uint64_t value) noexcept;
+
+        /**
+         * @return name of the probe
+         */
+        [[nodiscard]] const char *Name() const noexcept;
+
+        /**
+         * @return what the probe measures
+         */
+        [[nodiscard]] ProbeKind Kind() const noexcept;
+
+        /**
+         * @return number of recorded events
+         */
+        [[nodiscard]] uint64_t Count() const noexcept;
+
+        /**
+         * @return sum of the recorded values
+         */
+        [[nodiscard]] uint64_t Total() const noexcept;
+
+        /**
+         * @return largest recorded value
+         */
+        [[nodiscard]] uint64_t Max() const noexcept;
+
+        /**
+         * @return next registered probe or nullptr
+         */
+        [[nodiscard]] const Probe *Next() const noexcept;
+
+    private:
+        const char *m_name;
+        ProbeKind m_kind;
+        std::atomic<uint64_t> m_count { 0 };
+        std::atomic<uint64_t> m_total { 0 };
+        std::atomic<uint64_t> m_max { 0 };
+        Probe *m_next = nullptr;
+    };
+
+    /**
+     * @brief Records the duration of a scope into a timer @link Probe @endlink.
+     */
+    class ScopedTimer
+    {
+    public:
+        /**
+         * @param probe probe receiving the duration
+         */
+        explicit ScopedTimer(Probe &probe) noexcept;
+
+        ~ScopedTimer();
+
+        ScopedTimer(const ScopedTimer &) = delete;
+        ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+    private:
+        Probe &m_probe;
+        std::chrono::steady_clock::time_point m_start;
+    };
+
+    /**
+     * @brief Returns the first registered probe.
+     *
+     * @return head of the list of probes or nullptr when none was hit yet
+     */
+    const Probe *FirstProbe() noexcept;
+
+    /**
+     * @brief Checks whether the library was built with the probes compiled in.
+     *
+     * @return true if the instrumentation is enabled
+     */
+    constexpr bool IsEnabled() noexcept
+    {
+#ifdef BLE_SERIAL_INSTRUMENTATION
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    /**
+     * @brief Prints a table of all the probes, sites sharing a name are merged.
+     *
+     * @param output stream the table is written to
+     */
+    void Report(std::ostream &output);
+}
+
+#define BLE_SERIAL_INSTRUMENTATION_CONCAT_(a, b) a##b
+#define BLE_SERIAL_INSTRUMENTATION_CONCAT(a, b) BLE_SERIAL_INSTRUMENTATION_CONCAT_(a, b)
+
+#ifdef BLE_SERIAL_INSTRUMENTATION
+
+/**
+ * Times the rest of the enclosing scope under the given phase name.
+ */
+#define BLE_SERIAL_TIMED_SCOPE(name)                                                                                               \
+    static ::BLE_Serial::Instrumentation::Probe BLE_SERIAL_INSTRUMENTATION_CONCAT(c_probe_, __LINE__) {                            \
+            name, ::BLE_Serial::Instrumentation::ProbeKind::Timer };                                                               \
+    ::BLE_Serial::Instrumentation::ScopedTimer BLE_SERIAL_INSTRUMENTATION_CONCAT(timer_, __LINE__) { BLE_SERIAL_INSTRUMENTATION_CONCAT(c_probe_, __LINE__) }
+
+/**
+ * Adds a value to the counter with the given name.
+ */
+#define BLE_SERIAL_COUNT(name, value)                                                                                              \
+    do {                                                                                                                           \
+        static ::BLE_Serial::Instrumentation::Probe c_probe { name, ::BLE_Serial::Instrumentation::ProbeKind::Counter };           \
+        c_probe.Record(static_cast<uint64_t>(value));                                                                              \
+    } while (false)
+
+#else
+
+#define BLE_SERIAL_TIMED_SCOPE(name) static_cast<void>(0)
+#define BLE_SERIAL_COUNT(name, value) static_cast<void>(0)
+
+#endif
+
+#endif // BLE_SERIAL_INCLUDE_INSTRUMENTATION_HPP_
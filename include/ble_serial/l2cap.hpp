@@ -0,0 +1,198 @@
+#ifndef BLE_SERIAL_INCLUDE_L2CAP_HPP_
+#define BLE_SERIAL_INCLUDE_L2CAP_HPP_
+
+#include <ble_serial/bluetooth.hpp>
+#include <ble_serial/listeners.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace BLE_Serial::Bluetooth
+{
+    /**
+     * @brief Settings of an @link L2CAPChannel @endlink.
+     */
+    struct L2CAPChannelOptions
+    {
+        /**
+         * Largest SDU accepted from the peer, up to 65535 bytes.
+         */
+        uint16_t mtu = 0xFFFF;
+
+        /**
+         * Payload size of a single K-frame, the SDUs are segmented into frames of this size over the air.
+         */
+        uint16_t mps = 247;
+
+        /**
+         * How many K-frames the peer may send before it has to wait for more credits. The credits are granted back as
+         * the received SDUs are consumed, so a slow consumer throttles the peer instead of losing data.
+         */
+        uint16_t credits = 32;
+
+        /**
+         * How long a send may wait for the peer to grant credits before the link is considered stalled.
+         */
+        std::chrono::milliseconds sendTimeout { 5000 };
+    };
+
+    /**
+     * @brief Traffic counters of an @link L2CAPChannel @endlink.
+     */
+    struct L2CAPChannelMetrics
+    {
+        uint64_t sdusSent;                        ///< number of SDUs sent
+        uint64_t bytesSent;                       ///< payload bytes of all sent SDUs
+        uint64_t sdusReceived;                    ///< number of SDUs received
+        uint64_t bytesReceived;                   ///< payload bytes of all received SDUs
+        uint64_t creditStalls;                    ///< number of sends that had to wait for credits
+        std::chrono::nanoseconds stalledTime;     ///< total time spent waiting for credits
+    };
+
+    /**
+     * @brief LE credit-based connection-oriented channel (L2CAP CoC) to a device.
+     *
+     * A channel carries whole SDUs of up to 64 KiB in both directions, which is several times the throughput of GATT
+     * notifications and writes on the same link. Flow control is credit-based: every K-frame needs a credit from the
+     * receiver, sends block while the peer has not granted any and received SDUs are only credited back once the
+     * listeners have consumed them.
+     *
+     * On Linux the channel is a BlueZ SOCK_SEQPACKET socket, any other connected SOCK_SEQPACKET socket (i.e. one end of
+     * a socketpair) can stand in for it. The WinRT Bluetooth API does not expose L2CAP channels, there all the
+     * constructors throw.
+     *
+     * All methods are safe to call from multiple threads. Listeners are called from a single subscriber thread, in the
+     * order the SDUs arrived.
+     */
+    class L2CAPChannel
+    {
+    public:
+        /**
+         * @brief Connects to an L2CAP CoC PSM of a device.
+         *
+         * @param address address of the device
+         * @param psm protocol/service multiplexer the device listens on
+         * @param timeout timeout for the connection
+         * @param options settings of the channel
+         *
+         * @return the connected channel
+         *
+         * @throw BluetoothException when the connection fails or the platform does not support L2CAP channels
+         */
+        static std::unique_ptr<L2CAPChannel> Connect(BluetoothAddress address, uint16_t psm, std::chrono::seconds timeout, L2CAPChannelOptions options = {});
+
+        /**
+         * @brief Constructs a channel over an already connected SOCK_SEQPACKET socket.
+         *
+         * @param socket the socket, the channel takes its ownership
+         * @param options settings of the channel
+         *
+         * @throw BluetoothException when the platform does not support L2CAP channels
+         */
+        explicit L2CAPChannel(intptr_t socket, L2CAPChannelOptions options = {});
+
+        /**
+         * @brief Stops the subscriber thread and closes the channel.
+         */
+        ~L2CAPChannel();
+
+        L2CAPChannel(const L2CAPChannel &) = delete;
+        L2CAPChannel &operator=(const L2CAPChannel &) = delete;
+
+        /**
+         * @brief Returns the largest SDU the peer accepts.
+         *
+         * @return maximum size of a sent SDU in bytes
+         */
+        [[nodiscard]] size_t GetMaxSduSize() const noexcept;
+
+        /**
+         * @brief Checks whether the channel is still connected.
+         *
+         * @return false once the channel was closed by either side
+         */
+        [[nodiscard]] bool IsOpen() const noexcept;
+
+        /**
+         * @brief Sends a single SDU, waits while the peer has no credits left.
+         *
+         * @param sdu the SDU
+         *
+         * @throw BluetoothException when the SDU is larger than @link GetMaxSduSize @endlink, the peer granted no
+         * credits within @link L2CAPChannelOptions::sendTimeout @endlink or the channel is closed
+         */
+        void Send(const std::vector<uint8_t> &sdu);
+
+        /**
+         * @brief Waits for a single SDU.
+         *
+         * Should not be used together with @link Subscribe @endlink.
+         *
+         * @param sdu receives the SDU
+         * @param timeout how long to wait
+         *
+         * @return false when no SDU arrived in time or the channel got closed
+         */
+        bool Receive(std::vector<uint8_t> &sdu, std::chrono::milliseconds timeout);
+
+        /**
+         * @brief Subscribes to the SDUs received on this channel.
+         *
+         * @param listener listener to be called with every received SDU
+         *
+         * @return id of the listener, used for the @link Unsubscribe @endlink function
+         */
+        size_t Subscribe(std::function<void(std::vector<uint8_t>)> listener);
+
+        /**
+         * @brief Unsubscribes a listener previously registered with @link Subscribe @endlink.
+         *
+         * Waits for a call of the listeners that is in progress, so the listener is never called once this returns.
+         * Called from a listener it returns right away, the other listeners of that call still run.
+         *
+         * @param id id of the listener
+         */
+        void Unsubscribe(size_t id);
+
+        /**
+         * @brief Unsubscribes all listeners previously registered with @link Subscribe @endlink.
+         */
+        void UnsubscribeAll();
+
+        /**
+         * @brief Closes the channel.
+         */
+        void Close();
+
+        /**
+         * @brief Copies the traffic counters of the channel.
+         *
+         * @return copy of the counters
+         */
+        [[nodiscard]] L2CAPChannelMetrics Metrics() const noexcept;
+
+    private:
+        bool ReceiveForListeners(std::vector<uint8_t> &sdu);
+
+        intptr_t m_socket;
+        L2CAPChannelOptions m_options;
+        size_t m_maxSduSize;
+        std::atomic<bool> m_open { true };
+        std::mutex m_sendMutex {};
+
+        std::atomic<uint64_t> m_sdusSent { 0 };
+        std::atomic<uint64_t> m_bytesSent { 0 };
+        std::atomic<uint64_t> m_sdusReceived { 0 };
+        std::atomic<uint64_t> m_bytesReceived { 0 };
+        std::atomic<uint64_t> m_creditStalls { 0 };
+        std::atomic<int64_t> m_stalledTime { 0 };
+
+        IO::SubscriberThread m_subscribers { [this](std::vector<uint8_t> &sdu) { return ReceiveForListeners(sdu); } };
+    };
+}
+
+#endif // BLE_SERIAL_INCLUDE_L2CAP_HPP_
@@ -0,0 +1,154 @@
+#ifndef BLE_SERIAL_INCLUDE_LISTENERS_HPP_
+#define BLE_SERIAL_INCLUDE_LISTENERS_HPP_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace BLE_Serial::IO
+{
+    /**
+     * @brief Listeners of received data, called without holding a lock.
+     *
+     * The listeners are copied on write, so adding or removing one never waits for a slow listener and any number of
+     * threads may dispatch at once. A listener is never called once its removal returned, the removal waits for the
+     * dispatches that may still hold it. Listeners may add and remove listeners, such a removal does not wait.
+     *
+     * All methods are safe to call from multiple threads.
+     */
+    class ListenerSet
+    {
+    public:
+        using Listener = std::function<void(std::vector<uint8_t>)>;
+
+        /**
+         * @brief Adds a listener, it is called by the dispatches that start from now on.
+         *
+         * @param listener the listener
+         *
+         * @return id of the listener, used for @link Remove @endlink. Ids stay valid until the listener is removed.
+         */
+        size_t Add(Listener listener);
+
+        /**
+         * @brief Removes a listener and waits for the dispatches that may still call it.
+         *
+         * Called from a listener it returns right away, the other listeners of that dispatch still run and dispatches
+         * on other threads may still call the removed listener. Removing it again from outside of a listener waits for
+         * them.
+         *
+         * @param id id of the listener
+         */
+        void Remove(size_t id);
+
+        /**
+         * @brief Removes all listeners and waits for the dispatches that may still call them, like @link Remove @endlink.
+         */
+        void Clear();
+
+        /**
+         * @return true when there are no listeners
+         */
+        [[nodiscard]] bool Empty() const;
+
+        /**
+         * @brief Calls all listeners with the data.
+         *
+         * @param data the data
+         */
+        void Dispatch(const std::vector<uint8_t> &data);
+
+    private:
+        using Listeners = std::map<size_t, Listener>;
+
+        void WaitForDispatches(std::unique_lock<std::mutex> &lock);
+
+        mutable std::mutex m_mutex {};
+        std::condition_variable m_condition {};
+        size_t m_nextId = 0;
+        std::shared_ptr<const Listeners> m_listeners { std::make_shared<const Listeners>() };
+        uint64_t m_nextDispatch = 0;
+        std::map<uint64_t, std::thread::id> m_dispatches {};  ///< dispatches in progress and their threads, by start order
+    };
+
+    /**
+     * @brief Thread receiving data and dispatching it to a @link ListenerSet @endlink while there are listeners.
+     *
+     * The thread is started by the first @link Subscribe @endlink and stopped by @link UnsubscribeAll @endlink. Data is
+     * dispatched in the order it was received, a listener sees all data received after it subscribed.
+     *
+     * All methods are safe to call from multiple threads.
+     */
+    class SubscriberThread
+    {
+    public:
+        using Receive = std::function<bool(std::vector<uint8_t> &)>;
+
+        /**
+         * @brief Constructs a new subscriber thread, nothing is received until @link Subscribe @endlink is called.
+         *
+         * @param receive called from the thread to receive the next data, returns false when nothing arrived. It may
+         *                wait for more data with @link Idle @endlink, the wait ends early when the thread is stopped.
+         */
+        explicit SubscriberThread(Receive receive);
+
+        /**
+         * @brief Stops the thread.
+         */
+        ~SubscriberThread();
+
+        SubscriberThread(const SubscriberThread &) = delete;
+        SubscriberThread &operator=(const SubscriberThread &) = delete;
+
+        /**
+         * @brief Adds a listener and starts the thread if it is not running.
+         *
+         * @param listener listener to be called with every received data
+         *
+         * @return id of the listener, used for @link Unsubscribe @endlink
+         */
+        size_t Subscribe(ListenerSet::Listener listener);
+
+        /**
+         * @brief Removes a listener, see @link ListenerSet::Remove @endlink.
+         *
+         * @param id id of the listener
+         */
+        void Unsubscribe(size_t id);
+
+        /**
+         * @brief Removes all listeners and stops the thread.
+         *
+         * Called from a listener it returns right away, the thread exits once the listener returns. There is never more
+         * than one thread, subscribing again before it exited keeps it running or waits for it.
+         */
+        void UnsubscribeAll();
+
+        /**
+         * @brief Waits while nothing can be received, called by the receive function.
+         *
+         * @param timeout how long to wait at most
+         */
+        void Idle(std::chrono::milliseconds timeout);
+
+    private:
+        void Start();
+        void Run();
+
+        Receive m_receive;
+        ListenerSet m_listeners {};
+        std::mutex m_mutex {};
+        std::condition_variable m_condition {};
+        std::thread m_thread {};
+        bool m_exiting = false;
+        bool m_running = false;  ///< the thread has not yet returned, even when another thread is joining it
+    };
+}
+
+#endif // BLE_SERIAL_INCLUDE_LISTENERS_HPP_
@@ -0,0 +1,306 @@
+#ifndef BLE_SERIAL_INCLUDE_LOG_HPP_
+#define BLE_SERIAL_INCLUDE_LOG_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Asynchronous structured logging
+ */
+namespace BLE_Serial::Log
+{
+    /**
+     * @brief Importance of a log record.
+     */
+    enum class Severity : uint8_t
+    {
+        Debug = 0,    ///< per-packet events, only useful when diagnosing a problem
+        Info = 1,     ///< normal operation milestones (connected, bridge started)
+        Warning = 2,  ///< recoverable problems (failed writes that will be retried)
+        Error = 3,    ///< failures that need attention (dead links)
+        Off = 4       ///< used as a level only, disables all records
+    };
+
+    /**
+     * @brief How the records are written out.
+     */
+    enum class LogFormat
+    {
+        Text,  ///< one human readable line per record, fields as key=value
+        Json   ///< one JSON object per line (NDJSON)
+    };
+
+    /**
+     * @brief Settings of a @link Logger @endlink.
+     */
+    struct LoggerOptions
+    {
+        /**
+         * Records below this severity are discarded before anything is copied.
+         */
+        Severity level = Severity::Info;
+
+        /**
+         * Format of the output.
+         */
+        LogFormat format = LogFormat::Text;
+
+        /**
+         * File the records are appended to, empty for the standard error.
+         */
+        std::string file {};
+
+        /**
+         * Size of the staging buffer of every logging thread in bytes, records that do not fit are dropped and counted.
+         */
+        size_t bufferSize = 1 << 16;
+
+        /**
+         * How often the sink thread collects the staged records.
+         */
+        std::chrono::milliseconds flushInterval { 100 };
+    };
+
+    /**
+     * @brief Single key-value pair attached to a record.
+     *
+     * Fields only reference their values, they must be passed straight to the logger.
+     */
+    class LogField
+    {
+    public:
+        /**
+         * @brief Type of the value of a field.
+         */
+        enum class Type : uint8_t
+        {
+            Signed,
+            Unsigned,
+            Float,
+            Bool,
+            String
+        };
+
+        LogField(std::string_view key, std::string_view value) noexcept;
+
+        LogField(std::string_view key, const char *value) noexcept;
+
+        LogField(std::string_view key, const std::string &value) noexcept;
+
+        LogField(std::string_view key, bool value) noexcept;
+
+        LogField(std::string_view key, double value) noexcept;
+
+        template<std::signed_integral T>
+        LogField(std::string_view key, T value) noexcept
+                : m_key { key }, m_type { Type::Signed }, m_signed { static_cast<int64_t>(value) }
+        {
+        }
+
+        template<std::unsigned_integral T>
+        LogField(std::string_view key, T value) noexcept
+                : m_key { key }, m_type { Type::Unsigned }, m_unsigned { static_cast<uint64_t>(value) }
+        {
+        }
+
+    private:
+        friend class Logger;
+
+        std::string_view m_key;
+        Type m_type;
+        union
+        {
+            int64_t m_signed;
+            uint64_t m_unsigned;
+            double m_float;
+            bool m_bool;
+        };
+        std::string_view m_string {};
+    };
+
+    /**
+     * @brief Handle of a set of fields attached to every record logged with it, i.e. the name of a bridge.
+     *
+     * A default constructed context attaches nothing.
+     */
+    struct LogContext
+    {
+        uint32_t id = 0;
+    };
+
+    /**
+     * @brief Logger that keeps the cost of a record on the logging thread down to a copy into a staging buffer.
+     *
+     * Every thread gets its own single-producer ring buffer, so logging never takes a lock and never allocates once the
+     * buffer exists. A background sink thread regularly collects the records of all threads, orders them by time,
+     * formats them as text or JSON and writes them out in one go. When a thread logs faster than the sink drains, the
+     * records over the buffer size are dropped and reported later instead of slowing the thread down.
+     *
+     * Records are discarded by a single relaxed load when their severity is below the configured level, so per-packet
+     * debug records cost next to nothing when debug logging is off.
+     */
+    class Logger
+    {
+    public:
+        /**
+         * @brief Returns the process-wide logger.
+         *
+         * The logger discards everything until @link Start @endlink is called.
+         *
+         * @return the logger
+         */
+        static Logger &Global();
+
+        ~Logger();
+
+        Logger(const Logger &) = delete;
+        Logger &operator=(const Logger &) = delete;
+
+        /**
+         * @brief Opens the output and starts the sink thread.
+         *
+         * @param options settings of the logger
+         *
+         * @throw IO::IOException when the log file cannot be opened
+         */
+        void Start(LoggerOptions options);
+
+        /**
+         * @brief Writes out all the staged records and stops the sink thread.
+         */
+        void Stop();
+
+        /**
+         * @brief Checks whether records of the given severity are currently kept.
+         *
+         * @param severity severity to check
+         *
+         * @return true if such records would be written
+         */
+        [[nodiscard]] bool IsEnabled(Severity severity) const noexcept
+        {
+            return static_cast<uint8_t>(severity) >= m_level.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Changes the minimal severity of the kept records, takes effect only while the logger runs.
+         *
+         * @param level new level
+         */
+        void SetLevel(Severity level) noexcept;
+
+        /**
+         * @brief Registers a set of fields attached to every record logged with the returned context.
+         *
+         * Contexts live as long as the logger, they are meant to be created once per bridge or connection.
+         *
+         * @param fields fields of the context
+         *
+         * @return handle of the context
+         */
+        LogContext CreateContext(std::initializer_list<LogField> fields);
+
+        /**
+         * @brief Stages a record.
+         *
+         * @param severity severity of the record
+         * @param message the message
+         * @param fields additional fields of the record
+         * @param context context whose fields are attached to the record
+         */
+        void Write(Severity severity, std::string_view message, std::initializer_list<LogField> fields = {}, LogContext context = {}) noexcept;
+
+        /**
+         * @return number of records dropped because a staging buffer was full
+         */
+        [[nodiscard]] uint64_t Dropped() const noexcept;
+
+    private:
+        class ThreadBuffer;
+
+        /**
+         * Header of a staged record, the message and the fields stay in the collected bytes
+         */
+        struct Record
+        {
+            int64_t time;
+            Severity severity;
+            uint32_t context;
+            size_t offset;
+        };
+
+        Logger() = default;
+
+        ThreadBuffer *GetThreadBuffer();
+
+        void Run();
+
+        void Drain();
+
+        void FormatRecord(const Record &record);
+
+        std::atomic<uint8_t> m_level { static_cast<uint8_t>(Severity::Off) };
+        LoggerOptions m_options {};
+        std::FILE *m_output = nullptr;
+
+        std::mutex m_buffersMutex {};
+        std::vector<std::shared_ptr<ThreadBuffer>> m_buffers {};
+
+        std::mutex m_contextsMutex {};
+        std::vector<std::string> m_textContexts {};
+        std::vector<std::string> m_jsonContexts {};
+
+        std::atomic<uint64_t> m_dropped { 0 };
+        uint64_t m_reportedDropped = 0;
+        std::vector<uint8_t> m_scratch {};
+        std::vector<Record> m_records {};
+        std::string m_text {};
+        int64_t m_cachedSecond = -1;
+        char m_cachedClock[20] {};
+
+        std::thread m_thread {};
+        std::mutex m_mutex {};
+        std::condition_variable m_condition {};
+        bool m_exiting = false;
+    };
+
+    /**
+     * @brief Stages a record in the global logger if its severity is enabled.
+     *
+     * @param severity severity of the record
+     * @param message the message
+     * @param fields additional fields of the record
+     * @param context context whose fields are attached to the record
+     */
+    inline void Write(Severity severity, std::string_view message, std::initializer_list<LogField> fields = {}, LogContext context = {}) noexcept
+    {
+        auto &logger = Logger::Global();
+        if (logger.IsEnabled(severity)) {
+            logger.Write(severity, message, fields, context);
+        }
+    }
+
+    /**
+     * @brief Converts a severity name (debug, info, warning, error, off) into a @link Severity @endlink.
+     *
+     * @param name name of the severity
+     *
+     * @return the severity
+     *
+     * @throw std::invalid_argument when the name is unknown
+     */
+    Severity SeverityFromString(std::string_view name);
+}
+
+#endif // BLE_SERIAL_INCLUDE_LOG_HPP_
@@ -0,0 +1,151 @@
+#ifndef BLE_SERIAL_INCLUDE_MAPPED_FILE_HPP_
+#define BLE_SERIAL_INCLUDE_MAPPED_FILE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <string>
+
+/**
+ * @brief File and memory mapping API
+ */
+namespace BLE_Serial::IO
+{
+    /**
+     * @brief General exception for all kinds of file errors.
+     */
+    class IOException : std::exception
+    {
+    public:
+        /**
+         * @brief Construct new @link IOException @endlink
+         *
+         * @param message error details
+         */
+        explicit IOException(std::string message);
+
+        /**
+         * @return error details
+         */
+        [[nodiscard]]  const char *what() const noexcept override;
+
+    private:
+        std::string m_message;
+    };
+
+    /**
+     * @brief Represents a file mapped into memory.
+     */
+    class MappedFile
+    {
+    public:
+        /**
+         * @brief Maps an existing file for reading.
+         *
+         * Other processes may keep the file mapped for writing, their updates show up in the mapping.
+         *
+         * @param path path to the file
+         *
+         * @return the mapped file
+         *
+         * @throw IOException when the file cannot be opened or mapped
+         */
+        static MappedFile OpenReadOnly(const std::string &path);
+
+        /**
+         * @brief Creates (or truncates) a file of the given size and maps it for reading and writing.
+         *
+         * @param path path to the file
+         * @param size size of the file in bytes, must not be zero
+         *
+         * @return the mapped file
+         *
+         * @throw IOException when the file cannot be created or mapped
+         */
+        static MappedFile Create(const std::string &path, size_t size);
+
+        /**
+         * @brief Constructs an empty mapping.
+         */
+        MappedFile() noexcept = default;
+
+        /**
+         * @brief Unmaps the file.
+         */
+        ~MappedFile();
+
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+
+        MappedFile(MappedFile &&other) noexcept;
+        MappedFile &operator=(MappedFile &&other) noexcept;
+
+        /**
+         * @return pointer to the first byte of the mapping or nullptr if nothing is mapped
+         */
+        [[nodiscard]] uint8_t *Data() noexcept;
+
+        /**
+         * @return pointer to the first byte of the mapping or nullptr if nothing is mapped
+         */
+        [[nodiscard]] const uint8_t *Data() const noexcept;
+
+        /**
+         * @return size of the mapping in bytes
+         */
+        [[nodiscard]] size_t Size() const noexcept;
+
+        /**
+         * @return path of the mapped file
+         */
+        [[nodiscard]] const std::string &Path() const noexcept;
+
+        /**
+         * @brief Unmaps the file and closes it.
+         */
+        void Close() noexcept;
+
+        /**
+         * @brief Deletes a file from the disk.
+         *
+         * @param path path to the file
+         */
+        static void Remove(const std::string &path) noexcept;
+
+    private:
+        std::string m_path {};
+        uint8_t *m_data = nullptr;
+        size_t m_size = 0;
+    };
+
+    /**
+     * @brief Exclusive advisory lock on a file, shared by all processes that lock the same file.
+     *
+     * The lock only keeps out others taking it, it does not stop anybody from writing the file.
+     */
+    class FileLock
+    {
+    public:
+        /**
+         * @brief Opens the file, creating it when it is missing, and waits until the lock is held.
+         *
+         * @param path path to the file
+         *
+         * @throw IOException when the file cannot be opened or locked
+         */
+        explicit FileLock(const std::string &path);
+
+        /**
+         * @brief Releases the lock.
+         */
+        ~FileLock();
+
+        FileLock(const FileLock &) = delete;
+        FileLock &operator=(const FileLock &) = delete;
+
+    private:
+        intptr_t m_handle;
+    };
+}
+
+#endif // BLE_SERIAL_INCLUDE_MAPPED_FILE_HPP_
@@ -0,0 +1,426 @@
+#ifndef BLE_SERIAL_INCLUDE_MODBUS_HPP_
+#define BLE_SERIAL_INCLUDE_MODBUS_HPP_
+
+#include <ble_serial/bluetooth.hpp>
+#include <ble_serial/com.hpp>
+#include <ble_serial/log.hpp>
+#include <ble_serial/socket.hpp>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Modbus RTU and Modbus TCP gateway to devices behind BLE serial characteristics
+ */
+namespace BLE_Serial::Modbus
+{
+    /**
+     * @brief Exception codes the gateway answers with on behalf of a device.
+     */
+    enum class ModbusException : uint8_t
+    {
+        IllegalFunction = 0x01,
+        GatewayPathUnavailable = 0x0A,      ///< no link serves the unit or its queue is full
+        GatewayTargetFailedToRespond = 0x0B ///< the device did not answer in time
+    };
+
+    /**
+     * @brief Which side of an exchange an RTU frame comes from, the length of a frame depends on it.
+     */
+    enum class ModbusFrameKind
+    {
+        Request,
+        Response
+    };
+
+    /**
+     * @brief Calculates the CRC-16 of an RTU frame (polynomial 0xA001 reflected, initial value 0xFFFF).
+     *
+     * Table-driven, two bytes per step.
+     *
+     * @param data data to checksum
+     * @param size size of the data
+     * @param crc CRC of the preceding data, to checksum in parts
+     *
+     * @return the CRC, transmitted low byte first
+     */
+    uint16_t Crc16(const uint8_t *data, size_t size, uint16_t crc = 0xFFFF) noexcept;
+
+    /**
+     * @brief Appends the CRC of the frame to the frame.
+     *
+     * @param frame unit id and PDU
+     */
+    void AppendCrc(std::vector<uint8_t> &frame);
+
+    /**
+     * @brief Checks the CRC at the end of a frame.
+     *
+     * @param frame frame together with its CRC
+     * @param size size of the frame
+     *
+     * @return true if the frame is at least 4 bytes long and its CRC matches
+     */
+    bool CheckCrc(const uint8_t *frame, size_t size) noexcept;
+
+    /**
+     * @brief Works out the length of an RTU frame from its first bytes.
+     *
+     * @param frame beginning of the frame
+     * @param size how many bytes are available
+     * @param kind whether the frame is a request or a response
+     *
+     * @return the length including the CRC, zero when the function code does not define the length, or an empty
+     * optional when more bytes are needed to tell
+     */
+    std::optional<size_t> ExpectedFrameLength(const uint8_t *frame, size_t size, ModbusFrameKind kind) noexcept;
+
+    /**
+     * @brief Returns the silent interval that separates RTU frames at the given speed.
+     *
+     * @param baud bits per second
+     *
+     * @return 3.5 character times, but at least 1750 us as the specification asks for above 19200 baud
+     */
+    std::chrono::microseconds InterFrameDelay(unsigned int baud) noexcept;
+
+    /**
+     * @brief Cuts a byte stream into RTU frames.
+     *
+     * A frame ends once its length, known from the function code, is reached. Frames of functions without a defined
+     * length end at the first silent interval or as soon as their CRC matches. Frames failing the CRC are dropped.
+     *
+     * Not thread-safe, the owner serializes the calls.
+     */
+    class RtuFramer
+    {
+    public:
+        /**
+         * @brief Constructs a new framer.
+         *
+         * @param kind whether requests or responses are framed
+         * @param interFrameDelay silent interval after which a partial frame is discarded, zero disables timing
+         * @param listener receives every complete frame, CRC included
+         */
+        RtuFramer(ModbusFrameKind kind, std::chrono::microseconds interFrameDelay, std::function<void(std::vector<uint8_t>)> listener);
+
+        /**
+         * @brief Adds received bytes.
+         *
+         * @param data received bytes
+         * @param size number of bytes
+         * @param now time the bytes were received
+         */
+        void Feed(const uint8_t *data, size_t size, std::chrono::steady_clock::time_point now);
+
+        /**
+         * @brief Discards a partial frame.
+         */
+        void Reset() noexcept;
+
+        /**
+         * @brief Returns how many frames were dropped.
+         *
+         * @return number of frames that failed the CRC or overran the maximum frame size
+         */
+        [[nodiscard]] uint64_t GetDroppedFrames() const noexcept;
+
+    private:
+        ModbusFrameKind m_kind;
+        std::chrono::microseconds m_interFrameDelay;
+        std::function<void(std::vector<uint8_t>)> m_listener;
+        std::vector<uint8_t> m_buffer {};
+        std::chrono::steady_clock::time_point m_lastByte {};
+        uint64_t m_dropped = 0;
+    };
+
+    /**
+     * @brief Settings of a @link ModbusGateway @endlink.
+     */
+    struct ModbusGatewayOptions
+    {
+        /**
+         * How long a device has to answer a request.
+         */
+        std::chrono::milliseconds responseTimeout { 1000 };
+
+        /**
+         * How many times a request that was not answered is sent again.
+         */
+        unsigned int retries = 0;
+
+        /**
+         * How many requests may wait per link, further ones are rejected right away.
+         */
+        size_t maxPending = 64;
+
+        /**
+         * Context attached to the log records of the gateway.
+         */
+        Log::LogContext logContext {};
+    };
+
+    /**
+     * @brief Counters of a @link ModbusGateway @endlink.
+     */
+    struct ModbusGatewayMetrics
+    {
+        uint64_t requests;                      ///< requests submitted
+        uint64_t responses;                     ///< responses received from the devices
+        uint64_t exceptions;                    ///< responses that carried an exception code
+        uint64_t timeouts;                      ///< requests the devices did not answer, retries included
+        uint64_t rejected;                      ///< requests without a link or over the queue limit
+        uint64_t droppedFrames;                 ///< response frames that failed the CRC
+        std::chrono::microseconds averageLatency; ///< average time from submitting a request to its response
+    };
+
+    /**
+     * @brief Routes Modbus requests to devices behind BLE serial characteristics.
+     *
+     * Every link is a characteristic that carries RTU frames in both directions and serves a set of unit ids. RTU has
+     * no transaction ids, so a link carries one request at a time, but every link has its own queue and thread: while
+     * one device answers, the requests to the others are already on their way. Requests are written without response
+     * where the characteristic allows it, so a transaction costs a single round trip.
+     *
+     * A request that cannot be delivered is answered by the gateway with an exception response, as a Modbus gateway
+     * should, so the master never waits longer than the response timeout.
+     */
+    class ModbusGateway
+    {
+    public:
+        /**
+         * @brief Called with the response PDU, empty for broadcasts that are not answered.
+         */
+        using Completion = std::function<void(std::vector<uint8_t>)>;
+
+        /**
+         * @brief Constructs a new gateway, the gateway does nothing until @link Start @endlink is called.
+         *
+         * @param options settings of the gateway
+         */
+        explicit ModbusGateway(ModbusGatewayOptions options = {});
+
+        /**
+         * @brief Stops the gateway.
+         */
+        ~ModbusGateway();
+
+        ModbusGateway(const ModbusGateway &) = delete;
+        ModbusGateway &operator=(const ModbusGateway &) = delete;
+
+        /**
+         * @brief Adds a link, must be called before @link Start @endlink.
+         *
+         * @param characteristic characteristic carrying the RTU frames, must outlive the gateway
+         * @param unitIds unit ids served by the link, empty makes it the link of all the unit ids no other link serves
+         */
+        void AddLink(Bluetooth::IBluetoothGattCharacteristic &characteristic, std::vector<uint8_t> unitIds);
+
+        /**
+         * @brief Subscribes to all links and starts their threads.
+         *
+         * @throw BluetoothException when subscribing to a characteristic fails
+         */
+        void Start();
+
+        /**
+         * @brief Stops the threads, waiting requests are answered with an exception.
+         */
+        void Stop();
+
+        /**
+         * @brief Queues a request, returns right away.
+         *
+         * @param unitId unit id of the device, 0 broadcasts to the devices of every link
+         * @param pdu function code and data
+         * @param completion called with the response PDU from the link's thread, or right away when the request is
+         * rejected. A broadcast completes once it was written to every link, with an empty PDU or the exception of
+         * the first link that failed.
+         */
+        void Submit(uint8_t unitId, std::vector<uint8_t> pdu, Completion completion);
+
+        /**
+         * @brief Copies the counters of the gateway.
+         *
+         * @return copy of the counters
+         */
+        [[nodiscard]] ModbusGatewayMetrics Metrics() const noexcept;
+
+    private:
+        struct Request
+        {
+            uint8_t unitId;
+            std::vector<uint8_t> pdu;
+            Completion completion;
+            std::chrono::steady_clock::time_point submitted;
+        };
+
+        struct Link
+        {
+            Bluetooth::IBluetoothGattCharacteristic *characteristic;
+            Bluetooth::GattWriteMode writeMode;
+            std::deque<Request> queue {};
+            std::optional<RtuFramer> framer {};
+            std::optional<std::vector<uint8_t>> response {};
+            size_t subscription = 0;
+            std::thread thread {};
+        };
+
+        void Broadcast(std::vector<uint8_t> pdu, Completion completion);
+
+        void Serve(Link &link);
+
+        void Complete(Request &request, std::vector<uint8_t> pdu);
+
+        static std::vector<uint8_t> ExceptionResponse(const std::vector<uint8_t> &pdu, ModbusException code);
+
+        ModbusGatewayOptions m_options;
+        std::vector<std::unique_ptr<Link>> m_links {};
+        std::array<Link *, 256> m_routes {};
+        Link *m_defaultLink = nullptr;
+
+        mutable std::mutex m_mutex {};
+        std::condition_variable m_condition {};
+        bool m_running = false;
+        bool m_exiting = false;
+
+        std::atomic<uint64_t> m_requests { 0 };
+        std::atomic<uint64_t> m_responses { 0 };
+        std::atomic<uint64_t> m_exceptions { 0 };
+        std::atomic<uint64_t> m_timeouts { 0 };
+        std::atomic<uint64_t> m_rejected { 0 };
+        std::atomic<uint64_t> m_totalLatency { 0 };
+    };
+
+    /**
+     * @brief Serves a Modbus RTU master on a COM port through a @link ModbusGateway @endlink.
+     *
+     * The port is read with a 1 ms refresh rate while the server runs, so requests are picked up right away instead of
+     * once per default polling interval.
+     */
+    class ModbusRtuServer
+    {
+    public:
+        /**
+         * @brief Constructs a new server, the server does nothing until @link Start @endlink is called.
+         *
+         * @param gateway gateway the requests go to, must outlive the server
+         * @param port port the master is connected to, must outlive the server
+         * @param baud speed of the port, for the silent interval between frames
+         */
+        ModbusRtuServer(ModbusGateway &gateway, COM::COMPort &port, unsigned int baud);
+
+        /**
+         * @brief Stops the server.
+         */
+        ~ModbusRtuServer();
+
+        /**
+         * @brief Subscribes to the port.
+         */
+        void Start();
+
+        /**
+         * @brief Unsubscribes from the port and restores its refresh rate.
+         */
+        void Stop();
+
+        /**
+         * @brief Returns how many request frames were dropped.
+         *
+         * @return number of frames that failed the CRC
+         */
+        [[nodiscard]] uint64_t GetDroppedFrames() const noexcept;
+
+    private:
+        ModbusGateway &m_gateway;
+        COM::COMPort &m_port;
+        RtuFramer m_framer;
+        mutable std::mutex m_mutex {};
+        std::chrono::milliseconds m_previousRefreshRate { 0 };
+        bool m_running = false;
+        size_t m_subscription = 0;
+    };
+
+    /**
+     * @brief Serves Modbus TCP clients through a @link ModbusGateway @endlink.
+     *
+     * Clients may send further requests without waiting for the previous responses. Each request goes to the gateway
+     * as soon as it is read, so requests to unit ids on different links are answered in parallel, and every response
+     * carries the transaction id of its request.
+     */
+    class ModbusTcpServer
+    {
+    public:
+        /**
+         * @brief Constructs a new server and starts listening.
+         *
+         * @param gateway gateway the requests go to, must outlive the server
+         * @param port TCP port, 502 is the standard one
+         * @param bindAddress local address to listen on
+         *
+         * @throw IOException when the port cannot be bound
+         */
+        ModbusTcpServer(ModbusGateway &gateway, uint16_t port, const std::string &bindAddress = "0.0.0.0");
+
+        /**
+         * @brief Stops the server.
+         */
+        ~ModbusTcpServer();
+
+        /**
+         * @brief Starts accepting clients.
+         */
+        void Start();
+
+        /**
+         * @brief Disconnects all clients and stops accepting new ones.
+         */
+        void Stop();
+
+        /**
+         * @brief Returns the port the server listens on.
+         *
+         * @return the port number
+         */
+        [[nodiscard]] uint16_t GetPort() const noexcept;
+
+        /**
+         * @brief Returns how many clients are connected.
+         *
+         * @return number of clients
+         */
+        [[nodiscard]] size_t GetClientCount() const noexcept;
+
+    private:
+        struct Client
+        {
+            std::shared_ptr<IO::TcpStream> stream;
+            std::thread thread {};
+            std::atomic<bool> finished { false };
+        };
+
+        void AcceptClients();
+
+        void ServeClient(Client &client);
+
+        ModbusGateway &m_gateway;
+        IO::TcpListener m_listener;
+        std::thread m_acceptThread {};
+        mutable std::mutex m_mutex {};
+        std::vector<std::unique_ptr<Client>> m_clients {};
+        std::atomic<bool> m_running { false };
+    };
+}
+
+#endif // BLE_SERIAL_INCLUDE_MODBUS_HPP_
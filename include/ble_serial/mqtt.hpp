@@ -0,0 +1,258 @@
+#ifndef BLE_SERIAL_INCLUDE_MQTT_HPP_
+#define BLE_SERIAL_INCLUDE_MQTT_HPP_
+
+#include <ble_serial/bluetooth.hpp>
+#include <ble_serial/log.hpp>
+#include <ble_serial/socket.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Publishing to MQTT brokers
+ */
+namespace BLE_Serial::Mqtt
+{
+    /**
+     * @brief Delivery guarantee of the published messages.
+     */
+    enum class MqttQoS : uint8_t
+    {
+        AtMostOnce = 0,  ///< fire and forget
+        AtLeastOnce = 1  ///< kept until the broker acknowledges it, sent again after a reconnection
+    };
+
+    /**
+     * @brief Settings of a @link MqttPublisher @endlink.
+     */
+    struct MqttOptions
+    {
+        /**
+         * Host name or address of the broker.
+         */
+        std::string host {};
+
+        /**
+         * Port of the broker.
+         */
+        uint16_t port = 1883;
+
+        /**
+         * Client identifier, unique per broker.
+         */
+        std::string clientId = "ble_serial";
+
+        /**
+         * User name, none is sent when empty.
+         */
+        std::optional<std::string> username {};
+
+        /**
+         * Password, none is sent when empty.
+         */
+        std::optional<std::string> password {};
+
+        /**
+         * Delivery guarantee of all messages.
+         */
+        MqttQoS qos = MqttQoS::AtMostOnce;
+
+        /**
+         * How many QoS 1 messages may wait for their acknowledgement at once.
+         */
+        size_t inFlightWindow = 16;
+
+        /**
+         * How many messages may be queued before @link MqttPublisher::Publish @endlink starts to wait.
+         */
+        size_t queueLimit = 1024;
+
+        /**
+         * How long @link MqttPublisher::Publish @endlink waits for room in the queue before it drops the message.
+         */
+        std::chrono::milliseconds publishTimeout { 1000 };
+
+        /**
+         * How many bytes of queued messages are coalesced into a single socket write at most.
+         */
+        size_t batchBytes = 16 * 1024;
+
+        /**
+         * Keep alive interval announced to the broker, a ping is sent after half of it without any other traffic.
+         */
+        std::chrono::seconds keepAlive { 30 };
+
+        /**
+         * How long connecting to the broker may take.
+         */
+        std::chrono::milliseconds connectTimeout { 5000 };
+
+        /**
+         * How long to wait before connecting again after the connection to the broker was lost.
+         */
+        std::chrono::milliseconds reconnectDelay { 1000 };
+
+        /**
+         * Context attached to the log records of the publisher.
+         */
+        Log::LogContext logContext {};
+    };
+
+    /**
+     * @brief Counters of a @link MqttPublisher @endlink.
+     */
+    struct MqttMetrics
+    {
+        uint64_t published;      ///< messages written to the broker, retransmissions excluded
+        uint64_t acknowledged;   ///< QoS 1 messages the broker acknowledged
+        uint64_t retransmitted;  ///< QoS 1 messages sent again after a reconnection
+        uint64_t dropped;        ///< messages dropped because the queue stayed full
+        uint64_t flushes;        ///< socket writes, every one carrying a batch of messages
+        uint64_t bytesSent;      ///< bytes written to the broker
+        uint64_t reconnects;     ///< connections re-established after a loss
+        size_t queued;           ///< messages waiting to be sent
+        size_t inFlight;         ///< QoS 1 messages waiting for their acknowledgement
+        bool connected;          ///< whether the broker is connected right now
+    };
+
+    /**
+     * @brief Expands a topic template for a single characteristic.
+     *
+     * The placeholders {address}, {service} and {characteristic} are replaced with the address of the device and the
+     * 16-bit ids of the service and the characteristic in hexadecimal, i.e. "ble/{address}/{characteristic}" becomes
+     * "ble/AA:BB:CC:DD:EE:FF/FFE1".
+     *
+     * @param pattern the template
+     * @param address address of the device
+     * @param serviceId service of the characteristic
+     * @param characteristicId the characteristic
+     *
+     * @return the topic
+     *
+     * @throw std::invalid_argument when the template holds an unknown placeholder or the topic contains a wildcard
+     */
+    std::string FormatTopic(const std::string &pattern, Bluetooth::BluetoothAddress address, Bluetooth::GattRegisteredService serviceId,
+                            Bluetooth::GattRegisteredCharacteristic characteristicId);
+
+    /**
+     * @brief MQTT 3.1.1 client that only publishes.
+     *
+     * @link Publish @endlink queues a message and returns, a writer thread encodes everything that is queued into a
+     * single buffer and writes it with one socket write, so a burst of notifications costs one system call instead of
+     * one per message. QoS 1 messages stay in flight until the broker acknowledges them, at most
+     * @link MqttOptions::inFlightWindow @endlink at once; a full window stops the writer, a full queue makes
+     * @link Publish @endlink wait, so a slow broker slows the producer down instead of growing the memory without
+     * bound.
+     *
+     * A lost connection is re-established in the background, queued messages wait for it and the QoS 1 messages that
+     * were not acknowledged are sent again.
+     */
+    class MqttPublisher
+    {
+    public:
+        /**
+         * @brief Constructs a new publisher, nothing is connected until @link Start @endlink is called.
+         *
+         * @param options settings of the publisher
+         */
+        explicit MqttPublisher(MqttOptions options);
+
+        /**
+         * @brief Stops the publisher.
+         */
+        ~MqttPublisher();
+
+        MqttPublisher(const MqttPublisher &) = delete;
+        MqttPublisher &operator=(const MqttPublisher &) = delete;
+
+        /**
+         * @brief Connects to the broker and starts the writer and reader threads.
+         *
+         * @throw IOException when the broker cannot be reached or refuses the connection
+         */
+        void Start();
+
+        /**
+         * @brief Sends what is queued, waits a moment for the outstanding acknowledgements and disconnects.
+         */
+        void Stop();
+
+        /**
+         * @brief Queues a message, waiting up to @link MqttOptions::publishTimeout @endlink while the queue is full.
+         *
+         * May be called from multiple threads at once.
+         *
+         * @param topic topic of the message
+         * @param payload payload of the message
+         *
+         * @return false when the message was dropped because the queue stayed full or the publisher is stopped
+         */
+        bool Publish(std::string topic, std::vector<uint8_t> payload);
+
+        /**
+         * @brief Copies the counters of the publisher.
+         *
+         * @return copy of the counters
+         */
+        [[nodiscard]] MqttMetrics Metrics() const noexcept;
+
+    private:
+        struct Message
+        {
+            std::string topic;
+            std::vector<uint8_t> payload;
+        };
+
+        struct InFlightMessage
+        {
+            uint16_t packetId;
+            std::vector<uint8_t> packet;
+        };
+
+        std::shared_ptr<IO::TcpStream> Connect();
+
+        void WriteMessages();
+
+        void ReadAcknowledgements();
+
+        void ConnectionLost(const std::shared_ptr<IO::TcpStream> &stream, const std::string &reason);
+
+        uint16_t NextPacketId();
+
+        MqttOptions m_options;
+
+        mutable std::mutex m_mutex {};
+        std::condition_variable m_condition {};
+        std::deque<Message> m_queue {};
+        std::deque<InFlightMessage> m_inFlight {};
+        std::shared_ptr<IO::TcpStream> m_stream {};
+        uint64_t m_generation = 0;
+        std::chrono::steady_clock::time_point m_drainDeadline {};
+        uint16_t m_nextPacketId = 1;
+        bool m_running = false;
+        bool m_exiting = false;
+        std::atomic<bool> m_readerExiting { false };
+
+        std::thread m_writerThread {};
+        std::thread m_readerThread {};
+
+        uint64_t m_published = 0;
+        uint64_t m_acknowledged = 0;
+        uint64_t m_retransmitted = 0;
+        uint64_t m_dropped = 0;
+        uint64_t m_flushes = 0;
+        uint64_t m_bytesSent = 0;
+        uint64_t m_reconnects = 0;
+    };
+}
+
+#endif // BLE_SERIAL_INCLUDE_MQTT_HPP_
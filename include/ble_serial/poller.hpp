@@ -0,0 +1,143 @@
+#ifndef BLE_SERIAL_INCLUDE_POLLER_HPP_
+#define BLE_SERIAL_INCLUDE_POLLER_HPP_
+
+#include <ble_serial/bluetooth.hpp>
+#include <ble_serial/cpu_usage.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace BLE_Serial::Bridge
+{
+    /**
+     * @brief Settings of a @link Poller @endlink.
+     */
+    struct PollingOptions
+    {
+        /**
+         * Whether characteristics should be polled even when they support notifications.
+         */
+        bool force = false;
+
+        /**
+         * Shortest interval between two reads of a characteristic, used right after its value changed.
+         */
+        std::chrono::milliseconds minInterval { 50 };
+
+        /**
+         * Longest interval between two reads of a characteristic, reached when its value is stable.
+         */
+        std::chrono::milliseconds maxInterval { 2000 };
+
+        /**
+         * By how much the interval grows every time a read returns an unchanged value.
+         */
+        double backoff = 1.5;
+
+        /**
+         * How long to wait for the reads of a round before the unfinished ones are considered failed. A read that
+         * timed out is not issued again until it finished.
+         */
+        std::chrono::milliseconds readTimeout { 1000 };
+    };
+
+    /**
+     * @brief Point-in-time state of a @link Poller @endlink.
+     */
+    struct PollingMetrics
+    {
+        uint64_t reads;      ///< number of finished reads
+        uint64_t changes;    ///< number of reads that returned a changed value
+        uint64_t errors;     ///< number of failed reads
+    };
+
+    /**
+     * @brief Periodically reads characteristics that cannot notify and reports their changed values.
+     *
+     * Every characteristic has its own adaptive interval: it drops to @link PollingOptions::minInterval @endlink when the
+     * value changes and grows by @link PollingOptions::backoff @endlink up to @link PollingOptions::maxInterval @endlink
+     * while it is stable. All characteristics that are due at the same time are read in a single pipelined round with
+     * @link Bluetooth::IBluetoothGattCharacteristic::ReadAsync @endlink. The reads bypass the value caches, the
+     * caches are left to the reads of the user.
+     */
+    class Poller
+    {
+    public:
+        /**
+         * @brief Constructs a new poller, nothing is read until @link Start @endlink is called.
+         *
+         * @param options settings of the poller
+         * @param usage account charged with all the CPU time of the poller thread, must outlive the poller
+         * @param listener listener receiving the index of the characteristic (in the order of
+         *                 @link AddCharacteristic @endlink calls) and its new value, called from the poller thread
+         */
+        Poller(PollingOptions options, CpuUsage &usage, std::function<void(size_t, std::vector<uint8_t> &&)> listener);
+
+        /**
+         * @brief Stops the poller.
+         */
+        ~Poller();
+
+        Poller(const Poller &) = delete;
+        Poller &operator=(const Poller &) = delete;
+
+        /**
+         * @brief Adds a characteristic to be polled, must be called before @link Start @endlink.
+         *
+         * @param characteristic characteristic to poll, must outlive the poller
+         *
+         * @return index of the characteristic
+         */
+        size_t AddCharacteristic(Bluetooth::IBluetoothGattCharacteristic &characteristic);
+
+        /**
+         * @brief Starts the poller thread.
+         */
+        void Start();
+
+        /**
+         * @brief Stops the poller thread.
+         */
+        void Stop();
+
+        /**
+         * @return the current state of the poller
+         */
+        [[nodiscard]] PollingMetrics Metrics() const noexcept;
+
+    private:
+        struct Target
+        {
+            Bluetooth::IBluetoothGattCharacteristic *characteristic;
+            std::vector<uint8_t> lastValue;
+            bool hasValue;
+            std::chrono::milliseconds interval;
+            std::chrono::steady_clock::time_point due;
+            std::future<std::vector<uint8_t>> read;  ///< read in flight, kept past its round when it timed out
+        };
+
+        void Run();
+
+        PollingOptions m_options;
+        CpuUsage &m_usage;
+        std::function<void(size_t, std::vector<uint8_t> &&)> m_listener;
+        std::vector<Target> m_targets {};
+
+        std::thread m_thread {};
+        std::mutex m_mutex {};
+        std::condition_variable m_condition {};
+        bool m_exiting = false;
+
+        std::atomic<uint64_t> m_reads { 0 };
+        std::atomic<uint64_t> m_changes { 0 };
+        std::atomic<uint64_t> m_errors { 0 };
+    };
+}
+
+#endif // BLE_SERIAL_INCLUDE_POLLER_HPP_
@@ -0,0 +1,186 @@
+#ifndef BLE_SERIAL_INCLUDE_SCHEDULER_HPP_
+#define BLE_SERIAL_INCLUDE_SCHEDULER_HPP_
+
+#include <ble_serial/spill_queue.hpp>
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace BLE_Serial::Bridge
+{
+    /**
+     * @brief Represents a priority class of the data written to a characteristic.
+     */
+    enum class Priority : uint8_t
+    {
+        /**
+         * Short interactive frames (commands, acknowledgements) that should never wait behind bulk data.
+         */
+        Control = 0,
+
+        /**
+         * Everything else.
+         */
+        Bulk = 1
+    };
+
+    /**
+     * Number of @link Priority @endlink classes.
+     */
+    constexpr size_t PriorityCount = 2;
+
+    /**
+     * @brief Represents how the @link WriteScheduler @endlink chooses between the priority lanes.
+     */
+    enum class SchedulingPolicy
+    {
+        /**
+         * Bulk packets are sent only when no control packet is waiting.
+         */
+        StrictPriority,
+
+        /**
+         * Lanes take turns according to their weights, so bulk data is never starved completely.
+         */
+        Weighted
+    };
+
+    /**
+     * @brief Assigns a @link Priority @endlink to frames that match it.
+     */
+    struct PriorityRule
+    {
+        /**
+         * Bytes the frame must start with, an empty prefix matches every frame.
+         */
+        std::vector<uint8_t> prefix {};
+
+        /**
+         * Maximum length of a matching frame, zero means any length.
+         */
+        size_t maxLength = 0;
+
+        /**
+         * Priority of the matching frames.
+         */
+        Priority priority = Priority::Control;
+    };
+
+    /**
+     * @brief Settings of a @link WriteScheduler @endlink.
+     */
+    struct SchedulerOptions
+    {
+        /**
+         * How to choose between the lanes.
+         */
+        SchedulingPolicy policy = SchedulingPolicy::StrictPriority;
+
+        /**
+         * How many packets each lane may send in a row under @link SchedulingPolicy::Weighted @endlink, indexed by @link Priority @endlink.
+         */
+        std::array<unsigned int, PriorityCount> weights { 4, 1 };
+
+        /**
+         * Rules used to classify frames, the first matching rule wins.
+         */
+        std::vector<PriorityRule> rules {};
+
+        /**
+         * Priority of frames that match no rule.
+         */
+        Priority defaultPriority = Priority::Bulk;
+
+        /**
+         * Size of the packets that frames are split into, so that a waiting control frame preempts a long bulk frame
+         * at the next packet boundary. Zero keeps frames intact.
+         */
+        size_t packetSize = 0;
+    };
+
+    /**
+     * @brief Priority lanes in front of characteristic writes.
+     *
+     * Every frame is classified with @link SchedulerOptions::rules @endlink, split into packets and queued on the lane
+     * of its priority. Each lane is a separate @link SpillQueue @endlink with an even share of the memory and disk
+     * limits.
+     *
+     * The scheduler is safe to use from multiple threads.
+     */
+    class WriteScheduler
+    {
+    public:
+        /**
+         * @brief Constructs a new scheduler with empty lanes.
+         *
+         * @param options settings of the scheduler
+         * @param queueOptions settings of the lanes, their memory and disk limits are split evenly between the lanes
+         */
+        WriteScheduler(SchedulerOptions options, const SpillQueueOptions &queueOptions);
+
+        /**
+         * @brief Classifies a frame and queues its packets.
+         *
+         * @param frame frame to queue
+         *
+         * @return false if any of the packets was dropped
+         *
+         * @throw IOException when a segment file cannot be created
+         */
+        bool Push(const std::vector<uint8_t> &frame);
+
+        /**
+         * @brief Classifies a frame without queueing it.
+         *
+         * @param frame frame to classify
+         *
+         * @return priority of the frame
+         */
+        [[nodiscard]] Priority Classify(const std::vector<uint8_t> &frame) const noexcept;
+
+        /**
+         * @brief Copies the packet that should be sent next without removing it.
+         *
+         * @param output vector that will be overwritten with the packet, its capacity is reused
+         *
+         * @return lane of the packet, to be passed to @link Pop @endlink, or an empty optional if all lanes are empty
+         */
+        std::optional<Priority> Front(std::vector<uint8_t> &output);
+
+        /**
+         * @brief Removes the first packet of a lane.
+         *
+         * @param lane lane returned by @link Front @endlink
+         */
+        void Pop(Priority lane);
+
+        /**
+         * @return whether all lanes are empty
+         */
+        [[nodiscard]] bool Empty();
+
+        /**
+         * @param lane lane to inspect
+         *
+         * @return the current state of the lane
+         */
+        [[nodiscard]] SpillQueueMetrics Metrics(Priority lane);
+
+        /**
+         * @return the combined state of all lanes
+         */
+        [[nodiscard]] SpillQueueMetrics Metrics();
+
+    private:
+        SchedulerOptions m_options;
+        std::array<SpillQueue, PriorityCount> m_lanes;
+        std::mutex m_mutex {};
+        size_t m_currentLane = 0;
+        unsigned int m_credits = 0;
+    };
+}
+
+#endif // BLE_SERIAL_INCLUDE_SCHEDULER_HPP_
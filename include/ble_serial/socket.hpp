@@ -0,0 +1,160 @@
+#ifndef BLE_SERIAL_INCLUDE_SOCKET_HPP_
+#define BLE_SERIAL_INCLUDE_SOCKET_HPP_
+
+#include <ble_serial/mapped_file.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace BLE_Serial::IO
+{
+    /**
+     * @brief Connected TCP socket.
+     *
+     * Nagle's algorithm is disabled, small request/response exchanges are sent right away.
+     */
+    class TcpStream
+    {
+    public:
+        /**
+         * @brief Connects to a remote host.
+         *
+         * @param host host name or address
+         * @param port port number
+         * @param timeout how long the connection attempt may take
+         *
+         * @return the connected stream
+         *
+         * @throw IOException when the host cannot be resolved or the connection fails
+         */
+        static std::unique_ptr<TcpStream> Connect(const std::string &host, uint16_t port, std::chrono::milliseconds timeout);
+
+        /**
+         * @brief Takes over an already connected socket.
+         *
+         * @param socket native socket handle
+         */
+        explicit TcpStream(intptr_t socket);
+
+        /**
+         * @brief Closes the socket.
+         */
+        ~TcpStream();
+
+        TcpStream(const TcpStream &) = delete;
+        TcpStream &operator=(const TcpStream &) = delete;
+
+        /**
+         * @brief Sends all the data, may be called from multiple threads at once.
+         *
+         * @param data data to be sent
+         * @param size size of the data
+         *
+         * @throw IOException when the stream is closed or sending fails
+         */
+        void Send(const uint8_t *data, size_t size);
+
+        /**
+         * @brief Sends all the data, may be called from multiple threads at once.
+         *
+         * @param data data to be sent
+         *
+         * @throw IOException when the stream is closed or sending fails
+         */
+        void Send(const std::vector<uint8_t> &data);
+
+        /**
+         * @brief Receives whatever data is available, waiting at most the timeout for some to arrive.
+         *
+         * @param buffer buffer where the data will be stored
+         * @param size size of the buffer
+         * @param timeout how long to wait for data
+         *
+         * @return number of bytes received, zero on a timeout or when the stream was closed (see @link IsOpen @endlink)
+         */
+        size_t Receive(uint8_t *buffer, size_t size, std::chrono::milliseconds timeout);
+
+        /**
+         * @brief Checks whether the stream is still open.
+         *
+         * @return false once the peer closed the stream, an operation failed or @link Close @endlink was called
+         */
+        [[nodiscard]] bool IsOpen() const noexcept;
+
+        /**
+         * @brief Shuts the stream down, a pending @link Receive @endlink returns right away.
+         */
+        void Close();
+
+        /**
+         * @brief Returns the address of the peer.
+         *
+         * @return address and port of the peer, i.e. "192.168.1.10:50112"
+         */
+        [[nodiscard]] const std::string &GetPeerName() const noexcept;
+
+    private:
+        intptr_t m_socket;
+        std::string m_peerName {};
+        std::atomic<bool> m_open { true };
+        std::mutex m_sendMutex {};
+    };
+
+    /**
+     * @brief Listening TCP socket.
+     */
+    class TcpListener
+    {
+    public:
+        /**
+         * @brief Starts listening.
+         *
+         * @param port port number, zero picks a free one
+         * @param bindAddress local address to listen on
+         *
+         * @throw IOException when the socket cannot be bound
+         */
+        explicit TcpListener(uint16_t port, const std::string &bindAddress = "0.0.0.0");
+
+        /**
+         * @brief Stops listening.
+         */
+        ~TcpListener();
+
+        TcpListener(const TcpListener &) = delete;
+        TcpListener &operator=(const TcpListener &) = delete;
+
+        /**
+         * @brief Waits for a connection.
+         *
+         * @param timeout how long to wait
+         *
+         * @return the accepted stream, nullptr on a timeout or once the listener is closed
+         */
+        std::unique_ptr<TcpStream> Accept(std::chrono::milliseconds timeout);
+
+        /**
+         * @brief Returns the port the listener is bound to.
+         *
+         * @return the port number
+         */
+        [[nodiscard]] uint16_t GetPort() const noexcept;
+
+        /**
+         * @brief Stops accepting connections.
+         */
+        void Close();
+
+    private:
+        intptr_t m_socket;
+        uint16_t m_port = 0;
+        std::atomic<bool> m_open { true };
+    };
+}
+
+#endif // BLE_SERIAL_INCLUDE_SOCKET_HPP_
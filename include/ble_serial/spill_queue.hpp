@@ -0,0 +1,149 @@
+#ifndef BLE_SERIAL_INCLUDE_SPILL_QUEUE_HPP_
+#define BLE_SERIAL_INCLUDE_SPILL_QUEUE_HPP_
+
+#include <ble_serial/mapped_file.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace BLE_Serial::Bridge
+{
+    /**
+     * @brief Settings of a @link SpillQueue @endlink.
+     */
+    struct SpillQueueOptions
+    {
+        /**
+         * How many payload bytes can be kept in memory before the queue starts spilling to the disk.
+         */
+        size_t memoryLimit = 64 * 1024;
+
+        /**
+         * Directory where the segment files are created, an empty string disables spilling and frames that do not
+         * fit in memory are dropped.
+         */
+        std::string spillDirectory {};
+
+        /**
+         * Size of a single segment file in bytes.
+         */
+        size_t segmentSize = 4 * 1024 * 1024;
+
+        /**
+         * How many bytes can be spilled to the disk at most, zero means no limit.
+         */
+        size_t diskLimit = 0;
+    };
+
+    /**
+     * @brief Point-in-time state of a @link SpillQueue @endlink.
+     */
+    struct SpillQueueMetrics
+    {
+        size_t frames;                        ///< number of queued frames
+        size_t memoryBytes;                   ///< number of payload bytes queued in memory
+        size_t diskBytes;                     ///< number of payload bytes queued on the disk
+        size_t segments;                      ///< number of segment files in use
+        uint64_t dropped;                     ///< number of frames dropped because all limits were reached
+        std::chrono::milliseconds oldestAge;  ///< how long the oldest queued frame has been waiting
+    };
+
+    /**
+     * @brief FIFO queue of frames that absorbs outages in memory and spills to mmap'd segment files.
+     *
+     * Frames are kept in memory until @link SpillQueueOptions::memoryLimit @endlink is reached, after that they are
+     * appended to segment files in @link SpillQueueOptions::spillDirectory @endlink. Once anything is spilled, new
+     * frames also go to the disk until the disk backlog is drained, so the order of frames is always preserved.
+     * Segment files are deleted as soon as all of their frames are consumed.
+     *
+     * The queue is safe to use from multiple threads.
+     */
+    class SpillQueue
+    {
+    public:
+        /**
+         * @brief Constructs a new empty queue.
+         *
+         * @param options settings of the queue
+         */
+        explicit SpillQueue(SpillQueueOptions options);
+
+        /**
+         * @brief Deletes all segment files.
+         */
+        ~SpillQueue();
+
+        SpillQueue(const SpillQueue &) = delete;
+        SpillQueue &operator=(const SpillQueue &) = delete;
+
+        /**
+         * @brief Appends a frame to the end of the queue.
+         *
+         * @param frame frame to append
+         *
+         * @return false if the frame was dropped because all limits were reached
+         *
+         * @throw IOException when a segment file cannot be created
+         */
+        bool Push(std::vector<uint8_t> frame);
+
+        /**
+         * @brief Copies the first frame of the queue without removing it.
+         *
+         * @param output vector that will be overwritten with the frame, its capacity is reused
+         *
+         * @return false if the queue is empty
+         */
+        bool Front(std::vector<uint8_t> &output);
+
+        /**
+         * @brief Removes the first frame of the queue.
+         */
+        void Pop();
+
+        /**
+         * @return whether the queue is empty
+         */
+        [[nodiscard]] bool Empty();
+
+        /**
+         * @return the current state of the queue
+         */
+        [[nodiscard]] SpillQueueMetrics Metrics();
+
+    private:
+        struct MemoryFrame
+        {
+            std::vector<uint8_t> data;
+            std::chrono::steady_clock::time_point enqueued;
+        };
+
+        struct Segment
+        {
+            IO::MappedFile file;
+            size_t writeOffset = 0;
+            size_t readOffset = 0;
+            size_t frames = 0;
+        };
+
+        void SpillFrame(const std::vector<uint8_t> &frame, std::chrono::steady_clock::time_point enqueued);
+
+        [[nodiscard]] std::chrono::steady_clock::time_point OldestEnqueueTime() const;
+
+        SpillQueueOptions m_options;
+        std::mutex m_mutex {};
+        std::deque<MemoryFrame> m_memory {};
+        std::deque<Segment> m_segments {};
+        size_t m_memoryBytes = 0;
+        size_t m_diskBytes = 0;
+        size_t m_diskFrames = 0;
+        uint64_t m_dropped = 0;
+        uint64_t m_nextSegmentId = 0;
+    };
+}
+
+#endif // BLE_SERIAL_INCLUDE_SPILL_QUEUE_HPP_
@@ -0,0 +1,213 @@
+#ifndef BLE_SERIAL_INCLUDE_STATS_HPP_
+#define BLE_SERIAL_INCLUDE_STATS_HPP_
+
+#include <ble_serial/bluetooth.hpp>
+#include <ble_serial/bridge.hpp>
+#include <ble_serial/mapped_file.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace BLE_Serial::Bridge
+{
+    /**
+     * @brief Published state of a single bridge.
+     *
+     * The layout is shared between processes, so it only contains fixed size fields.
+     */
+    struct BridgeStatsRecord
+    {
+        char name[48];                  ///< zero terminated name of the bridge
+        uint8_t alive;                  ///< whether the link is still considered alive
+        uint8_t polling;                ///< whether the characteristic is polled instead of subscribed to
+        int16_t rssi;                   ///< last known signal strength in dBm, 0 when unknown
+        uint32_t reserved;
+        uint64_t notifications;         ///< number of received notifications
+        uint64_t bytesReceived;         ///< payload bytes of all received notifications
+        uint64_t writes;                ///< number of successful characteristic writes
+        uint64_t bytesSent;             ///< payload bytes of all successful characteristic writes
+        uint64_t writeErrors;           ///< number of failed characteristic write attempts
+        uint64_t retries;               ///< number of retried characteristic writes
+        uint64_t heartbeatErrors;       ///< number of failed heartbeats
+        uint64_t recoveries;            ///< number of times the link came back after going down
+        uint64_t writeLatencyP50;       ///< median write latency in microseconds
+        uint64_t writeLatencyP90;       ///< 90th percentile of the write latency in microseconds
+        uint64_t writeLatencyP99;       ///< 99th percentile of the write latency in microseconds
+        uint64_t controlFrames;         ///< frames waiting in the control lane
+        uint64_t bulkFrames;            ///< frames waiting in the bulk lane
+        uint64_t queuedBytes;           ///< payload bytes waiting in memory and on the disk
+        uint64_t droppedFrames;         ///< frames dropped because the queue limits were reached
+        uint64_t conflated;             ///< notifications conflated away before reaching the port
+        uint64_t threadCpuTime;         ///< CPU time of the threads owned by the bridge in nanoseconds
+        uint64_t callbackCpuTime;       ///< CPU time attributed to the bridge on shared threads in nanoseconds
+        uint64_t memoryBytes;           ///< memory held by the queues, the buffers and the value cache
+        uint64_t cacheBytes;            ///< memory held by the value cache
+    };
+
+    /**
+     * @brief Published state of a single Bluetooth adapter.
+     */
+    struct AdapterStatsRecord
+    {
+        char id[128];                   ///< zero terminated identifier of the adapter, empty for the default one
+        uint64_t connections;           ///< number of open connections
+        uint64_t maxConnections;        ///< maximum number of connections the adapter should handle
+        uint64_t transferredBytes;      ///< bytes read, written and received through the adapter
+    };
+
+    /**
+     * @brief Everything a process running bridges publishes about itself.
+     */
+    struct StatsSnapshot
+    {
+        static constexpr uint32_t Magic = 0x534C4242;
+        static constexpr uint32_t Version = 2;
+        static constexpr size_t MaxBridges = 32;
+        static constexpr size_t MaxAdapters = 16;
+
+        uint32_t magic;                             ///< always @link Magic @endlink
+        uint32_t version;                           ///< layout version, always @link Version @endlink
+        uint64_t pid;                               ///< process publishing the snapshot
+        int64_t publishedAt;                        ///< wall clock time of the snapshot in nanoseconds since the epoch
+        uint32_t bridgeCount;                       ///< number of valid entries in @link bridges @endlink
+        uint32_t adapterCount;                      ///< number of valid entries in @link adapters @endlink
+        BridgeStatsRecord bridges[MaxBridges];
+        AdapterStatsRecord adapters[MaxAdapters];
+    };
+
+    /**
+     * @brief Periodically publishes the metrics of bridges into a shared memory snapshot.
+     *
+     * The snapshot lives in a memory mapped file in @link GetStatsDirectory @endlink named after the process id. The
+     * metrics are sampled on the publisher's own thread at a fixed interval whether anybody watches or not, so readers
+     * never touch the bridges and cannot add load to the hot path. Every update is guarded by a sequence counter, readers
+     * retry when they see a torn copy.
+     */
+    class StatsPublisher
+    {
+    public:
+        /**
+         * @brief Constructs a new publisher, nothing is published until @link Start @endlink is called.
+         *
+         * @param interval how often the snapshot is updated
+         */
+        explicit StatsPublisher(std::chrono::milliseconds interval = std::chrono::milliseconds(500));
+
+        /**
+         * @brief Stops the publisher and removes the snapshot.
+         */
+        ~StatsPublisher();
+
+        StatsPublisher(const StatsPublisher &) = delete;
+        StatsPublisher &operator=(const StatsPublisher &) = delete;
+
+        /**
+         * @brief Adds a bridge to the snapshot, must be called before @link Start @endlink.
+         *
+         * Bridges over @link StatsSnapshot::MaxBridges @endlink are ignored.
+         *
+         * @param name name shown for the bridge
+         * @param bridge the bridge, must outlive the publisher or the publisher must be stopped first
+         */
+        void AddBridge(const std::string &name, Bridge &bridge);
+
+        /**
+         * @brief Adds an adapter to the snapshot, must be called before @link Start @endlink.
+         *
+         * Adapters over @link StatsSnapshot::MaxAdapters @endlink are ignored.
+         *
+         * @param service service of the adapter, must outlive the publisher or the publisher must be stopped first
+         */
+        void AddAdapter(const Bluetooth::IBluetoothService &service);
+
+        /**
+         * @brief Creates the snapshot and starts updating it.
+         *
+         * @throw IO::IOException when the snapshot cannot be created
+         */
+        void Start();
+
+        /**
+         * @brief Stops updating the snapshot and removes it.
+         */
+        void Stop();
+
+    private:
+        void Run();
+
+        void Publish();
+
+        struct BridgeEntry
+        {
+            std::string name;
+            Bridge *bridge;
+        };
+
+        std::chrono::milliseconds m_interval;
+        std::vector<BridgeEntry> m_bridges {};
+        std::vector<const Bluetooth::IBluetoothService *> m_adapters {};
+        IO::MappedFile m_file {};
+
+        std::thread m_thread {};
+        std::mutex m_mutex {};
+        std::condition_variable m_condition {};
+        bool m_exiting = false;
+    };
+
+    /**
+     * @brief Reads snapshots published by a @link StatsPublisher @endlink, possibly in another process.
+     */
+    class StatsReader
+    {
+    public:
+        /**
+         * @brief Maps a published snapshot.
+         *
+         * @param path path to the snapshot
+         *
+         * @throw IO::IOException when the file cannot be mapped or is not a snapshot
+         */
+        explicit StatsReader(const std::string &path);
+
+        /**
+         * @brief Copies the current snapshot.
+         *
+         * @param snapshot receives the copy
+         *
+         * @return false when no consistent copy could be made because the publisher kept updating it
+         */
+        bool Read(StatsSnapshot &snapshot) const noexcept;
+
+        /**
+         * @return path of the mapped snapshot
+         */
+        [[nodiscard]] const std::string &Path() const noexcept;
+
+    private:
+        IO::MappedFile m_file;
+    };
+
+    /**
+     * @brief Returns the directory all the snapshots are published to.
+     *
+     * @return path of the directory
+     */
+    std::string GetStatsDirectory();
+
+    /**
+     * @brief Lists the snapshots of all processes currently publishing them.
+     *
+     * Snapshots left behind by crashed processes are listed as well, they can be told apart by
+     * @link StatsSnapshot::publishedAt @endlink not advancing.
+     *
+     * @return paths of the snapshots, sorted
+     */
+    std::vector<std::string> FindPublishedStats();
+}
+
+#endif // BLE_SERIAL_INCLUDE_STATS_HPP_
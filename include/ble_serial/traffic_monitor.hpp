@@ -0,0 +1,137 @@
+#ifndef BLE_SERIAL_INCLUDE_TRAFFIC_MONITOR_HPP_
+#define BLE_SERIAL_INCLUDE_TRAFFIC_MONITOR_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace BLE_Serial::Bridge
+{
+    /**
+     * @brief Represents which way a packet went.
+     */
+    enum class TrafficDirection : uint8_t
+    {
+        Received, ///< notification or read value coming from the device
+        Sent      ///< value written to the device
+    };
+
+    /**
+     * @brief Settings of a @link TrafficMonitor @endlink.
+     */
+    struct TrafficMonitorOptions
+    {
+        /**
+         * How often the collected packets are printed together with the rates.
+         */
+        std::chrono::milliseconds refresh { 250 };
+
+        /**
+         * How many bytes may wait for the next refresh, packets over the limit are only counted.
+         */
+        size_t maxPending = 1 << 20;
+
+        /**
+         * Whether every packet should be printed as a hexdump, otherwise only the summary lines are printed.
+         */
+        bool hexdump = true;
+    };
+
+    /**
+     * @brief Prints a live, time-stamped view of the traffic of a characteristic or a bridge.
+     *
+     * @link Record @endlink only copies the packet into a pending buffer under a short lock, all the formatting happens
+     * on the monitor thread, which renders everything collected since the previous refresh into a reused buffer and
+     * writes it to the output at once. When the output cannot keep up the packets over
+     * @link TrafficMonitorOptions::maxPending @endlink are dropped from the view, never slowing the producer down.
+     */
+    class TrafficMonitor
+    {
+    public:
+        /**
+         * @brief Constructs a new monitor, nothing is printed until @link Start @endlink is called.
+         *
+         * @param options settings of the monitor
+         * @param output stream the view is written to, must outlive the monitor
+         */
+        TrafficMonitor(TrafficMonitorOptions options, std::ostream &output);
+
+        /**
+         * @brief Stops the monitor.
+         */
+        ~TrafficMonitor();
+
+        TrafficMonitor(const TrafficMonitor &) = delete;
+        TrafficMonitor &operator=(const TrafficMonitor &) = delete;
+
+        /**
+         * @brief Starts the monitor thread.
+         */
+        void Start();
+
+        /**
+         * @brief Prints the remaining packets and stops the monitor thread.
+         */
+        void Stop();
+
+        /**
+         * @brief Records a single packet, may be called from any thread.
+         *
+         * @param direction which way the packet went
+         * @param data payload of the packet
+         * @param size size of the payload
+         * @param latency how long the operation took, zero if unknown
+         */
+        void Record(TrafficDirection direction, const uint8_t *data, size_t size, std::chrono::steady_clock::duration latency = {}) noexcept;
+
+    private:
+        struct RecordHeader
+        {
+            int64_t time;        // system clock, nanoseconds since the epoch
+            int64_t latency;     // nanoseconds
+            uint32_t size;
+            TrafficDirection direction;
+        };
+
+        struct DirectionStats
+        {
+            uint64_t packets = 0;
+            uint64_t bytes = 0;
+            uint64_t latencyCount = 0;
+            int64_t latencyTotal = 0;
+            int64_t latencyMax = 0;
+            int64_t lastTime = 0;
+        };
+
+        void Run();
+
+        void Render(std::chrono::steady_clock::duration elapsed);
+
+        void AppendTimestamp(int64_t time);
+
+        TrafficMonitorOptions m_options;
+        std::ostream &m_output;
+
+        std::mutex m_mutex {};
+        std::condition_variable m_condition {};
+        std::vector<uint8_t> m_pending {};
+        bool m_exiting = false;
+        std::atomic<uint64_t> m_dropped { 0 };
+
+        std::vector<uint8_t> m_draining {};
+        std::string m_text {};
+        DirectionStats m_stats[2] {};
+        int64_t m_cachedSecond = -1;
+        char m_cachedClock[9] {};
+
+        std::thread m_thread {};
+    };
+}
+
+#endif // BLE_SERIAL_INCLUDE_TRAFFIC_MONITOR_HPP_
@@ -0,0 +1,168 @@
+#ifndef BLE_SERIAL_INCLUDE_UUID_DATABASE_HPP_
+#define BLE_SERIAL_INCLUDE_UUID_DATABASE_HPP_
+
+#include <ble_serial/bluetooth.hpp>
+#include <ble_serial/mapped_file.hpp>
+
+#include <cstdint>
+#include <istream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace BLE_Serial::Gatt
+{
+    /**
+     * @brief What a UUID identifies.
+     */
+    enum class UuidKind : uint8_t
+    {
+        Other = 0,
+        Service = 1,
+        Characteristic = 2,
+        Descriptor = 3
+    };
+
+    /**
+     * @brief A single named UUID, the input of @link UuidDatabase::Write @endlink.
+     */
+    struct UuidDefinition
+    {
+        Bluetooth::BluetoothUUID uuid;  ///< the UUID
+        UuidKind kind;                  ///< what the UUID identifies
+        std::string name;               ///< human-readable name
+    };
+
+    /**
+     * @brief A UUID found in a @link UuidDatabase @endlink.
+     */
+    struct UuidRecord
+    {
+        Bluetooth::BluetoothUUID uuid;  ///< the UUID
+        UuidKind kind;                  ///< what the UUID identifies
+        std::string_view name;          ///< name of the UUID, points into the mapping of the database
+    };
+
+    /**
+     * @brief Parses a UUID in either the 16-bit or 32-bit short form (i.e. 0x180D or 180D) or the full 128-bit form
+     * (XXXXXXXX-XXXX-XXXX-XXXX-XXXXXXXXXXXX).
+     *
+     * Short UUIDs are expanded with the Bluetooth base UUID. Unlike @link Bluetooth::IBluetoothService::UUIDFromString
+     * @endlink it does not need the platform service.
+     *
+     * @param string string to parse
+     *
+     * @return the UUID or an empty optional when the string is not a UUID
+     */
+    std::optional<Bluetooth::BluetoothUUID> ParseUuid(std::string_view string);
+
+    /**
+     * @brief Checks whether a UUID is a short UUID expanded with the Bluetooth base UUID.
+     *
+     * @param uuid the UUID
+     *
+     * @return true when only the first 4 bytes differ from the base UUID
+     */
+    bool IsBaseUuid(const Bluetooth::BluetoothUUID &uuid);
+
+    /**
+     * @brief Reads UUID definitions in the format of the Bluetooth SIG assigned numbers YAML files.
+     *
+     * Every entry of the list holds a "uuid" and a "name", i.e.
+     *
+     *     uuids:
+     *       - uuid: 0x180D
+     *         name: Heart Rate
+     *         id: org.bluetooth.service.heart_rate
+     *
+     * Vendor files use the same layout with 128-bit UUIDs. The kind of an entry is taken from its "kind" key (service,
+     * characteristic or descriptor), then from the prefix of its "id", then from @p kind. Only this subset of YAML is
+     * understood, other keys are ignored.
+     *
+     * @param input stream to read
+     * @param kind kind of the entries that tell nothing else
+     * @param source name of the input used in the error messages
+     *
+     * @return the definitions in the order they appear
+     *
+     * @throw std::invalid_argument when an entry misses its UUID or name or the UUID is malformed
+     */
+    std::vector<UuidDefinition> ParseUuidDefinitions(std::istream &input, UuidKind kind, const std::string &source);
+
+    /**
+     * @brief Read-only index of UUID names stored in a memory mapped file.
+     *
+     * The file is built once by @link Write @endlink and holds the records, their names and two open addressing hash
+     * tables, one keyed by the UUID and one keyed by the case-insensitive name. Opening maps the file and checks its
+     * header, nothing is parsed or copied, so the startup cost does not grow with the database and every process using
+     * the same file shares its pages.
+     */
+    class UuidDatabase
+    {
+    public:
+        /**
+         * @brief Builds a database file, replacing the file atomically.
+         *
+         * On POSIX systems running processes that have the old file mapped keep reading it. Windows cannot replace a
+         * file that is mapped, so the processes using it must be stopped first, or the database written to a new path.
+         *
+         * A UUID defined more than once keeps its last definition, so vendor files listed after the SIG files can
+         * rename the standard UUIDs.
+         *
+         * @param path path to the file
+         * @param definitions the definitions
+         *
+         * @throw IOException when the file cannot be written
+         * @throw std::invalid_argument when a name is longer than 65535 bytes
+         */
+        static void Write(const std::string &path, const std::vector<UuidDefinition> &definitions);
+
+        /**
+         * @brief Maps a database file built by @link Write @endlink.
+         *
+         * @param path path to the file
+         *
+         * @return the database
+         *
+         * @throw IOException when the file cannot be mapped or is not a database of a supported version
+         */
+        static UuidDatabase Open(const std::string &path);
+
+        /**
+         * @brief Constructs an empty database.
+         */
+        UuidDatabase() noexcept = default;
+
+        /**
+         * @brief Looks a UUID up.
+         *
+         * @param uuid the UUID
+         *
+         * @return the record or an empty optional when the UUID is not in the database
+         */
+        [[nodiscard]] std::optional<UuidRecord> Find(const Bluetooth::BluetoothUUID &uuid) const noexcept;
+
+        /**
+         * @brief Looks a name up, ignoring the case of ASCII letters.
+         *
+         * @param name the name
+         * @param kind kind of the UUID, @link UuidKind::Other @endlink accepts any
+         *
+         * @return the first record with the name or an empty optional when there is none
+         */
+        [[nodiscard]] std::optional<UuidRecord> FindByName(std::string_view name, UuidKind kind) const noexcept;
+
+        /**
+         * @return number of UUIDs in the database
+         */
+        [[nodiscard]] size_t Size() const noexcept;
+
+    private:
+        [[nodiscard]] UuidRecord GetRecord(uint32_t index) const noexcept;
+
+        IO::MappedFile m_file {};
+    };
+}
+
+#endif // BLE_SERIAL_INCLUDE_UUID_DATABASE_HPP_
@@ -0,0 +1,187 @@
+#include <ble_serial/advertisement_bridge.hpp>
+#include <ble_serial/format.hpp>
+#include <ble_serial/instrumentation.hpp>
+
+#include <algorithm>
+#include <charconv>
+
+namespace BLE_Serial::Bridge
+{
+    using namespace BLE_Serial::Bluetooth;
+
+    namespace
+    {
+        constexpr uint8_t c_recordMarker = 0xA5;
+        constexpr uint8_t c_extendedFlag = 0x01;
+
+        /**
+         * FNV-1a hash of a manufacturer data section, so the last payload of a device is remembered in 8 bytes
+         */
+        uint64_t HashSection(const BluetoothManufacturerData &section) noexcept
+        {
+            uint64_t hash = 0xCBF29CE484222325ull;
+
+            hash ^= section.companyId;
+            hash *= 0x100000001B3ull;
+
+            for (uint8_t byte : section.data) {
+                hash ^= byte;
+                hash *= 0x100000001B3ull;
+            }
+
+            return hash;
+        }
+
+        /**
+         * Devices are tracked per company, a device may advertise several manufacturer data sections
+         */
+        uint64_t DeviceKey(BluetoothAddress address, uint16_t companyId) noexcept
+        {
+            return (address << 16) | companyId;
+        }
+
+        template<typename T>
+        void AppendLittleEndian(std::vector<uint8_t> &output, T value, size_t size)
+        {
+            for (size_t i = 0; i < size; i++) {
+                output.push_back(static_cast<uint8_t>(static_cast<uint64_t>(value) >> (8 * i)));
+            }
+        }
+
+        template<typename T>
+        void AppendNumber(std::vector<uint8_t> &output, T value)
+        {
+            char buffer[24];
+            auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+            output.insert(output.end(), buffer, result.ptr);
+        }
+
+        void AppendText(std::vector<uint8_t> &output, std::string_view text)
+        {
+            output.insert(output.end(), text.begin(), text.end());
+        }
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // AdvertisementBridge implementation                   //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    AdvertisementBridge::AdvertisementBridge(AdvertisementBridgeOptions options, std::function<void(const std::vector<uint8_t> &)> sink)
+            : m_options { std::move(options) }, m_sink { std::move(sink) }
+    {
+    }
+
+    void AdvertisementBridge::Offer(const BluetoothAdvertisement &advertisement)
+    {
+        const auto &filter = m_options.filter;
+        bool addressMatches = filter.addresses.empty() || std::find(filter.addresses.begin(), filter.addresses.end(), advertisement.address) != filter.addresses.end();
+
+        std::vector<uint8_t> record;
+
+        for (const auto &section : advertisement.manufacturerData) {
+            m_received.fetch_add(1, std::memory_order_relaxed);
+
+            if (!addressMatches || (!filter.companyIds.empty() && std::find(filter.companyIds.begin(), filter.companyIds.end(), section.companyId) == filter.companyIds.end())) {
+                m_filtered.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+
+            if (!Admit(advertisement, section)) {
+                continue;
+            }
+
+            BLE_SERIAL_COUNT("advertisement.forwarded.bytes", section.data.size());
+
+            record.clear();
+            EncodeRecord(m_options.format, advertisement, section, record);
+            m_forwarded.fetch_add(1, std::memory_order_relaxed);
+            m_sink(record);
+        }
+    }
+
+    AdvertisementBridgeMetrics AdvertisementBridge::Metrics() const noexcept
+    {
+        return AdvertisementBridgeMetrics {
+                .received = m_received.load(std::memory_order_relaxed),
+                .filtered = m_filtered.load(std::memory_order_relaxed),
+                .duplicates = m_duplicates.load(std::memory_order_relaxed),
+                .rateLimited = m_rateLimited.load(std::memory_order_relaxed),
+                .forwarded = m_forwarded.load(std::memory_order_relaxed),
+                .devices = m_devices.load(std::memory_order_relaxed),
+                .evicted = m_evicted.load(std::memory_order_relaxed)
+        };
+    }
+
+    void AdvertisementBridge::EncodeRecord(AdvertisementFormat format, const BluetoothAdvertisement &advertisement, const BluetoothManufacturerData &section,
+                                           std::vector<uint8_t> &output)
+    {
+        if (format == AdvertisementFormat::Binary) {
+            output.push_back(c_recordMarker);
+            AppendLittleEndian(output, 6 + 1 + 1 + 2 + section.data.size(), 2);
+            AppendLittleEndian(output, advertisement.address, 6);
+            output.push_back(static_cast<uint8_t>(static_cast<int8_t>(std::clamp<int16_t>(advertisement.rssi, -128, 127))));
+            output.push_back(advertisement.extended ? c_extendedFlag : 0);
+            AppendLittleEndian(output, section.companyId, 2);
+            output.insert(output.end(), section.data.begin(), section.data.end());
+            return;
+        }
+
+        AppendText(output, "{\"address\":\"");
+        AppendText(output, BluetoothAddressToString(advertisement.address));
+        AppendText(output, "\",\"rssi\":");
+        AppendNumber(output, advertisement.rssi);
+        AppendText(output, advertisement.extended ? ",\"extended\":true,\"company\":" : ",\"extended\":false,\"company\":");
+        AppendNumber(output, section.companyId);
+        AppendText(output, ",\"data\":\"");
+
+        size_t offset = output.size();
+        output.resize(offset + 2 * section.data.size());
+        Format::EncodeHex(section.data.data(), section.data.size(), reinterpret_cast<char *>(output.data() + offset));
+
+        AppendText(output, "\"}\n");
+    }
+
+    bool AdvertisementBridge::Admit(const BluetoothAdvertisement &advertisement, const BluetoothManufacturerData &section)
+    {
+        uint64_t key = DeviceKey(advertisement.address, section.companyId);
+        uint64_t hash = HashSection(section);
+        auto now = std::chrono::steady_clock::now();
+        // Fibonacci hashing, the low bits of the key are the company id and would put a whole fleet into one shard
+        auto &shard = m_shards[(key * 0x9E3779B97F4A7C15ull) >> 60];
+
+        std::unique_lock<std::mutex> lock { shard.mutex };
+        auto it = shard.devices.find(key);
+
+        if (it != shard.devices.end()) {
+            auto &state = it->second;
+            auto elapsed = now - state.lastForward;
+
+            if (state.hash == hash && (m_options.repeatInterval.count() == 0 || elapsed < m_options.repeatInterval)) {
+                m_duplicates.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+
+            if (elapsed < m_options.minInterval) {
+                m_rateLimited.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+
+            state = DeviceState { .hash = hash, .lastForward = now };
+            return true;
+        }
+
+        if (shard.devices.size() >= std::max<size_t>(1, m_options.maxDevices / ShardCount)) {
+            // Forgetting a device only costs one repeated record once it advertises again
+            auto oldest = std::min_element(shard.devices.begin(), shard.devices.end(), [](const auto &a, const auto &b) { return a.second.lastForward < b.second.lastForward; });
+            shard.devices.erase(oldest);
+            m_evicted.fetch_add(1, std::memory_order_relaxed);
+            m_devices.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        shard.devices.emplace(key, DeviceState { .hash = hash, .lastForward = now });
+        m_devices.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+}
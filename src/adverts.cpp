@@ -0,0 +1,75 @@
+#include "adverts.hpp"
+
+#include <ble_serial/com.hpp>
+
+#include <cstdio>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+
+using namespace BLE_Serial::Bluetooth;
+using namespace BLE_Serial::Bridge;
+using namespace BLE_Serial::COM;
+
+AdvertisementFilter AdvertisementFilterFromString(const std::string &str)
+{
+    AdvertisementFilter filter;
+    if (str == "all") {
+        return filter;
+    }
+
+    std::stringstream stream { str };
+    std::string entry;
+
+    while (std::getline(stream, entry, ',')) {
+        if (entry.find(':') != std::string::npos) {
+            filter.addresses.push_back(BluetoothAddressFromString(entry));
+            continue;
+        }
+
+        size_t end = 0;
+        unsigned long companyId = std::stoul(entry, &end, 16);
+        if (end != entry.size() || companyId > 0xFFFF) {
+            throw std::invalid_argument("Invalid advertisement filter entry: " + entry);
+        }
+
+        filter.companyIds.push_back(static_cast<uint16_t>(companyId));
+    }
+
+    return filter;
+}
+
+int Adverts(const AdvertsSettings &settings, const std::atomic_bool &stop)
+{
+    std::unique_ptr<COMPort> port;
+    if (settings.portNumber) {
+        port = std::make_unique<COMPort>(*settings.portNumber, settings.baud);
+    }
+
+    // The watcher delivers from a thread pool, records must not interleave on the output
+    std::mutex outputMutex;
+
+    AdvertisementBridge bridge { settings.options, [&](const std::vector<uint8_t> &record) {
+        std::unique_lock<std::mutex> lock { outputMutex };
+
+        if (port) {
+            port->Write(record);
+        } else {
+            std::fwrite(record.data(), 1, record.size(), stdout);
+            std::fflush(stdout);
+        }
+    } };
+
+    std::cerr << "Forwarding advertisements, press Ctrl+C to stop" << std::endl;
+
+    IBluetoothService::GetService().WatchAdvertisements([&bridge](const BluetoothAdvertisement &advertisement) {
+        bridge.Offer(advertisement);
+    }, stop);
+
+    auto metrics = bridge.Metrics();
+    std::cerr << "Received " << metrics.received << " sections, forwarded " << metrics.forwarded << ", filtered " << metrics.filtered << ", duplicates "
+              << metrics.duplicates << ", rate limited " << metrics.rateLimited << ", tracking " << metrics.devices << " devices" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,41 @@
+#ifndef BLE_SERIAL_SRC_ADVERTS_HPP_
+#define BLE_SERIAL_SRC_ADVERTS_HPP_
+
+#include <ble_serial/advertisement_bridge.hpp>
+
+#include <atomic>
+#include <optional>
+#include <string>
+
+/**
+ * @brief Settings of the adverts command.
+ */
+struct AdvertsSettings
+{
+    std::optional<unsigned int> portNumber; ///< COM port the records are written to, standard output when empty
+    unsigned int baud = 9600;
+    BLE_Serial::Bridge::AdvertisementBridgeOptions options {};
+};
+
+/**
+ * @brief Parses a comma separated list of device addresses and hexadecimal company ids.
+ *
+ * @param str the list, "all" matches every advertisement
+ *
+ * @return the filter
+ *
+ * @throw std::invalid_argument when an entry is neither an address nor a company id
+ */
+BLE_Serial::Bridge::AdvertisementFilter AdvertisementFilterFromString(const std::string &str);
+
+/**
+ * @brief Forwards the manufacturer data of all matching advertisements until interrupted.
+ *
+ * @param settings settings of the command
+ * @param stop flag that ends the command when set
+ *
+ * @return exit code of the application
+ */
+int Adverts(const AdvertsSettings &settings, const std::atomic_bool &stop);
+
+#endif // BLE_SERIAL_SRC_ADVERTS_HPP_
@@ -0,0 +1,81 @@
+#include "aggregate.hpp"
+
+#include <iostream>
+#include <thread>
+
+using namespace BLE_Serial::Bluetooth;
+using namespace BLE_Serial::Bridge;
+using namespace BLE_Serial::COM;
+
+int Aggregate(const AggregateSettings &settings, const std::atomic_bool &stop)
+{
+    std::vector<std::shared_ptr<IBluetoothConnection>> connections;
+    std::vector<AggregationLink> links;
+
+    for (auto address : settings.addresses) {
+        std::cout << "Connecting to " << BluetoothAddressToString(address) << " ..." << std::endl;
+
+        auto deviceOptional = IBluetoothService::GetService().FindDevice(address, settings.timeout);
+        if (!deviceOptional) {
+            throw BluetoothException("Device with address " + BluetoothAddressToString(address) + " couldn't be found");
+        }
+
+        auto connection = deviceOptional.value()->OpenConnection(settings.timeout);
+        connections.push_back(connection);
+
+        auto service = connection->GetService(GetServiceUUID(settings.serviceId));
+        if (!service) {
+            throw BluetoothException("Requested service couldn't be found");
+        }
+
+        service->FetchCharacteristics();
+
+        for (auto characteristicId : settings.characteristicIds) {
+            auto &characteristic = service->GetCharacteristic(GetCharacteristicUUID(characteristicId));
+            if (!characteristic) {
+                throw BluetoothException("Requested characteristic couldn't be found");
+            }
+
+            links.push_back(AggregationLink { .connection = connection, .characteristic = characteristic.get() });
+        }
+    }
+
+    COMPort port { settings.portNumber, settings.baud, settings.data, settings.stopBits, settings.parity };
+    port.SetRefreshRate(settings.refresh);
+
+    AggregatedBridge bridge { links, port, settings.options };
+    bridge.Start();
+
+    std::cout << "Striping across " << bridge.GetLinkCount() << " links in segments of " << bridge.GetSegmentSize() << " bytes, press Ctrl+C to stop" << std::endl;
+
+    while (!stop.load() && bridge.IsAlive()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+
+    bridge.Stop();
+    port.UnsubscribeAll();
+    port.Close();
+
+    auto metrics = bridge.Metrics();
+    std::cout << "Sent " << metrics.segmentsSent << " segments, " << metrics.redispatched << " moved to another link, " << metrics.dropped << " dropped\n";
+    std::cout << "Received " << metrics.reorder.delivered << " segments, " << metrics.reorder.reordered << " out of order (up to " << metrics.reorder.maxDepth
+              << " held), " << metrics.reorder.lost << " lost, " << metrics.reorder.duplicates << " duplicates\n";
+
+    for (size_t i = 0; i < bridge.GetLinkCount(); i++) {
+        auto link = bridge.GetLinkMetrics(i).Snapshot();
+        std::cout << "\tLink " << i << ": " << link.writes << " writes, " << link.bytesSent << " bytes sent, " << link.writeErrors << " write errors, "
+                  << link.notifications << " notifications, p50 write " << link.writeLatencyP50.count() << " us\n";
+    }
+
+    std::cout << std::flush;
+
+    for (auto &connection : connections) {
+        try {
+            connection->Close();
+        } catch (const BluetoothException &ignored) {
+            // The link may be already dead
+        }
+    }
+
+    return bridge.IsAlive() ? 0 : 1;
+}
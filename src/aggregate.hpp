@@ -0,0 +1,38 @@
+#ifndef BLE_SERIAL_SRC_AGGREGATE_HPP_
+#define BLE_SERIAL_SRC_AGGREGATE_HPP_
+
+#include <ble_serial/aggregation.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+/**
+ * @brief Settings of the aggregate command, every characteristic of every device becomes a link.
+ */
+struct AggregateSettings
+{
+    std::vector<BLE_Serial::Bluetooth::BluetoothAddress> addresses;
+    BLE_Serial::Bluetooth::GattRegisteredService serviceId;
+    std::vector<BLE_Serial::Bluetooth::GattRegisteredCharacteristic> characteristicIds;
+    unsigned int portNumber;
+    std::chrono::seconds timeout { 5 };
+    unsigned int baud = 9600;
+    unsigned int data = 8;
+    BLE_Serial::COM::StopBits stopBits = BLE_Serial::COM::STOP_BITS_ONE;
+    BLE_Serial::COM::Parity parity = BLE_Serial::COM::PARITY_BITS_NONE;
+    std::chrono::milliseconds refresh { 100 };
+    BLE_Serial::Bridge::AggregationOptions options {};
+};
+
+/**
+ * @brief Stripes a COM port across several links until interrupted or until every link is lost.
+ *
+ * @param settings settings of the command
+ * @param stop flag that ends the command when set
+ *
+ * @return exit code of the application
+ */
+int Aggregate(const AggregateSettings &settings, const std::atomic_bool &stop);
+
+#endif // BLE_SERIAL_SRC_AGGREGATE_HPP_
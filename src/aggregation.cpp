@@ -0,0 +1,484 @@
+#include <ble_serial/aggregation.hpp>
+#include <ble_serial/instrumentation.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+
+namespace BLE_Serial::Bridge
+{
+    using namespace BLE_Serial::Bluetooth;
+    using namespace BLE_Serial::COM;
+
+    namespace
+    {
+        /**
+         * Largest window for which the distance to the next expected sequence number stays unambiguous
+         */
+        constexpr size_t c_maxReorderWindow = 0x8000;
+
+        /**
+         * How often the gaps are checked at most, for very short gap timeouts
+         */
+        constexpr std::chrono::milliseconds c_minExpiryInterval { 5 };
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // ReorderBuffer implementation                         //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    ReorderBuffer::ReorderBuffer(size_t window, std::function<void(std::vector<uint8_t>)> deliver)
+            : m_slots(std::bit_ceil(std::clamp<size_t>(window, 1, c_maxReorderWindow))), m_deliver { std::move(deliver) }
+    {
+    }
+
+    void ReorderBuffer::Push(uint16_t sequence, std::vector<uint8_t> payload, std::chrono::steady_clock::time_point now)
+    {
+        // The window is a power of two, so slots stay aligned to the sequence numbers when they wrap around
+        size_t window = m_slots.size();
+
+        // The sender may have started long before this end, its numbering is not reset for the receiver
+        if (!m_synchronized) {
+            m_next = sequence;
+            m_synchronized = true;
+        }
+
+        auto distance = static_cast<uint16_t>(sequence - m_next);
+
+        if (distance >= c_maxReorderWindow) {
+            m_metrics.duplicates++;
+            return;
+        }
+
+        if (distance >= window) {
+            // Make room by giving up on everything that no longer fits behind the new segment
+            auto first = static_cast<uint16_t>(sequence - (window - 1));
+
+            while (m_next != first) {
+                auto &slot = m_slots[m_next & (window - 1)];
+                if (slot) {
+                    m_deliver(std::move(*slot));
+                    slot.reset();
+                    m_held--;
+                    m_metrics.delivered++;
+                } else {
+                    m_metrics.lost++;
+                }
+
+                m_next++;
+            }
+
+            DeliverContiguous(now);
+            distance = static_cast<uint16_t>(sequence - m_next);
+        }
+
+        auto &slot = m_slots[sequence & (window - 1)];
+        if (slot) {
+            m_metrics.duplicates++;
+            return;
+        }
+
+        if (m_held == 0) {
+            m_waitingSince = now;
+        }
+
+        slot = std::move(payload);
+        m_held++;
+
+        if (distance != 0) {
+            m_metrics.reordered++;
+        }
+
+        DeliverContiguous(now);
+        m_metrics.maxDepth = std::max<uint64_t>(m_metrics.maxDepth, m_held);
+    }
+
+    void ReorderBuffer::Expire(std::chrono::steady_clock::time_point now, std::chrono::milliseconds gapTimeout)
+    {
+        if (m_held == 0 || now - m_waitingSince < gapTimeout) {
+            return;
+        }
+
+        SkipGap();
+        DeliverContiguous(now);
+    }
+
+    size_t ReorderBuffer::GetHeldCount() const noexcept
+    {
+        return m_held;
+    }
+
+    ReorderMetrics ReorderBuffer::Metrics() const noexcept
+    {
+        return m_metrics;
+    }
+
+    void ReorderBuffer::DeliverContiguous(std::chrono::steady_clock::time_point now)
+    {
+        size_t mask = m_slots.size() - 1;
+        bool progressed = false;
+
+        for (auto *slot = &m_slots[m_next & mask]; slot->has_value(); slot = &m_slots[m_next & mask]) {
+            m_deliver(std::move(**slot));
+            slot->reset();
+            m_held--;
+            m_next++;
+            m_metrics.delivered++;
+            progressed = true;
+        }
+
+        // The gap timeout counts from the last progress, not from when the first segment started waiting
+        if (progressed && m_held != 0) {
+            m_waitingSince = now;
+        }
+    }
+
+    void ReorderBuffer::SkipGap()
+    {
+        // Only called with segments held, so the loop ends at the first of them
+        size_t mask = m_slots.size() - 1;
+
+        while (!m_slots[m_next & mask]) {
+            m_metrics.lost++;
+            m_next++;
+        }
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // AggregatedBridge implementation                      //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    AggregatedBridge::AggregatedBridge(std::vector<AggregationLink> links, COMPort &port, AggregationOptions options)
+            : m_port { port }, m_options { std::move(options) }, m_segmentSize { m_options.segmentSize }, m_activeLinks { links.size() },
+              m_reorder { m_options.reorderWindow, [this](std::vector<uint8_t> data) { m_port.Write(data); } }
+    {
+        if (links.empty()) {
+            throw std::invalid_argument("At least one link is required");
+        }
+
+        size_t maxWriteSize = SIZE_MAX;
+
+        for (auto &link : links) {
+            auto properties = link.characteristic->GetProperties();
+            auto writeMode = HasProperty(properties, GattCharacteristicProperty::WriteWithoutResponse) ? GattWriteMode::WithoutResponse : GattWriteMode::WithResponse;
+
+            maxWriteSize = std::min(maxWriteSize, link.connection->GetMaxWriteSize());
+            auto state = std::make_unique<LinkState>();
+            state->link = std::move(link);
+            state->writeMode = writeMode;
+            m_links.push_back(std::move(state));
+        }
+
+        if (m_segmentSize == 0) {
+            m_segmentSize = maxWriteSize > c_segmentHeaderSize ? maxWriteSize - c_segmentHeaderSize : 0;
+        }
+
+        if (m_segmentSize == 0) {
+            throw std::invalid_argument("The segment size leaves no room for a payload");
+        }
+    }
+
+    AggregatedBridge::~AggregatedBridge()
+    {
+        Stop();
+    }
+
+    void AggregatedBridge::Start()
+    {
+        if (m_running) {
+            return;
+        }
+
+        m_running = true;
+
+        {
+            std::unique_lock<std::mutex> lock { m_sendMutex };
+            m_exiting = false;
+        }
+
+        for (auto &state : m_links) {
+            state->metrics.MarkActivity();
+
+            state->subscription = state->link.characteristic->Subscribe([this, link = state.get()](std::vector<uint8_t> data) {
+                link->metrics.NotificationReceived(data.size());
+                Receive(std::move(data));
+            });
+
+            state->statusSubscription = state->link.connection->SubscribeStatusChanged([this, link = state.get()](bool connected) {
+                if (!connected) {
+                    std::unique_lock<std::mutex> lock { m_sendMutex };
+                    Deactivate(*link, "connection lost", lock);
+                }
+            });
+
+            state->writerThread = std::thread([this, link = state.get()]() { DrainLink(*link); });
+        }
+
+        {
+            std::unique_lock<std::mutex> lock { m_receiveMutex };
+            m_expiryExiting = false;
+        }
+
+        m_expiryThread = std::thread([this]() { ExpireGaps(); });
+
+        m_portSubscription = m_port.Subscribe([this](const std::vector<uint8_t> &data) {
+            Stripe(data);
+        });
+    }
+
+    void AggregatedBridge::Stop()
+    {
+        if (!m_running) {
+            return;
+        }
+
+        m_running = false;
+        m_port.Unsubscribe(m_portSubscription);
+
+        {
+            std::unique_lock<std::mutex> lock { m_sendMutex };
+            m_exiting = true;
+            m_sendCondition.notify_all();
+        }
+
+        for (auto &state : m_links) {
+            state->writerThread.join();
+            state->link.characteristic->Unsubscribe(state->subscription);
+            state->link.connection->UnsubscribeStatusChanged(state->statusSubscription);
+        }
+
+        {
+            std::unique_lock<std::mutex> lock { m_receiveMutex };
+            m_expiryExiting = true;
+            m_expiryCondition.notify_all();
+        }
+
+        m_expiryThread.join();
+    }
+
+    bool AggregatedBridge::IsAlive() const noexcept
+    {
+        return m_alive.load();
+    }
+
+    void AggregatedBridge::OnDisconnected(std::function<void(const std::string &)> listener)
+    {
+        std::unique_lock<std::mutex> lock { m_listenerMutex };
+        m_disconnectedListener = std::move(listener);
+    }
+
+    size_t AggregatedBridge::GetSegmentSize() const noexcept
+    {
+        return m_segmentSize;
+    }
+
+    size_t AggregatedBridge::GetLinkCount() const noexcept
+    {
+        return m_links.size();
+    }
+
+    const LinkQualityMetrics &AggregatedBridge::GetLinkMetrics(size_t index) const
+    {
+        return m_links.at(index)->metrics;
+    }
+
+    AggregationMetrics AggregatedBridge::Metrics()
+    {
+        AggregationMetrics metrics {};
+
+        {
+            std::unique_lock<std::mutex> lock { m_sendMutex };
+            metrics.segmentsSent = m_segmentsSent;
+            metrics.redispatched = m_redispatched;
+            metrics.dropped = m_dropped;
+            metrics.activeLinks = m_activeLinks;
+        }
+
+        std::unique_lock<std::mutex> lock { m_receiveMutex };
+        metrics.reorder = m_reorder.Metrics();
+        return metrics;
+    }
+
+    void AggregatedBridge::Stripe(const std::vector<uint8_t> &data)
+    {
+        BLE_SERIAL_TIMED_SCOPE("aggregation.stripe");
+
+        std::unique_lock<std::mutex> lock { m_sendMutex };
+
+        for (size_t offset = 0; offset < data.size(); offset += m_segmentSize) {
+            size_t size = std::min(m_segmentSize, data.size() - offset);
+
+            std::vector<uint8_t> segment;
+            segment.reserve(c_segmentHeaderSize + size);
+            segment.push_back(static_cast<uint8_t>(m_nextSequence));
+            segment.push_back(static_cast<uint8_t>(m_nextSequence >> 8));
+            segment.insert(segment.end(), data.begin() + static_cast<ptrdiff_t>(offset), data.begin() + static_cast<ptrdiff_t>(offset + size));
+            m_nextSequence++;
+
+            // Holding the port back once every link is saturated keeps the latency of the queued data bounded
+            m_sendCondition.wait(lock, [this]() {
+                return m_exiting || m_activeLinks == 0 || std::any_of(m_links.begin(), m_links.end(), [this](const auto &state) {
+                    return state->active && state->queue.size() < m_options.linkQueueLimit;
+                });
+            });
+
+            if (m_exiting) {
+                return;
+            }
+
+            Dispatch(std::move(segment), lock);
+        }
+    }
+
+    bool AggregatedBridge::Dispatch(std::vector<uint8_t> segment, std::unique_lock<std::mutex> &)
+    {
+        // Shortest queue first, ties go round-robin so that idle links share the load evenly
+        LinkState *target = nullptr;
+
+        for (size_t i = 0; i < m_links.size(); i++) {
+            auto &state = *m_links[(m_nextLink + i) % m_links.size()];
+            if (state.active && (target == nullptr || state.queue.size() < target->queue.size())) {
+                target = &state;
+            }
+        }
+
+        if (target == nullptr) {
+            m_dropped++;
+            return false;
+        }
+
+        m_nextLink = (m_nextLink + 1) % m_links.size();
+        target->queue.push_back(std::move(segment));
+        m_sendCondition.notify_all();
+        return true;
+    }
+
+    void AggregatedBridge::DrainLink(LinkState &state)
+    {
+        std::unique_lock<std::mutex> lock { m_sendMutex };
+
+        for (;;) {
+            m_sendCondition.wait(lock, [this, &state]() { return m_exiting || !state.active || !state.queue.empty(); });
+
+            if (m_exiting || !state.active) {
+                return;
+            }
+
+            auto segment = std::move(state.queue.front());
+            state.queue.pop_front();
+            m_sendCondition.notify_all();
+            lock.unlock();
+
+            bool written = false;
+            for (unsigned int attempt = 0; attempt <= m_options.writeRetries && !written; attempt++) {
+                try {
+                    auto start = std::chrono::steady_clock::now();
+                    state.link.characteristic->Write(segment, state.writeMode);
+                    state.metrics.WriteAttempted(true, attempt != 0, segment.size());
+                    state.metrics.WriteCompleted(std::chrono::steady_clock::now() - start);
+                    written = true;
+                } catch (const BluetoothException &e) {
+                    state.metrics.WriteAttempted(false, attempt != 0, segment.size());
+                    Log::Write(Log::Severity::Warning, "Segment write failed", { { "size", segment.size() }, { "attempt", attempt }, { "error", e.what() } },
+                               m_options.logContext);
+                }
+            }
+
+            lock.lock();
+
+            if (written) {
+                state.consecutiveErrors = 0;
+                m_segmentsSent++;
+                continue;
+            }
+
+            state.consecutiveErrors++;
+            if (state.consecutiveErrors >= m_options.maxConsecutiveErrors) {
+                Deactivate(state, "writes keep failing", lock);
+            }
+
+            // The receiving side reorders anyway, so the segment can simply go out on another link
+            if (Dispatch(std::move(segment), lock)) {
+                m_redispatched++;
+            }
+        }
+    }
+
+    void AggregatedBridge::Deactivate(LinkState &state, const std::string &reason, std::unique_lock<std::mutex> &lock)
+    {
+        if (!state.active) {
+            return;
+        }
+
+        state.active = false;
+        m_activeLinks--;
+        Log::Write(Log::Severity::Warning, "Link taken out of the stripe", { { "reason", reason }, { "queued", state.queue.size() }, { "remaining", m_activeLinks } },
+                   m_options.logContext);
+
+        auto queue = std::move(state.queue);
+        state.queue.clear();
+
+        for (auto &segment : queue) {
+            if (Dispatch(std::move(segment), lock)) {
+                m_redispatched++;
+            }
+        }
+
+        m_sendCondition.notify_all();
+
+        if (m_activeLinks == 0) {
+            lock.unlock();
+            ReportDisconnected(reason);
+            lock.lock();
+        }
+    }
+
+    void AggregatedBridge::Receive(std::vector<uint8_t> data)
+    {
+        if (data.size() < c_segmentHeaderSize) {
+            Log::Write(Log::Severity::Warning, "Segment without a header dropped", { { "size", data.size() } }, m_options.logContext);
+            return;
+        }
+
+        auto sequence = static_cast<uint16_t>(data[0] | (data[1] << 8));
+        data.erase(data.begin(), data.begin() + c_segmentHeaderSize);
+
+        // Delivering under the lock keeps the port writes of concurrent notifications in order
+        std::unique_lock<std::mutex> lock { m_receiveMutex };
+        m_reorder.Push(sequence, std::move(data), std::chrono::steady_clock::now());
+    }
+
+    void AggregatedBridge::ExpireGaps()
+    {
+        auto interval = std::max(c_minExpiryInterval, m_options.gapTimeout / 2);
+        std::unique_lock<std::mutex> lock { m_receiveMutex };
+
+        while (!m_expiryCondition.wait_for(lock, interval, [this]() { return m_expiryExiting; })) {
+            auto before = m_reorder.Metrics().lost;
+            m_reorder.Expire(std::chrono::steady_clock::now(), m_options.gapTimeout);
+
+            if (auto lost = m_reorder.Metrics().lost - before; lost != 0) {
+                Log::Write(Log::Severity::Warning, "Missing segments skipped", { { "count", lost } }, m_options.logContext);
+            }
+        }
+    }
+
+    void AggregatedBridge::ReportDisconnected(const std::string &reason)
+    {
+        if (!m_alive.exchange(false)) {
+            // Already reported
+            return;
+        }
+
+        Log::Write(Log::Severity::Error, "Link down", { { "reason", reason } }, m_options.logContext);
+
+        std::unique_lock<std::mutex> lock { m_listenerMutex };
+        if (m_disconnectedListener) {
+            m_disconnectedListener(reason);
+        }
+    }
+}
@@ -0,0 +1,111 @@
+#include <ble_serial/async_writer.hpp>
+
+namespace BLE_Serial::IO
+{
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // AsyncFileWriter implementation                       //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    AsyncFileWriter::AsyncFileWriter(const std::string &path, size_t bufferSize, std::chrono::milliseconds flushInterval)
+            : m_file { path, std::ios::binary | std::ios::trunc }, m_path { path }, m_bufferSize { bufferSize }, m_flushInterval { flushInterval }
+    {
+        if (!m_file) {
+            throw IOException("Cannot create file " + path);
+        }
+
+        m_pending.reserve(m_bufferSize);
+        m_thread = std::thread([this]() { Run(); });
+    }
+
+    AsyncFileWriter::~AsyncFileWriter()
+    {
+        try {
+            Close();
+        } catch (const IOException &ignored) {}
+    }
+
+    void AsyncFileWriter::Append(const uint8_t *data, size_t size)
+    {
+        std::unique_lock<std::mutex> lock { m_mutex };
+
+        // Back pressure, one buffer is being written and another one is already full
+        m_condition.wait(lock, [this]() { return m_failed || m_closing || m_pending.size() < 2 * m_bufferSize; });
+
+        if (m_failed) {
+            throw IOException("Writing to " + m_path + " failed");
+        }
+
+        m_pending.insert(m_pending.end(), data, data + size);
+
+        if (m_pending.size() >= m_bufferSize) {
+            m_condition.notify_all();
+        }
+    }
+
+    void AsyncFileWriter::Close()
+    {
+        if (!m_thread.joinable()) {
+            return;
+        }
+
+        {
+            std::unique_lock<std::mutex> lock { m_mutex };
+            m_closing = true;
+            m_condition.notify_all();
+        }
+
+        m_thread.join();
+        m_file.close();
+
+        if (m_failed) {
+            throw IOException("Writing to " + m_path + " failed");
+        }
+    }
+
+    uint64_t AsyncFileWriter::Written() const noexcept
+    {
+        return m_written.load(std::memory_order_relaxed);
+    }
+
+    void AsyncFileWriter::Run()
+    {
+        std::vector<uint8_t> buffer;
+        buffer.reserve(m_bufferSize);
+
+        for (;;) {
+            bool closing;
+
+            {
+                std::unique_lock<std::mutex> lock { m_mutex };
+                m_condition.wait_for(lock, m_flushInterval, [this]() { return m_closing || m_pending.size() >= m_bufferSize; });
+
+                closing = m_closing;
+                buffer.swap(m_pending);
+
+                // The producer may be waiting for the swapped out buffer
+                m_condition.notify_all();
+            }
+
+            if (!buffer.empty()) {
+                m_file.write(reinterpret_cast<const char *>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+                m_file.flush();
+
+                if (!m_file) {
+                    std::unique_lock<std::mutex> lock { m_mutex };
+                    m_failed = true;
+                    m_condition.notify_all();
+                    return;
+                }
+
+                m_written.fetch_add(buffer.size(), std::memory_order_relaxed);
+                buffer.clear();
+            }
+
+            if (closing) {
+                return;
+            }
+        }
+    }
+}
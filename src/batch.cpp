@@ -0,0 +1,339 @@
+#include "batch.hpp"
+
+#include <ble_serial/bluetooth.hpp>
+#include <ble_serial/format.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+using namespace BLE_Serial::Bluetooth;
+using namespace BLE_Serial::Format;
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * Single operation of the plan
+     */
+    struct Operation
+    {
+        std::string name;
+        std::string uuid;
+        std::vector<uint8_t> value;
+    };
+
+    /**
+     * All operations of a single device, in the order of the plan
+     */
+    struct DeviceJob
+    {
+        BluetoothAddress address;
+        std::vector<Operation> operations;
+    };
+
+    /**
+     * Outcome of a single finished operation
+     */
+    struct OperationResult
+    {
+        const Operation *operation;
+        Clock::duration latency;
+        std::vector<uint8_t> value;
+        std::string error;
+    };
+
+    double ToMilliseconds(Clock::duration duration)
+    {
+        return std::chrono::duration<double, std::milli>(duration).count();
+    }
+
+    bool EqualsIgnoreCase(std::string_view lhs, std::string_view rhs)
+    {
+        return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin(), [](char a, char b) {
+            return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b));
+        });
+    }
+
+    std::vector<DeviceJob> LoadPlan(const std::string &fileName)
+    {
+        std::ifstream file { fileName };
+        if (!file) {
+            throw std::invalid_argument("Cannot open plan file " + fileName);
+        }
+
+        std::vector<DeviceJob> jobs;
+        std::map<BluetoothAddress, size_t> indices;
+        std::string line;
+
+        while (std::getline(file, line)) {
+            if (line.empty() || line.starts_with("#")) {
+                continue;
+            }
+
+            std::istringstream stream { line };
+            std::string address, name, uuid, value;
+            stream >> address >> name >> uuid;
+            std::getline(stream >> std::ws, value);
+
+            if (uuid.empty()) {
+                throw std::invalid_argument("Invalid plan entry: " + line);
+            }
+
+            Operation operation { .name = name, .uuid = uuid, .value = {} };
+            if (name == "write") {
+                operation.value = ParseHex(value);
+            } else if (name == "writestr") {
+                operation.value.assign(value.begin(), value.end());
+            } else if (name != "read") {
+                throw std::invalid_argument("Valid plan operations are: read; write; writestr");
+            }
+
+            auto parsedAddress = BluetoothAddressFromString(address);
+            auto [it, inserted] = indices.try_emplace(parsedAddress, jobs.size());
+            if (inserted) {
+                jobs.push_back(DeviceJob { .address = parsedAddress, .operations = {} });
+            }
+
+            jobs[it->second].operations.push_back(std::move(operation));
+        }
+
+        return jobs;
+    }
+
+    /**
+     * Processes the devices of a plan with a fixed number of worker threads
+     */
+    class BatchRunner
+    {
+    public:
+        BatchRunner(const BatchSettings &settings, std::vector<DeviceJob> jobs, std::ostream &output)
+                : m_settings { settings }, m_jobs { std::move(jobs) }, m_output { output }
+        {
+        }
+
+        bool Run()
+        {
+            std::vector<std::unique_ptr<IBluetoothDevice>> scanned;
+
+            std::cerr << "Scanning for " << m_settings.scanTimeout.count() << " seconds..." << std::endl;
+            IBluetoothService::GetService().ScanDevices(scanned, m_settings.scanTimeout);
+
+            for (auto &device : scanned) {
+                m_scanned.emplace(device->GetDeviceAddress(), std::move(device));
+            }
+
+            std::cerr << "Found " << m_scanned.size() << " devices, processing " << m_jobs.size() << " devices with " << m_settings.concurrency << " connections" << std::endl;
+
+            std::vector<std::thread> workers;
+            size_t count = std::clamp<size_t>(m_settings.concurrency, 1, std::max<size_t>(1, m_jobs.size()));
+
+            for (size_t i = 0; i < count; i++) {
+                workers.emplace_back([this]() { Work(); });
+            }
+
+            for (auto &worker : workers) {
+                worker.join();
+            }
+
+            return m_failed.load() == 0;
+        }
+
+    private:
+        void Work()
+        {
+            for (;;) {
+                size_t index = m_nextJob.fetch_add(1);
+                if (index >= m_jobs.size()) {
+                    return;
+                }
+
+                Process(m_jobs[index]);
+            }
+        }
+
+        std::unique_ptr<IBluetoothDevice> FindDevice(BluetoothAddress address)
+        {
+            {
+                std::unique_lock<std::mutex> lock { m_scannedMutex };
+
+                auto it = m_scanned.find(address);
+                if (it != m_scanned.end()) {
+                    auto device = std::move(it->second);
+                    m_scanned.erase(it);
+                    return device;
+                }
+            }
+
+            // Not seen by the shared scan, look for it on its own
+            auto device = IBluetoothService::GetService().FindDevice(address, m_settings.timeout);
+            if (!device) {
+                throw BluetoothException("Device couldn't be found");
+            }
+
+            return std::move(*device);
+        }
+
+        static IBluetoothGattCharacteristic &FindCharacteristic(IBluetoothConnection &connection, const std::string &uuid)
+        {
+            auto &bluetooth = IBluetoothService::GetService();
+
+            for (auto &service : connection.GetServices()) {
+                if (service->GetCachedCharacteristics().empty()) {
+                    service->FetchCharacteristics();
+                }
+
+                for (auto &characteristic : service->GetCachedCharacteristics()) {
+                    if (EqualsIgnoreCase(bluetooth.UUIDToShortString(characteristic->GetUUID()), uuid)) {
+                        return *characteristic;
+                    }
+                }
+            }
+
+            throw BluetoothException("Characteristic " + uuid + " couldn't be found");
+        }
+
+        void Process(const DeviceJob &job)
+        {
+            auto start = Clock::now();
+            std::vector<OperationResult> results;
+            std::unique_ptr<IBluetoothDevice> device;
+            std::optional<Clock::duration> connectLatency;
+            std::string error;
+            unsigned int attempts = 0;
+
+            for (unsigned int attempt = 0; attempt <= m_settings.retries; attempt++) {
+                if (attempt != 0) {
+                    std::this_thread::sleep_for(m_settings.backoff * (1 << std::min(attempt - 1, 10u)));
+                }
+
+                attempts++;
+                std::shared_ptr<IBluetoothConnection> connection;
+
+                try {
+                    if (!device) {
+                        device = FindDevice(job.address);
+                    }
+
+                    auto connectStart = Clock::now();
+                    connection = device->OpenConnection(m_settings.timeout);
+                    connectLatency = Clock::now() - connectStart;
+
+                    // Operations that already succeeded in a previous attempt are not repeated
+                    for (size_t i = results.size(); i < job.operations.size(); i++) {
+                        const auto &operation = job.operations[i];
+                        auto &characteristic = FindCharacteristic(*connection, operation.uuid);
+
+                        OperationResult result { .operation = &operation, .latency = {}, .value = {}, .error = {} };
+                        auto operationStart = Clock::now();
+
+                        if (operation.name == "read") {
+                            result.value = characteristic.Read();
+                        } else {
+                            characteristic.Write(operation.value);
+                        }
+
+                        result.latency = Clock::now() - operationStart;
+                        results.push_back(std::move(result));
+                    }
+
+                    connection->Close();
+                    error.clear();
+                    break;
+                } catch (const BluetoothException &e) {
+                    error = e.what();
+
+                    if (connection) {
+                        try {
+                            connection->Close();
+                        } catch (const BluetoothException &ignored) {}
+                    }
+                }
+            }
+
+            if (!error.empty()) {
+                m_failed.fetch_add(1);
+
+                if (results.size() < job.operations.size()) {
+                    results.push_back(OperationResult { .operation = &job.operations[results.size()], .latency = {}, .value = {}, .error = error });
+                }
+            }
+
+            Report(job, results, attempts, connectLatency, Clock::now() - start, error);
+        }
+
+        void Report(const DeviceJob &job, const std::vector<OperationResult> &results, unsigned int attempts, std::optional<Clock::duration> connectLatency,
+                    Clock::duration total, const std::string &error)
+        {
+            std::ostringstream line;
+            line << std::fixed << std::setprecision(2);
+            line << "{\"address\":" << ToJsonString(BluetoothAddressToString(job.address)) << ",\"ok\":" << (error.empty() ? "true" : "false")
+                 << ",\"attempts\":" << attempts << ",\"connect_ms\":";
+
+            if (connectLatency) {
+                line << ToMilliseconds(*connectLatency);
+            } else {
+                line << "null";
+            }
+
+            line << ",\"total_ms\":" << ToMilliseconds(total) << ",\"operations\":[";
+
+            for (size_t i = 0; i < results.size(); i++) {
+                const auto &result = results[i];
+
+                line << (i == 0 ? "" : ",") << "{\"op\":" << ToJsonString(result.operation->name) << ",\"uuid\":" << ToJsonString(result.operation->uuid)
+                     << ",\"ok\":" << (result.error.empty() ? "true" : "false");
+
+                if (result.error.empty()) {
+                    line << ",\"ms\":" << ToMilliseconds(result.latency);
+                } else {
+                    line << ",\"error\":" << ToJsonString(result.error);
+                }
+
+                if (result.operation->name == "read" && result.error.empty()) {
+                    line << ",\"value\":" << ToJsonString(ToHexString(result.value));
+                }
+
+                line << "}";
+            }
+
+            line << "],\"error\":" << (error.empty() ? "null" : ToJsonString(error)) << "}\n";
+
+            std::unique_lock<std::mutex> lock { m_outputMutex };
+            m_output << line.str() << std::flush;
+        }
+
+        const BatchSettings &m_settings;
+        std::vector<DeviceJob> m_jobs;
+        std::ostream &m_output;
+
+        std::mutex m_scannedMutex {};
+        std::map<BluetoothAddress, std::unique_ptr<IBluetoothDevice>> m_scanned {};
+
+        std::mutex m_outputMutex {};
+        std::atomic<size_t> m_nextJob { 0 };
+        std::atomic<size_t> m_failed { 0 };
+    };
+}
+
+int Batch(const BatchSettings &settings, std::ostream &output)
+{
+    auto jobs = LoadPlan(settings.planFile);
+    if (jobs.empty()) {
+        std::cerr << "The plan is empty" << std::endl;
+        return 0;
+    }
+
+    BatchRunner runner { settings, std::move(jobs), output };
+    return runner.Run() ? 0 : 1;
+}
@@ -0,0 +1,36 @@
+#ifndef BLE_SERIAL_SRC_BATCH_HPP_
+#define BLE_SERIAL_SRC_BATCH_HPP_
+
+#include <chrono>
+#include <ostream>
+#include <string>
+
+/**
+ * @brief Settings of a batch run.
+ */
+struct BatchSettings
+{
+    std::string planFile;                         ///< path to the plan
+    unsigned int concurrency = 4;                 ///< maximum number of devices processed at once
+    unsigned int retries = 2;                     ///< how many times a failed device is retried
+    std::chrono::seconds scanTimeout { 5 };       ///< duration of the shared scan
+    std::chrono::seconds timeout { 5 };           ///< timeout of the connections and of every operation
+    std::chrono::milliseconds backoff { 500 };    ///< delay before the first retry, doubled with every further one
+};
+
+/**
+ * @brief Runs the operations listed in a plan on many devices.
+ *
+ * Every non-empty line of the plan that doesn't start with '#' has the format
+ * "<device_addr> <read|write|writestr> <characteristic_uuid> [value]". The operations of a single device are executed
+ * in the order of the plan over a single connection, different devices are processed concurrently. The result of every
+ * device is written to the output as a single JSON line.
+ *
+ * @param settings settings of the run
+ * @param output stream the results are written to
+ *
+ * @return exit code of the application, 0 only if all the devices succeeded
+ */
+int Batch(const BatchSettings &settings, std::ostream &output);
+
+#endif // BLE_SERIAL_SRC_BATCH_HPP_
@@ -1,6 +1,10 @@
 #include <ble_serial/bluetooth.hpp>
 
+#include <algorithm>
+#include <cctype>
+#include <cstring>
 #include <iomanip>
+#include <mutex>
 #include <sstream>
 #include <unordered_map>
 
@@ -11,34 +15,59 @@ namespace BLE_Serial::Bluetooth
      */
     extern IBluetoothService &GetPlatformLocalBluetoothService();
 
+    /**
+     * Helper function for retrieving platform-specific IBluetoothService bound to the given adapter
+     */
+    extern IBluetoothService &GetPlatformBluetoothService(const std::string &adapterId);
+
+    /**
+     * Helper function for enumerating platform-specific adapters
+     */
+    extern std::vector<BluetoothAdapterInfo> GetPlatformBluetoothAdapters();
+
     namespace
     {
         std::unordered_map<GattRegisteredService, std::string> g_serviceNameCache {}; // NOLINT(cert-err58-cpp)
         std::unordered_map<GattRegisteredCharacteristic, std::string> g_characteristicNameCache; // NOLINT(cert-err58-cpp)
+        std::mutex g_bondStoreMutex {};
+        std::shared_ptr<BondStore> g_bondStore {}; // NOLINT(cert-err58-cpp)
 
         /**
          * Initializes the GATT names cache
          */
         void InitializeCache()
         {
-            static bool c_cacheInitialized = false;
+            static std::once_flag c_cacheInitialized;
 
-            if (c_cacheInitialized) {
-                return;
-            }
+            std::call_once(c_cacheInitialized, []() {
+                g_serviceNameCache.reserve(50);
+                g_characteristicNameCache.reserve(300);
 
-            g_serviceNameCache.reserve(50);
-            g_characteristicNameCache.reserve(300);
+                #define GATT_SERVICE(id, name) g_serviceNameCache[static_cast<GattRegisteredService>(id)] = name
+                #define GATT_CHARACTERISTIC(id, name) g_characteristicNameCache[static_cast<GattRegisteredCharacteristic>(id)] = name
 
-            #define GATT_SERVICE(id, name) g_serviceNameCache[static_cast<GattRegisteredService>(id)] = name
-            #define GATT_CHARACTERISTIC(id, name) g_characteristicNameCache[static_cast<GattRegisteredCharacteristic>(id)] = name
+                #include "gatt_db.cpp"
 
-            #include "gatt_db.cpp"
+                #undef GATT_SERVICE
+                #undef GATT_CHARACTERISTIC
+            });
+        }
+
+        /**
+         * Helper for the reverse lookups, the tables are small enough for a linear search
+         */
+        template<typename Id>
+        std::optional<Id> FindByName(const std::unordered_map<Id, std::string> &cache, std::string_view name)
+        {
+            auto equals = [](char a, char b) { return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b)); };
 
-            #undef GATT_SERVICE
-            #undef GATT_CHARACTERISTIC
+            for (auto &[id, entry] : cache) {
+                if (entry.size() == name.size() && std::equal(entry.begin(), entry.end(), name.begin(), equals)) {
+                    return id;
+                }
+            }
 
-            c_cacheInitialized = true;
+            return std::nullopt;
         }
 
         /**
@@ -101,6 +130,20 @@ namespace BLE_Serial::Bluetooth
         return it == g_characteristicNameCache.end() ? std::nullopt : std::make_optional<std::string>(it->second);
     }
 
+    std::optional<GattRegisteredService> FindServiceByName(std::string_view name)
+    {
+        InitializeCache();
+
+        return FindByName(g_serviceNameCache, name);
+    }
+
+    std::optional<GattRegisteredCharacteristic> FindCharacteristicByName(std::string_view name)
+    {
+        InitializeCache();
+
+        return FindByName(g_characteristicNameCache, name);
+    }
+
     BluetoothUUID GetServiceUUID(GattRegisteredService service)
     {
         return GetBluetoothUUID(static_cast<uint32_t>(service));
@@ -122,11 +165,22 @@ namespace BLE_Serial::Bluetooth
     {
     }
 
-    const char *BluetoothException::what() const
+    const char *BluetoothException::what() const noexcept
     {
         return m_message.c_str();
     }
 
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // BluetoothSecurityException implementation            //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    BluetoothSecurityException::BluetoothSecurityException(std::string message)
+            : BluetoothException(std::move(message))
+    {
+    }
+
     //////////////////////////////////////////////////////////
     //                                                      //
     // IBluetoothService implementation                     //
@@ -138,6 +192,302 @@ namespace BLE_Serial::Bluetooth
         return GetPlatformLocalBluetoothService();
     }
 
+    IBluetoothService &IBluetoothService::GetService(const std::string &adapterId)
+    {
+        return GetPlatformBluetoothService(adapterId);
+    }
+
+    std::vector<BluetoothAdapterInfo> IBluetoothService::GetAdapters()
+    {
+        return GetPlatformBluetoothAdapters();
+    }
+
+    void IBluetoothService::SetBondStore(std::shared_ptr<BondStore> store)
+    {
+        std::unique_lock<std::mutex> lock { g_bondStoreMutex };
+        g_bondStore = std::move(store);
+    }
+
+    std::shared_ptr<BondStore> IBluetoothService::GetBondStore()
+    {
+        std::unique_lock<std::mutex> lock { g_bondStoreMutex };
+        return g_bondStore;
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // BluetoothAdapterBalancer implementation              //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    BluetoothAdapterBalancer::BluetoothAdapterBalancer(std::vector<IBluetoothService *> services)
+            : m_services { std::move(services) }, m_lastTransferredBytes {}
+    {
+        if (m_services.empty()) {
+            throw BluetoothException("No Bluetooth adapters to balance between");
+        }
+
+        m_lastTransferredBytes.reserve(m_services.size());
+        for (auto service : m_services) {
+            m_lastTransferredBytes.push_back(service->GetTransferredBytes());
+        }
+    }
+
+    BluetoothAdapterBalancer BluetoothAdapterBalancer::ForAllAdapters()
+    {
+        std::vector<IBluetoothService *> services;
+
+        for (auto &adapter : IBluetoothService::GetAdapters()) {
+            auto &service = IBluetoothService::GetService(adapter.id);
+
+            // Adapters sharing a radio share its connection limit
+            if (std::find(services.begin(), services.end(), &service) != services.end()) {
+                continue;
+            }
+
+            service.Initialize();
+            services.push_back(&service);
+        }
+
+        return BluetoothAdapterBalancer { std::move(services) };
+    }
+
+    IBluetoothService &BluetoothAdapterBalancer::SelectService()
+    {
+        std::unique_lock<std::mutex> lock { m_mutex };
+
+        uint64_t totalDelta = 0;
+        std::vector<uint64_t> deltas(m_services.size());
+
+        for (size_t i = 0; i < m_services.size(); i++) {
+            uint64_t transferred = m_services[i]->GetTransferredBytes();
+            deltas[i] = transferred - m_lastTransferredBytes[i];
+            m_lastTransferredBytes[i] = transferred;
+            totalDelta += deltas[i];
+        }
+
+        IBluetoothService *best = nullptr;
+        double bestLoad = 0.0;
+
+        for (size_t i = 0; i < m_services.size(); i++) {
+            auto service = m_services[i];
+            size_t connections = service->GetActiveConnectionCount();
+            size_t limit = service->GetMaxConnectionCount();
+
+            if (limit == 0 || connections >= limit) {
+                continue;
+            }
+
+            double load = static_cast<double>(connections) / static_cast<double>(limit);
+            if (totalDelta != 0) {
+                load += static_cast<double>(deltas[i]) / static_cast<double>(totalDelta);
+            }
+
+            if (best == nullptr || load < bestLoad || (load == bestLoad && connections < best->GetActiveConnectionCount())) {
+                best = service;
+                bestLoad = load;
+            }
+        }
+
+        if (best == nullptr) {
+            throw BluetoothException("All Bluetooth adapters reached their connection limit");
+        }
+
+        return *best;
+    }
+
+    const std::vector<IBluetoothService *> &BluetoothAdapterBalancer::GetServices() const noexcept
+    {
+        return m_services;
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // SharedBluetoothConnection implementation             //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    void SharedBluetoothConnection::Close()
+    {
+        std::unique_lock<std::mutex> lock { m_usersMutex };
+
+        if (m_users == 0 || --m_users != 0) {
+            return;
+        }
+
+        // Held while the link closes, so that the connection cannot be handed out again meanwhile
+        m_services.clear();
+        CloseLink();
+    }
+
+    std::vector<std::shared_ptr<IBluetoothGattService>> SharedBluetoothConnection::GetServices()
+    {
+        std::unique_lock<std::mutex> lock { m_usersMutex };
+        return m_services;
+    }
+
+    std::shared_ptr<IBluetoothGattService> SharedBluetoothConnection::GetService(BluetoothUUID uuid)
+    {
+        std::unique_lock<std::mutex> lock { m_usersMutex };
+
+        for (auto &service : m_services) {
+            if (service->GetUUID() == uuid) {
+                return service;
+            }
+        }
+
+        return nullptr;
+    }
+
+    bool SharedBluetoothConnection::Retain() noexcept
+    {
+        std::unique_lock<std::mutex> lock { m_usersMutex };
+
+        if (m_users == 0) {
+            return false;
+        }
+
+        m_users++;
+        return true;
+    }
+
+    size_t SharedBluetoothConnection::GetUserCount() const noexcept
+    {
+        std::unique_lock<std::mutex> lock { m_usersMutex };
+        return m_users;
+    }
+
+    void SharedBluetoothConnection::SetServices(std::vector<std::shared_ptr<IBluetoothGattService>> services)
+    {
+        std::unique_lock<std::mutex> lock { m_usersMutex };
+        m_services = std::move(services);
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // SharedConnectionSlot implementation                  //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    std::shared_ptr<IBluetoothConnection> SharedConnectionSlot::Open(const std::function<std::shared_ptr<SharedBluetoothConnection>()> &open)
+    {
+        std::unique_lock<std::mutex> lock { m_mutex };
+
+        // A connection whose last user is closing it refuses the new user, it is replaced like a lost one
+        if (m_connection && m_connection->IsOpen() && m_connection->Retain()) {
+            return m_connection;
+        }
+
+        m_connection.reset();
+        m_connection = open();
+        return m_connection;
+    }
+
+    std::optional<std::shared_ptr<IBluetoothConnection>> SharedConnectionSlot::Get() const noexcept
+    {
+        std::unique_lock<std::mutex> lock { m_mutex };
+
+        if (!m_connection || m_connection->GetUserCount() == 0 || !m_connection->IsOpen()) {
+            return std::nullopt;
+        }
+
+        return m_connection;
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // GattValueCache implementation                        //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    void GattValueCache::SetTimeToLive(std::chrono::milliseconds ttl)
+    {
+        std::unique_lock<std::mutex> lock { m_mutex };
+        m_ttl = ttl;
+
+        if (m_ttl.count() == 0) {
+            m_entries.clear();
+        }
+    }
+
+    std::chrono::milliseconds GattValueCache::GetTimeToLive() const noexcept
+    {
+        std::unique_lock<std::mutex> lock { m_mutex };
+        return m_ttl;
+    }
+
+    std::optional<std::vector<uint8_t>> GattValueCache::Lookup(uint16_t handle)
+    {
+        std::unique_lock<std::mutex> lock { m_mutex };
+
+        if (m_ttl.count() == 0) {
+            return std::nullopt;
+        }
+
+        auto it = m_entries.find(handle);
+        if (it == m_entries.end() || std::chrono::steady_clock::now() - it->second.updated > m_ttl) {
+            m_misses.fetch_add(1, std::memory_order_relaxed);
+            return std::nullopt;
+        }
+
+        m_hits.fetch_add(1, std::memory_order_relaxed);
+        return it->second.value;
+    }
+
+    bool GattValueCache::Store(uint16_t handle, const std::vector<uint8_t> &value)
+    {
+        std::unique_lock<std::mutex> lock { m_mutex };
+
+        if (m_ttl.count() == 0) {
+            return true;
+        }
+
+        auto [it, inserted] = m_entries.try_emplace(handle);
+        bool changed = inserted || it->second.value != value;
+
+        if (changed) {
+            it->second.value = value;
+            m_changes.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        it->second.updated = std::chrono::steady_clock::now();
+        return changed;
+    }
+
+    void GattValueCache::Invalidate(uint16_t handle)
+    {
+        std::unique_lock<std::mutex> lock { m_mutex };
+
+        if (m_entries.erase(handle) != 0) {
+            m_invalidations.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void GattValueCache::Clear()
+    {
+        std::unique_lock<std::mutex> lock { m_mutex };
+        m_entries.clear();
+    }
+
+    GattValueCacheMetrics GattValueCache::Metrics() const
+    {
+        std::unique_lock<std::mutex> lock { m_mutex };
+
+        size_t bytes = 0;
+        for (const auto &[handle, entry] : m_entries) {
+            bytes += sizeof(entry) + entry.value.capacity();
+        }
+
+        return GattValueCacheMetrics {
+                .hits = m_hits.load(std::memory_order_relaxed),
+                .misses = m_misses.load(std::memory_order_relaxed),
+                .changes = m_changes.load(std::memory_order_relaxed),
+                .invalidations = m_invalidations.load(std::memory_order_relaxed),
+                .entries = m_entries.size(),
+                .bytes = bytes
+        };
+    }
+
     //////////////////////////////////////////////////////////
     //                                                      //
     // IBluetoothDevice implementation                      //
@@ -148,4 +498,35 @@ namespace BLE_Serial::Bluetooth
     {
         return OpenConnection(DefaultTimeout);
     }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // IBluetoothGattCharacteristic implementation          //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    std::vector<GattPresentationFormat> IBluetoothGattCharacteristic::GetPresentationFormats() const
+    {
+        return {};
+    }
+
+    std::vector<uint8_t> IBluetoothGattCharacteristic::Read()
+    {
+        return Read(GattReadMode::Cached);
+    }
+
+    std::future<std::vector<uint8_t>> IBluetoothGattCharacteristic::ReadAsync()
+    {
+        return ReadAsync(GattReadMode::Cached);
+    }
+
+    std::future<std::vector<uint8_t>> IBluetoothGattCharacteristic::ReadAsync(GattReadMode mode)
+    {
+        return std::async(std::launch::async, [this, mode]() { return Read(mode); });
+    }
+
+    void IBluetoothGattCharacteristic::Write(const std::vector<uint8_t> &data)
+    {
+        Write(data, GattWriteMode::WithResponse);
+    }
 }
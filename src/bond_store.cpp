@@ -0,0 +1,302 @@
+#include <ble_serial/bond_store.hpp>
+
+#include <ble_serial/instrumentation.hpp>
+#include <ble_serial/mapped_file.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace BLE_Serial::Bluetooth
+{
+    using namespace Log;
+
+    namespace
+    {
+        const char *ProtectionToString(PairingProtection protection) noexcept
+        {
+            return protection == PairingProtection::EncryptionAndAuthentication ? "authenticated" : "encrypted";
+        }
+
+        std::optional<PairingProtection> ProtectionFromString(const std::string &protection) noexcept
+        {
+            if (protection == "encrypted") {
+                return PairingProtection::Encryption;
+            } else if (protection == "authenticated") {
+                return PairingProtection::EncryptionAndAuthentication;
+            }
+            return std::nullopt;
+        }
+
+        int64_t ToMilliseconds(std::chrono::system_clock::time_point time) noexcept
+        {
+            return std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count();
+        }
+
+        uint64_t CurrentProcessId() noexcept
+        {
+#ifdef _WIN32
+            return static_cast<uint64_t>(_getpid());
+#else
+            return static_cast<uint64_t>(getpid());
+#endif
+        }
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // BondStore implementation                             //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    std::string BondStore::GetDefaultPath()
+    {
+#ifdef _WIN32
+        const char *base = std::getenv("LOCALAPPDATA");
+        const char *folder = "ble_serial";
+#else
+        const char *base = std::getenv("HOME");
+        const char *folder = ".ble_serial";
+#endif
+
+        std::filesystem::path directory;
+        if (base && *base) {
+            directory = base;
+        } else {
+            std::error_code error;
+            directory = std::filesystem::temp_directory_path(error);
+            if (error) {
+                directory = ".";
+            }
+        }
+
+        return (directory / folder / "bonds").string();
+    }
+
+    BondStore::BondStore(std::string path)
+            : m_path { std::move(path) }
+    {
+        std::unique_lock<std::mutex> lock { m_mutex };
+        Load();
+    }
+
+    std::optional<BondRecord> BondStore::Find(BluetoothAddress address) const
+    {
+        std::unique_lock<std::mutex> lock { m_mutex };
+
+        auto it = m_bonds.find(address);
+        return it == m_bonds.end() ? std::nullopt : std::make_optional(it->second);
+    }
+
+    std::vector<BondRecord> BondStore::List() const
+    {
+        std::unique_lock<std::mutex> lock { m_mutex };
+
+        std::vector<BondRecord> result;
+        result.reserve(m_bonds.size());
+        for (auto &[address, record] : m_bonds) {
+            result.push_back(record);
+        }
+
+        std::sort(result.begin(), result.end(), [](const BondRecord &lhs, const BondRecord &rhs) { return lhs.address < rhs.address; });
+        return result;
+    }
+
+    void BondStore::Save(const BondRecord &record)
+    {
+        std::unique_lock<std::mutex> lock { m_mutex };
+
+        // Picks up what other processes stored meanwhile, none of them can store in between
+        auto fileLock = LockFile();
+        Load();
+        m_bonds[record.address] = record;
+        Store();
+    }
+
+    bool BondStore::Remove(BluetoothAddress address)
+    {
+        std::unique_lock<std::mutex> lock { m_mutex };
+
+        auto fileLock = LockFile();
+        Load();
+        if (m_bonds.erase(address) == 0) {
+            return false;
+        }
+
+        Store();
+        return true;
+    }
+
+    bool BondStore::Resume(IBluetoothDevice &device, std::chrono::seconds timeout, const LogContext &context)
+    {
+        auto record = Find(device.GetDeviceAddress());
+        if (!record) {
+            return false;
+        }
+
+        auto address = BluetoothAddressToString(device.GetDeviceAddress());
+
+        try {
+            BLE_SERIAL_TIMED_SCOPE("bluetooth.bond_resume");
+
+            if (device.IsPaired(timeout)) {
+                // The OS encrypts the link with the stored keys by itself
+                Write(Severity::Debug, "Resuming bond", { { "device", address }, { "protection", ProtectionToString(record->protection) } }, context);
+                return true;
+            }
+
+            Write(Severity::Warning, "Bond was lost, pairing again", { { "device", address }, { "protection", ProtectionToString(record->protection) } }, context);
+            Pair(device, record->protection, timeout, context);
+        } catch (const BluetoothException &e) {
+            Write(Severity::Warning, "Failed to resume bond", { { "device", address }, { "error", e.what() } }, context);
+        }
+
+        return true;
+    }
+
+    void BondStore::Pair(IBluetoothDevice &device, PairingProtection protection, std::chrono::seconds timeout, const LogContext &context)
+    {
+        std::unique_lock<std::mutex> pairingLock { m_pairingMutex };
+
+        auto address = device.GetDeviceAddress();
+        auto addressString = BluetoothAddressToString(address);
+
+        // Another operation on the same link may have paired while this one waited
+        auto known = Find(address);
+        bool paired = device.IsPaired(timeout);
+        if (paired && known) {
+            return;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        if (!paired) {
+            BLE_SERIAL_TIMED_SCOPE("bluetooth.pairing");
+            Write(Severity::Info, "Pairing", { { "device", addressString }, { "protection", ProtectionToString(protection) } }, context);
+            device.Pair(protection, timeout);
+        }
+        auto pairingTime = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+
+        // The link is paired either way, a store that cannot be written only costs a pairing on the next connection
+        try {
+            Save(BondRecord {
+                    .address = address,
+                    .protection = protection,
+                    .pairedAt = std::chrono::system_clock::now(),
+                    .pairingTime = pairingTime
+            });
+        } catch (const IO::IOException &e) {
+            Write(Severity::Warning, "Failed to update bond store", { { "path", m_path }, { "error", e.what() } }, context);
+        }
+
+        Write(Severity::Info, paired ? "Recorded existing bond" : "Paired", { { "device", addressString }, { "protection", ProtectionToString(protection) }, { "pairing_ms", pairingTime.count() } },
+              context);
+    }
+
+    const std::string &BondStore::GetPath() const noexcept
+    {
+        return m_path;
+    }
+
+    void BondStore::Load()
+    {
+        std::ifstream input { m_path };
+        if (!input) {
+            std::error_code error;
+            if (std::filesystem::exists(m_path, error)) {
+                throw IO::IOException("Failed to open " + m_path);
+            }
+
+            m_bonds.clear();
+            return;
+        }
+
+        std::unordered_map<BluetoothAddress, BondRecord> bonds;
+        std::string line;
+        size_t lineNumber = 0;
+        while (std::getline(input, line)) {
+            lineNumber++;
+            if (line.empty() || line.front() == '#') {
+                continue;
+            }
+
+            // <address> <protection> <paired at, ms since the epoch> <pairing time, ms>
+            std::istringstream stream { line };
+            std::string address, protectionName;
+            int64_t pairedAt = 0, pairingTime = 0;
+            stream >> address >> protectionName >> pairedAt >> pairingTime;
+
+            auto protection = ProtectionFromString(protectionName);
+            if (!stream || !protection || address.size() != 17) {
+                throw IO::IOException("Malformed bond in " + m_path + " on line " + std::to_string(lineNumber));
+            }
+
+            BluetoothAddress parsedAddress;
+            try {
+                parsedAddress = BluetoothAddressFromString(address);
+            } catch (const std::logic_error &) {
+                throw IO::IOException("Malformed bond in " + m_path + " on line " + std::to_string(lineNumber));
+            }
+
+            BondRecord record {
+                    .address = parsedAddress,
+                    .protection = *protection,
+                    .pairedAt = std::chrono::system_clock::time_point { std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::milliseconds(pairedAt)) },
+                    .pairingTime = std::chrono::milliseconds(pairingTime)
+            };
+            bonds[record.address] = record;
+        }
+
+        m_bonds = std::move(bonds);
+    }
+
+    IO::FileLock BondStore::LockFile() const
+    {
+        // The store itself is replaced on every write, so the lock lives in a file of its own
+        std::error_code error;
+        std::filesystem::create_directories(std::filesystem::path { m_path }.parent_path(), error);
+
+        return IO::FileLock { m_path + ".lock" };
+    }
+
+    void BondStore::Store() const
+    {
+        std::vector<const BondRecord *> records;
+        for (auto &[address, record] : m_bonds) {
+            records.push_back(&record);
+        }
+        std::sort(records.begin(), records.end(), [](const BondRecord *lhs, const BondRecord *rhs) { return lhs->address < rhs->address; });
+
+        // Written next to the store and renamed over it, so a reader never sees half of it. Named after the process,
+        // so that writers never share it even where the file system does not honour the lock.
+        auto temporaryPath = m_path + "." + std::to_string(CurrentProcessId()) + ".tmp";
+        {
+            std::ofstream output { temporaryPath, std::ios::trunc };
+            output << "# ble_serial bonds: <address> <protection> <paired at, ms since the epoch> <pairing time, ms>\n";
+            for (auto record : records) {
+                output << BluetoothAddressToString(record->address) << ' ' << ProtectionToString(record->protection) << ' ' << ToMilliseconds(record->pairedAt) << ' '
+                       << record->pairingTime.count() << '\n';
+            }
+
+            if (!output.flush()) {
+                throw IO::IOException("Failed to write " + temporaryPath);
+            }
+        }
+
+        std::error_code error;
+        std::filesystem::rename(temporaryPath, m_path, error);
+        if (error) {
+            IO::MappedFile::Remove(temporaryPath);
+            throw IO::IOException("Failed to replace " + m_path + ": " + error.message());
+        }
+    }
+}
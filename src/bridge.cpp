@@ -0,0 +1,680 @@
+#include <ble_serial/bridge.hpp>
+#include <ble_serial/instrumentation.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <optional>
+
+namespace BLE_Serial::Bridge
+{
+    using namespace BLE_Serial::Bluetooth;
+    using namespace BLE_Serial::COM;
+
+    namespace
+    {
+        /**
+         * Values below 4 us have their own buckets, every power of two above is split into four linear buckets
+         */
+        size_t LatencyBucket(uint64_t microseconds, size_t bucketCount) noexcept
+        {
+            if (microseconds < 4) {
+                return static_cast<size_t>(microseconds);
+            }
+
+            auto log = static_cast<size_t>(std::bit_width(microseconds) - 1);
+            return std::min((log - 1) * 4 + ((microseconds >> (log - 2)) & 3), bucketCount - 1);
+        }
+
+        uint64_t LatencyBucketUpperBound(size_t bucket) noexcept
+        {
+            if (bucket < 4) {
+                return bucket;
+            }
+
+            size_t log = bucket / 4 + 1;
+            return ((5 + bucket % 4) << (log - 2)) - 1;
+        }
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // BridgeResourceUsage implementation                   //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    std::chrono::nanoseconds BridgeResourceUsage::CpuTime() const noexcept
+    {
+        return threadCpuTime + callbackCpuTime;
+    }
+
+    size_t BridgeResourceUsage::MemoryBytes() const noexcept
+    {
+        return queueMemoryBytes + bufferBytes + cacheBytes;
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // LinkQualitySnapshot implementation                   //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    double LinkQualitySnapshot::RetryRate() const noexcept
+    {
+        uint64_t attempts = writes + writeErrors;
+        return attempts == 0 ? 0.0 : static_cast<double>(retries) / static_cast<double>(attempts);
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // LinkQualityMetrics implementation                    //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    void LinkQualityMetrics::SetSignalStrength(int16_t rssi) noexcept
+    {
+        m_rssi.store(rssi, std::memory_order_relaxed);
+    }
+
+    void LinkQualityMetrics::MarkActivity() noexcept
+    {
+        m_lastActivity.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+    }
+
+    void LinkQualityMetrics::NotificationReceived(size_t size) noexcept
+    {
+        m_notifications.fetch_add(1, std::memory_order_relaxed);
+        m_bytesReceived.fetch_add(size, std::memory_order_relaxed);
+        MarkActivity();
+    }
+
+    void LinkQualityMetrics::WriteAttempted(bool success, bool retry, size_t size) noexcept
+    {
+        if (retry) {
+            m_retries.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        if (success) {
+            m_writes.fetch_add(1, std::memory_order_relaxed);
+            m_bytesSent.fetch_add(size, std::memory_order_relaxed);
+            MarkActivity();
+        } else {
+            m_writeErrors.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void LinkQualityMetrics::HeartbeatAttempted(bool success) noexcept
+    {
+        if (success) {
+            m_heartbeats.fetch_add(1, std::memory_order_relaxed);
+            MarkActivity();
+        } else {
+            m_heartbeatErrors.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void LinkQualityMetrics::WriteCompleted(std::chrono::steady_clock::duration latency) noexcept
+    {
+        auto microseconds = std::chrono::duration_cast<std::chrono::microseconds>(latency).count();
+        m_writeLatency[LatencyBucket(static_cast<uint64_t>(std::max<int64_t>(microseconds, 0)), LatencyBucketCount)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void LinkQualityMetrics::LinkRecovered() noexcept
+    {
+        m_recoveries.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::chrono::steady_clock::time_point LinkQualityMetrics::GetLastActivity() const noexcept
+    {
+        return std::chrono::steady_clock::time_point { std::chrono::steady_clock::duration { m_lastActivity.load(std::memory_order_relaxed) }};
+    }
+
+    LinkQualitySnapshot LinkQualityMetrics::Snapshot() const noexcept
+    {
+        std::array<uint64_t, LatencyBucketCount> latency {};
+        uint64_t total = 0;
+        for (size_t i = 0; i < LatencyBucketCount; i++) {
+            latency[i] = m_writeLatency[i].load(std::memory_order_relaxed);
+            total += latency[i];
+        }
+
+        // Every percentile is reported as the upper bound of the bucket it falls into
+        auto percentile = [&latency, total](double fraction) {
+            auto rank = static_cast<uint64_t>(std::ceil(fraction * static_cast<double>(total)));
+            uint64_t seen = 0;
+            for (size_t i = 0; i < LatencyBucketCount && total != 0; i++) {
+                seen += latency[i];
+                if (seen >= rank) {
+                    return std::chrono::microseconds(LatencyBucketUpperBound(i));
+                }
+            }
+
+            return std::chrono::microseconds(0);
+        };
+
+        return LinkQualitySnapshot {
+                .rssi = m_rssi.load(std::memory_order_relaxed),
+                .notifications = m_notifications.load(std::memory_order_relaxed),
+                .bytesReceived = m_bytesReceived.load(std::memory_order_relaxed),
+                .writes = m_writes.load(std::memory_order_relaxed),
+                .bytesSent = m_bytesSent.load(std::memory_order_relaxed),
+                .writeErrors = m_writeErrors.load(std::memory_order_relaxed),
+                .retries = m_retries.load(std::memory_order_relaxed),
+                .heartbeats = m_heartbeats.load(std::memory_order_relaxed),
+                .heartbeatErrors = m_heartbeatErrors.load(std::memory_order_relaxed),
+                .recoveries = m_recoveries.load(std::memory_order_relaxed),
+                .writeLatencyP50 = percentile(0.50),
+                .writeLatencyP90 = percentile(0.90),
+                .writeLatencyP99 = percentile(0.99),
+                .sinceLastActivity = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - GetLastActivity())
+        };
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // Bridge implementation                                //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    Bridge::Bridge(std::shared_ptr<IBluetoothConnection> connection, IBluetoothGattCharacteristic &characteristic, COMPort &port, BridgeOptions options)
+            : Bridge(std::move(connection), &characteristic, nullptr, port, std::move(options))
+    {
+    }
+
+    Bridge::Bridge(std::shared_ptr<IBluetoothConnection> connection, L2CAPChannel &channel, COMPort &port, BridgeOptions options)
+            : Bridge(std::move(connection), nullptr, &channel, port, [&channel](BridgeOptions options) {
+                  // Every packet has to fit into a single SDU
+                  if (options.scheduler.packetSize == 0 || options.scheduler.packetSize > channel.GetMaxSduSize()) {
+                      options.scheduler.packetSize = channel.GetMaxSduSize();
+                  }
+
+                  return options;
+              }(std::move(options)))
+    {
+    }
+
+    Bridge::Bridge(std::shared_ptr<IBluetoothConnection> connection, IBluetoothGattCharacteristic *characteristic, L2CAPChannel *channel, COMPort &port, BridgeOptions options)
+            : m_connection { std::move(connection) }, m_characteristic { characteristic }, m_channel { channel }, m_port { port }, m_options { std::move(options) }, m_scheduler { m_options.scheduler, m_options.queue },
+              m_conflator { m_options.conflation, [this](const std::vector<uint8_t> &data) {
+                  // Without conflation the sink runs inside the notification callback, which is charged already
+                  if (m_options.conflation.mode == ConflationMode::None) {
+                      m_port.Write(data);
+                  } else {
+                      CpuUsage::Scope scope { m_threadCpu };
+                      m_port.Write(data);
+                  }
+              } },
+              m_poller { m_options.polling, m_threadCpu, [this](size_t, std::vector<uint8_t> &&data) {
+                  // The poller thread is metered as a whole, reads included
+                  m_metrics.NotificationReceived(data.size());
+                  Log::Write(Log::Severity::Debug, "Value polled", { { "size", data.size() } }, m_options.logContext);
+                  if (auto monitor = m_trafficMonitor.load(std::memory_order_acquire)) {
+                      monitor->Record(TrafficDirection::Received, data.data(), data.size());
+                  }
+
+                  m_conflator.Offer(std::move(data));
+              } }
+    {
+        if (m_connection) {
+            if (auto rssi = m_connection->GetSignalStrength()) {
+                m_metrics.SetSignalStrength(*rssi);
+            }
+        }
+    }
+
+    Bridge::~Bridge()
+    {
+        try {
+            Stop();
+        } catch (const BluetoothException &ignored) {}
+    }
+
+    void Bridge::Start()
+    {
+        if (m_running) {
+            return;
+        }
+
+        // Calibrated here, before the first callback is charged on a thread pool thread
+        CpuUsage::Calibrate();
+
+        m_metrics.MarkActivity();
+        m_conflator.Start();
+
+        if (m_connection && m_options.valueCacheTtl.count() != 0) {
+            m_connection->GetValueCache().SetTimeToLive(m_options.valueCacheTtl);
+        }
+
+        if (m_channel != nullptr) {
+            m_polling = false;
+        } else {
+            auto properties = m_characteristic->GetProperties();
+            m_polling = m_options.polling.force || !m_polledCharacteristics.empty() ||
+                        (!HasProperty(properties, GattCharacteristicProperty::Notify) && !HasProperty(properties, GattCharacteristicProperty::Indicate));
+        }
+
+        if (m_channel != nullptr) {
+            m_characteristicSubscription = m_channel->Subscribe([this](std::vector<uint8_t> data) {
+                CpuUsage::Scope scope { m_callbackCpu };
+                m_metrics.NotificationReceived(data.size());
+                Log::Write(Log::Severity::Debug, "SDU received", { { "size", data.size() } }, m_options.logContext);
+                if (auto monitor = m_trafficMonitor.load(std::memory_order_acquire)) {
+                    monitor->Record(TrafficDirection::Received, data.data(), data.size());
+                }
+
+                m_conflator.Offer(std::move(data));
+            });
+        } else if (m_polling) {
+            m_poller.AddCharacteristic(*m_characteristic);
+            for (auto characteristic : m_polledCharacteristics) {
+                m_poller.AddCharacteristic(*characteristic);
+            }
+
+            m_poller.Start();
+        } else {
+            m_characteristicSubscription = m_characteristic->Subscribe([this](std::vector<uint8_t> data) {
+                CpuUsage::Scope scope { m_callbackCpu };
+                m_metrics.NotificationReceived(data.size());
+                Log::Write(Log::Severity::Debug, "Notification received", { { "size", data.size() } }, m_options.logContext);
+                if (auto monitor = m_trafficMonitor.load(std::memory_order_acquire)) {
+                    monitor->Record(TrafficDirection::Received, data.data(), data.size());
+                }
+
+                m_conflator.Offer(std::move(data));
+            });
+        }
+
+        m_writerExiting = false;
+        m_writerThread = std::thread([this]() { DrainQueue(); });
+
+        m_portSubscription = m_port.Subscribe([this](const std::vector<uint8_t> &data) {
+            CpuUsage::Scope scope { m_callbackCpu };
+            Log::Write(Log::Severity::Debug, "Frame read from port", { { "size", data.size() } }, m_options.logContext);
+
+            try {
+                m_scheduler.Push(data);
+            } catch (const IO::IOException &e) {
+                // Spilling failed, the frame is lost
+                Log::Write(Log::Severity::Error, "Frame lost, spilling failed", { { "size", data.size() }, { "error", e.what() } }, m_options.logContext);
+            }
+
+            std::unique_lock<std::mutex> lock { m_writerMutex };
+            m_writerCondition.notify_all();
+        });
+
+        if (m_options.health.enabled) {
+            if (m_connection) {
+                m_statusSubscription = m_connection->SubscribeStatusChanged([this](bool connected) {
+                    if (!connected) {
+                        ReportDisconnected(LinkFailure::Connection, "connection lost");
+                    }
+                });
+            }
+
+            m_monitorExiting = false;
+            m_monitorThread = std::thread([this]() { MonitorHealth(); });
+        }
+
+        m_running = true;
+    }
+
+    void Bridge::Stop()
+    {
+        if (!m_running) {
+            return;
+        }
+
+        m_running = false;
+
+        if (m_monitorThread.joinable()) {
+            {
+                std::unique_lock<std::mutex> lock { m_monitorMutex };
+                m_monitorExiting = true;
+                m_monitorCondition.notify_all();
+            }
+
+            m_monitorThread.join();
+            if (m_connection) {
+                m_connection->UnsubscribeStatusChanged(m_statusSubscription);
+            }
+        }
+
+        m_port.Unsubscribe(m_portSubscription);
+
+        {
+            std::unique_lock<std::mutex> lock { m_writerMutex };
+            m_writerExiting = true;
+            m_writerCondition.notify_all();
+        }
+
+        m_writerThread.join();
+
+        if (m_channel != nullptr) {
+            m_channel->Unsubscribe(m_characteristicSubscription);
+        } else if (m_polling) {
+            m_poller.Stop();
+        } else {
+            m_characteristic->Unsubscribe(m_characteristicSubscription);
+        }
+
+        m_conflator.Stop();
+    }
+
+    void Bridge::AddPolledCharacteristic(IBluetoothGattCharacteristic &characteristic)
+    {
+        m_polledCharacteristics.push_back(&characteristic);
+    }
+
+    bool Bridge::IsPolling() const noexcept
+    {
+        return m_polling;
+    }
+
+    bool Bridge::IsAlive() const noexcept
+    {
+        return m_alive.load();
+    }
+
+    void Bridge::OnDisconnected(std::function<void(const std::string &)> listener)
+    {
+        std::unique_lock<std::mutex> lock { m_listenerMutex };
+        m_disconnectedListener = std::move(listener);
+    }
+
+    void Bridge::OnRecovered(std::function<void()> listener)
+    {
+        std::unique_lock<std::mutex> lock { m_listenerMutex };
+        m_recoveredListener = std::move(listener);
+    }
+
+    const LinkQualityMetrics &Bridge::GetMetrics() const noexcept
+    {
+        return m_metrics;
+    }
+
+    LinkQualityMetrics &Bridge::GetMetrics() noexcept
+    {
+        return m_metrics;
+    }
+
+    SpillQueueMetrics Bridge::GetQueueMetrics()
+    {
+        return m_scheduler.Metrics();
+    }
+
+    SpillQueueMetrics Bridge::GetQueueMetrics(Priority lane)
+    {
+        return m_scheduler.Metrics(lane);
+    }
+
+    ConflationMetrics Bridge::GetConflationMetrics() const noexcept
+    {
+        return m_conflator.Metrics();
+    }
+
+    PollingMetrics Bridge::GetPollingMetrics() const noexcept
+    {
+        return m_poller.Metrics();
+    }
+
+    BridgeResourceUsage Bridge::GetResourceUsage()
+    {
+        auto queue = m_scheduler.Metrics();
+
+        return BridgeResourceUsage {
+                .threadCpuTime = m_threadCpu.Total(),
+                .callbackCpuTime = m_callbackCpu.Total(),
+                .queueMemoryBytes = queue.memoryBytes,
+                .queueDiskBytes = queue.diskBytes,
+                .bufferBytes = m_conflator.Metrics().bufferBytes,
+                .cacheBytes = m_connection ? m_connection->GetValueCache().Metrics().bytes : 0
+        };
+    }
+
+    void Bridge::AttachMonitor(TrafficMonitor *monitor) noexcept
+    {
+        m_trafficMonitor.store(monitor, std::memory_order_release);
+    }
+
+    bool Bridge::WriteToLink(const std::vector<uint8_t> &data)
+    {
+        BLE_SERIAL_TIMED_SCOPE("bridge.write");
+
+        for (unsigned int attempt = 0; attempt <= m_options.writeRetries; attempt++) {
+            try {
+                auto start = std::chrono::steady_clock::now();
+                if (m_channel != nullptr) {
+                    m_channel->Send(data);
+                } else {
+                    m_characteristic->Write(data);
+                }
+                auto latency = std::chrono::steady_clock::now() - start;
+                m_metrics.WriteAttempted(true, attempt != 0, data.size());
+                m_metrics.WriteCompleted(latency);
+                Log::Write(Log::Severity::Debug, m_channel != nullptr ? "SDU sent" : "Characteristic written",
+                           { { "size", data.size() }, { "latency_us", std::chrono::duration_cast<std::chrono::microseconds>(latency).count() }, { "attempt", attempt } },
+                           m_options.logContext);
+
+                if (auto monitor = m_trafficMonitor.load(std::memory_order_acquire)) {
+                    monitor->Record(TrafficDirection::Sent, data.data(), data.size(), latency);
+                }
+
+                if (!m_alive.load()) {
+                    ReportRecovered();
+                } else if (m_consecutiveErrors.exchange(0) != 0) {
+                    m_metrics.LinkRecovered();
+                    Log::Write(Log::Severity::Info, "Link recovered", {}, m_options.logContext);
+                }
+                return true;
+            } catch (const BluetoothException &e) {
+                m_metrics.WriteAttempted(false, attempt != 0, data.size());
+                Log::Write(Log::Severity::Warning, m_channel != nullptr ? "SDU send failed" : "Characteristic write failed", { { "size", data.size() }, { "attempt", attempt }, { "error", e.what() } }, m_options.logContext);
+            }
+        }
+
+        if (m_options.health.enabled && m_consecutiveErrors.fetch_add(1) + 1 >= m_options.health.maxConsecutiveErrors) {
+            ReportDisconnected(LinkFailure::Writes, "too many failed writes");
+        }
+
+        return false;
+    }
+
+    void Bridge::DrainQueue()
+    {
+        CpuUsage::ThreadMeter meter { m_threadCpu };
+        std::vector<uint8_t> frame, next;
+
+        for (;;) {
+            meter.Update();
+
+            {
+                std::unique_lock<std::mutex> lock { m_writerMutex };
+                m_writerCondition.wait(lock, [this]() { return m_writerExiting || !m_scheduler.Empty(); });
+
+                if (m_writerExiting) {
+                    return;
+                }
+            }
+
+            // Picked again for every packet, so a newly queued control frame preempts the bulk backlog
+            auto lane = m_scheduler.Front(frame);
+            if (!lane) {
+                continue;
+            }
+
+            if (m_channel != nullptr) {
+                // Consecutive packets of the lane are merged into one SDU, taken off the queue it is retried as a whole
+                m_scheduler.Pop(*lane);
+
+                size_t maxSduSize = m_channel->GetMaxSduSize();
+                while (frame.size() < maxSduSize && m_scheduler.Front(next) == lane && frame.size() + next.size() <= maxSduSize) {
+                    frame.insert(frame.end(), next.begin(), next.end());
+                    m_scheduler.Pop(*lane);
+                }
+
+                while (!WriteToLink(frame)) {
+                    if (WaitForWriter(m_options.retryInterval)) {
+                        return;
+                    }
+                }
+            } else {
+                if (!WriteToLink(frame)) {
+                    // The link is down, keep the frame and try again later
+                    if (WaitForWriter(m_options.retryInterval)) {
+                        return;
+                    }
+
+                    continue;
+                }
+
+                m_scheduler.Pop(*lane);
+            }
+
+            if (m_options.replayRate != 0 && !m_scheduler.Empty()) {
+                auto delay = std::chrono::microseconds { frame.size() * 1000000 / m_options.replayRate };
+
+                if (WaitForWriter(delay)) {
+                    return;
+                }
+            }
+        }
+    }
+
+    bool Bridge::WaitForWriter(std::chrono::steady_clock::duration duration)
+    {
+        std::unique_lock<std::mutex> lock { m_writerMutex };
+        return m_writerCondition.wait_for(lock, duration, [this]() { return m_writerExiting; });
+    }
+
+    void Bridge::MonitorHealth()
+    {
+        const auto &options = m_options.health;
+        uint64_t lastReads = 0;
+        std::optional<std::chrono::steady_clock::time_point> downSince;
+        CpuUsage::ThreadMeter meter { m_threadCpu };
+
+        for (;;) {
+            meter.Update();
+
+            {
+                std::unique_lock<std::mutex> lock { m_monitorMutex };
+                if (m_monitorCondition.wait_for(lock, options.checkInterval, [this]() { return m_monitorExiting; })) {
+                    return;
+                }
+            }
+
+            if (m_polling) {
+                // Polled values may legitimately stay unchanged, any finished read proves the link is alive
+                uint64_t reads = m_poller.Metrics().reads;
+                if (reads != lastReads) {
+                    lastReads = reads;
+                    m_metrics.MarkActivity();
+                }
+            }
+
+            if (!m_alive.load()) {
+                // A dead link is watched until there is proof that it works again, what proves it depends on how it
+                // failed; failed writes are only cleared by a write going through
+                if (!downSince) {
+                    downSince = std::chrono::steady_clock::now();
+                }
+
+                if (!IsLinkOpen()) {
+                    continue;
+                }
+
+                bool works;
+                if (options.readHeartbeat && m_characteristic != nullptr) {
+                    works = Heartbeat();
+                } else if (m_failure.load() == LinkFailure::Inactivity) {
+                    works = m_metrics.GetLastActivity() > *downSince;
+                } else {
+                    works = m_failure.load() == LinkFailure::Connection;
+                }
+
+                if (works) {
+                    ReportRecovered();
+                }
+
+                continue;
+            }
+
+            downSince.reset();
+
+            if (!IsLinkOpen()) {
+                ReportDisconnected(LinkFailure::Connection, "connection closed");
+                continue;
+            }
+
+            if (options.readHeartbeat && m_characteristic != nullptr) {
+                if (Heartbeat()) {
+                    if (m_consecutiveErrors.exchange(0) != 0) {
+                        m_metrics.LinkRecovered();
+                        Log::Write(Log::Severity::Info, "Link recovered", {}, m_options.logContext);
+                    }
+                } else if (m_consecutiveErrors.fetch_add(1) + 1 >= options.maxConsecutiveErrors) {
+                    ReportDisconnected(LinkFailure::Heartbeats, "too many failed heartbeats");
+                    continue;
+                }
+            }
+
+            if (options.inactivityTimeout.count() != 0 && std::chrono::steady_clock::now() - m_metrics.GetLastActivity() > options.inactivityTimeout) {
+                ReportDisconnected(LinkFailure::Inactivity, "link inactive");
+            }
+        }
+    }
+
+    bool Bridge::Heartbeat()
+    {
+        try {
+            // A cached value would prove nothing about the link
+            (void) m_characteristic->Read(GattReadMode::Uncached);
+            m_metrics.HeartbeatAttempted(true);
+            return true;
+        } catch (const BluetoothException &e) {
+            m_metrics.HeartbeatAttempted(false);
+            Log::Write(Log::Severity::Warning, "Heartbeat failed", { { "error", e.what() } }, m_options.logContext);
+            return false;
+        }
+    }
+
+    bool Bridge::IsLinkOpen() const noexcept
+    {
+        return (!m_connection || m_connection->IsOpen()) && (m_channel == nullptr || m_channel->IsOpen());
+    }
+
+    void Bridge::ReportDisconnected(LinkFailure failure, const std::string &reason)
+    {
+        // Changed under the lock, so that the listeners see the drops and recoveries in the order they happened
+        std::unique_lock<std::mutex> lock { m_listenerMutex };
+        if (!m_alive.exchange(false)) {
+            // Already reported
+            return;
+        }
+
+        m_failure.store(failure);
+
+        Log::Write(Log::Severity::Error, "Link down", { { "reason", reason } }, m_options.logContext);
+
+        if (m_disconnectedListener) {
+            m_disconnectedListener(reason);
+        }
+    }
+
+    void Bridge::ReportRecovered()
+    {
+        std::unique_lock<std::mutex> lock { m_listenerMutex };
+        if (m_alive.exchange(true)) {
+            // Already reported
+            return;
+        }
+
+        m_consecutiveErrors.store(0);
+        m_metrics.LinkRecovered();
+        Log::Write(Log::Severity::Info, "Link up", {}, m_options.logContext);
+
+        if (m_recoveredListener) {
+            m_recoveredListener();
+        }
+    }
+}
@@ -1,6 +1,5 @@
 #include <ble_serial/com.hpp>
-
-#include <thread>
+#include <ble_serial/instrumentation.hpp>
 
 namespace BLE_Serial::COM
 {
@@ -15,7 +14,7 @@ namespace BLE_Serial::COM
     {
     }
 
-    const char *COMException::what() const
+    const char *COMException::what() const noexcept
     {
         return m_message.c_str();
     }
@@ -34,61 +33,37 @@ namespace BLE_Serial::COM
 
     size_t COMPort::Subscribe(std::function<void(std::vector<uint8_t>)> listener)
     {
-        std::unique_lock<std::mutex> lock { m_mutex };
-        m_callbacks.emplace_back(std::move(listener));
-        m_condition.notify_all();
-
-        if (!m_subscriberThread.joinable()) {
-            m_subscriberThread = std::thread([this]() {
-                uint8_t buffer[128];
-
-                for (;;) {
-                    std::unique_lock<std::mutex> lock { m_mutex };
-
-                    if (m_exiting) {
-                        return;
-                    }
-
-                    if (m_callbacks.empty()) {
-                        m_condition.wait(lock);
-                        break;
-                    }
-
-                    size_t read = Read(buffer, sizeof(buffer));
-                    if (read == 0) {
-                        std::this_thread::sleep_for(m_refreshRate);
-                        continue;
-                    }
-
-                    std::vector<uint8_t> data { buffer, buffer + read };
-
-                    for (auto &callback : m_callbacks) {
-                        callback(data);
-                    }
-                }
-            });
-        }
-
-        return m_callbacks.size() - 1;
+        return m_subscribers.Subscribe(std::move(listener));
     }
 
     void COMPort::Unsubscribe(size_t id)
     {
-        std::unique_lock<std::mutex> lock { m_mutex };
-        m_callbacks.erase(m_callbacks.begin() + id);
-        m_condition.notify_all();
+        m_subscribers.Unsubscribe(id);
     }
 
     void COMPort::UnsubscribeAll()
     {
-        m_exiting = true;
-        std::unique_lock<std::mutex> lock { m_mutex };
-        m_callbacks.clear();
-        m_condition.notify_all();
+        m_subscribers.UnsubscribeAll();
+    }
 
-        if (m_subscriberThread.joinable()) {
-            m_subscriberThread.join();
+    bool COMPort::ReadForListeners(std::vector<uint8_t> &data)
+    {
+        uint8_t buffer[128];
+        size_t read = 0;
+
+        {
+            BLE_SERIAL_TIMED_SCOPE("com.read");
+            read = Read(buffer, sizeof(buffer));
+        }
+
+        if (read == 0) {
+            m_subscribers.Idle(GetRefreshRate());
+            return false;
         }
+
+        BLE_SERIAL_COUNT("com.read.bytes", read);
+        data.assign(buffer, buffer + read);
+        return true;
     }
 
     void COMPort::SetRefreshRate(std::chrono::milliseconds rate) noexcept
@@ -0,0 +1,163 @@
+#include <ble_serial/conflation.hpp>
+#include <ble_serial/instrumentation.hpp>
+
+namespace BLE_Serial::Bridge
+{
+    namespace
+    {
+        /**
+         * FNV-1a hash, used to detect identical consecutive payloads without keeping a copy of them
+         */
+        uint64_t HashPayload(const std::vector<uint8_t> &data) noexcept
+        {
+            uint64_t hash = 0xCBF29CE484222325ull;
+
+            for (uint8_t byte : data) {
+                hash ^= byte;
+                hash *= 0x100000001B3ull;
+            }
+
+            // Zero is reserved for "nothing forwarded yet"
+            return hash == 0 ? 1 : hash;
+        }
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // Conflator implementation                             //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    Conflator::Conflator(ConflationOptions options, std::function<void(const std::vector<uint8_t> &)> sink)
+            : m_options { options }, m_sink { std::move(sink) }
+    {
+        if (m_options.everyNth == 0) {
+            m_options.everyNth = 1;
+        }
+    }
+
+    Conflator::~Conflator()
+    {
+        Stop();
+    }
+
+    void Conflator::Start()
+    {
+        if (m_options.mode == ConflationMode::None || m_flusherThread.joinable()) {
+            return;
+        }
+
+        m_state.fetch_and(static_cast<uint8_t>(~ExitBit));
+        m_flusherThread = std::thread([this]() { Flush(); });
+    }
+
+    void Conflator::Stop()
+    {
+        if (!m_flusherThread.joinable()) {
+            return;
+        }
+
+        m_state.fetch_or(ExitBit);
+        m_state.notify_all();
+        m_flusherThread.join();
+    }
+
+    void Conflator::Offer(std::vector<uint8_t> &&data)
+    {
+        uint64_t received = m_received.fetch_add(1, std::memory_order_relaxed);
+        if (received % m_options.everyNth != 0) {
+            return;
+        }
+
+        if (m_options.mode == ConflationMode::None) {
+            Forward(data);
+            return;
+        }
+
+        // Reading the slots would race with the flusher, their size is bounded by the largest payload instead
+        if (data.size() > m_largestPayload.load(std::memory_order_relaxed)) {
+            m_largestPayload.store(data.size(), std::memory_order_relaxed);
+        }
+
+        // Publish into the back buffer and swap it with the middle one, the flusher owns the front buffer
+        m_buffers[m_back].swap(data);
+
+        uint8_t previous = m_state.load(std::memory_order_relaxed);
+        while (!m_state.compare_exchange_weak(previous, static_cast<uint8_t>(m_back | FreshBit | (previous & ExitBit)), std::memory_order_acq_rel)) {}
+
+        m_back = previous & IndexMask;
+        m_state.notify_one();
+    }
+
+    ConflationMetrics Conflator::Metrics() const noexcept
+    {
+        uint64_t received = m_received.load(std::memory_order_relaxed);
+        uint64_t forwarded = m_forwarded.load(std::memory_order_relaxed);
+
+        return ConflationMetrics {
+                .received = received,
+                .forwarded = forwarded,
+                .dropped = received - forwarded,
+                .bufferBytes = m_buffers.size() * m_largestPayload.load(std::memory_order_relaxed)
+        };
+    }
+
+    void Conflator::Flush()
+    {
+        auto lastForward = std::chrono::steady_clock::now() - m_options.interval;
+
+        for (;;) {
+            uint8_t state = m_state.load(std::memory_order_acquire);
+
+            while ((state & (FreshBit | ExitBit)) == 0) {
+                m_state.wait(state, std::memory_order_acquire);
+                state = m_state.load(std::memory_order_acquire);
+            }
+
+            if (state & ExitBit) {
+                return;
+            }
+
+            auto now = std::chrono::steady_clock::now();
+            if (now - lastForward < m_options.interval) {
+                if (m_options.mode == ConflationMode::MinInterval) {
+                    // Too early, the payload is dropped without ever being copied
+                    while (!m_state.compare_exchange_weak(state, static_cast<uint8_t>(m_front | (state & ExitBit)), std::memory_order_acq_rel)) {}
+                    m_front = state & IndexMask;
+                    continue;
+                }
+
+                // Let the rest of the interval pass, newer payloads replace the pending one meanwhile
+                std::this_thread::sleep_for(m_options.interval - (now - lastForward));
+                state = m_state.load(std::memory_order_acquire);
+            }
+
+            while (!m_state.compare_exchange_weak(state, static_cast<uint8_t>(m_front | (state & ExitBit)), std::memory_order_acq_rel)) {}
+            m_front = state & IndexMask;
+
+            if (state & ExitBit) {
+                return;
+            }
+
+            lastForward = std::chrono::steady_clock::now();
+            Forward(m_buffers[m_front]);
+        }
+    }
+
+    void Conflator::Forward(const std::vector<uint8_t> &data)
+    {
+        if (m_options.deduplicate && IsDuplicate(data)) {
+            return;
+        }
+
+        BLE_SERIAL_TIMED_SCOPE("conflation.forward");
+        m_forwarded.fetch_add(1, std::memory_order_relaxed);
+        m_sink(data);
+    }
+
+    bool Conflator::IsDuplicate(const std::vector<uint8_t> &data) noexcept
+    {
+        uint64_t hash = HashPayload(data);
+        return m_lastHash.exchange(hash, std::memory_order_relaxed) == hash;
+    }
+}
@@ -0,0 +1,62 @@
+#include <ble_serial/cpu_usage.hpp>
+
+namespace BLE_Serial::Bridge
+{
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // CpuUsage implementation                              //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    void CpuUsage::Charge(std::chrono::nanoseconds time) noexcept
+    {
+        // Coarse clocks may step back a little between two threads, never let the account shrink
+        if (time.count() > 0) {
+            m_total.fetch_add(time.count(), std::memory_order_relaxed);
+        }
+    }
+
+    std::chrono::nanoseconds CpuUsage::Total() const noexcept
+    {
+        return std::chrono::nanoseconds { m_total.load(std::memory_order_relaxed) };
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // CpuUsage::Scope implementation                       //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    CpuUsage::Scope::Scope(CpuUsage &usage) noexcept
+            : m_usage { usage }, m_start { ThreadTime() }
+    {
+    }
+
+    CpuUsage::Scope::~Scope()
+    {
+        m_usage.Charge(ThreadTime() - m_start);
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // CpuUsage::ThreadMeter implementation                 //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    CpuUsage::ThreadMeter::ThreadMeter(CpuUsage &usage) noexcept
+            : m_usage { usage }, m_last { ThreadTime() }
+    {
+    }
+
+    CpuUsage::ThreadMeter::~ThreadMeter()
+    {
+        Update();
+    }
+
+    void CpuUsage::ThreadMeter::Update() noexcept
+    {
+        auto now = ThreadTime();
+        m_usage.Charge(now - m_last);
+        m_last = now;
+    }
+}
@@ -0,0 +1,64 @@
+#include "decode.hpp"
+#include "endpoint.hpp"
+
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+using namespace BLE_Serial::Bluetooth;
+using namespace BLE_Serial::Gatt;
+
+int Decode(const DecodeSettings &settings, const std::atomic_bool &stop)
+{
+    // The standard output carries the records, everything else goes to the standard error
+    auto endpoint = OpenEndpoint(settings.address, settings.serviceId, settings.characteristicId, settings.timeout, std::cerr);
+
+    auto decoder = GattDecoderRegistry::GetStandard().Resolve(*endpoint.characteristic);
+    if (!decoder) {
+        throw BluetoothException("The characteristic has neither a known layout nor a presentation format");
+    }
+
+    std::mutex mutex;
+    GattRecord record {};
+    std::string json;
+    std::vector<uint8_t> binary;
+    uint64_t decoded = 0;
+    uint64_t malformed = 0;
+
+    auto id = endpoint.characteristic->Subscribe([&](std::vector<uint8_t> data) {
+        std::unique_lock<std::mutex> lock { mutex };
+
+        if (!decoder->Decode(data.data(), data.size(), record)) {
+            malformed++;
+            return;
+        }
+
+        decoded++;
+
+        if (settings.format == DecodeFormat::Json) {
+            json.clear();
+            AppendJson(json, record);
+            std::cout.write(json.data(), static_cast<std::streamsize>(json.size()));
+        } else {
+            binary.clear();
+            AppendBinary(binary, record);
+            std::cout.write(reinterpret_cast<const char *>(binary.data()), static_cast<std::streamsize>(binary.size()));
+        }
+
+        std::cout.flush();
+    });
+
+    std::cerr << "Decoding, press Ctrl+C to stop" << std::endl;
+
+    while (!stop.load()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+
+    endpoint.characteristic->Unsubscribe(id);
+    endpoint.connection->Close();
+
+    std::unique_lock<std::mutex> lock { mutex };
+    std::cerr << "Decoded " << decoded << " notifications, " << malformed << " too short for their layout" << std::endl;
+
+    return 0;
+}
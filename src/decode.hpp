@@ -0,0 +1,42 @@
+#ifndef BLE_SERIAL_SRC_DECODE_HPP_
+#define BLE_SERIAL_SRC_DECODE_HPP_
+
+#include <ble_serial/gatt_decoder.hpp>
+
+#include <atomic>
+#include <chrono>
+
+/**
+ * @brief Output format of the decode command.
+ */
+enum class DecodeFormat
+{
+    Json,   ///< NDJSON, see @link BLE_Serial::Gatt::AppendJson @endlink
+    Binary  ///< see @link BLE_Serial::Gatt::AppendBinary @endlink
+};
+
+/**
+ * @brief Settings of the decode command.
+ */
+struct DecodeSettings
+{
+    BLE_Serial::Bluetooth::BluetoothAddress address;
+    BLE_Serial::Bluetooth::GattRegisteredService serviceId;
+    BLE_Serial::Bluetooth::GattRegisteredCharacteristic characteristicId;
+    std::chrono::seconds timeout { 5 };
+    DecodeFormat format = DecodeFormat::Json;
+};
+
+/**
+ * @brief Writes the decoded notifications of a characteristic to the standard output until interrupted.
+ *
+ * @param settings settings of the command
+ * @param stop flag that ends the command when set
+ *
+ * @return exit code of the application
+ *
+ * @throw BluetoothException when the characteristic has no known format
+ */
+int Decode(const DecodeSettings &settings, const std::atomic_bool &stop);
+
+#endif // BLE_SERIAL_SRC_DECODE_HPP_
@@ -0,0 +1,926 @@
+#include <ble_serial/dfu.hpp>
+#include <ble_serial/instrumentation.hpp>
+#include <ble_serial/uuid_database.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#define BLE_SERIAL_DFU_ARM_CRC32 1
+#elif defined(_M_ARM64)
+#include <intrin.h>
+#define BLE_SERIAL_DFU_ARM_CRC32 1
+#elif defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define BLE_SERIAL_DFU_CLMUL_TARGET
+#else
+#define BLE_SERIAL_DFU_CLMUL_TARGET __attribute__((target("pclmul,sse4.1")))
+#endif
+#define BLE_SERIAL_DFU_X86_CLMUL 1
+#endif
+
+namespace BLE_Serial::Dfu
+{
+    using namespace BLE_Serial::Bluetooth;
+    using namespace BLE_Serial::Log;
+
+    namespace
+    {
+        constexpr int c_maxWriteAttempts = 5;
+
+        /**
+         * Slicing-by-8 tables, table k advances the CRC over k more zero bytes than the first one
+         */
+        [[maybe_unused]] constexpr std::array<std::array<uint32_t, 256>, 8> c_crcTables = []() {
+            std::array<std::array<uint32_t, 256>, 8> tables {};
+
+            for (uint32_t i = 0; i < 256; i++) {
+                uint32_t crc = i;
+                for (int bit = 0; bit < 8; bit++) {
+                    crc = (crc & 1) != 0 ? (crc >> 1) ^ 0xEDB88320 : crc >> 1;
+                }
+                tables[0][i] = crc;
+            }
+
+            for (size_t table = 1; table < tables.size(); table++) {
+                for (uint32_t i = 0; i < 256; i++) {
+                    tables[table][i] = (tables[table - 1][i] >> 8) ^ tables[0][tables[table - 1][i] & 0xFF];
+                }
+            }
+
+            return tables;
+        }();
+
+#ifdef BLE_SERIAL_DFU_X86_CLMUL
+        bool HasClmul() noexcept
+        {
+#ifdef _MSC_VER
+            int registers[4];
+            __cpuid(registers, 1);
+            return (registers[2] & (1 << 1)) != 0 && (registers[2] & (1 << 19)) != 0;
+#else
+            return __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1");
+#endif
+        }
+
+        const bool c_hasClmul = HasClmul();
+
+        BLE_SERIAL_DFU_CLMUL_TARGET __m128i LoadBlock(const uint8_t *block) noexcept
+        {
+            return _mm_loadu_si128(reinterpret_cast<const __m128i *>(block));
+        }
+
+        /**
+         * Multiplies both halves of the value by their fold constant and adds the next block
+         */
+        BLE_SERIAL_DFU_CLMUL_TARGET __m128i Fold(__m128i value, __m128i constants, __m128i next) noexcept
+        {
+            __m128i low = _mm_clmulepi64_si128(value, constants, 0x00);
+            __m128i high = _mm_clmulepi64_si128(value, constants, 0x11);
+            return _mm_xor_si128(_mm_xor_si128(high, low), next);
+        }
+
+        /**
+         * Folds 64 bytes at a time with carry-less multiplications and reduces the result with Barrett's method, as in
+         * Intel's "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ Instruction" (the constants are the
+         * bit-reflected ones of its appendix)
+         *
+         * @param crc the CRC state, i.e. the inverted CRC
+         * @param size at least 64 and a multiple of 16
+         *
+         * @return the CRC state after the data
+         */
+        BLE_SERIAL_DFU_CLMUL_TARGET uint32_t Crc32Clmul(const uint8_t *data, size_t size, uint32_t crc) noexcept
+        {
+            const __m128i k1k2 = _mm_set_epi64x(0x01C6E41596, 0x0154442BD4);
+            const __m128i k3k4 = _mm_set_epi64x(0x00CCAA009E, 0x01751997D0);
+            const __m128i k5 = _mm_set_epi64x(0, 0x0163CD6124);
+            const __m128i polynomial = _mm_set_epi64x(0x01F7011641, 0x01DB710641);
+            const __m128i low32 = _mm_setr_epi32(~0, 0, ~0, 0);
+
+            __m128i x1 = _mm_xor_si128(LoadBlock(data), _mm_cvtsi32_si128(static_cast<int>(crc)));
+            __m128i x2 = LoadBlock(data + 16);
+            __m128i x3 = LoadBlock(data + 32);
+            __m128i x4 = LoadBlock(data + 48);
+            data += 64;
+            size -= 64;
+
+            for (; size >= 64; data += 64, size -= 64) {
+                x1 = Fold(x1, k1k2, LoadBlock(data));
+                x2 = Fold(x2, k1k2, LoadBlock(data + 16));
+                x3 = Fold(x3, k1k2, LoadBlock(data + 32));
+                x4 = Fold(x4, k1k2, LoadBlock(data + 48));
+            }
+
+            x1 = Fold(x1, k3k4, x2);
+            x1 = Fold(x1, k3k4, x3);
+            x1 = Fold(x1, k3k4, x4);
+
+            for (; size >= 16; data += 16, size -= 16) {
+                x1 = Fold(x1, k3k4, LoadBlock(data));
+            }
+
+            // 128 to 64 bits
+            __m128i x0 = _mm_clmulepi64_si128(x1, k3k4, 0x10);
+            x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x0);
+            x0 = _mm_srli_si128(x1, 4);
+            x1 = _mm_xor_si128(_mm_clmulepi64_si128(_mm_and_si128(x1, low32), k5, 0x00), x0);
+
+            // Barrett reduction to 32 bits
+            x0 = _mm_clmulepi64_si128(_mm_and_si128(x1, low32), polynomial, 0x10);
+            x0 = _mm_clmulepi64_si128(_mm_and_si128(x0, low32), polynomial, 0x00);
+            x1 = _mm_xor_si128(x1, x0);
+
+            return static_cast<uint32_t>(_mm_extract_epi32(x1, 1));
+        }
+#endif
+
+        uint32_t ReadLittleEndian(const uint8_t *data) noexcept
+        {
+            return static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8) | (static_cast<uint32_t>(data[2]) << 16) | (static_cast<uint32_t>(data[3]) << 24);
+        }
+
+        void AppendLittleEndian(std::vector<uint8_t> &output, uint32_t value)
+        {
+            for (int shift = 0; shift < 32; shift += 8) {
+                output.push_back(static_cast<uint8_t>(value >> shift));
+            }
+        }
+
+        std::vector<uint8_t> CreateRequest(DfuObjectType type, uint32_t size)
+        {
+            std::vector<uint8_t> request { static_cast<uint8_t>(DfuOpCode::Create), static_cast<uint8_t>(type) };
+            AppendLittleEndian(request, size);
+            return request;
+        }
+
+        std::vector<uint8_t> ChecksumResponse(uint32_t offset, uint32_t crc)
+        {
+            std::vector<uint8_t> response { static_cast<uint8_t>(DfuOpCode::Response), static_cast<uint8_t>(DfuOpCode::CalculateChecksum), static_cast<uint8_t>(DfuResult::Success) };
+            AppendLittleEndian(response, offset);
+            AppendLittleEndian(response, crc);
+            return response;
+        }
+
+        const char *OpCodeToString(DfuOpCode opCode) noexcept
+        {
+            switch (opCode) {
+                case DfuOpCode::Create:
+                    return "create";
+                case DfuOpCode::SetReceiptNotification:
+                    return "set receipt notification";
+                case DfuOpCode::CalculateChecksum:
+                    return "calculate checksum";
+                case DfuOpCode::Execute:
+                    return "execute";
+                case DfuOpCode::Select:
+                    return "select";
+                default:
+                    return "unknown request";
+            }
+        }
+
+        std::string ResultToString(DfuResult result, const std::vector<uint8_t> &payload)
+        {
+            switch (result) {
+                case DfuResult::OpCodeNotSupported:
+                    return "request not supported";
+                case DfuResult::InvalidParameter:
+                    return "invalid parameter";
+                case DfuResult::InsufficientResources:
+                    return "insufficient resources";
+                case DfuResult::InvalidObject:
+                    return "invalid object";
+                case DfuResult::UnsupportedType:
+                    return "unsupported object type";
+                case DfuResult::OperationNotPermitted:
+                    return "operation not permitted";
+                case DfuResult::OperationFailed:
+                    return "operation failed";
+                case DfuResult::ExtendedError:
+                    return "extended error " + (payload.empty() ? std::string { "?" } : std::to_string(payload[0]));
+                default:
+                    return "result " + std::to_string(static_cast<int>(result));
+            }
+        }
+    }
+
+    uint32_t Crc32(const uint8_t *data, size_t size, uint32_t crc) noexcept
+    {
+        crc = ~crc;
+
+#ifdef BLE_SERIAL_DFU_ARM_CRC32
+        for (; size >= 8; data += 8, size -= 8) {
+            uint64_t word;
+            std::memcpy(&word, data, sizeof(word));
+            crc = __crc32d(crc, word);
+        }
+
+        for (; size != 0; data++, size--) {
+            crc = __crc32b(crc, *data);
+        }
+#else
+#ifdef BLE_SERIAL_DFU_X86_CLMUL
+        if (size >= 64 && c_hasClmul) {
+            size_t folded = size & ~static_cast<size_t>(15);
+            crc = Crc32Clmul(data, folded, crc);
+            data += folded;
+            size -= folded;
+        }
+#endif
+
+        for (; size >= 8; data += 8, size -= 8) {
+            uint32_t low = ReadLittleEndian(data) ^ crc;
+            crc = c_crcTables[7][low & 0xFF] ^ c_crcTables[6][(low >> 8) & 0xFF] ^ c_crcTables[5][(low >> 16) & 0xFF] ^ c_crcTables[4][low >> 24] ^
+                  c_crcTables[3][data[4]] ^ c_crcTables[2][data[5]] ^ c_crcTables[1][data[6]] ^ c_crcTables[0][data[7]];
+        }
+
+        for (; size != 0; data++, size--) {
+            crc = (crc >> 8) ^ c_crcTables[0][(crc ^ *data) & 0xFF];
+        }
+#endif
+
+        return ~crc;
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // SecureDfuClient implementation                       //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    SecureDfuClient::SecureDfuClient(IBluetoothGattCharacteristic &controlPoint, IBluetoothGattCharacteristic &packet, DfuOptions options)
+            : m_controlPoint { controlPoint },
+              m_packet { packet },
+              m_options { std::move(options) },
+              m_subscription { m_controlPoint.Subscribe([this](std::vector<uint8_t> data) { OnNotification(std::move(data)); }) }
+    {
+        m_options.packetSize = std::max<size_t>(m_options.packetSize, 1);
+        m_options.receiptWindow = std::max<size_t>(m_options.receiptWindow, 1);
+    }
+
+    SecureDfuClient::~SecureDfuClient()
+    {
+        m_controlPoint.Unsubscribe(m_subscription);
+    }
+
+    bool SecureDfuClient::Upload(const uint8_t *initPacket, size_t initPacketSize, const uint8_t *firmware, size_t firmwareSize, const std::atomic_bool &stop)
+    {
+        if (initPacketSize == 0 || firmwareSize == 0) {
+            throw std::invalid_argument("The init packet and the firmware must not be empty");
+        }
+        if (initPacketSize > UINT32_MAX || firmwareSize > UINT32_MAX) {
+            throw std::invalid_argument("The firmware image is too large");
+        }
+
+        BLE_SERIAL_TIMED_SCOPE("dfu.upload");
+
+        {
+            std::unique_lock<std::mutex> lock { m_mutex };
+            m_responses.clear();
+            m_checksums.clear();
+            m_protocolError.reset();
+        }
+        m_progress = DfuProgress { .sent = 0, .total = firmwareSize, .resumed = 0, .objects = 0, .retries = 0 };
+
+        // Also restarts the packet count of the target, so the receipts line up with this upload
+        Request({ static_cast<uint8_t>(DfuOpCode::SetReceiptNotification), static_cast<uint8_t>(m_options.receiptInterval), static_cast<uint8_t>(m_options.receiptInterval >> 8) });
+        WaitForResponse(DfuOpCode::SetReceiptNotification);
+
+        // Requests act on the object selected last, so the command object is selected second for its execute
+        auto data = Select(DfuObjectType::Data);
+        auto command = Select(DfuObjectType::Command);
+        if (data.maxSize == 0) {
+            throw BluetoothException("DFU target reported an empty data object size");
+        }
+
+        auto size = static_cast<uint32_t>(firmwareSize);
+        bool initPacketHeld = command.checksum == Checksum { static_cast<uint32_t>(initPacketSize), Crc32(initPacket, initPacketSize) };
+        bool dataMatches = data.checksum.offset <= size && data.checksum.crc == Crc32(firmware, data.checksum.offset);
+        uint32_t start = 0;
+
+        if (!initPacketHeld) {
+            // A new init packet discards whatever data the target holds
+            if (!SendInitPacket(initPacket, initPacketSize, stop)) {
+                return false;
+            }
+        } else if (data.checksum.offset == 0) {
+            Execute();
+        } else if (dataMatches) {
+            start = data.checksum.offset;
+            Select(DfuObjectType::Data);
+
+            // The last object may be complete but not executed yet; a refusal means it was executed, or the next one
+            // was created and is created again below
+            if ((start % data.maxSize == 0 || start == size) && !TryExecute()) {
+                Write(Severity::Debug, "Last firmware object needs no execute", { { "offset", start } }, m_options.logContext);
+            }
+        } else if (data.checksum.offset <= size && data.checksum.offset % data.maxSize != 0) {
+            // Only the unexecuted object is wrong, creating it again drops it
+            start = data.checksum.offset - data.checksum.offset % data.maxSize;
+        } else {
+            if (!SendInitPacket(initPacket, initPacketSize, stop)) {
+                return false;
+            }
+        }
+
+        if (start != 0) {
+            Write(Severity::Info, "Resuming firmware update", { { "offset", start }, { "size", size } }, m_options.logContext);
+        }
+
+        m_progress.sent = start;
+        m_progress.resumed = start;
+        if (start != 0 && m_options.progress) {
+            m_options.progress(m_progress);
+        }
+
+        return SendFirmware(firmware, size, data.maxSize, start, stop);
+    }
+
+    void SecureDfuClient::OnNotification(std::vector<uint8_t> data)
+    {
+        std::unique_lock<std::mutex> lock { m_mutex };
+
+        if (data.size() < 3 || data[0] != static_cast<uint8_t>(DfuOpCode::Response)) {
+            m_protocolError = "DFU target sent a malformed response";
+        } else {
+            auto request = static_cast<DfuOpCode>(data[1]);
+            auto result = static_cast<DfuResult>(data[2]);
+            std::vector<uint8_t> payload { data.begin() + 3, data.end() };
+
+            if (request == DfuOpCode::CalculateChecksum && result == DfuResult::Success) {
+                // Receipt notifications and explicit checksum requests share the response
+                if (payload.size() < 8) {
+                    m_protocolError = "DFU target sent a malformed checksum";
+                } else {
+                    m_checksums.push_back(Checksum { ReadLittleEndian(payload.data()), ReadLittleEndian(payload.data() + 4) });
+                }
+            } else {
+                m_responses.push_back(Response { request, result, std::move(payload) });
+            }
+        }
+
+        m_condition.notify_all();
+    }
+
+    void SecureDfuClient::Request(const std::vector<uint8_t> &request)
+    {
+        m_controlPoint.Write(request, GattWriteMode::WithResponse);
+    }
+
+    SecureDfuClient::Response SecureDfuClient::WaitForResponse(DfuOpCode request, bool allowRefusal)
+    {
+        std::unique_lock<std::mutex> lock { m_mutex };
+
+        if (!m_condition.wait_for(lock, m_options.responseTimeout, [this] { return m_protocolError || !m_responses.empty(); })) {
+            throw BluetoothException(std::string { "DFU target did not answer " } + OpCodeToString(request) + " in time");
+        }
+        if (m_protocolError) {
+            throw BluetoothException(*m_protocolError);
+        }
+
+        auto response = std::move(m_responses.front());
+        m_responses.pop_front();
+
+        if (response.request != request) {
+            throw BluetoothException(std::string { "DFU target answered " } + OpCodeToString(response.request) + " instead of " + OpCodeToString(request));
+        }
+        if (response.result != DfuResult::Success && !allowRefusal) {
+            throw BluetoothException(std::string { "DFU target refused " } + OpCodeToString(request) + ": " + ResultToString(response.result, response.payload));
+        }
+
+        return response;
+    }
+
+    SecureDfuClient::Checksum SecureDfuClient::WaitForChecksum()
+    {
+        std::unique_lock<std::mutex> lock { m_mutex };
+
+        if (!m_condition.wait_for(lock, m_options.responseTimeout, [this] { return m_protocolError || !m_checksums.empty() || !m_responses.empty(); })) {
+            throw BluetoothException("DFU target did not report its checksum in time");
+        }
+        if (m_protocolError) {
+            throw BluetoothException(*m_protocolError);
+        }
+        if (m_checksums.empty()) {
+            // Nothing else is outstanding while the checksums are awaited, so this is a refusal
+            auto &response = m_responses.front();
+            throw BluetoothException(std::string { "DFU target refused " } + OpCodeToString(response.request) + ": " + ResultToString(response.result, response.payload));
+        }
+
+        auto checksum = m_checksums.front();
+        m_checksums.pop_front();
+        return checksum;
+    }
+
+    SecureDfuClient::Selection SecureDfuClient::Select(DfuObjectType type)
+    {
+        Request({ static_cast<uint8_t>(DfuOpCode::Select), static_cast<uint8_t>(type) });
+
+        auto response = WaitForResponse(DfuOpCode::Select);
+        if (response.payload.size() < 12) {
+            throw BluetoothException("DFU target sent a malformed object selection");
+        }
+
+        return Selection {
+                .maxSize = ReadLittleEndian(response.payload.data()),
+                .checksum = Checksum { ReadLittleEndian(response.payload.data() + 4), ReadLittleEndian(response.payload.data() + 8) }
+        };
+    }
+
+    void SecureDfuClient::Create(DfuObjectType type, uint32_t size)
+    {
+        Request(CreateRequest(type, size));
+        WaitForResponse(DfuOpCode::Create);
+    }
+
+    void SecureDfuClient::Execute()
+    {
+        BLE_SERIAL_TIMED_SCOPE("dfu.execute");
+
+        Request({ static_cast<uint8_t>(DfuOpCode::Execute) });
+        WaitForResponse(DfuOpCode::Execute);
+    }
+
+    bool SecureDfuClient::TryExecute()
+    {
+        BLE_SERIAL_TIMED_SCOPE("dfu.execute");
+
+        Request({ static_cast<uint8_t>(DfuOpCode::Execute) });
+        return WaitForResponse(DfuOpCode::Execute, true).result == DfuResult::Success;
+    }
+
+    SecureDfuClient::Checksum SecureDfuClient::CalculateChecksum()
+    {
+        Request({ static_cast<uint8_t>(DfuOpCode::CalculateChecksum) });
+        return WaitForChecksum();
+    }
+
+    void SecureDfuClient::WritePacket(const std::vector<uint8_t> &packet)
+    {
+        // Writes without response fail when the controller's queue is full, give it a moment to drain
+        for (int attempt = 1;; attempt++) {
+            try {
+                m_packet.Write(packet, GattWriteMode::WithoutResponse);
+                return;
+            } catch (const BluetoothException &) {
+                if (attempt == c_maxWriteAttempts) {
+                    throw;
+                }
+
+                std::this_thread::sleep_for(std::chrono::milliseconds(5 * attempt));
+            }
+        }
+    }
+
+    bool SecureDfuClient::SendObject(const uint8_t *image, uint32_t begin, uint32_t end, uint32_t &crc, const std::atomic_bool &stop)
+    {
+        // What every receipt notification must report, checked as they arrive
+        std::deque<Checksum> receipts;
+        bool matches = true;
+
+        auto confirm = [&]() {
+            auto checksum = WaitForChecksum();
+            if (!(checksum == receipts.front())) {
+                matches = false;
+            }
+            receipts.pop_front();
+        };
+
+        std::vector<uint8_t> packet;
+        packet.reserve(m_options.packetSize);
+        uint16_t sinceReceipt = 0;
+
+        for (uint32_t offset = begin; offset < end;) {
+            if (stop.load()) {
+                return false;
+            }
+
+            // Keeps at most the window in flight, so a corrupted packet costs no more than that
+            while (receipts.size() >= m_options.receiptWindow && matches) {
+                confirm();
+            }
+            if (!matches) {
+                break;
+            }
+
+            auto size = static_cast<uint32_t>(std::min<size_t>(m_options.packetSize, end - offset));
+            packet.assign(image + offset, image + offset + size);
+            WritePacket(packet);
+
+            crc = Crc32(image + offset, size, crc);
+            offset += size;
+
+            if (m_options.receiptInterval != 0 && ++sinceReceipt == m_options.receiptInterval) {
+                sinceReceipt = 0;
+                receipts.push_back(Checksum { offset, crc });
+            }
+        }
+
+        // Drains the outstanding receipts even after a mismatch, so they are not taken for the next checksum
+        while (!receipts.empty()) {
+            confirm();
+        }
+
+        return matches;
+    }
+
+    bool SecureDfuClient::SendInitPacket(const uint8_t *initPacket, size_t initPacketSize, const std::atomic_bool &stop)
+    {
+        auto size = static_cast<uint32_t>(initPacketSize);
+
+        for (size_t attempt = 0;; attempt++) {
+            Create(DfuObjectType::Command, size);
+
+            uint32_t crc = 0;
+            bool sent = SendObject(initPacket, 0, size, crc, stop);
+            if (stop.load()) {
+                return false;
+            }
+            if (sent && CalculateChecksum() == Checksum { size, crc }) {
+                break;
+            }
+
+            if (attempt == m_options.maxRetries) {
+                throw BluetoothException("Init packet checksum kept mismatching");
+            }
+            Write(Severity::Warning, "Init packet checksum mismatch, sending it again", {}, m_options.logContext);
+        }
+
+        Execute();
+        return true;
+    }
+
+    bool SecureDfuClient::SendFirmware(const uint8_t *firmware, uint32_t firmwareSize, uint32_t maxObjectSize, uint32_t start, const std::atomic_bool &stop)
+    {
+        bool executePending = false;
+        auto finishExecute = [&](uint32_t end) {
+            WaitForResponse(DfuOpCode::Execute);
+            executePending = false;
+
+            m_progress.sent = end;
+            m_progress.objects++;
+            if (m_options.progress) {
+                m_options.progress(m_progress);
+            }
+        };
+
+        uint32_t position = start;
+        uint32_t objectBegin = position - position % maxObjectSize;
+        uint32_t objectCrc = Crc32(firmware, objectBegin);
+
+        while (position < firmwareSize) {
+            uint32_t objectEnd = objectBegin + std::min(maxObjectSize, firmwareSize - objectBegin);
+
+            if (position == objectBegin) {
+                // Sent right behind the previous execute, the target answers both in order
+                Request(CreateRequest(DfuObjectType::Data, objectEnd - objectBegin));
+                if (executePending) {
+                    finishExecute(objectBegin);
+                }
+                WaitForResponse(DfuOpCode::Create);
+            }
+
+            uint32_t crc = position == objectBegin ? objectCrc : Crc32(firmware + objectBegin, position - objectBegin, objectCrc);
+
+            for (size_t attempt = 0;; attempt++) {
+                bool sent = SendObject(firmware, position, objectEnd, crc, stop);
+                if (stop.load()) {
+                    return false;
+                }
+                if (sent && CalculateChecksum() == Checksum { objectEnd, crc }) {
+                    break;
+                }
+
+                if (attempt == m_options.maxRetries) {
+                    throw BluetoothException("Firmware checksum kept mismatching at offset " + std::to_string(objectBegin));
+                }
+
+                Write(Severity::Warning, "Firmware checksum mismatch, sending the object again", { { "offset", objectBegin } }, m_options.logContext);
+                m_progress.retries++;
+
+                // Creating the object again drops what the target received of it
+                Create(DfuObjectType::Data, objectEnd - objectBegin);
+                position = objectBegin;
+                crc = objectCrc;
+            }
+
+            {
+                BLE_SERIAL_TIMED_SCOPE("dfu.execute");
+                Request({ static_cast<uint8_t>(DfuOpCode::Execute) });
+                executePending = true;
+
+                // The last object is activated by its execute, so its result is always awaited
+                if (!m_options.pipelineObjects || objectEnd == firmwareSize) {
+                    finishExecute(objectEnd);
+                }
+            }
+
+            position = objectEnd;
+            objectBegin = objectEnd;
+            objectCrc = crc;
+        }
+
+        if (executePending) {
+            finishExecute(position);
+        }
+
+        return true;
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // SimulatedDfuTarget implementation                    //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    /**
+     * A characteristic of the simulated target, forwarding the writes to it
+     */
+    class SimulatedDfuTarget::Characteristic : public IBluetoothGattCharacteristic
+    {
+    public:
+        Characteristic(SimulatedDfuTarget &target, BluetoothUUID uuid, GattCharacteristicProperty properties, uint16_t handle)
+                : m_target { target }, m_uuid { uuid }, m_properties { properties }, m_handle { handle }
+        {
+        }
+
+        [[nodiscard]] BluetoothUUID GetUUID() const override
+        {
+            return m_uuid;
+        }
+
+        [[nodiscard]] GattRegisteredCharacteristic GetRegisteredCharacteristicType() const override
+        {
+            return static_cast<GattRegisteredCharacteristic>(m_uuid.custom);
+        }
+
+        [[nodiscard]] GattCharacteristicProperty GetProperties() const override
+        {
+            return m_properties;
+        }
+
+        [[nodiscard]] uint16_t GetHandle() const override
+        {
+            return m_handle;
+        }
+
+        using IBluetoothGattCharacteristic::Read;
+
+        std::vector<uint8_t> Read(GattReadMode) override
+        {
+            throw BluetoothException("Characteristic is not readable");
+        }
+
+        using IBluetoothGattCharacteristic::Write;
+
+        void Write(const std::vector<uint8_t> &data, GattWriteMode mode) override
+        {
+            auto required = mode == GattWriteMode::WithResponse ? GattCharacteristicProperty::Write : GattCharacteristicProperty::WriteWithoutResponse;
+            if (!HasProperty(m_properties, required)) {
+                throw BluetoothException("Characteristic does not support the write mode");
+            }
+
+            if (HasProperty(m_properties, GattCharacteristicProperty::Notify)) {
+                m_target.OnControlPoint(data);
+            } else {
+                m_target.OnPacket(data);
+            }
+        }
+
+        size_t Subscribe(std::function<void(std::vector<uint8_t>)> listener) override
+        {
+            if (!HasProperty(m_properties, GattCharacteristicProperty::Notify)) {
+                throw BluetoothException("Characteristic does not notify");
+            }
+
+            std::unique_lock<std::mutex> lock { m_target.m_mutex };
+            m_target.m_listener = std::move(listener);
+            return 1;
+        }
+
+        void Unsubscribe(size_t) override
+        {
+            UnsubscribeAll();
+        }
+
+        void UnsubscribeAll() override
+        {
+            std::unique_lock<std::mutex> lock { m_target.m_mutex };
+            m_target.m_listener = nullptr;
+        }
+
+    private:
+        SimulatedDfuTarget &m_target;
+        BluetoothUUID m_uuid;
+        GattCharacteristicProperty m_properties;
+        uint16_t m_handle;
+    };
+
+    SimulatedDfuTarget::SimulatedDfuTarget(uint32_t maxDataObjectSize, uint32_t maxCommandObjectSize)
+            : m_maxDataObjectSize { maxDataObjectSize },
+              m_maxCommandObjectSize { maxCommandObjectSize },
+              m_controlPoint { std::make_unique<Characteristic>(*this, Gatt::ParseUuid(SecureDfuControlPointUuid).value(),
+                                                                static_cast<GattCharacteristicProperty>(static_cast<uint32_t>(GattCharacteristicProperty::Write) |
+                                                                                                        static_cast<uint32_t>(GattCharacteristicProperty::Notify)),
+                                                                0x0010) },
+              m_packet { std::make_unique<Characteristic>(*this, Gatt::ParseUuid(SecureDfuPacketUuid).value(), GattCharacteristicProperty::WriteWithoutResponse, 0x0013) }
+    {
+        m_thread = std::thread { &SimulatedDfuTarget::Run, this };
+    }
+
+    SimulatedDfuTarget::~SimulatedDfuTarget()
+    {
+        {
+            std::unique_lock<std::mutex> lock { m_mutex };
+            m_exiting = true;
+            m_condition.notify_all();
+        }
+
+        m_thread.join();
+    }
+
+    IBluetoothGattCharacteristic &SimulatedDfuTarget::GetControlPoint() noexcept
+    {
+        return *m_controlPoint;
+    }
+
+    IBluetoothGattCharacteristic &SimulatedDfuTarget::GetPacket() noexcept
+    {
+        return *m_packet;
+    }
+
+    std::vector<uint8_t> SimulatedDfuTarget::GetInitPacket() const
+    {
+        std::unique_lock<std::mutex> lock { m_mutex };
+        return { m_command.received.begin(), m_command.received.begin() + m_command.executed };
+    }
+
+    std::vector<uint8_t> SimulatedDfuTarget::GetFirmware() const
+    {
+        std::unique_lock<std::mutex> lock { m_mutex };
+        return { m_data.received.begin(), m_data.received.begin() + m_data.executed };
+    }
+
+    void SimulatedDfuTarget::OnControlPoint(const std::vector<uint8_t> &request)
+    {
+        std::unique_lock<std::mutex> lock { m_mutex };
+
+        if (request.empty()) {
+            return;
+        }
+
+        auto opCode = static_cast<DfuOpCode>(request[0]);
+        std::vector<uint8_t> response { static_cast<uint8_t>(DfuOpCode::Response), request[0], static_cast<uint8_t>(DfuResult::Success) };
+        auto fail = [&](DfuResult result) {
+            response[2] = static_cast<uint8_t>(result);
+            Notify(std::move(response));
+        };
+
+        switch (opCode) {
+            case DfuOpCode::Create: {
+                if (request.size() < 6) {
+                    return fail(DfuResult::InvalidParameter);
+                }
+
+                auto type = static_cast<DfuObjectType>(request[1]);
+                uint32_t size = ReadLittleEndian(request.data() + 2);
+
+                if (type == DfuObjectType::Command) {
+                    if (size == 0 || size > m_maxCommandObjectSize) {
+                        return fail(DfuResult::InsufficientResources);
+                    }
+
+                    // A new init packet starts a new update
+                    m_command = Object {};
+                    m_data = Object {};
+                    m_current = &m_command;
+                } else if (type == DfuObjectType::Data) {
+                    if (m_command.executed == 0) {
+                        return fail(DfuResult::OperationNotPermitted);
+                    }
+                    if (size == 0 || size > m_maxDataObjectSize) {
+                        return fail(DfuResult::InsufficientResources);
+                    }
+
+                    // Drops what was received of an object that was never executed
+                    m_data.received.resize(m_data.executed);
+                    m_data.crc = Crc32(m_data.received.data(), m_data.received.size());
+                    m_current = &m_data;
+                } else {
+                    return fail(DfuResult::UnsupportedType);
+                }
+
+                m_current->objectBegin = m_current->executed;
+                m_current->objectSize = size;
+                m_packetsSinceReceipt = 0;
+                break;
+            }
+            case DfuOpCode::SetReceiptNotification:
+                if (request.size() < 3) {
+                    return fail(DfuResult::InvalidParameter);
+                }
+
+                m_receiptInterval = static_cast<uint16_t>(request[1] | (request[2] << 8));
+                m_packetsSinceReceipt = 0;
+                break;
+            case DfuOpCode::CalculateChecksum: {
+                auto &object = m_current ? *m_current : m_data;
+                return Notify(ChecksumResponse(static_cast<uint32_t>(object.received.size()), object.crc));
+            }
+            case DfuOpCode::Execute: {
+                if (!m_current) {
+                    return fail(DfuResult::OperationNotPermitted);
+                }
+
+                auto &object = *m_current;
+                if (object.objectSize == 0) {
+                    // Executing an object again succeeds as long as nothing was received since
+                    if (object.received.size() != object.executed || object.executed == 0) {
+                        return fail(DfuResult::OperationNotPermitted);
+                    }
+                    break;
+                }
+                if (object.received.size() != object.objectBegin + object.objectSize) {
+                    return fail(DfuResult::OperationNotPermitted);
+                }
+
+                object.executed = static_cast<uint32_t>(object.received.size());
+                object.objectSize = 0;
+                break;
+            }
+            case DfuOpCode::Select: {
+                if (request.size() < 2) {
+                    return fail(DfuResult::InvalidParameter);
+                }
+
+                auto type = static_cast<DfuObjectType>(request[1]);
+                if (type != DfuObjectType::Command && type != DfuObjectType::Data) {
+                    return fail(DfuResult::UnsupportedType);
+                }
+
+                m_current = type == DfuObjectType::Command ? &m_command : &m_data;
+                AppendLittleEndian(response, type == DfuObjectType::Command ? m_maxCommandObjectSize : m_maxDataObjectSize);
+                AppendLittleEndian(response, static_cast<uint32_t>(m_current->received.size()));
+                AppendLittleEndian(response, m_current->crc);
+                break;
+            }
+            default:
+                return fail(DfuResult::OpCodeNotSupported);
+        }
+
+        Notify(std::move(response));
+    }
+
+    void SimulatedDfuTarget::OnPacket(const std::vector<uint8_t> &data)
+    {
+        std::unique_lock<std::mutex> lock { m_mutex };
+
+        // The bootloader drops data that does not fit into the current object
+        if (!m_current || m_current->objectSize == 0 || m_current->received.size() + data.size() > m_current->objectBegin + m_current->objectSize) {
+            return;
+        }
+
+        m_current->received.insert(m_current->received.end(), data.begin(), data.end());
+        m_current->crc = Crc32(data.data(), data.size(), m_current->crc);
+
+        if (m_receiptInterval != 0 && ++m_packetsSinceReceipt == m_receiptInterval) {
+            m_packetsSinceReceipt = 0;
+            Notify(ChecksumResponse(static_cast<uint32_t>(m_current->received.size()), m_current->crc));
+        }
+    }
+
+    void SimulatedDfuTarget::Notify(std::vector<uint8_t> notification)
+    {
+        m_notifications.push_back(std::move(notification));
+        m_condition.notify_all();
+    }
+
+    void SimulatedDfuTarget::Run()
+    {
+        std::unique_lock<std::mutex> lock { m_mutex };
+
+        while (true) {
+            m_condition.wait(lock, [this] { return m_exiting || !m_notifications.empty(); });
+            if (m_exiting) {
+                return;
+            }
+
+            auto notification = std::move(m_notifications.front());
+            m_notifications.pop_front();
+            auto listener = m_listener;
+
+            // Delivered outside of the lock, the listener may write to the target again
+            lock.unlock();
+            if (listener) {
+                listener(std::move(notification));
+            }
+            lock.lock();
+        }
+    }
+}
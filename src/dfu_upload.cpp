@@ -0,0 +1,148 @@
+#include "dfu_upload.hpp"
+
+#include <ble_serial/dfu.hpp>
+#include <ble_serial/mapped_file.hpp>
+#include <ble_serial/uuid_database.hpp>
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+
+using namespace BLE_Serial::Bluetooth;
+using namespace BLE_Serial::Dfu;
+using namespace BLE_Serial::IO;
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    constexpr std::chrono::milliseconds c_progressInterval { 500 };
+
+    /**
+     * Largest write without response on a 247 byte MTU, what the simulated target is updated with
+     */
+    constexpr size_t c_simulatedPacketSize = 244;
+
+    void PrintProgress(const DfuProgress &progress, Clock::duration elapsed, bool last)
+    {
+        double seconds = std::max(std::chrono::duration<double>(elapsed).count(), 0.001);
+
+        // The throughput only counts what this run sent
+        std::cout << "\r" << progress.sent << "/" << progress.total << " bytes (" << (progress.sent * 100 / progress.total) << "%), " << progress.objects << " objects";
+        std::cout << std::fixed << std::setprecision(2) << ", " << static_cast<double>(progress.sent - progress.resumed) / 1024.0 / seconds << " KiB/s   ";
+        std::cout << std::defaultfloat;
+
+        if (last) {
+            std::cout << "\nSent " << (progress.sent - progress.resumed) << " bytes in " << std::fixed << std::setprecision(2) << seconds << " s" << std::defaultfloat;
+            if (progress.retries != 0) {
+                std::cout << ", " << progress.retries << " objects sent again";
+            }
+            std::cout << std::endl;
+        } else {
+            std::cout << std::flush;
+        }
+    }
+
+    IBluetoothGattCharacteristic &FindCharacteristic(IBluetoothGattService &service, const char *uuid)
+    {
+        auto &characteristic = service.GetCharacteristic(BLE_Serial::Gatt::ParseUuid(uuid).value());
+        if (!characteristic) {
+            throw BluetoothException(std::string { "Secure DFU characteristic " } + uuid + " couldn't be found");
+        }
+
+        return *characteristic;
+    }
+}
+
+int UploadFirmware(const DfuSettings &settings, const std::atomic_bool &stop)
+{
+    auto initPacket = MappedFile::OpenReadOnly(settings.initPacket);
+    auto firmware = MappedFile::OpenReadOnly(settings.firmware);
+
+    std::unique_ptr<SimulatedDfuTarget> simulated;
+    std::shared_ptr<IBluetoothConnection> connection;
+    IBluetoothGattCharacteristic *controlPoint;
+    IBluetoothGattCharacteristic *packet;
+    size_t packetSize;
+
+    if (!settings.address) {
+        std::cout << "Updating a simulated target" << std::endl;
+
+        simulated = std::make_unique<SimulatedDfuTarget>();
+        controlPoint = &simulated->GetControlPoint();
+        packet = &simulated->GetPacket();
+        packetSize = c_simulatedPacketSize;
+    } else {
+        std::cout << "Connecting ..." << std::endl;
+
+        auto deviceOptional = IBluetoothService::GetService().FindDevice(*settings.address, settings.timeout);
+        if (!deviceOptional) {
+            throw BluetoothException("Device with address " + BluetoothAddressToString(*settings.address) + " couldn't be found");
+        }
+
+        connection = deviceOptional.value()->OpenConnection(settings.timeout);
+
+        auto service = connection->GetService(BLE_Serial::Gatt::ParseUuid(SecureDfuServiceUuid).value());
+        if (!service) {
+            throw BluetoothException("Device is not in its Secure DFU bootloader");
+        }
+
+        service->FetchCharacteristics();
+        controlPoint = &FindCharacteristic(*service, SecureDfuControlPointUuid);
+        packet = &FindCharacteristic(*service, SecureDfuPacketUuid);
+        packetSize = connection->GetMaxWriteSize();
+    }
+
+    std::cout << "Sending a " << initPacket.Size() << " byte init packet and a " << firmware.Size() << " byte firmware in packets of " << packetSize << " bytes" << std::endl;
+
+    auto start = Clock::now();
+    auto lastProgress = start;
+    DfuProgress progress { .sent = 0, .total = firmware.Size(), .resumed = 0, .objects = 0, .retries = 0 };
+
+    bool complete;
+    {
+        SecureDfuClient client { *controlPoint, *packet, DfuOptions {
+                .packetSize = packetSize,
+                .receiptInterval = settings.receiptInterval,
+                .receiptWindow = settings.receiptWindow,
+                .responseTimeout = settings.timeout,
+                .progress = [&](const DfuProgress &current) {
+                    progress = current;
+
+                    auto now = Clock::now();
+                    if (now - lastProgress >= c_progressInterval) {
+                        lastProgress = now;
+                        PrintProgress(progress, now - start, false);
+                    }
+                }
+        }};
+
+        complete = client.Upload(initPacket.Data(), initPacket.Size(), firmware.Data(), firmware.Size(), stop);
+    }
+
+    PrintProgress(progress, Clock::now() - start, true);
+
+    // The bootloader activates the firmware and resets after the last object, dropping the link on its own
+    if (connection) {
+        connection->Close();
+    }
+
+    if (!complete) {
+        std::cout << "Update interrupted, run the same command again to resume it" << std::endl;
+        return 1;
+    }
+
+    if (simulated) {
+        if (simulated->GetFirmware() != std::vector<uint8_t> { firmware.Data(), firmware.Data() + firmware.Size() }) {
+            std::cerr << "Simulated target holds a different firmware" << std::endl;
+            return 1;
+        }
+
+        std::cout << "Simulated target holds the firmware" << std::endl;
+    } else {
+        std::cout << "Firmware update complete" << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,46 @@
+#ifndef BLE_SERIAL_SRC_DFU_UPLOAD_HPP_
+#define BLE_SERIAL_SRC_DFU_UPLOAD_HPP_
+
+#include <ble_serial/bluetooth.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+/**
+ * @brief Settings of a firmware update.
+ */
+struct DfuSettings
+{
+    /**
+     * Device in its Secure DFU bootloader, empty to update an in-process simulated target.
+     */
+    std::optional<BLE_Serial::Bluetooth::BluetoothAddress> address;
+    std::string initPacket;
+    std::string firmware;
+    std::chrono::seconds timeout { 5 };
+
+    /**
+     * Packets between the receipt notifications of the target.
+     */
+    uint16_t receiptInterval = 12;
+
+    /**
+     * Receipt intervals in flight before waiting for the oldest one.
+     */
+    size_t receiptWindow = 2;
+};
+
+/**
+ * @brief Uploads a firmware with the Nordic Secure DFU protocol, resuming an interrupted update of the same image.
+ *
+ * @param settings settings of the update
+ * @param stop flag that interrupts the update when set
+ *
+ * @return exit code of the application
+ */
+int UploadFirmware(const DfuSettings &settings, const std::atomic_bool &stop);
+
+#endif // BLE_SERIAL_SRC_DFU_UPLOAD_HPP_
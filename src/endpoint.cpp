@@ -0,0 +1,33 @@
+#include "endpoint.hpp"
+
+#include <iostream>
+
+using namespace BLE_Serial::Bluetooth;
+
+CharacteristicEndpoint OpenEndpoint(BluetoothAddress address, GattRegisteredService serviceId, GattRegisteredCharacteristic characteristicId, std::chrono::seconds timeout,
+                                    std::ostream &status)
+{
+    status << "Connecting ..." << std::endl;
+
+    auto deviceOptional = IBluetoothService::GetService().FindDevice(address, timeout);
+    if (!deviceOptional) {
+        throw BluetoothException("Device with address " + BluetoothAddressToString(address) + " couldn't be found");
+    }
+
+    CharacteristicEndpoint endpoint {};
+    endpoint.connection = deviceOptional.value()->OpenConnection(timeout);
+
+    auto service = endpoint.connection->GetService(GetServiceUUID(serviceId));
+    if (!service) {
+        throw BluetoothException("Requested service couldn't be found");
+    }
+
+    service->FetchCharacteristics();
+    auto &characteristic = service->GetCharacteristic(GetCharacteristicUUID(characteristicId));
+    if (!characteristic) {
+        throw BluetoothException("Requested characteristic couldn't be found");
+    }
+
+    endpoint.characteristic = characteristic.get();
+    return endpoint;
+}
@@ -0,0 +1,36 @@
+#ifndef BLE_SERIAL_SRC_ENDPOINT_HPP_
+#define BLE_SERIAL_SRC_ENDPOINT_HPP_
+
+#include <ble_serial/bluetooth.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+
+/**
+ * @brief Open connection together with a single characteristic of it.
+ */
+struct CharacteristicEndpoint
+{
+    std::shared_ptr<BLE_Serial::Bluetooth::IBluetoothConnection> connection;
+    BLE_Serial::Bluetooth::IBluetoothGattCharacteristic *characteristic = nullptr;
+};
+
+/**
+ * @brief Finds a device, connects to it and looks up a characteristic.
+ *
+ * @param address address of the device
+ * @param serviceId service the characteristic belongs to
+ * @param characteristicId the characteristic
+ * @param timeout timeout for finding the device and for the connection
+ * @param status stream the progress is written to
+ *
+ * @return the open endpoint
+ *
+ * @throw BluetoothException when the device, the service or the characteristic cannot be found or the connection fails
+ */
+CharacteristicEndpoint OpenEndpoint(BLE_Serial::Bluetooth::BluetoothAddress address, BLE_Serial::Bluetooth::GattRegisteredService serviceId,
+                                    BLE_Serial::Bluetooth::GattRegisteredCharacteristic characteristicId, std::chrono::seconds timeout,
+                                    std::ostream &status = std::cout);
+
+#endif // BLE_SERIAL_SRC_ENDPOINT_HPP_
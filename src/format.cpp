@@ -0,0 +1,288 @@
+#include <ble_serial/format.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BLE_SERIAL_FORMAT_SSE2
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define BLE_SERIAL_FORMAT_NEON
+#include <arm_neon.h>
+#endif
+
+namespace BLE_Serial::Format
+{
+    namespace
+    {
+        constexpr char c_hexDigits[] = "0123456789ABCDEF";
+
+        /**
+         * Returns the value of a hex digit or -1 if the character is not one
+         */
+        int HexDigitValue(char c) noexcept
+        {
+            if (c >= '0' && c <= '9') {
+                return c - '0';
+            } else if (c >= 'a' && c <= 'f') {
+                return c - 'a' + 10;
+            } else if (c >= 'A' && c <= 'F') {
+                return c - 'A' + 10;
+            }
+
+            return -1;
+        }
+
+        constexpr bool IsPrintable(uint8_t byte) noexcept
+        {
+            return byte >= 0x20 && byte < 0x7F;
+        }
+
+#if defined(BLE_SERIAL_FORMAT_SSE2)
+        /**
+         * Converts nibbles to hex digits, '0' is added to all of them and values over 9 get shifted up to 'A'
+         */
+        inline __m128i NibblesToHex(__m128i nibbles) noexcept
+        {
+            __m128i letters = _mm_cmpgt_epi8(nibbles, _mm_set1_epi8(9));
+            __m128i digits = _mm_add_epi8(nibbles, _mm_set1_epi8('0'));
+            return _mm_add_epi8(digits, _mm_and_si128(letters, _mm_set1_epi8('A' - '0' - 10)));
+        }
+
+        inline void EncodeHex16(const uint8_t *data, char *output) noexcept
+        {
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data));
+            __m128i mask = _mm_set1_epi8(0x0F);
+
+            __m128i high = NibblesToHex(_mm_and_si128(_mm_srli_epi16(bytes, 4), mask));
+            __m128i low = NibblesToHex(_mm_and_si128(bytes, mask));
+
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(output), _mm_unpacklo_epi8(high, low));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(output + 16), _mm_unpackhi_epi8(high, low));
+        }
+
+        inline void EncodePrintable16(const uint8_t *data, char *output) noexcept
+        {
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data));
+
+            // Signed comparisons, bytes over 0x7F are negative and fail the first one
+            __m128i printable = _mm_and_si128(_mm_cmpgt_epi8(bytes, _mm_set1_epi8(0x1F)), _mm_cmplt_epi8(bytes, _mm_set1_epi8(0x7F)));
+            __m128i result = _mm_or_si128(_mm_and_si128(printable, bytes), _mm_andnot_si128(printable, _mm_set1_epi8('.')));
+
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(output), result);
+        }
+#elif defined(BLE_SERIAL_FORMAT_NEON)
+        inline void EncodeHex16(const uint8_t *data, char *output) noexcept
+        {
+            uint8x16_t bytes = vld1q_u8(data);
+            uint8x16_t table = vld1q_u8(reinterpret_cast<const uint8_t *>(c_hexDigits));
+
+            uint8x16x2_t digits;
+            digits.val[0] = vqtbl1q_u8(table, vshrq_n_u8(bytes, 4));
+            digits.val[1] = vqtbl1q_u8(table, vandq_u8(bytes, vdupq_n_u8(0x0F)));
+
+            // Interleaving store puts every high digit in front of its low digit
+            vst2q_u8(reinterpret_cast<uint8_t *>(output), digits);
+        }
+
+        inline void EncodePrintable16(const uint8_t *data, char *output) noexcept
+        {
+            uint8x16_t bytes = vld1q_u8(data);
+            uint8x16_t printable = vandq_u8(vcgeq_u8(bytes, vdupq_n_u8(0x20)), vcltq_u8(bytes, vdupq_n_u8(0x7F)));
+
+            vst1q_u8(reinterpret_cast<uint8_t *>(output), vbslq_u8(printable, bytes, vdupq_n_u8('.')));
+        }
+#else
+        inline void EncodeHex16(const uint8_t *data, char *output) noexcept
+        {
+            for (size_t i = 0; i < 16; i++) {
+                output[2 * i] = c_hexDigits[data[i] >> 4];
+                output[2 * i + 1] = c_hexDigits[data[i] & 0x0F];
+            }
+        }
+
+        inline void EncodePrintable16(const uint8_t *data, char *output) noexcept
+        {
+            for (size_t i = 0; i < 16; i++) {
+                output[i] = IsPrintable(data[i]) ? static_cast<char>(data[i]) : '.';
+            }
+        }
+#endif
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // Hex helpers implementation                           //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    void EncodeHex(const uint8_t *data, size_t size, char *output) noexcept
+    {
+        size_t i = 0;
+
+        for (; i + 16 <= size; i += 16) {
+            EncodeHex16(data + i, output + 2 * i);
+        }
+
+        for (; i < size; i++) {
+            output[2 * i] = c_hexDigits[data[i] >> 4];
+            output[2 * i + 1] = c_hexDigits[data[i] & 0x0F];
+        }
+    }
+
+    std::string ToHexString(const std::vector<uint8_t> &data)
+    {
+        if (data.empty()) {
+            return {};
+        }
+
+        std::string result(data.size() * 3 - 1, ' ');
+        char encoded[32];
+
+        for (size_t offset = 0; offset < data.size(); offset += 16) {
+            size_t count = std::min<size_t>(16, data.size() - offset);
+            EncodeHex(data.data() + offset, count, encoded);
+
+            for (size_t i = 0; i < count; i++) {
+                result[(offset + i) * 3] = encoded[2 * i];
+                result[(offset + i) * 3 + 1] = encoded[2 * i + 1];
+            }
+        }
+
+        return result;
+    }
+
+    std::vector<uint8_t> ParseHex(std::string_view text)
+    {
+        std::vector<uint8_t> result;
+        result.reserve(text.size() / 2);
+
+        int high = -1;
+
+        for (size_t i = 0; i < text.size(); i++) {
+            char c = text[i];
+
+            if (c == ' ' || c == '\t' || c == ':' || c == ',') {
+                if (high != -1) {
+                    throw std::invalid_argument("Hex bytes must consist of two digits");
+                }
+                continue;
+            }
+
+            if (c == '0' && high == -1 && i + 1 < text.size() && (text[i + 1] == 'x' || text[i + 1] == 'X')) {
+                i++;
+                continue;
+            }
+
+            int value = HexDigitValue(c);
+            if (value == -1) {
+                throw std::invalid_argument(std::string { "Invalid hex character: " } + c);
+            }
+
+            if (high == -1) {
+                high = value;
+            } else {
+                result.push_back(static_cast<uint8_t>((high << 4) | value));
+                high = -1;
+            }
+        }
+
+        if (high != -1) {
+            throw std::invalid_argument("Hex string has an odd number of digits");
+        }
+
+        return result;
+    }
+
+    std::string ToJsonString(std::string_view text)
+    {
+        std::string result;
+        result.reserve(text.size() + 2);
+        result.push_back('"');
+
+        for (char c : text) {
+            switch (c) {
+                case '"':
+                    result += "\\\"";
+                    break;
+                case '\\':
+                    result += "\\\\";
+                    break;
+                case '\n':
+                    result += "\\n";
+                    break;
+                case '\r':
+                    result += "\\r";
+                    break;
+                case '\t':
+                    result += "\\t";
+                    break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20) {
+                        result += "\\u00";
+                        result.push_back(c_hexDigits[c >> 4]);
+                        result.push_back(c_hexDigits[c & 0x0F]);
+                    } else {
+                        result.push_back(c);
+                    }
+            }
+        }
+
+        result.push_back('"');
+        return result;
+    }
+
+    void HexDump(std::string &output, const uint8_t *data, size_t size, std::string_view indent, size_t baseOffset)
+    {
+        // "OOOO  " + 16 * "XX " + " |" + 16 characters + "|\n"
+        constexpr size_t c_lineLength = 6 + 16 * 3 + 2 + 16 + 2;
+        char encoded[32];
+
+        output.reserve(output.size() + (size + 15) / 16 * (indent.size() + c_lineLength));
+
+        for (size_t offset = 0; offset < size; offset += 16) {
+            size_t count = std::min<size_t>(16, size - offset);
+            size_t lineStart = output.size();
+
+            output.append(indent);
+            output.resize(lineStart + indent.size() + c_lineLength, ' ');
+            char *line = output.data() + lineStart + indent.size();
+
+            size_t address = baseOffset + offset;
+            for (int i = 3; i >= 0; i--, address >>= 4) {
+                line[i] = c_hexDigits[address & 0x0F];
+            }
+
+            EncodeHex(data + offset, count, encoded);
+            for (size_t i = 0; i < count; i++) {
+                line[6 + i * 3] = encoded[2 * i];
+                line[6 + i * 3 + 1] = encoded[2 * i + 1];
+            }
+
+            if (count > 8) {
+                line[6 + 7 * 3 + 2] = '-';
+            }
+
+            char *text = line + 6 + 16 * 3 + 1;
+            text[0] = '|';
+            if (count == 16) {
+                EncodePrintable16(data + offset, text + 1);
+            } else {
+                for (size_t i = 0; i < count; i++) {
+                    text[1 + i] = IsPrintable(data[offset + i]) ? static_cast<char>(data[offset + i]) : '.';
+                }
+            }
+
+            text[1 + count] = '|';
+            text[2 + count] = '\n';
+            output.resize(lineStart + indent.size() + 6 + 16 * 3 + 1 + count + 3);
+        }
+    }
+
+    void HexDump(std::ostream &output, const uint8_t *data, size_t size, std::string_view indent)
+    {
+        std::string text;
+        HexDump(text, data, size, indent);
+        output.write(text.data(), static_cast<std::streamsize>(text.size()));
+    }
+}
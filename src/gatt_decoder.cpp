@@ -0,0 +1,650 @@
+#include <ble_serial/gatt_decoder.hpp>
+#include <ble_serial/format.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace BLE_Serial::Gatt
+{
+    using namespace BLE_Serial::Bluetooth;
+
+    namespace
+    {
+        constexpr uint8_t c_recordMarker = 0xA5;
+
+        constexpr uint16_t c_unitSecond = 0x2703;
+        constexpr uint16_t c_unitMetre = 0x2701;
+        constexpr uint16_t c_unitMetresPerSecond = 0x2712;
+        constexpr uint16_t c_unitPascal = 0x2724;
+        constexpr uint16_t c_unitCelsius = 0x272F;
+        constexpr uint16_t c_unitFahrenheit = 0x27AC;
+        constexpr uint16_t c_unitPercentage = 0x27AD;
+        constexpr uint16_t c_unitBeatsPerMinute = 0x27AF;
+        constexpr uint16_t c_unitDecibel = 0x27C3;
+
+        enum class ValueTag : uint8_t
+        {
+            Boolean = 0,
+            Signed = 1,
+            Unsigned = 2,
+            Double = 3,
+            String = 4
+        };
+
+        /**
+         * Encoded size of a format, 0 for the formats taking the rest of the value
+         */
+        size_t FieldSize(GattFormat format)
+        {
+            switch (format) {
+                case GattFormat::Boolean:
+                case GattFormat::UInt2:
+                case GattFormat::UInt4:
+                case GattFormat::UInt8:
+                case GattFormat::SInt8:
+                    return 1;
+                case GattFormat::UInt12:
+                case GattFormat::UInt16:
+                case GattFormat::SInt12:
+                case GattFormat::SInt16:
+                case GattFormat::SFloat:
+                    return 2;
+                case GattFormat::UInt24:
+                case GattFormat::SInt24:
+                    return 3;
+                case GattFormat::UInt32:
+                case GattFormat::SInt32:
+                case GattFormat::Float32:
+                case GattFormat::Float:
+                case GattFormat::DUInt16:
+                    return 4;
+                case GattFormat::UInt48:
+                case GattFormat::SInt48:
+                    return 6;
+                case GattFormat::UInt64:
+                case GattFormat::SInt64:
+                case GattFormat::Float64:
+                    return 8;
+                case GattFormat::UInt128:
+                case GattFormat::SInt128:
+                    return 16;
+                case GattFormat::Utf8String:
+                case GattFormat::Utf16String:
+                case GattFormat::Struct:
+                    return 0;
+            }
+
+            throw std::invalid_argument("Unknown GATT format: " + std::to_string(static_cast<int>(format)));
+        }
+
+        /**
+         * Multiplies by a power of ten, negative exponents divide so that i.e. 3694e-2 is exactly 36.94
+         */
+        double ApplyExponent(double value, int exponent) noexcept
+        {
+            static const std::array<double, 129> c_powers = []() {
+                std::array<double, 129> powers {};
+                for (size_t i = 0; i < powers.size(); i++) {
+                    powers[i] = std::pow(10.0, static_cast<double>(i));
+                }
+                return powers;
+            }();
+
+            return exponent < 0 ? value / c_powers[static_cast<size_t>(-exponent)] : value * c_powers[static_cast<size_t>(exponent)];
+        }
+
+        uint64_t ReadLittleEndian(const uint8_t *data, size_t size) noexcept
+        {
+            uint64_t value = 0;
+            for (size_t i = 0; i < size; i++) {
+                value |= static_cast<uint64_t>(data[i]) << (8 * i);
+            }
+            return value;
+        }
+
+        int64_t SignExtend(uint64_t value, unsigned int bits) noexcept
+        {
+            auto shift = 64 - bits;
+            return static_cast<int64_t>(value << shift) >> shift;
+        }
+
+        double DecodeSFloat(uint16_t raw) noexcept
+        {
+            switch (raw) {
+                case 0x07FE:
+                    return std::numeric_limits<double>::infinity();
+                case 0x0802:
+                    return -std::numeric_limits<double>::infinity();
+                case 0x07FF:
+                case 0x0800:
+                case 0x0801:
+                    return std::numeric_limits<double>::quiet_NaN();
+                default:
+                    break;
+            }
+
+            auto mantissa = SignExtend(raw & 0x0FFF, 12);
+            auto exponent = SignExtend(raw >> 12, 4);
+            return ApplyExponent(static_cast<double>(mantissa), static_cast<int>(exponent));
+        }
+
+        double DecodeFloat(uint32_t raw) noexcept
+        {
+            switch (raw) {
+                case 0x007FFFFE:
+                    return std::numeric_limits<double>::infinity();
+                case 0x00800002:
+                    return -std::numeric_limits<double>::infinity();
+                case 0x007FFFFF:
+                case 0x00800000:
+                case 0x00800001:
+                    return std::numeric_limits<double>::quiet_NaN();
+                default:
+                    break;
+            }
+
+            auto mantissa = SignExtend(raw & 0x00FFFFFF, 24);
+            auto exponent = static_cast<int8_t>(raw >> 24);
+            return ApplyExponent(static_cast<double>(mantissa), exponent);
+        }
+
+        std::string DecodeUtf16(const uint8_t *data, size_t size)
+        {
+            std::string output;
+            output.reserve(size);
+
+            for (size_t i = 0; i + 1 < size; i += 2) {
+                uint32_t codePoint = data[i] | (data[i + 1] << 8);
+
+                if (codePoint >= 0xD800 && codePoint < 0xDC00 && i + 3 < size) {
+                    uint32_t low = data[i + 2] | (data[i + 3] << 8);
+                    if (low >= 0xDC00 && low < 0xE000) {
+                        codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                        i += 2;
+                    }
+                }
+
+                if (codePoint < 0x80) {
+                    output.push_back(static_cast<char>(codePoint));
+                } else if (codePoint < 0x800) {
+                    output.push_back(static_cast<char>(0xC0 | (codePoint >> 6)));
+                    output.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+                } else if (codePoint < 0x10000) {
+                    output.push_back(static_cast<char>(0xE0 | (codePoint >> 12)));
+                    output.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+                    output.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+                } else {
+                    output.push_back(static_cast<char>(0xF0 | (codePoint >> 18)));
+                    output.push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+                    output.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+                    output.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+                }
+            }
+
+            return output;
+        }
+
+        std::string EncodeHex(const uint8_t *data, size_t size, bool reversed)
+        {
+            std::string output(size * 2, '\0');
+
+            if (reversed) {
+                // Integers are little-endian on the air but read most significant digit first
+                std::array<uint8_t, 16> bigEndian {};
+                for (size_t i = 0; i < size; i++) {
+                    bigEndian[i] = data[size - 1 - i];
+                }
+                Format::EncodeHex(bigEndian.data(), size, output.data());
+            } else {
+                Format::EncodeHex(data, size, output.data());
+            }
+
+            return output;
+        }
+
+        GattValue DecodeField(const GattFieldLayout &layout, const uint8_t *data, size_t size)
+        {
+            auto scaledReal = [&layout](double value) -> GattValue {
+                return ApplyExponent(value * layout.scale, layout.exponent);
+            };
+
+            auto scaled = [&layout, &scaledReal](auto value) -> GattValue {
+                if (layout.scale == 1.0 && layout.exponent == 0) {
+                    return value;
+                }
+                return scaledReal(static_cast<double>(value));
+            };
+
+            switch (layout.format) {
+                case GattFormat::Boolean:
+                    return data[0] != 0;
+                case GattFormat::UInt2:
+                    return scaled(static_cast<uint64_t>(data[0] & 0x03));
+                case GattFormat::UInt4:
+                    return scaled(static_cast<uint64_t>(data[0] & 0x0F));
+                case GattFormat::UInt12:
+                    return scaled(ReadLittleEndian(data, 2) & 0x0FFF);
+                case GattFormat::UInt8:
+                case GattFormat::UInt16:
+                case GattFormat::UInt24:
+                case GattFormat::UInt32:
+                case GattFormat::UInt48:
+                case GattFormat::UInt64:
+                case GattFormat::DUInt16:
+                    return scaled(ReadLittleEndian(data, size));
+                case GattFormat::SInt12:
+                    return scaled(SignExtend(ReadLittleEndian(data, 2), 12));
+                case GattFormat::SInt8:
+                case GattFormat::SInt16:
+                case GattFormat::SInt24:
+                case GattFormat::SInt32:
+                case GattFormat::SInt48:
+                case GattFormat::SInt64:
+                    return scaled(SignExtend(ReadLittleEndian(data, size), static_cast<unsigned int>(size * 8)));
+                case GattFormat::Float32: {
+                    float value;
+                    auto raw = static_cast<uint32_t>(ReadLittleEndian(data, 4));
+                    std::memcpy(&value, &raw, sizeof(value));
+                    return scaledReal(static_cast<double>(value));
+                }
+                case GattFormat::Float64: {
+                    double value;
+                    auto raw = ReadLittleEndian(data, 8);
+                    std::memcpy(&value, &raw, sizeof(value));
+                    return scaledReal(value);
+                }
+                case GattFormat::SFloat:
+                    return scaledReal(DecodeSFloat(static_cast<uint16_t>(ReadLittleEndian(data, 2))));
+                case GattFormat::Float:
+                    return scaledReal(DecodeFloat(static_cast<uint32_t>(ReadLittleEndian(data, 4))));
+                case GattFormat::UInt128:
+                case GattFormat::SInt128:
+                    return EncodeHex(data, size, true);
+                case GattFormat::Utf8String:
+                    return std::string { reinterpret_cast<const char *>(data), size };
+                case GattFormat::Utf16String:
+                    return DecodeUtf16(data, size);
+                case GattFormat::Struct:
+                    return EncodeHex(data, size, false);
+            }
+
+            return false;
+        }
+
+        void AppendVarint(std::vector<uint8_t> &output, uint64_t value)
+        {
+            while (value >= 0x80) {
+                output.push_back(static_cast<uint8_t>(value | 0x80));
+                value >>= 7;
+            }
+            output.push_back(static_cast<uint8_t>(value));
+        }
+
+        void AppendJsonValue(std::string &output, const GattValue &value)
+        {
+            char buffer[32];
+
+            if (auto boolean = std::get_if<bool>(&value)) {
+                output += *boolean ? "true" : "false";
+            } else if (auto integer = std::get_if<int64_t>(&value)) {
+                output.append(buffer, std::to_chars(buffer, buffer + sizeof(buffer), *integer).ptr);
+            } else if (auto unsignedInteger = std::get_if<uint64_t>(&value)) {
+                output.append(buffer, std::to_chars(buffer, buffer + sizeof(buffer), *unsignedInteger).ptr);
+            } else if (auto number = std::get_if<double>(&value)) {
+                if (std::isfinite(*number)) {
+                    output.append(buffer, std::to_chars(buffer, buffer + sizeof(buffer), *number).ptr);
+                } else {
+                    output += "null";
+                }
+            } else {
+                output += Format::ToJsonString(std::get<std::string>(value));
+            }
+        }
+
+        GattFieldLayout Field(std::string name, GattFormat format, uint16_t unit = 0x2700, uint32_t presenceMask = 0, uint32_t presenceValue = 0)
+        {
+            return GattFieldLayout { .name = std::move(name), .format = format, .unit = unit, .presenceMask = presenceMask, .presenceValue = presenceValue };
+        }
+
+        GattFieldLayout Scaled(GattFieldLayout field, double scale, int8_t exponent = 0)
+        {
+            field.scale = scale;
+            field.exponent = exponent;
+            return field;
+        }
+
+        /**
+         * Date Time fields (year, month, day, hours, minutes and seconds) present when the flag is set
+         */
+        void AppendTimestamp(std::vector<GattFieldLayout> &fields, uint32_t flag)
+        {
+            fields.push_back(Field("year", GattFormat::UInt16, 0x2700, flag, flag));
+            for (const auto *name : { "month", "day", "hours", "minutes", "seconds" }) {
+                fields.push_back(Field(name, GattFormat::UInt8, 0x2700, flag, flag));
+            }
+        }
+
+        GattCharacteristicLayout TemperatureMeasurementLayout()
+        {
+            GattCharacteristicLayout layout { .flagsSize = 1, .fields = {} };
+            layout.fields.push_back(Field("temperature_c", GattFormat::Float, c_unitCelsius, 0x01, 0x00));
+            layout.fields.push_back(Field("temperature_f", GattFormat::Float, c_unitFahrenheit, 0x01, 0x01));
+            AppendTimestamp(layout.fields, 0x02);
+            layout.fields.push_back(Field("temperature_type", GattFormat::UInt8, 0x2700, 0x04, 0x04));
+            return layout;
+        }
+
+        GattCharacteristicLayout StringLayout(std::string name)
+        {
+            return GattCharacteristicLayout { .flagsSize = 0, .fields = { Field(std::move(name), GattFormat::Utf8String) } };
+        }
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // GattDecoder implementation                           //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    GattDecoder::GattDecoder(GattRegisteredCharacteristic characteristic, GattCharacteristicLayout layout)
+            : m_characteristic { characteristic }, m_layout { std::move(layout) }, m_minimumSize { m_layout.flagsSize }
+    {
+        if (m_layout.flagsSize > 4) {
+            throw std::invalid_argument("GATT flags wider than 4 bytes");
+        }
+
+        if (m_layout.fields.size() > 255) {
+            throw std::invalid_argument("Too many GATT fields");
+        }
+
+        m_sizes.reserve(m_layout.fields.size());
+
+        for (size_t i = 0; i < m_layout.fields.size(); i++) {
+            const auto &field = m_layout.fields[i];
+            auto size = FieldSize(field.format);
+            bool last = i + 1 == m_layout.fields.size();
+
+            if ((size == 0 || field.repeated) && !last) {
+                throw std::invalid_argument("GATT field " + field.name + " must be the last one");
+            }
+
+            if (size == 0 && field.repeated) {
+                throw std::invalid_argument("GATT field " + field.name + " of variable size cannot repeat");
+            }
+
+            if (field.presenceMask == 0 && !field.repeated) {
+                m_minimumSize += size;
+            }
+
+            m_sizes.push_back(size);
+        }
+    }
+
+    GattDecoder GattDecoder::FromPresentationFormats(GattRegisteredCharacteristic characteristic, const std::vector<GattPresentationFormat> &formats)
+    {
+        if (formats.empty()) {
+            throw std::invalid_argument("No presentation format given");
+        }
+
+        GattCharacteristicLayout layout {};
+
+        for (size_t i = 0; i < formats.size(); i++) {
+            const auto &format = formats[i];
+
+            layout.fields.push_back(GattFieldLayout {
+                    .name = formats.size() == 1 ? "value" : "value" + std::to_string(i),
+                    .format = static_cast<GattFormat>(format.format),
+                    .exponent = format.exponent,
+                    .unit = format.unit
+            });
+        }
+
+        return GattDecoder { characteristic, std::move(layout) };
+    }
+
+    bool GattDecoder::Decode(const uint8_t *data, size_t size, GattRecord &record) const
+    {
+        if (size < m_minimumSize) {
+            return false;
+        }
+
+        record.characteristic = m_characteristic;
+        record.fields.clear();
+
+        auto flags = static_cast<uint32_t>(ReadLittleEndian(data, m_layout.flagsSize));
+        size_t offset = m_layout.flagsSize;
+
+        for (size_t i = 0; i < m_layout.fields.size(); i++) {
+            const auto &field = m_layout.fields[i];
+            if ((flags & field.presenceMask) != field.presenceValue) {
+                continue;
+            }
+
+            auto fieldSize = m_sizes[i];
+            auto index = static_cast<uint8_t>(i);
+
+            if (fieldSize == 0) {
+                record.fields.push_back(GattField { .layout = &field, .index = index, .value = DecodeField(field, data + offset, size - offset) });
+                offset = size;
+            } else if (field.repeated) {
+                for (; offset + fieldSize <= size; offset += fieldSize) {
+                    record.fields.push_back(GattField { .layout = &field, .index = index, .value = DecodeField(field, data + offset, fieldSize) });
+                }
+            } else {
+                if (offset + fieldSize > size) {
+                    return false;
+                }
+
+                record.fields.push_back(GattField { .layout = &field, .index = index, .value = DecodeField(field, data + offset, fieldSize) });
+                offset += fieldSize;
+            }
+        }
+
+        return true;
+    }
+
+    GattRegisteredCharacteristic GattDecoder::GetCharacteristic() const noexcept
+    {
+        return m_characteristic;
+    }
+
+    const GattCharacteristicLayout &GattDecoder::GetLayout() const noexcept
+    {
+        return m_layout;
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // GattDecoderRegistry implementation                   //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    const GattDecoderRegistry &GattDecoderRegistry::GetStandard()
+    {
+        static const GattDecoderRegistry c_registry = []() {
+            using C = GattRegisteredCharacteristic;
+            GattDecoderRegistry registry;
+
+            registry.Register(GattDecoder { C::DeviceName, StringLayout("name") });
+            registry.Register(GattDecoder { C::ModelNumberString, StringLayout("model_number") });
+            registry.Register(GattDecoder { C::SerialNumberString, StringLayout("serial_number") });
+            registry.Register(GattDecoder { C::FirmwareRevisionString, StringLayout("firmware_revision") });
+            registry.Register(GattDecoder { C::HardwareRevisionString, StringLayout("hardware_revision") });
+            registry.Register(GattDecoder { C::SoftwareRevisionString, StringLayout("software_revision") });
+            registry.Register(GattDecoder { C::ManufacturerNameString, StringLayout("manufacturer_name") });
+
+            registry.Register(GattDecoder { C::TxPowerLevel, { .flagsSize = 0, .fields = { Field("tx_power", GattFormat::SInt8, c_unitDecibel) } } });
+            registry.Register(GattDecoder { C::BatteryLevel, { .flagsSize = 0, .fields = { Field("level", GattFormat::UInt8, c_unitPercentage) } } });
+            registry.Register(GattDecoder { C::TemperatureType, { .flagsSize = 0, .fields = { Field("temperature_type", GattFormat::UInt8) } } });
+            registry.Register(GattDecoder { C::BodySensorLocation, { .flagsSize = 0, .fields = { Field("location", GattFormat::UInt8) } } });
+            registry.Register(GattDecoder { C::Pressure, { .flagsSize = 0, .fields = { Scaled(Field("pressure", GattFormat::UInt32, c_unitPascal), 1.0, -1) } } });
+            registry.Register(GattDecoder { C::Temperature, { .flagsSize = 0, .fields = { Scaled(Field("temperature", GattFormat::SInt16, c_unitCelsius), 1.0, -2) } } });
+            registry.Register(GattDecoder { C::Humidity, { .flagsSize = 0, .fields = { Scaled(Field("humidity", GattFormat::UInt16, c_unitPercentage), 1.0, -2) } } });
+
+            registry.Register(GattDecoder { C::TemperatureMeasurement, TemperatureMeasurementLayout() });
+            registry.Register(GattDecoder { C::IntermediateTemperature, TemperatureMeasurementLayout() });
+
+            GattCharacteristicLayout heartRate { .flagsSize = 1, .fields = {} };
+            heartRate.fields.push_back(Field("heart_rate", GattFormat::UInt8, c_unitBeatsPerMinute, 0x01, 0x00));
+            heartRate.fields.push_back(Field("heart_rate", GattFormat::UInt16, c_unitBeatsPerMinute, 0x01, 0x01));
+            heartRate.fields.push_back(Field("energy_expended_kj", GattFormat::UInt16, 0x2700, 0x08, 0x08));
+            heartRate.fields.push_back(Scaled(Field("rr_interval", GattFormat::UInt16, c_unitSecond, 0x10, 0x10), 1.0 / 1024));
+            heartRate.fields.back().repeated = true;
+            registry.Register(GattDecoder { C::HeartRateMeasurement, std::move(heartRate) });
+
+            GattCharacteristicLayout bloodPressure { .flagsSize = 1, .fields = {} };
+            bloodPressure.fields.push_back(Field("systolic", GattFormat::SFloat));
+            bloodPressure.fields.push_back(Field("diastolic", GattFormat::SFloat));
+            bloodPressure.fields.push_back(Field("mean_arterial_pressure", GattFormat::SFloat));
+            AppendTimestamp(bloodPressure.fields, 0x02);
+            bloodPressure.fields.push_back(Field("pulse_rate", GattFormat::SFloat, c_unitBeatsPerMinute, 0x04, 0x04));
+            bloodPressure.fields.push_back(Field("user_id", GattFormat::UInt8, 0x2700, 0x08, 0x08));
+            bloodPressure.fields.push_back(Field("measurement_status", GattFormat::UInt16, 0x2700, 0x10, 0x10));
+            registry.Register(GattDecoder { C::BloodPressureMeasurement, std::move(bloodPressure) });
+
+            GattCharacteristicLayout cyclingSpeed { .flagsSize = 1, .fields = {} };
+            cyclingSpeed.fields.push_back(Field("wheel_revolutions", GattFormat::UInt32, 0x2700, 0x01, 0x01));
+            cyclingSpeed.fields.push_back(Scaled(Field("last_wheel_event_time", GattFormat::UInt16, c_unitSecond, 0x01, 0x01), 1.0 / 1024));
+            cyclingSpeed.fields.push_back(Field("crank_revolutions", GattFormat::UInt16, 0x2700, 0x02, 0x02));
+            cyclingSpeed.fields.push_back(Scaled(Field("last_crank_event_time", GattFormat::UInt16, c_unitSecond, 0x02, 0x02), 1.0 / 1024));
+            registry.Register(GattDecoder { C::CscMeasurement, std::move(cyclingSpeed) });
+
+            GattCharacteristicLayout runningSpeed { .flagsSize = 1, .fields = {} };
+            runningSpeed.fields.push_back(Scaled(Field("speed", GattFormat::UInt16, c_unitMetresPerSecond), 1.0 / 256));
+            runningSpeed.fields.push_back(Field("cadence", GattFormat::UInt8));
+            runningSpeed.fields.push_back(Scaled(Field("stride_length", GattFormat::UInt16, c_unitMetre, 0x01, 0x01), 1.0, -2));
+            runningSpeed.fields.push_back(Scaled(Field("total_distance", GattFormat::UInt32, c_unitMetre, 0x02, 0x02), 1.0, -1));
+            registry.Register(GattDecoder { C::RscMeasurement, std::move(runningSpeed) });
+
+            return registry;
+        }();
+
+        return c_registry;
+    }
+
+    void GattDecoderRegistry::Register(GattDecoder decoder)
+    {
+        auto characteristic = decoder.GetCharacteristic();
+        m_decoders[characteristic] = std::make_shared<const GattDecoder>(std::move(decoder));
+    }
+
+    std::shared_ptr<const GattDecoder> GattDecoderRegistry::Find(GattRegisteredCharacteristic characteristic) const
+    {
+        auto it = m_decoders.find(characteristic);
+        return it != m_decoders.end() ? it->second : nullptr;
+    }
+
+    std::shared_ptr<const GattDecoder> GattDecoderRegistry::Resolve(const IBluetoothGattCharacteristic &characteristic) const
+    {
+        auto type = characteristic.GetRegisteredCharacteristicType();
+        if (auto decoder = Find(type)) {
+            return decoder;
+        }
+
+        auto formats = characteristic.GetPresentationFormats();
+        if (formats.empty()) {
+            return nullptr;
+        }
+
+        try {
+            return std::make_shared<const GattDecoder>(GattDecoder::FromPresentationFormats(type, formats));
+        } catch (const std::invalid_argument &) {
+            // A format this decoder does not know, the value stays opaque
+            return nullptr;
+        }
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // Record encoding implementation                       //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    void AppendJson(std::string &output, const GattRecord &record)
+    {
+        char characteristic[8];
+        auto id = static_cast<uint32_t>(record.characteristic);
+        auto idSize = static_cast<size_t>(std::to_chars(characteristic, characteristic + sizeof(characteristic), id, 16).ptr - characteristic);
+
+        output += "{\"characteristic\":\"";
+        output.append(4 - std::min<size_t>(idSize, 4), '0');
+        for (size_t i = 0; i < idSize; i++) {
+            output.push_back(static_cast<char>(std::toupper(static_cast<unsigned char>(characteristic[i]))));
+        }
+        output.push_back('"');
+
+        for (size_t i = 0; i < record.fields.size(); i++) {
+            const auto &field = record.fields[i];
+            bool first = i == 0 || record.fields[i - 1].layout != field.layout;
+            bool last = i + 1 == record.fields.size() || record.fields[i + 1].layout != field.layout;
+
+            if (first) {
+                output.push_back(',');
+                output += Format::ToJsonString(field.layout->name);
+                output.push_back(':');
+                if (field.layout->repeated) {
+                    output.push_back('[');
+                }
+            } else {
+                output.push_back(',');
+            }
+
+            AppendJsonValue(output, field.value);
+
+            if (last && field.layout->repeated) {
+                output.push_back(']');
+            }
+        }
+
+        output += "}\n";
+    }
+
+    void AppendBinary(std::vector<uint8_t> &output, const GattRecord &record)
+    {
+        auto start = output.size();
+        auto characteristic = static_cast<uint32_t>(record.characteristic);
+
+        output.push_back(c_recordMarker);
+        output.push_back(0);
+        output.push_back(0);
+        output.push_back(static_cast<uint8_t>(characteristic));
+        output.push_back(static_cast<uint8_t>(characteristic >> 8));
+
+        for (const auto &field : record.fields) {
+            output.push_back(field.index);
+
+            if (auto boolean = std::get_if<bool>(&field.value)) {
+                output.push_back(static_cast<uint8_t>(ValueTag::Boolean));
+                output.push_back(*boolean ? 1 : 0);
+            } else if (auto integer = std::get_if<int64_t>(&field.value)) {
+                output.push_back(static_cast<uint8_t>(ValueTag::Signed));
+                AppendVarint(output, (static_cast<uint64_t>(*integer) << 1) ^ static_cast<uint64_t>(*integer >> 63));
+            } else if (auto unsignedInteger = std::get_if<uint64_t>(&field.value)) {
+                output.push_back(static_cast<uint8_t>(ValueTag::Unsigned));
+                AppendVarint(output, *unsignedInteger);
+            } else if (auto number = std::get_if<double>(&field.value)) {
+                uint64_t raw;
+                std::memcpy(&raw, number, sizeof(raw));
+                output.push_back(static_cast<uint8_t>(ValueTag::Double));
+                for (int i = 0; i < 8; i++) {
+                    output.push_back(static_cast<uint8_t>(raw >> (8 * i)));
+                }
+            } else {
+                const auto &text = std::get<std::string>(field.value);
+                output.push_back(static_cast<uint8_t>(ValueTag::String));
+                AppendVarint(output, text.size());
+                output.insert(output.end(), text.begin(), text.end());
+            }
+        }
+
+        auto length = static_cast<uint16_t>(output.size() - start - 3);
+        output[start + 1] = static_cast<uint8_t>(length);
+        output[start + 2] = static_cast<uint8_t>(length >> 8);
+    }
+}
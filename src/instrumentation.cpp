@@ -0,0 +1,138 @@
+#include <ble_serial/instrumentation.hpp>
+
+#include <algorithm>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+namespace BLE_Serial::Instrumentation
+{
+    namespace
+    {
+        std::atomic<Probe *> g_firstProbe { nullptr };
+
+        struct ReportLine
+        {
+            std::string name;
+            ProbeKind kind;
+            uint64_t count;
+            uint64_t total;
+            uint64_t max;
+        };
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // Probe implementation                                 //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    Probe::Probe(const char *name, ProbeKind kind) noexcept
+            : m_name { name }, m_kind { kind }
+    {
+        m_next = g_firstProbe.load(std::memory_order_relaxed);
+        while (!g_firstProbe.compare_exchange_weak(m_next, this, std::memory_order_release, std::memory_order_relaxed)) {}
+    }
+
+    void Probe::Record(uint64_t value) noexcept
+    {
+        m_count.fetch_add(1, std::memory_order_relaxed);
+        m_total.fetch_add(value, std::memory_order_relaxed);
+
+        uint64_t max = m_max.load(std::memory_order_relaxed);
+        while (value > max && !m_max.compare_exchange_weak(max, value, std::memory_order_relaxed)) {}
+    }
+
+    const char *Probe::Name() const noexcept
+    {
+        return m_name;
+    }
+
+    ProbeKind Probe::Kind() const noexcept
+    {
+        return m_kind;
+    }
+
+    uint64_t Probe::Count() const noexcept
+    {
+        return m_count.load(std::memory_order_relaxed);
+    }
+
+    uint64_t Probe::Total() const noexcept
+    {
+        return m_total.load(std::memory_order_relaxed);
+    }
+
+    uint64_t Probe::Max() const noexcept
+    {
+        return m_max.load(std::memory_order_relaxed);
+    }
+
+    const Probe *Probe::Next() const noexcept
+    {
+        return m_next;
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // ScopedTimer implementation                           //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    ScopedTimer::ScopedTimer(Probe &probe) noexcept
+            : m_probe { probe }, m_start { std::chrono::steady_clock::now() }
+    {
+    }
+
+    ScopedTimer::~ScopedTimer()
+    {
+        m_probe.Record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start).count()));
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // Report implementation                                //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    const Probe *FirstProbe() noexcept
+    {
+        return g_firstProbe.load(std::memory_order_acquire);
+    }
+
+    void Report(std::ostream &output)
+    {
+        std::vector<ReportLine> lines;
+
+        for (auto probe = FirstProbe(); probe != nullptr; probe = probe->Next()) {
+            auto it = std::find_if(lines.begin(), lines.end(), [probe](const ReportLine &line) { return line.name == probe->Name() && line.kind == probe->Kind(); });
+            if (it == lines.end()) {
+                lines.push_back(ReportLine { .name = probe->Name(), .kind = probe->Kind(), .count = 0, .total = 0, .max = 0 });
+                it = lines.end() - 1;
+            }
+
+            it->count += probe->Count();
+            it->total += probe->Total();
+            it->max = std::max(it->max, probe->Max());
+        }
+
+        std::sort(lines.begin(), lines.end(), [](const ReportLine &a, const ReportLine &b) { return a.name < b.name; });
+
+        output << std::left << std::setw(36) << "Phase" << std::right << std::setw(10) << "Count" << std::setw(14) << "Total" << std::setw(14) << "Average"
+               << std::setw(14) << "Max" << "\n";
+
+        for (const auto &line : lines) {
+            double average = line.count == 0 ? 0.0 : static_cast<double>(line.total) / static_cast<double>(line.count);
+            output << std::left << std::setw(36) << line.name << std::right << std::setw(10) << line.count << std::fixed << std::setprecision(3);
+
+            if (line.kind == ProbeKind::Timer) {
+                output << std::setw(11) << static_cast<double>(line.total) / 1e6 << " ms" << std::setw(11) << average / 1e6 << " ms"
+                       << std::setw(11) << static_cast<double>(line.max) / 1e6 << " ms\n";
+            } else {
+                output << std::setw(14) << line.total << std::setw(14) << average << std::setw(14) << line.max << "\n";
+            }
+        }
+
+        output << std::defaultfloat << std::flush;
+    }
+}
@@ -0,0 +1,72 @@
+#include <ble_serial/l2cap.hpp>
+#include <ble_serial/instrumentation.hpp>
+
+namespace BLE_Serial::Bluetooth
+{
+    namespace
+    {
+        /**
+         * How often the subscriber thread checks whether it should exit while no SDU arrives
+         */
+        constexpr std::chrono::milliseconds c_receivePollInterval { 100 };
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // L2CAPChannel implementation                          //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    size_t L2CAPChannel::GetMaxSduSize() const noexcept
+    {
+        return m_maxSduSize;
+    }
+
+    bool L2CAPChannel::IsOpen() const noexcept
+    {
+        return m_open.load();
+    }
+
+    size_t L2CAPChannel::Subscribe(std::function<void(std::vector<uint8_t>)> listener)
+    {
+        return m_subscribers.Subscribe(std::move(listener));
+    }
+
+    void L2CAPChannel::Unsubscribe(size_t id)
+    {
+        m_subscribers.Unsubscribe(id);
+    }
+
+    void L2CAPChannel::UnsubscribeAll()
+    {
+        m_subscribers.UnsubscribeAll();
+    }
+
+    bool L2CAPChannel::ReceiveForListeners(std::vector<uint8_t> &sdu)
+    {
+        // The next SDU is only taken once the listeners are done with the previous one, so a slow listener stops the
+        // credits from being granted back
+        if (!Receive(sdu, c_receivePollInterval)) {
+            if (!IsOpen()) {
+                m_subscribers.Idle(c_receivePollInterval);
+            }
+
+            return false;
+        }
+
+        BLE_SERIAL_COUNT("l2cap.receive.bytes", sdu.size());
+        return true;
+    }
+
+    L2CAPChannelMetrics L2CAPChannel::Metrics() const noexcept
+    {
+        return L2CAPChannelMetrics {
+                .sdusSent = m_sdusSent.load(std::memory_order_relaxed),
+                .bytesSent = m_bytesSent.load(std::memory_order_relaxed),
+                .sdusReceived = m_sdusReceived.load(std::memory_order_relaxed),
+                .bytesReceived = m_bytesReceived.load(std::memory_order_relaxed),
+                .creditStalls = m_creditStalls.load(std::memory_order_relaxed),
+                .stalledTime = std::chrono::nanoseconds { m_stalledTime.load(std::memory_order_relaxed) }
+        };
+    }
+}
@@ -0,0 +1,228 @@
+#include <ble_serial/listeners.hpp>
+
+namespace BLE_Serial::IO
+{
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // ListenerSet implementation                           //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    size_t ListenerSet::Add(Listener listener)
+    {
+        std::unique_lock<std::mutex> lock { m_mutex };
+
+        auto listeners = std::make_shared<Listeners>(*m_listeners);
+        size_t id = m_nextId++;
+        listeners->emplace(id, std::move(listener));
+        m_listeners = std::move(listeners);
+
+        return id;
+    }
+
+    void ListenerSet::Remove(size_t id)
+    {
+        std::unique_lock<std::mutex> lock { m_mutex };
+
+        auto listeners = std::make_shared<Listeners>(*m_listeners);
+        listeners->erase(id);
+        m_listeners = std::move(listeners);
+
+        WaitForDispatches(lock);
+    }
+
+    void ListenerSet::Clear()
+    {
+        std::unique_lock<std::mutex> lock { m_mutex };
+        m_listeners = std::make_shared<const Listeners>();
+
+        WaitForDispatches(lock);
+    }
+
+    bool ListenerSet::Empty() const
+    {
+        std::unique_lock<std::mutex> lock { m_mutex };
+        return m_listeners->empty();
+    }
+
+    void ListenerSet::Dispatch(const std::vector<uint8_t> &data)
+    {
+        std::shared_ptr<const Listeners> listeners;
+        uint64_t dispatch;
+
+        {
+            std::unique_lock<std::mutex> lock { m_mutex };
+            listeners = m_listeners;
+            dispatch = m_nextDispatch++;
+            m_dispatches.emplace(dispatch, std::this_thread::get_id());
+        }
+
+        struct Finish
+        {
+            ListenerSet &set;
+            uint64_t dispatch;
+
+            ~Finish()
+            {
+                std::unique_lock<std::mutex> lock { set.m_mutex };
+                set.m_dispatches.erase(dispatch);
+                set.m_condition.notify_all();
+            }
+        } finish { *this, dispatch };
+
+        for (auto &[id, listener] : *listeners) {
+            listener(data);
+        }
+    }
+
+    void ListenerSet::WaitForDispatches(std::unique_lock<std::mutex> &lock)
+    {
+        // A listener would wait for its own dispatch, or for another dispatch whose listener waits for this one
+        auto self = std::this_thread::get_id();
+        for (auto &[dispatch, thread] : m_dispatches) {
+            if (thread == self) {
+                return;
+            }
+        }
+
+        // Dispatches starting from now on take the new listeners, only the ones already running may hold the old ones
+        uint64_t removedAt = m_nextDispatch;
+        m_condition.wait(lock, [this, removedAt]() {
+            return m_dispatches.empty() || m_dispatches.begin()->first >= removedAt;
+        });
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // SubscriberThread implementation                      //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    SubscriberThread::SubscriberThread(Receive receive)
+            : m_receive { std::move(receive) }
+    {
+    }
+
+    SubscriberThread::~SubscriberThread()
+    {
+        UnsubscribeAll();
+
+        if (m_thread.joinable()) {
+            // Destroyed from a listener, the thread exits on its own after the listener returns
+            m_thread.detach();
+        }
+    }
+
+    size_t SubscriberThread::Subscribe(ListenerSet::Listener listener)
+    {
+        std::unique_lock<std::mutex> lock { m_mutex };
+
+        size_t id = m_listeners.Add(std::move(listener));
+
+        if (!m_thread.joinable() && m_running) {
+            // Another thread is stopping the reader, it starts a new one for the listeners added meanwhile
+            return id;
+        }
+
+        m_exiting = false;
+        m_condition.notify_all();
+        Start();
+
+        return id;
+    }
+
+    void SubscriberThread::Unsubscribe(size_t id)
+    {
+        m_listeners.Remove(id);
+
+        std::unique_lock<std::mutex> lock { m_mutex };
+        m_condition.notify_all();
+    }
+
+    void SubscriberThread::UnsubscribeAll()
+    {
+        std::thread thread;
+
+        {
+            std::unique_lock<std::mutex> lock { m_mutex };
+            m_exiting = true;
+            m_condition.notify_all();
+
+            // Called from a listener the reader keeps its thread, it exits once the listener returns unless a listener
+            // subscribes again before that
+            if (m_thread.get_id() != std::this_thread::get_id()) {
+                thread = std::move(m_thread);
+            }
+        }
+
+        m_listeners.Clear();
+
+        if (!thread.joinable()) {
+            return;
+        }
+
+        thread.join();
+
+        std::unique_lock<std::mutex> lock { m_mutex };
+        if (!m_thread.joinable() && !m_listeners.Empty()) {
+            m_exiting = false;
+            Start();
+        }
+    }
+
+    void SubscriberThread::Idle(std::chrono::milliseconds timeout)
+    {
+        std::unique_lock<std::mutex> lock { m_mutex };
+        m_condition.wait_for(lock, timeout, [this]() { return m_exiting; });
+    }
+
+    void SubscriberThread::Start()
+    {
+        if (m_thread.joinable() && m_running) {
+            // Still running, m_exiting was cleared so it goes on
+            return;
+        }
+
+        if (m_thread.joinable()) {
+            // Stopped from a listener and already past its last check, only the return is left
+            m_thread.join();
+        }
+
+        m_running = true;
+        m_thread = std::thread([this]() { Run(); });
+    }
+
+    void SubscriberThread::Run()
+    {
+        std::vector<uint8_t> data;
+
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock { m_mutex };
+                m_condition.wait(lock, [this]() { return m_exiting || !m_listeners.Empty(); });
+
+                if (m_exiting) {
+                    m_running = false;
+                    m_condition.notify_all();
+                    return;
+                }
+            }
+
+            if (!m_receive(data)) {
+                continue;
+            }
+
+            {
+                std::unique_lock<std::mutex> lock { m_mutex };
+                if (m_exiting) {
+                    m_running = false;
+                    m_condition.notify_all();
+                    return;
+                }
+            }
+
+            // The listeners are taken now, so the ones removed while the receive blocked are not called
+            m_listeners.Dispatch(data);
+        }
+    }
+}
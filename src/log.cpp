@@ -0,0 +1,544 @@
+#include <ble_serial/log.hpp>
+#include <ble_serial/format.hpp>
+#include <ble_serial/mapped_file.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cstring>
+#include <ctime>
+#include <stdexcept>
+
+namespace BLE_Serial::Log
+{
+    namespace
+    {
+        constexpr size_t c_maxKeyLength = 255;
+
+        const char *SeverityName(Severity severity) noexcept
+        {
+            switch (severity) {
+                case Severity::Debug:
+                    return "debug";
+                case Severity::Info:
+                    return "info";
+                case Severity::Warning:
+                    return "warning";
+                case Severity::Error:
+                    return "error";
+                default:
+                    return "off";
+            }
+        }
+
+        template<typename T>
+        void AppendNumber(std::string &output, T value)
+        {
+            char buffer[32];
+            auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+            output.append(buffer, result.ptr);
+        }
+
+        bool NeedsQuoting(std::string_view text) noexcept
+        {
+            return text.empty() || std::any_of(text.begin(), text.end(), [](char c) { return c == ' ' || c == '"' || c == '=' || static_cast<unsigned char>(c) < 0x20; });
+        }
+
+        /**
+         * Reads the serialized records back, the layout is produced by Logger::Write
+         */
+        class RecordReader
+        {
+        public:
+            explicit RecordReader(const uint8_t *data) noexcept
+                    : m_data { data }
+            {
+            }
+
+            template<typename T>
+            T Read() noexcept
+            {
+                T value;
+                std::memcpy(&value, m_data, sizeof(T));
+                m_data += sizeof(T);
+                return value;
+            }
+
+            std::string_view ReadString(size_t length) noexcept
+            {
+                std::string_view result { reinterpret_cast<const char *>(m_data), length };
+                m_data += length;
+                return result;
+            }
+
+        private:
+            const uint8_t *m_data;
+        };
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // LogField implementation                              //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    LogField::LogField(std::string_view key, std::string_view value) noexcept
+            : m_key { key }, m_type { Type::String }, m_unsigned { 0 }, m_string { value }
+    {
+    }
+
+    LogField::LogField(std::string_view key, const char *value) noexcept
+            : LogField(key, std::string_view { value })
+    {
+    }
+
+    LogField::LogField(std::string_view key, const std::string &value) noexcept
+            : LogField(key, std::string_view { value })
+    {
+    }
+
+    LogField::LogField(std::string_view key, bool value) noexcept
+            : m_key { key }, m_type { Type::Bool }, m_bool { value }
+    {
+    }
+
+    LogField::LogField(std::string_view key, double value) noexcept
+            : m_key { key }, m_type { Type::Float }, m_float { value }
+    {
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // Logger::ThreadBuffer implementation                  //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    /**
+     * Single-producer single-consumer byte ring, the owning thread writes whole records, the sink thread takes
+     * everything written so far
+     */
+    class Logger::ThreadBuffer
+    {
+    public:
+        explicit ThreadBuffer(size_t capacity)
+                : m_data(std::bit_ceil(std::max<size_t>(capacity, 256))), m_mask { m_data.size() - 1 }
+        {
+        }
+
+        [[nodiscard]] size_t Free() const noexcept
+        {
+            return m_data.size() - static_cast<size_t>(m_head.load(std::memory_order_relaxed) - m_tail.load(std::memory_order_acquire));
+        }
+
+        void Put(const void *data, size_t size) noexcept
+        {
+            size_t offset = static_cast<size_t>(m_writing) & m_mask;
+            size_t first = std::min(size, m_data.size() - offset);
+
+            std::memcpy(m_data.data() + offset, data, first);
+            std::memcpy(m_data.data(), static_cast<const uint8_t *>(data) + first, size - first);
+            m_writing += size;
+        }
+
+        void BeginRecord() noexcept
+        {
+            m_writing = m_head.load(std::memory_order_relaxed);
+        }
+
+        void CommitRecord() noexcept
+        {
+            m_head.store(m_writing, std::memory_order_release);
+        }
+
+        void TakeAll(std::vector<uint8_t> &output)
+        {
+            uint64_t head = m_head.load(std::memory_order_acquire);
+            uint64_t tail = m_tail.load(std::memory_order_relaxed);
+
+            for (uint64_t position = tail; position != head;) {
+                size_t offset = static_cast<size_t>(position) & m_mask;
+                size_t chunk = std::min(static_cast<size_t>(head - position), m_data.size() - offset);
+
+                output.insert(output.end(), m_data.begin() + static_cast<ptrdiff_t>(offset), m_data.begin() + static_cast<ptrdiff_t>(offset + chunk));
+                position += chunk;
+            }
+
+            m_tail.store(head, std::memory_order_release);
+        }
+
+        [[nodiscard]] bool Empty() const noexcept
+        {
+            return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_relaxed);
+        }
+
+    private:
+        std::vector<uint8_t> m_data;
+        size_t m_mask;
+        uint64_t m_writing = 0;
+        alignas(64) std::atomic<uint64_t> m_head { 0 };
+        alignas(64) std::atomic<uint64_t> m_tail { 0 };
+    };
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // Logger implementation                                //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    Logger &Logger::Global()
+    {
+        static Logger c_logger;
+        return c_logger;
+    }
+
+    Logger::~Logger()
+    {
+        Stop();
+    }
+
+    void Logger::Start(LoggerOptions options)
+    {
+        if (m_thread.joinable()) {
+            return;
+        }
+
+        std::FILE *output = stderr;
+        if (!options.file.empty()) {
+            output = std::fopen(options.file.c_str(), "a");
+            if (output == nullptr) {
+                throw IO::IOException("Failed to open log file " + options.file);
+            }
+        }
+
+        m_options = std::move(options);
+        m_output = output;
+        m_exiting = false;
+        m_thread = std::thread([this]() { Run(); });
+
+        m_level.store(static_cast<uint8_t>(m_options.level), std::memory_order_relaxed);
+    }
+
+    void Logger::Stop()
+    {
+        if (!m_thread.joinable()) {
+            return;
+        }
+
+        m_level.store(static_cast<uint8_t>(Severity::Off), std::memory_order_relaxed);
+
+        {
+            std::unique_lock<std::mutex> lock { m_mutex };
+            m_exiting = true;
+            m_condition.notify_all();
+        }
+
+        m_thread.join();
+
+        if (m_output != stderr) {
+            std::fclose(m_output);
+        }
+        m_output = nullptr;
+    }
+
+    void Logger::SetLevel(Severity level) noexcept
+    {
+        m_options.level = level;
+        if (m_thread.joinable()) {
+            m_level.store(static_cast<uint8_t>(level), std::memory_order_relaxed);
+        }
+    }
+
+    LogContext Logger::CreateContext(std::initializer_list<LogField> fields)
+    {
+        std::string text, json;
+
+        for (const auto &field : fields) {
+            text.push_back(' ');
+            text.append(field.m_key);
+            text.push_back('=');
+
+            json.push_back(',');
+            json.append(Format::ToJsonString(field.m_key));
+            json.push_back(':');
+
+            // Contexts are formatted once, so that the sink only has to copy them
+            switch (field.m_type) {
+                case LogField::Type::Signed:
+                    AppendNumber(text, field.m_signed);
+                    AppendNumber(json, field.m_signed);
+                    break;
+                case LogField::Type::Unsigned:
+                    AppendNumber(text, field.m_unsigned);
+                    AppendNumber(json, field.m_unsigned);
+                    break;
+                case LogField::Type::Float:
+                    AppendNumber(text, field.m_float);
+                    AppendNumber(json, field.m_float);
+                    break;
+                case LogField::Type::Bool:
+                    text.append(field.m_bool ? "true" : "false");
+                    json.append(field.m_bool ? "true" : "false");
+                    break;
+                case LogField::Type::String:
+                    text.append(NeedsQuoting(field.m_string) ? Format::ToJsonString(field.m_string) : std::string { field.m_string });
+                    json.append(Format::ToJsonString(field.m_string));
+                    break;
+            }
+        }
+
+        std::unique_lock<std::mutex> lock { m_contextsMutex };
+        m_textContexts.push_back(std::move(text));
+        m_jsonContexts.push_back(std::move(json));
+
+        // Id 0 is the empty context
+        return LogContext { .id = static_cast<uint32_t>(m_textContexts.size()) };
+    }
+
+    void Logger::Write(Severity severity, std::string_view message, std::initializer_list<LogField> fields, LogContext context) noexcept
+    {
+        if (!IsEnabled(severity)) {
+            return;
+        }
+
+        ThreadBuffer *buffer;
+        try {
+            buffer = GetThreadBuffer();
+        } catch (const std::bad_alloc &) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        // time, severity, context, message length, message, field count, then type, key length, key, value per field
+        size_t size = sizeof(uint32_t) + sizeof(int64_t) + 1 + sizeof(uint32_t) + sizeof(uint32_t) + message.size() + 1;
+        for (const auto &field : fields) {
+            size += 2 + std::min(field.m_key.size(), c_maxKeyLength) + (field.m_type == LogField::Type::String ? sizeof(uint32_t) + field.m_string.size() : sizeof(uint64_t));
+        }
+
+        if (size > buffer->Free() || fields.size() > 255) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        auto recordSize = static_cast<uint32_t>(size);
+        auto time = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+        auto severityByte = static_cast<uint8_t>(severity);
+        auto messageLength = static_cast<uint32_t>(message.size());
+        auto fieldCount = static_cast<uint8_t>(fields.size());
+
+        buffer->BeginRecord();
+        buffer->Put(&recordSize, sizeof(recordSize));
+        buffer->Put(&time, sizeof(time));
+        buffer->Put(&severityByte, 1);
+        buffer->Put(&context.id, sizeof(context.id));
+        buffer->Put(&messageLength, sizeof(messageLength));
+        buffer->Put(message.data(), message.size());
+        buffer->Put(&fieldCount, 1);
+
+        for (const auto &field : fields) {
+            auto type = static_cast<uint8_t>(field.m_type);
+            auto keyLength = static_cast<uint8_t>(std::min(field.m_key.size(), c_maxKeyLength));
+
+            buffer->Put(&type, 1);
+            buffer->Put(&keyLength, 1);
+            buffer->Put(field.m_key.data(), keyLength);
+
+            if (field.m_type == LogField::Type::String) {
+                auto length = static_cast<uint32_t>(field.m_string.size());
+                buffer->Put(&length, sizeof(length));
+                buffer->Put(field.m_string.data(), field.m_string.size());
+            } else {
+                uint64_t value = field.m_type == LogField::Type::Bool ? static_cast<uint64_t>(field.m_bool) : field.m_unsigned;
+                buffer->Put(&value, sizeof(value));
+            }
+        }
+
+        buffer->CommitRecord();
+    }
+
+    uint64_t Logger::Dropped() const noexcept
+    {
+        return m_dropped.load(std::memory_order_relaxed);
+    }
+
+    Logger::ThreadBuffer *Logger::GetThreadBuffer()
+    {
+        thread_local std::shared_ptr<ThreadBuffer> c_buffer;
+
+        if (!c_buffer) {
+            c_buffer = std::make_shared<ThreadBuffer>(m_options.bufferSize);
+
+            std::unique_lock<std::mutex> lock { m_buffersMutex };
+            m_buffers.push_back(c_buffer);
+        }
+
+        return c_buffer.get();
+    }
+
+    void Logger::Run()
+    {
+        std::unique_lock<std::mutex> lock { m_mutex };
+
+        for (;;) {
+            bool exiting = m_condition.wait_for(lock, m_options.flushInterval, [this]() { return m_exiting; });
+
+            lock.unlock();
+            Drain();
+            lock.lock();
+
+            if (exiting) {
+                return;
+            }
+        }
+    }
+
+    void Logger::Drain()
+    {
+        m_scratch.clear();
+        m_records.clear();
+
+        {
+            std::unique_lock<std::mutex> lock { m_buffersMutex };
+
+            for (auto &buffer : m_buffers) {
+                buffer->TakeAll(m_scratch);
+            }
+
+            // Buffers only referenced here belong to threads that exited
+            std::erase_if(m_buffers, [](const auto &buffer) { return buffer.use_count() == 1 && buffer->Empty(); });
+        }
+
+        for (size_t offset = 0; offset < m_scratch.size();) {
+            RecordReader reader { m_scratch.data() + offset };
+            auto size = reader.Read<uint32_t>();
+            auto time = reader.Read<int64_t>();
+            auto severity = static_cast<Severity>(reader.Read<uint8_t>());
+            auto context = reader.Read<uint32_t>();
+
+            m_records.push_back(Record { .time = time, .severity = severity, .context = context, .offset = offset + sizeof(uint32_t) + sizeof(int64_t) + 1 + sizeof(uint32_t) });
+            offset += size;
+        }
+
+        // Every thread stages its records in order, merging the threads needs a sort
+        std::stable_sort(m_records.begin(), m_records.end(), [](const Record &a, const Record &b) { return a.time < b.time; });
+
+        m_text.clear();
+        for (const auto &record : m_records) {
+            FormatRecord(record);
+        }
+
+        if (!m_text.empty()) {
+            std::fwrite(m_text.data(), 1, m_text.size(), m_output);
+            std::fflush(m_output);
+        }
+
+        uint64_t dropped = m_dropped.load(std::memory_order_relaxed);
+        if (dropped != m_reportedDropped) {
+            Write(Severity::Warning, "Log records dropped, the staging buffers were full", { LogField { "count", dropped - m_reportedDropped } });
+            m_reportedDropped = dropped;
+        }
+    }
+
+    void Logger::FormatRecord(const Record &record)
+    {
+        bool json = m_options.format == LogFormat::Json;
+        RecordReader reader { m_scratch.data() + record.offset };
+        auto message = reader.ReadString(reader.Read<uint32_t>());
+
+        int64_t second = record.time / 1000000000;
+        if (second != m_cachedSecond) {
+            m_cachedSecond = second;
+
+            std::time_t clock = static_cast<std::time_t>(second);
+            std::tm utc {};
+#ifdef _WIN32
+            gmtime_s(&utc, &clock);
+#else
+            gmtime_r(&clock, &utc);
+#endif
+            std::strftime(m_cachedClock, sizeof(m_cachedClock), "%Y-%m-%dT%H:%M:%S", &utc);
+        }
+
+        int milliseconds = static_cast<int>(record.time / 1000000 % 1000);
+        char fraction[5] = { '.', static_cast<char>('0' + milliseconds / 100), static_cast<char>('0' + milliseconds / 10 % 10), static_cast<char>('0' + milliseconds % 10), 'Z' };
+
+        if (json) {
+            m_text.append("{\"time\":\"");
+            m_text.append(m_cachedClock, 19);
+            m_text.append(fraction, 5);
+            m_text.append("\",\"level\":\"");
+            m_text.append(SeverityName(record.severity));
+            m_text.append("\",\"msg\":");
+            m_text.append(Format::ToJsonString(message));
+        } else {
+            m_text.append(m_cachedClock, 19);
+            m_text.append(fraction, 5);
+            m_text.push_back(' ');
+
+            std::string_view name = SeverityName(record.severity);
+            m_text.append(name);
+            m_text.append(8 - name.size(), ' ');
+            m_text.append(message);
+        }
+
+        if (record.context != 0) {
+            std::unique_lock<std::mutex> lock { m_contextsMutex };
+            m_text.append(json ? m_jsonContexts[record.context - 1] : m_textContexts[record.context - 1]);
+        }
+
+        auto count = reader.Read<uint8_t>();
+        for (uint8_t i = 0; i < count; i++) {
+            auto type = static_cast<LogField::Type>(reader.Read<uint8_t>());
+            auto key = reader.ReadString(reader.Read<uint8_t>());
+
+            if (json) {
+                m_text.push_back(',');
+                m_text.append(Format::ToJsonString(key));
+                m_text.push_back(':');
+            } else {
+                m_text.push_back(' ');
+                m_text.append(key);
+                m_text.push_back('=');
+            }
+
+            if (type == LogField::Type::String) {
+                auto value = reader.ReadString(reader.Read<uint32_t>());
+                if (json || NeedsQuoting(value)) {
+                    m_text.append(Format::ToJsonString(value));
+                } else {
+                    m_text.append(value);
+                }
+
+                continue;
+            }
+
+            auto raw = reader.Read<uint64_t>();
+            switch (type) {
+                case LogField::Type::Signed:
+                    AppendNumber(m_text, static_cast<int64_t>(raw));
+                    break;
+                case LogField::Type::Float:
+                    AppendNumber(m_text, std::bit_cast<double>(raw));
+                    break;
+                case LogField::Type::Bool:
+                    m_text.append(raw != 0 ? "true" : "false");
+                    break;
+                default:
+                    AppendNumber(m_text, raw);
+                    break;
+            }
+        }
+
+        m_text.append(json ? "}\n" : "\n");
+    }
+
+    Severity SeverityFromString(std::string_view name)
+    {
+        for (auto severity : { Severity::Debug, Severity::Info, Severity::Warning, Severity::Error, Severity::Off }) {
+            if (name == SeverityName(severity)) {
+                return severity;
+            }
+        }
+
+        throw std::invalid_argument("Unknown log level " + std::string { name });
+    }
+}
@@ -1,12 +1,40 @@
+#include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <sstream>
 #include <thread>
 #include <csignal>
 
 #include <ble_serial/bluetooth.hpp>
+#include <ble_serial/bond_store.hpp>
+#include <ble_serial/bridge.hpp>
 #include <ble_serial/com.hpp>
+#include <ble_serial/instrumentation.hpp>
+#include <ble_serial/l2cap.hpp>
+#include <ble_serial/log.hpp>
+#include <ble_serial/mapped_file.hpp>
+#include <ble_serial/stats.hpp>
+
+#include "adverts.hpp"
+#include "aggregate.hpp"
+#include "batch.hpp"
+#include "decode.hpp"
+#include "dfu_upload.hpp"
+#include "modbus_gateway.hpp"
+#include "monitor.hpp"
+#include "mqtt_publish.hpp"
+#include "shell.hpp"
+#include "stats_view.hpp"
+#include "transfer.hpp"
+#include "uuid_db.hpp"
 
 using namespace BLE_Serial::Bluetooth;
+using namespace BLE_Serial::Bridge;
 using namespace BLE_Serial::COM;
+using namespace BLE_Serial::IO;
+using namespace BLE_Serial::Log;
+using namespace BLE_Serial::Modbus;
+using namespace BLE_Serial::Mqtt;
 
 static std::atomic_bool sigintReceived { false };
 
@@ -21,8 +49,33 @@ void PrintUsage(const char* name)
     std::cout << "Correct usage: \n";
     std::cout << "\t" << name << " ls [timeout=5] - Scans for BLE devices for [timeout] seconds and prints the results. \n";
     std::cout << "\t" << name << " query <device_addr> [timeout=5] - Tries to query information from a BLE device with <device_addr> for [timeout] seconds and prints the results. \n";
-    std::cout << "\t" << name << " connect <device_addr> <service_id> <characteristic_id> <com_port_number> [timeout=5] [baud=9600] [data=8] [stop=1] [parity=none] [refresh_ms=100]\n";
+    std::cout << "\t" << name << " connect <device_addr> <service_id> <characteristic_id> <com_port_number> [timeout=5] [baud=9600] [data=8] [stop=1] [parity=none] [refresh_ms=100] [heartbeat_ms=0] [inactivity_ms=0] [spill_dir] [replay_bps=0] [control_max_len=0] [packet_size=0] [conflation=none] [polling=auto] [cache_ms=0] [monitor=off]\n";
+    std::cout << "\t" << name << " l2cap <device_addr> <psm> <com_port_number> [timeout=5] [baud=9600] [data=8] [stop=1] [parity=none] [refresh_ms=100] [mtu=65535] [credits=32] - Bridges a COM port to an L2CAP connection-oriented channel. \n";
+    std::cout << "\t" << name << " aggregate <device_addrs> <service_id> <characteristic_ids> <com_port_number> [timeout=5] [baud=9600] [data=8] [stop=1] [parity=none] [refresh_ms=100] [segment_size=0] [window=256] [gap_ms=200] - Stripes a COM port across every listed characteristic of every listed device. \n";
+    std::cout << "\t" << name << " adverts <com_port_number|-> [filter=all] [interval_ms=0] [repeat_ms=0] [format] - Forwards the manufacturer data of advertisements as framed records without connecting. \n";
+    std::cout << "\t" << name << " modbus <device_addrs> <service_id> <characteristic_id> [tcp_port=502] [com_port_number=-] [timeout=5] [baud=9600] [parity=even] [response_ms=1000] [units] - Runs a Modbus TCP/RTU gateway to Modbus RTU devices behind BLE serial characteristics. \n";
+    std::cout << "\t" << name << " mqtt <device_addrs> <service_id> <characteristic_ids> <broker> [topic=ble/{address}/{characteristic}] [qos=0] [window=16] [timeout=5] [client_id=ble_serial] [spill_dir] - Publishes the notifications of every listed characteristic of every listed device to an MQTT broker. \n";
+    std::cout << "\t" << name << " adapters - Lists all local Bluetooth adapters. \n";
+    std::cout << "\t" << name << " bonds [forget <device_addr>] - Lists the remembered bonds or forgets one of them. \n";
+    std::cout << "\t" << name << " multi <bridges_file> [max_per_adapter=7] - Starts every bridge listed in <bridges_file> and spreads them across all local adapters. \n";
+    std::cout << "\t" << name << " shell <device_addr> [timeout=5] - Opens an interactive session that keeps a single connection to <device_addr> open. \n";
+    std::cout << "\t" << name << " batch <plan_file> [concurrency=4] [retries=2] [scan_timeout=5] [timeout=5] - Runs the operations of <plan_file> on many devices and prints the results as NDJSON. \n";
+    std::cout << "\t" << name << " send <device_addr> <service_id> <characteristic_id> <file> [timeout=5] [rate_bps=0] [mode=auto] - Sends <file> to the characteristic as fast as possible. \n";
+    std::cout << "\t" << name << " recv <device_addr> <service_id> <characteristic_id> <file> [timeout=5] [idle_ms=0] - Writes all notifications of the characteristic to <file>. \n";
+    std::cout << "\t" << name << " monitor <device_addr> <service_id> <characteristic_id> [timeout=5] [view=hexdump] - Shows a live view of the notifications of the characteristic. \n";
+    std::cout << "\t" << name << " decode <device_addr> <service_id> <characteristic_id> [timeout=5] [format=json] - Decodes the notifications of a standard characteristic into NDJSON or binary records. \n";
+    std::cout << "\t" << name << " dfu <device_addr|sim> <init_packet> <firmware> [timeout=5] [prn=12] [window=2] - Updates the firmware of a device in its Nordic Secure DFU bootloader. \n";
+    std::cout << "\t" << name << " uuiddb <output> <yaml_files...> - Compiles assigned numbers and vendor UUID definitions into a database for --uuid-db. \n";
+    std::cout << "\t" << name << " stats [pid] [refresh_ms=1000] - Shows live metrics of the bridges running in other processes. \n";
     std::cout << "\t" << name << " help - Shows this help page \n";
+    std::cout << "Logging options, accepted anywhere on the command line: \n";
+    std::cout << "\t--log-level=<debug|info|warning|error|off> - Minimal severity of the logged records, info by default. \n";
+    std::cout << "\t--log-format=<text|json> - Writes the records as text lines or as NDJSON, text by default. \n";
+    std::cout << "\t--log-file=<path> - Appends the records to <path> instead of the standard error. \n";
+    std::cout << "Naming and security options, accepted anywhere on the command line: \n";
+    std::cout << "\t--uuid-db=<path> - Names UUIDs with a database built by uuiddb; services and characteristics may then be given by name. \n";
+    std::cout << "\t--bond-store=<path> - Pairs devices that refuse an unencrypted link and remembers their bonds in <path>, i.e. " << BondStore::GetDefaultPath()
+              << ". Off by default. \n";
 
     std::cout << std::flush;
 }
@@ -70,12 +123,12 @@ int QueryDevices(BluetoothAddress addr, int timeout)
     for (auto &service : connection->GetServices()) {
         service->FetchCharacteristics();
 
-        std::cout << "\t\t" << IBluetoothService::GetService().UUIDToShortString(service->GetUUID()) << " (Service type: " << GetServiceName(service->GetRegisteredServiceType()).value_or("unknown")
+        std::cout << "\t\t" << IBluetoothService::GetService().UUIDToShortString(service->GetUUID()) << " (Service type: " << DescribeUuid(service->GetUUID(), GetServiceName(service->GetRegisteredServiceType()))
                   << ") with " << service->GetCachedCharacteristics().size() << " characteristics\n";
 
         for (auto &characteristic : service->GetCachedCharacteristics()) {
             std::cout << "\t\t\t" << IBluetoothService::GetService().UUIDToShortString(characteristic->GetUUID()) << " (Characteristic type: "
-                      << GetCharacteristicName(characteristic->GetRegisteredCharacteristicType()).value_or("unknown") << ")" << std::endl;
+                      << DescribeUuid(characteristic->GetUUID(), GetCharacteristicName(characteristic->GetRegisteredCharacteristicType())) << ")" << std::endl;
 
             if (service->GetRegisteredServiceType() == GattRegisteredService::GenericAccess && characteristic->GetRegisteredCharacteristicType() == GattRegisteredCharacteristic::DeviceName) {
                 try {
@@ -94,68 +147,356 @@ int QueryDevices(BluetoothAddress addr, int timeout)
     return 0;
 }
 
-int Connect(BluetoothAddress addr, GattRegisteredService serviceId, GattRegisteredCharacteristic characteristicId, unsigned int portNumber, unsigned int timeout, unsigned int baud, unsigned int data, StopBits stopBits, Parity parity, std::chrono::milliseconds refresh)
+struct BridgeSettings
 {
-    std::cout << "Searching for device " << BluetoothAddressToString(addr) << " ..." << std::endl;
+    BluetoothAddress address;
+    GattRegisteredService serviceId;
+    GattRegisteredCharacteristic characteristicId;
+    std::vector<GattRegisteredCharacteristic> polledCharacteristicIds;
+    unsigned int portNumber;
+    unsigned int timeout;
+    unsigned int baud;
+    unsigned int data;
+    StopBits stopBits;
+    Parity parity;
+    std::chrono::milliseconds refresh;
+    BridgeOptions options;
+    std::optional<TrafficMonitorOptions> monitor {};
+};
 
-    auto deviceOptional = IBluetoothService::GetService().FindDevice(addr, std::chrono::seconds(timeout));
-    if (!deviceOptional) {
-        std::cerr << "Device with address: " << BluetoothAddressToString(addr) << " couldn't be found. \n";
-        return 1;
+struct ChannelSettings
+{
+    BluetoothAddress address;
+    uint16_t psm;
+    unsigned int portNumber;
+    unsigned int timeout;
+    unsigned int baud;
+    unsigned int data;
+    StopBits stopBits;
+    Parity parity;
+    std::chrono::milliseconds refresh;
+    L2CAPChannelOptions channel;
+};
+
+struct BridgeSession
+{
+    std::shared_ptr<IBluetoothConnection> connection;
+    IBluetoothGattCharacteristic *characteristic;
+    std::unique_ptr<L2CAPChannel> channel;
+    std::unique_ptr<COMPort> port;
+    std::unique_ptr<Bridge> bridge;
+    std::unique_ptr<TrafficMonitor> monitor;
+    std::string name;
+    LogContext logContext;
+    bool keepsBacklog = false;  ///< the bridge spills to the disk, so it waits out outages of any length
+};
+
+void CloseBridge(BridgeSession &session)
+{
+    // Sessions that failed half way through their setup are closed as well, anything may be missing
+    if (session.bridge) {
+        session.bridge->Stop();
+
+        if (session.monitor) {
+            session.bridge->AttachMonitor(nullptr);
+            session.monitor->Stop();
+        }
     }
 
-    std::cout << "Device found! Connecting ..." << std::endl;
-    auto connection = deviceOptional.value()->OpenConnection();
-    std::cout << "Connected!" << std::endl;
+    if (session.port) {
+        session.port->UnsubscribeAll();
+        session.port->Close();
+    }
+
+    if (session.channel) {
+        session.channel->UnsubscribeAll();
+        session.channel->Close();
+    }
+
+    try {
+        if (session.characteristic != nullptr) {
+            session.characteristic->UnsubscribeAll();
+        }
+        if (session.connection) {
+            session.connection->Close();
+        }
+    } catch (const BluetoothException &ignored) {
+        // The link may be already dead
+    }
+}
+
+void CloseBridges(std::vector<std::unique_ptr<BridgeSession>> &sessions)
+{
+    for (auto &session : sessions) {
+        CloseBridge(*session);
+    }
+}
+
+bool SetUpBridge(BridgeSession &session, const BridgeSettings &settings)
+{
+    auto &context = session.logContext;
 
-    std::cout << "Searching for service 0x" << std::hex << static_cast<uint32_t >(serviceId) << std::dec << "..." << std::endl;
-    auto &service = connection->GetService(GetServiceUUID(serviceId));
+    Write(Severity::Info, "Searching for service", { { "service", IBluetoothService::GetService().UUIDToShortString(GetServiceUUID(settings.serviceId)) } }, context);
+    auto service = session.connection->GetService(GetServiceUUID(settings.serviceId));
     if (!service) {
-        std::cerr << "Requested service couldn't be found \n";
-        return 1;
+        Write(Severity::Error, "Requested service couldn't be found", {}, context);
+        return false;
     }
 
-    std::cout << "Querying characteristics" << std::endl;
     service->FetchCharacteristics();
 
-    std::cout << "Searching for characteristic 0x" << std::hex << static_cast<uint32_t >(serviceId) << std::dec << "..." << std::endl;
-    auto &characteristic = service->GetCharacteristic(GetCharacteristicUUID(characteristicId));
+    auto characteristicName = IBluetoothService::GetService().UUIDToShortString(GetCharacteristicUUID(settings.characteristicId));
+    Write(Severity::Info, "Searching for characteristic", { { "characteristic", characteristicName } }, context);
+    auto &characteristic = service->GetCharacteristic(GetCharacteristicUUID(settings.characteristicId));
     if (!characteristic) {
-        std::cerr << "Requested characteristic couldn't be found \n";
-        return 1;
+        Write(Severity::Error, "Requested characteristic couldn't be found", { { "characteristic", characteristicName } }, context);
+        return false;
     }
+    session.characteristic = characteristic.get();
 
-    std::cout << "Opening COM" << portNumber << " port..." << std::endl;
-    COMPort port { portNumber, baud, data, stopBits, parity };
-    port.SetRefreshRate(refresh);
+    Write(Severity::Info, "Opening port", { { "baud", settings.baud } }, context);
+    session.port = std::make_unique<COMPort>(settings.portNumber, settings.baud, settings.data, settings.stopBits, settings.parity);
+    session.port->SetRefreshRate(settings.refresh);
 
-    std::cout << "Subscribing to the characteristic ..." << std::endl;
-    characteristic->Subscribe([&](std::vector<uint8_t> data) {
-        port.Write(std::move(data));
-    });
+    auto options = settings.options;
+    options.logContext = context;
+    session.keepsBacklog = !options.queue.spillDirectory.empty();
+    session.bridge = std::make_unique<Bridge>(session.connection, *session.characteristic, *session.port, std::move(options));
 
-    std::cout << "Subscribing to the port ..." << std::endl;
-    port.Subscribe([&](const std::vector<uint8_t> &data) {
-        characteristic->Write(data);
-    });
+    for (auto polledId : settings.polledCharacteristicIds) {
+        auto &polled = service->GetCharacteristic(GetCharacteristicUUID(polledId));
+        if (!polled) {
+            Write(Severity::Error, "Requested characteristic couldn't be found",
+                  { { "characteristic", IBluetoothService::GetService().UUIDToShortString(GetCharacteristicUUID(polledId)) } }, context);
+            return false;
+        }
 
-    std::cout << "Working ..." << std::endl;
+        session.bridge->AddPolledCharacteristic(*polled);
+    }
+
+    if (settings.monitor) {
+        session.monitor = std::make_unique<TrafficMonitor>(*settings.monitor, std::cout);
+        session.bridge->AttachMonitor(session.monitor.get());
+    }
+
+    return true;
+}
+
+std::unique_ptr<BridgeSession> EstablishBridge(IBluetoothService &bluetooth, const BridgeSettings &settings)
+{
+    auto name = BluetoothAddressToString(settings.address);
+    auto context = Logger::Global().CreateContext({ { "bridge", name }, { "port", settings.portNumber } });
+
+    Write(Severity::Info, "Searching for device", { { "timeout_s", settings.timeout } }, context);
+
+    auto deviceOptional = bluetooth.FindDevice(settings.address, std::chrono::seconds(settings.timeout));
+    if (!deviceOptional) {
+        Write(Severity::Error, "Device couldn't be found", {}, context);
+        return nullptr;
+    }
+
+    Write(Severity::Info, "Device found, connecting", {}, context);
+    auto session = std::make_unique<BridgeSession>();
+    session->name = name;
+    session->logContext = context;
+    session->characteristic = nullptr;
+    session->connection = deviceOptional.value()->OpenConnection();
+    Write(Severity::Info, "Connected", {}, context);
+
+    // The link is open from here on, a failed setup has to close it again
+    try {
+        if (!SetUpBridge(*session, settings)) {
+            CloseBridge(*session);
+            return nullptr;
+        }
+    } catch (...) {
+        CloseBridge(*session);
+        throw;
+    }
+
+    return session;
+}
+
+std::unique_ptr<BridgeSession> EstablishChannelBridge(const ChannelSettings &settings)
+{
+    auto name = BluetoothAddressToString(settings.address);
+    auto context = Logger::Global().CreateContext({ { "bridge", name }, { "port", settings.portNumber }, { "psm", settings.psm } });
+
+    Write(Severity::Info, "Connecting to the L2CAP channel", { { "timeout_s", settings.timeout } }, context);
+    auto session = std::make_unique<BridgeSession>();
+    session->name = name;
+    session->logContext = context;
+    session->characteristic = nullptr;
+    session->channel = L2CAPChannel::Connect(settings.address, settings.psm, std::chrono::seconds(settings.timeout), settings.channel);
+    Write(Severity::Info, "Connected", { { "max_sdu", session->channel->GetMaxSduSize() } }, context);
+
+    Write(Severity::Info, "Opening port", { { "baud", settings.baud } }, context);
+    session->port = std::make_unique<COMPort>(settings.portNumber, settings.baud, settings.data, settings.stopBits, settings.parity);
+    session->port->SetRefreshRate(settings.refresh);
+
+    // A closed channel is only noticed by the health monitor
+    BridgeOptions options {};
+    options.health.enabled = true;
+    options.logContext = context;
+    session->bridge = std::make_unique<Bridge>(nullptr, *session->channel, *session->port, std::move(options));
+
+    return session;
+}
+
+int RunBridges(std::vector<std::unique_ptr<BridgeSession>> &sessions, const std::vector<IBluetoothService *> &adapters)
+{
+    std::atomic<size_t> down { 0 };  ///< bridges whose link is down
+    std::atomic<size_t> lost { 0 };  ///< bridges whose link is down and that keep no backlog on the disk
+    StatsPublisher publisher;
+
+    for (auto adapter : adapters) {
+        publisher.AddAdapter(*adapter);
+    }
+
+    for (auto &session : sessions) {
+        session->bridge->OnDisconnected([&down, &lost, keepsBacklog = session->keepsBacklog](const std::string &) {
+            // The bridge logs the reason itself
+            down.fetch_add(1);
+            if (!keepsBacklog) {
+                lost.fetch_add(1);
+            }
+        });
+
+        session->bridge->OnRecovered([&down, &lost, keepsBacklog = session->keepsBacklog]() {
+            down.fetch_sub(1);
+            if (!keepsBacklog) {
+                lost.fetch_sub(1);
+            }
+        });
+
+        Write(Severity::Info, "Subscribing to the characteristic and the port", {}, session->logContext);
+        session->bridge->Start();
+
+        if (session->monitor) {
+            session->monitor->Start();
+        }
+
+        if (session->bridge->IsPolling()) {
+            Write(Severity::Warning, "The characteristic cannot notify, polling it instead", {}, session->logContext);
+        }
+
+        publisher.AddBridge(session->name, *session->bridge);
+    }
+
+    try {
+        publisher.Start();
+    } catch (const IOException &e) {
+        Write(Severity::Warning, "Metrics won't be available to the stats command", { { "error", e.what() } });
+    }
+
+    Write(Severity::Info, "Working", { { "bridges", sessions.size() } });
 
     signal(SIGINT, SigintHandler);
 
-    while (!sigintReceived.load()) {
+    // Links come back on their own, only when all of them are down and none has a backlog to deliver there is nothing
+    // left to wait for
+    while (!sigintReceived.load() && lost.load() != sessions.size()) {
         std::this_thread::sleep_for(std::chrono::milliseconds(100));
     }
 
-    std::cout << "Exiting ..." << std::endl;
+    Write(Severity::Info, "Exiting");
+    publisher.Stop();
 
-    port.UnsubscribeAll();
-    port.Close();
+    for (auto &session : sessions) {
+        auto metrics = session->bridge->GetMetrics().Snapshot();
+        std::cout << "Bridge " << session->name << ": " << metrics.notifications << " notifications, " << metrics.writes << " writes, "
+                  << metrics.writeErrors << " write errors, " << metrics.heartbeatErrors << " failed heartbeats, RSSI " << metrics.rssi << " dBm\n";
 
-    characteristic->UnsubscribeAll();
-    connection->Close();
+        auto usage = session->bridge->GetResourceUsage();
+        std::cout << "\tResources: " << std::chrono::duration_cast<std::chrono::milliseconds>(usage.threadCpuTime).count() << " ms CPU on bridge threads, "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(usage.callbackCpuTime).count() << " ms CPU in callbacks, " << usage.MemoryBytes() << " bytes of memory\n";
+
+        if (session->connection && session->connection->GetValueCache().GetTimeToLive().count() != 0) {
+            auto cacheMetrics = session->connection->GetValueCache().Metrics();
+            std::cout << "\tValue cache: " << cacheMetrics.hits << " hits, " << cacheMetrics.misses << " misses, " << cacheMetrics.invalidations << " invalidations\n";
+        }
+
+        if (session->channel) {
+            auto channelMetrics = session->channel->Metrics();
+            std::cout << "\tChannel: " << channelMetrics.sdusSent << " SDUs sent, " << channelMetrics.sdusReceived << " SDUs received, " << channelMetrics.creditStalls
+                      << " credit stalls (" << std::chrono::duration_cast<std::chrono::milliseconds>(channelMetrics.stalledTime).count() << " ms)\n";
+        }
+    }
+
+    CloseBridges(sessions);
+
+    Write(Severity::Info, "Good bye!");
+    return down.load() == 0 ? 0 : 1;
+}
+
+int Connect(const BridgeSettings &settings)
+{
+    std::vector<std::unique_ptr<BridgeSession>> sessions;
+
+    auto session = EstablishBridge(IBluetoothService::GetService(), settings);
+    if (!session) {
+        return 1;
+    }
+
+    sessions.push_back(std::move(session));
+    return RunBridges(sessions, { &IBluetoothService::GetService() });
+}
+
+int ConnectChannel(const ChannelSettings &settings)
+{
+    std::vector<std::unique_ptr<BridgeSession>> sessions;
+    sessions.push_back(EstablishChannelBridge(settings));
+
+    // The channel is opened directly, not through an adapter service
+    return RunBridges(sessions, {});
+}
 
-    std::cout << "Good bye!" << std::endl;
+int ListBonds()
+{
+    auto bondStore = IBluetoothService::GetBondStore();
+    if (!bondStore) {
+        std::cerr << "No bond store, pass --bond-store=<path> to use one. \n";
+        return 1;
+    }
+
+    auto bonds = bondStore->List();
+    std::cout << "Found " << bonds.size() << " bonds in " << bondStore->GetPath() << "\n";
+    for (auto &bond : bonds) {
+        auto pairedAt = std::chrono::system_clock::to_time_t(bond.pairedAt);
+        std::cout << "\t" << BluetoothAddressToString(bond.address) << " (" << (bond.protection == PairingProtection::EncryptionAndAuthentication ? "authenticated" : "encrypted")
+                  << ") paired " << std::put_time(std::localtime(&pairedAt), "%Y-%m-%d %H:%M:%S") << " in " << bond.pairingTime.count() << " ms\n";
+    }
+
+    std::cout << std::flush;
+    return 0;
+}
+
+int ForgetBond(BluetoothAddress address)
+{
+    auto bondStore = IBluetoothService::GetBondStore();
+    if (!bondStore || !bondStore->Remove(address)) {
+        std::cerr << "No bond with " << BluetoothAddressToString(address) << " is stored. \n";
+        return 1;
+    }
+
+    std::cout << "Forgot the bond with " << BluetoothAddressToString(address) << ", the OS keeps its keys until the device is removed there. \n" << std::flush;
+    return 0;
+}
+
+int ListAdapters()
+{
+    auto adapters = IBluetoothService::GetAdapters();
+
+    std::cout << "Found " << adapters.size() << " adapters\n";
+    size_t i = 1;
+    for (auto &adapter : adapters) {
+        std::cout << "\t" << i++ << ". ";
+        std::wcout << adapter.name;
+        std::cout << " [Addr: " << BluetoothAddressToString(adapter.address) << "]" << (adapter.isDefault ? " (default)" : "") << "\n";
+        std::cout << "\t   Id: " << adapter.id << "\n";
+    }
+
+    std::cout << std::flush;
     return 0;
 }
 
@@ -215,8 +556,315 @@ Parity ParityFromString(const std::string &str)
     }
 }
 
+std::optional<TrafficMonitorOptions> MonitorViewFromString(const std::string &str)
+{
+    TrafficMonitorOptions options {};
+
+    if (str == "off") {
+        return std::nullopt;
+    } else if (str == "hexdump") {
+        options.hexdump = true;
+    } else if (str == "summary") {
+        options.hexdump = false;
+    } else {
+        throw std::invalid_argument("Valid arguments for the monitor view are: off; hexdump; summary");
+    }
+
+    return options;
+}
+
+std::optional<GattWriteMode> WriteModeFromString(const std::string &str)
+{
+    if (str == "auto") {
+        return std::nullopt;
+    } else if (str == "response") {
+        return GattWriteMode::WithResponse;
+    } else if (str == "noresponse") {
+        return GattWriteMode::WithoutResponse;
+    } else {
+        throw std::invalid_argument("Valid arguments for the write mode are: auto; response; noresponse");
+    }
+}
+
+std::optional<BluetoothAddress> DfuTargetFromString(const std::string &str)
+{
+    if (str == "sim") {
+        return std::nullopt;
+    }
+
+    return BluetoothAddressFromString(str);
+}
+
+std::vector<GattRegisteredCharacteristic> CharacteristicIdsFromString(const std::string &str)
+{
+    std::vector<GattRegisteredCharacteristic> result;
+    std::istringstream stream { str };
+    std::string id;
+
+    while (std::getline(stream, id, ',')) {
+        result.push_back(CharacteristicIdFromString(id));
+    }
+
+    if (result.empty()) {
+        throw std::invalid_argument("At least one characteristic id is required");
+    }
+
+    return result;
+}
+
+PollingOptions PollingFromString(const std::string &str)
+{
+    PollingOptions options {};
+    std::istringstream stream { str };
+    std::string mode, minInterval, maxInterval;
+
+    std::getline(stream, mode, ':');
+    std::getline(stream, minInterval, ':');
+    std::getline(stream, maxInterval, ':');
+
+    if (mode == "force") {
+        options.force = true;
+    } else if (mode != "auto") {
+        throw std::invalid_argument("Valid arguments for polling are: auto; force optionally followed by :<min_ms>:<max_ms>");
+    }
+
+    if (!minInterval.empty()) {
+        options.minInterval = std::chrono::milliseconds(StringToInt(minInterval));
+    }
+
+    if (!maxInterval.empty()) {
+        options.maxInterval = std::chrono::milliseconds(StringToInt(maxInterval));
+    }
+
+    return options;
+}
+
+ConflationOptions ConflationFromString(const std::string &str)
+{
+    ConflationOptions options {};
+    std::string policy = str;
+
+    if (policy.ends_with("+dedup")) {
+        options.deduplicate = true;
+        policy.erase(policy.size() - 6);
+    }
+
+    auto separator = policy.find(':');
+    std::string mode = policy.substr(0, separator);
+    int value = separator == std::string::npos ? 0 : StringToInt(policy.substr(separator + 1));
+
+    if (mode == "none" || mode == "dedup") {
+        options.deduplicate |= mode == "dedup";
+    } else if (mode == "latest" && value > 0) {
+        options.mode = ConflationMode::LatestOnly;
+        options.interval = std::chrono::milliseconds(value);
+    } else if (mode == "interval" && value > 0) {
+        options.mode = ConflationMode::MinInterval;
+        options.interval = std::chrono::milliseconds(value);
+    } else if (mode == "nth" && value > 0) {
+        options.everyNth = value;
+    } else {
+        throw std::invalid_argument("Valid arguments for conflation are: none; dedup; latest:<ms>; interval:<ms>; nth:<n> optionally followed by +dedup");
+    }
+
+    return options;
+}
+
+BridgeOptions BridgeOptionsFromArgs(const ParamHelper &args, size_t heartbeatIndex, size_t inactivityIndex, size_t spillIndex, size_t replayIndex, size_t controlIndex,
+                                    size_t packetIndex, size_t conflationIndex, size_t pollingIndex, size_t cacheIndex)
+{
+    BridgeOptions options {};
+    options.valueCacheTtl = std::chrono::milliseconds(args.GetOrDefault<int>(cacheIndex, "0", &StringToInt));
+    options.polling = args.GetOrDefault<PollingOptions>(pollingIndex, "auto", &PollingFromString);
+    options.conflation = args.GetOrDefault<ConflationOptions>(conflationIndex, "none", &ConflationFromString);
+    options.scheduler.packetSize = args.GetOrDefault<int>(packetIndex, "0", &StringToInt);
+
+    if (size_t controlMaxLength = args.GetOrDefault<int>(controlIndex, "0", &StringToInt)) {
+        options.scheduler.rules.push_back(PriorityRule { .prefix = {}, .maxLength = controlMaxLength, .priority = Priority::Control });
+    }
+
+    options.queue.spillDirectory = args.GetStringOrDefault(spillIndex, "");
+    options.replayRate = args.GetOrDefault<int>(replayIndex, "0", &StringToInt);
+
+    auto heartbeat = std::chrono::milliseconds(args.GetOrDefault<int>(heartbeatIndex, "0", &StringToInt));
+    auto inactivity = std::chrono::milliseconds(args.GetOrDefault<int>(inactivityIndex, "0", &StringToInt));
+
+    if (heartbeat.count() != 0 || inactivity.count() != 0) {
+        options.health.enabled = true;
+        options.health.readHeartbeat = heartbeat.count() != 0;
+        options.health.inactivityTimeout = inactivity;
+
+        if (heartbeat.count() != 0) {
+            options.health.checkInterval = heartbeat;
+        } else {
+            options.health.checkInterval = std::min(options.health.checkInterval, inactivity);
+        }
+    }
+
+    return options;
+}
+
+int Multi(const std::string &fileName, unsigned int maxPerAdapter)
+{
+    std::ifstream file { fileName };
+    if (!file) {
+        throw std::invalid_argument("Cannot open bridges file " + fileName);
+    }
+
+    auto balancer = BluetoothAdapterBalancer::ForAllAdapters();
+    for (auto service : balancer.GetServices()) {
+        service->SetMaxConnectionCount(maxPerAdapter);
+    }
+
+    size_t adapterCount = IBluetoothService::GetAdapters().size();
+    if (adapterCount > balancer.GetServices().size()) {
+        // Not only logged, the bridges file was most likely sized for all the adapters
+        std::cerr << "Warning: only " << balancer.GetServices().size() << " of " << adapterCount << " adapters can be used, connections cannot be pinned to an adapter on this platform. "
+                  << "All bridges share the limit of " << maxPerAdapter * balancer.GetServices().size() << " connections. \n";
+        Write(Severity::Warning, "Connections cannot be pinned to an adapter on this platform, the adapters share the limit of one",
+              { { "adapters", adapterCount }, { "usable", balancer.GetServices().size() }, { "max_connections", maxPerAdapter * balancer.GetServices().size() } });
+    }
+
+    std::vector<std::unique_ptr<BridgeSession>> sessions;
+    std::string line;
+
+    // The bridges established before a failing one are already connected
+    try {
+        while (std::getline(file, line)) {
+            if (line.empty() || line.starts_with("#")) {
+                continue;
+            }
+
+            std::istringstream stream { line };
+            std::string address, serviceId, characteristicId, portNumber;
+            std::string baud = "9600", data = "8", stop = "1", parity = "none";
+            stream >> address >> serviceId >> characteristicId >> portNumber >> baud >> data >> stop >> parity;
+
+            if (portNumber.empty()) {
+                throw std::invalid_argument("Invalid bridge definition: " + line);
+            }
+
+            BridgeSettings settings {
+                    .address = BluetoothAddressFromString(address),
+                    .serviceId = ServiceIdFromString(serviceId),
+                    .characteristicId = CharacteristicIdsFromString(characteristicId).front(),
+                    .polledCharacteristicIds = {},
+                    .portNumber = static_cast<unsigned int>(StringToInt(portNumber)),
+                    .timeout = 5,
+                    .baud = static_cast<unsigned int>(StringToInt(baud)),
+                    .data = static_cast<unsigned int>(StringToInt(data)),
+                    .stopBits = StopBitsFromString(stop),
+                    .parity = ParityFromString(parity),
+                    .refresh = std::chrono::milliseconds(100),
+                    .options = {}
+            };
+
+            // Connections are opened one by one, so that every selection sees the load of the previous ones
+            auto &service = balancer.SelectService();
+            Write(Severity::Info, "Assigning bridge to adapter", { { "bridge", address }, { "adapter", service.GetAdapterId().empty() ? "(default)" : service.GetAdapterId() } });
+
+            auto session = EstablishBridge(service, settings);
+            if (!session) {
+                CloseBridges(sessions);
+                return 1;
+            }
+
+            sessions.push_back(std::move(session));
+        }
+    } catch (...) {
+        CloseBridges(sessions);
+        throw;
+    }
+
+    return RunBridges(sessions, balancer.GetServices());
+}
+
+LoggerOptions LoggerOptionsFromArgs(int &argc, char **argv)
+{
+    LoggerOptions options {};
+    int kept = 1;
+
+    // Logging options may appear anywhere, they are removed so that the positional arguments stay where they were
+    for (int i = 1; i < argc; i++) {
+        std::string_view arg { argv[i] };
+
+        if (arg.starts_with("--log-level=")) {
+            options.level = SeverityFromString(arg.substr(12));
+        } else if (arg.starts_with("--log-format=")) {
+            auto format = arg.substr(13);
+            if (format == "text") {
+                options.format = LogFormat::Text;
+            } else if (format == "json") {
+                options.format = LogFormat::Json;
+            } else {
+                throw std::invalid_argument("Unknown log format " + std::string { format });
+            }
+        } else if (arg.starts_with("--log-file=")) {
+            options.file = arg.substr(11);
+        } else {
+            argv[kept++] = argv[i];
+        }
+    }
+
+    argc = kept;
+    return options;
+}
+
+std::optional<std::string> OptionFromArgs(int &argc, char **argv, std::string_view prefix)
+{
+    std::optional<std::string> value;
+    int kept = 1;
+
+    for (int i = 1; i < argc; i++) {
+        std::string_view arg { argv[i] };
+
+        if (arg.starts_with(prefix)) {
+            value = arg.substr(prefix.size());
+        } else {
+            argv[kept++] = argv[i];
+        }
+    }
+
+    argc = kept;
+    return value;
+}
+
 int main(int argc, char **argv)
 {
+    LoggerOptions loggerOptions;
+    try {
+        loggerOptions = LoggerOptionsFromArgs(argc, argv);
+        Logger::Global().Start(loggerOptions);
+
+        if (auto uuidDatabase = OptionFromArgs(argc, argv, "--uuid-db=")) {
+            LoadUuidDatabase(*uuidDatabase);
+        }
+    } catch (const std::invalid_argument &e) {
+        std::cerr << "Invalid argument: " << e.what();
+        return 1;
+    } catch (const IOException &e) {
+        std::cerr << "IO error: " << e.what();
+        return 1;
+    }
+
+    // Whatever is still staged is written out before the process exits
+    struct LoggerGuard
+    {
+        ~LoggerGuard()
+        {
+            Logger::Global().Stop();
+        }
+    } loggerGuard;
+
+    // Pairing changes the state of the OS, so it is only done when asked for. A broken store only costs pairings.
+    if (auto bondStorePath = OptionFromArgs(argc, argv, "--bond-store=")) {
+        try {
+            IBluetoothService::SetBondStore(std::make_shared<BondStore>(*bondStorePath));
+        } catch (const IOException &e) {
+            Write(Severity::Warning, "Bond store is unusable, bonds are not remembered", { { "path", *bondStorePath }, { "error", e.what() } });
+        }
+    }
+
     if (argc < 2) {
         PrintUsage(argv[0]);
         return 1;
@@ -225,6 +873,17 @@ int main(int argc, char **argv)
     std::string action { argv[1] };
     IBluetoothService::GetService().Initialize();
 
+#ifdef BLE_SERIAL_INSTRUMENTATION
+    // Profile builds print where the time went once the command finishes
+    struct InstrumentationReport
+    {
+        ~InstrumentationReport()
+        {
+            BLE_Serial::Instrumentation::Report(std::cerr);
+        }
+    } instrumentationReport;
+#endif
+
     // @formatter:off
     try {
         ParamHelper args { argc, argv };
@@ -240,17 +899,272 @@ int main(int argc, char **argv)
             PrintUsage(argv[0]);
             return 0;
         } else if (action == "connect" && argc >= 4) {
-            return Connect(
+            return Connect(BridgeSettings {
+                    .address = args.GetOrDefault<BluetoothAddress>(2, "", &BluetoothAddressFromString),
+                    .serviceId = args.GetOrDefault<GattRegisteredService>(3, "", &ServiceIdFromString),
+                    .characteristicId = args.GetOrDefault<GattRegisteredCharacteristic>(4, "", [](const std::string& str) { return CharacteristicIdsFromString(str).front(); }),
+                    .polledCharacteristicIds = args.GetOrDefault<std::vector<GattRegisteredCharacteristic>>(4, "", [](const std::string& str) {
+                        auto ids = CharacteristicIdsFromString(str);
+                        return std::vector<GattRegisteredCharacteristic> { ids.begin() + 1, ids.end() };
+                    }),
+                    .portNumber = static_cast<unsigned int>(args.GetOrDefault<int>(5, "", &StringToInt)),
+                    .timeout = static_cast<unsigned int>(args.GetOrDefault<int>(6, "5", &StringToInt)),
+                    .baud = static_cast<unsigned int>(args.GetOrDefault<int>(7, "9600", &StringToInt)),
+                    .data = static_cast<unsigned int>(args.GetOrDefault<int>(8, "8", &StringToInt)),
+                    .stopBits = args.GetOrDefault<StopBits>(9, "1", &StopBitsFromString),
+                    .parity = args.GetOrDefault<Parity>(10, "none", &ParityFromString),
+                    .refresh = args.GetOrDefault<std::chrono::milliseconds>(11, "100", [](const std::string& str) { return std::chrono::milliseconds(StringToInt(str)); }),
+                    .options = BridgeOptionsFromArgs(args, 12, 13, 14, 15, 16, 17, 18, 19, 20),
+                    .monitor = args.GetOrDefault<std::optional<TrafficMonitorOptions>>(21, "off", &MonitorViewFromString)
+            });
+        } else if (action == "l2cap" && argc >= 5) {
+            return ConnectChannel(ChannelSettings {
+                    .address = args.GetOrDefault<BluetoothAddress>(2, "", &BluetoothAddressFromString),
+                    .psm = args.GetOrDefault<uint16_t>(3, "", [](const std::string& str) { return static_cast<uint16_t>(std::stoi(str, nullptr, 0)); }),
+                    .portNumber = static_cast<unsigned int>(args.GetOrDefault<int>(4, "", &StringToInt)),
+                    .timeout = static_cast<unsigned int>(args.GetOrDefault<int>(5, "5", &StringToInt)),
+                    .baud = static_cast<unsigned int>(args.GetOrDefault<int>(6, "9600", &StringToInt)),
+                    .data = static_cast<unsigned int>(args.GetOrDefault<int>(7, "8", &StringToInt)),
+                    .stopBits = args.GetOrDefault<StopBits>(8, "1", &StopBitsFromString),
+                    .parity = args.GetOrDefault<Parity>(9, "none", &ParityFromString),
+                    .refresh = args.GetOrDefault<std::chrono::milliseconds>(10, "100", [](const std::string& str) { return std::chrono::milliseconds(StringToInt(str)); }),
+                    .channel = L2CAPChannelOptions {
+                            .mtu = static_cast<uint16_t>(args.GetOrDefault<int>(11, "65535", &StringToInt)),
+                            .credits = static_cast<uint16_t>(args.GetOrDefault<int>(12, "32", &StringToInt))
+                    }
+            });
+        } else if (action == "shell" && argc >= 3) {
+            return Shell(
                     args.GetOrDefault<BluetoothAddress>(2, "", &BluetoothAddressFromString),
-                    args.GetOrDefault<GattRegisteredService>(3, "", [](const std::string& str) { return static_cast<GattRegisteredService>(std::stoi(str, nullptr, 16)); }),
-                    args.GetOrDefault<GattRegisteredCharacteristic>(4, "", [](const std::string& str) { return static_cast<GattRegisteredCharacteristic>(std::stoi(str, nullptr, 16)); }),
-                    args.GetOrDefault<int>(5, "", &StringToInt),
-                    args.GetOrDefault<int>(6, "5", &StringToInt),
-                    args.GetOrDefault<int>(7, "9600", &StringToInt),
-                    args.GetOrDefault<int>(8, "8", &StringToInt),
-                    args.GetOrDefault<StopBits>(9, "1", &StopBitsFromString),
-                    args.GetOrDefault<Parity>(10, "none", &ParityFromString),
-                    args.GetOrDefault<std::chrono::milliseconds>(11, "100", [](const std::string& str) { return std::chrono::milliseconds(StringToInt(str)); })
+                    args.GetOrDefault<int>(3, "5", &StringToInt),
+                    std::cin
+            );
+        } else if (action == "batch" && argc >= 3) {
+            return Batch(BatchSettings {
+                    .planFile = args.GetStringOrDefault(2, ""),
+                    .concurrency = static_cast<unsigned int>(args.GetOrDefault<int>(3, "4", &StringToInt)),
+                    .retries = static_cast<unsigned int>(args.GetOrDefault<int>(4, "2", &StringToInt)),
+                    .scanTimeout = std::chrono::seconds(args.GetOrDefault<int>(5, "5", &StringToInt)),
+                    .timeout = std::chrono::seconds(args.GetOrDefault<int>(6, "5", &StringToInt))
+            }, std::cout);
+        } else if ((action == "send" || action == "recv") && argc >= 6) {
+            TransferSettings settings {
+                    .address = args.GetOrDefault<BluetoothAddress>(2, "", &BluetoothAddressFromString),
+                    .serviceId = args.GetOrDefault<GattRegisteredService>(3, "", &ServiceIdFromString),
+                    .characteristicId = args.GetOrDefault<GattRegisteredCharacteristic>(4, "", &CharacteristicIdFromString),
+                    .file = args.GetStringOrDefault(5, ""),
+                    .timeout = std::chrono::seconds(args.GetOrDefault<int>(6, "5", &StringToInt))
+            };
+
+            signal(SIGINT, SigintHandler);
+
+            if (action == "send") {
+                settings.rate = args.GetOrDefault<int>(7, "0", &StringToInt);
+                settings.writeMode = args.GetOrDefault<std::optional<GattWriteMode>>(8, "auto", &WriteModeFromString);
+                return Send(settings, sigintReceived);
+            } else {
+                settings.idleTimeout = std::chrono::milliseconds(args.GetOrDefault<int>(7, "0", &StringToInt));
+                return Receive(settings, sigintReceived);
+            }
+        } else if (action == "monitor" && argc >= 5) {
+            auto options = args.GetOrDefault<std::optional<TrafficMonitorOptions>>(6, "hexdump", &MonitorViewFromString);
+            if (!options) {
+                throw std::invalid_argument("The monitor view cannot be off");
+            }
+
+            signal(SIGINT, SigintHandler);
+
+            return Monitor(MonitorSettings {
+                    .address = args.GetOrDefault<BluetoothAddress>(2, "", &BluetoothAddressFromString),
+                    .serviceId = args.GetOrDefault<GattRegisteredService>(3, "", &ServiceIdFromString),
+                    .characteristicId = args.GetOrDefault<GattRegisteredCharacteristic>(4, "", &CharacteristicIdFromString),
+                    .timeout = std::chrono::seconds(args.GetOrDefault<int>(5, "5", &StringToInt)),
+                    .options = *options
+            }, sigintReceived);
+        } else if (action == "decode" && argc >= 5) {
+            signal(SIGINT, SigintHandler);
+
+            return Decode(DecodeSettings {
+                    .address = args.GetOrDefault<BluetoothAddress>(2, "", &BluetoothAddressFromString),
+                    .serviceId = args.GetOrDefault<GattRegisteredService>(3, "", &ServiceIdFromString),
+                    .characteristicId = args.GetOrDefault<GattRegisteredCharacteristic>(4, "", &CharacteristicIdFromString),
+                    .timeout = std::chrono::seconds(args.GetOrDefault<int>(5, "5", &StringToInt)),
+                    .format = args.GetOrDefault<DecodeFormat>(6, "json", [](const std::string& str) {
+                        if (str == "json") {
+                            return DecodeFormat::Json;
+                        } else if (str == "binary") {
+                            return DecodeFormat::Binary;
+                        }
+
+                        throw std::invalid_argument("Valid arguments for the decode format are: json; binary");
+                    })
+            }, sigintReceived);
+        } else if (action == "stats") {
+            signal(SIGINT, SigintHandler);
+
+            return Stats(StatsViewSettings {
+                    .process = args.GetOrDefault<std::string>(2, "", [](const std::string& str) { return str.empty() ? str : std::to_string(StringToInt(str)); }),
+                    .refresh = std::chrono::milliseconds(args.GetOrDefault<int>(3, "1000", &StringToInt))
+            }, sigintReceived);
+        } else if (action == "aggregate" && argc >= 6) {
+            signal(SIGINT, SigintHandler);
+
+            return Aggregate(AggregateSettings {
+                    .addresses = args.GetOrDefault<std::vector<BluetoothAddress>>(2, "", [](const std::string& str) {
+                        std::vector<BluetoothAddress> addresses;
+                        std::istringstream stream { str };
+                        for (std::string address; std::getline(stream, address, ',');) {
+                            addresses.push_back(BluetoothAddressFromString(address));
+                        }
+                        return addresses;
+                    }),
+                    .serviceId = args.GetOrDefault<GattRegisteredService>(3, "", &ServiceIdFromString),
+                    .characteristicIds = args.GetOrDefault<std::vector<GattRegisteredCharacteristic>>(4, "", &CharacteristicIdsFromString),
+                    .portNumber = static_cast<unsigned int>(args.GetOrDefault<int>(5, "", &StringToInt)),
+                    .timeout = std::chrono::seconds(args.GetOrDefault<int>(6, "5", &StringToInt)),
+                    .baud = static_cast<unsigned int>(args.GetOrDefault<int>(7, "9600", &StringToInt)),
+                    .data = static_cast<unsigned int>(args.GetOrDefault<int>(8, "8", &StringToInt)),
+                    .stopBits = args.GetOrDefault<StopBits>(9, "1", &StopBitsFromString),
+                    .parity = args.GetOrDefault<Parity>(10, "none", &ParityFromString),
+                    .refresh = std::chrono::milliseconds(args.GetOrDefault<int>(11, "100", &StringToInt)),
+                    .options = AggregationOptions {
+                            .segmentSize = static_cast<size_t>(args.GetOrDefault<int>(12, "0", &StringToInt)),
+                            .reorderWindow = static_cast<size_t>(args.GetOrDefault<int>(13, "256", &StringToInt)),
+                            .gapTimeout = std::chrono::milliseconds(args.GetOrDefault<int>(14, "200", &StringToInt))
+                    }
+            }, sigintReceived);
+        } else if (action == "adverts" && argc >= 3) {
+            AdvertsSettings settings {
+                    .portNumber = args.GetOrDefault<std::optional<unsigned int>>(2, "", [](const std::string& str) {
+                        return str == "-" ? std::nullopt : std::optional<unsigned int> { static_cast<unsigned int>(StringToInt(str)) };
+                    }),
+                    .options = AdvertisementBridgeOptions {
+                            .filter = args.GetOrDefault<AdvertisementFilter>(3, "all", &AdvertisementFilterFromString),
+                            .minInterval = std::chrono::milliseconds(args.GetOrDefault<int>(4, "0", &StringToInt)),
+                            .repeatInterval = std::chrono::milliseconds(args.GetOrDefault<int>(5, "0", &StringToInt))
+                    }
+            };
+
+            settings.options.format = args.GetOrDefault<AdvertisementFormat>(6, settings.portNumber ? "binary" : "json", [](const std::string& str) {
+                if (str == "binary") {
+                    return AdvertisementFormat::Binary;
+                } else if (str == "json") {
+                    return AdvertisementFormat::Json;
+                }
+
+                throw std::invalid_argument("Invalid advertisement format: " + str);
+            });
+
+            signal(SIGINT, SigintHandler);
+            return Adverts(settings, sigintReceived);
+        } else if (action == "modbus" && argc >= 5) {
+            signal(SIGINT, SigintHandler);
+
+            return Modbus(ModbusSettings {
+                    .addresses = args.GetOrDefault<std::vector<BluetoothAddress>>(2, "", [](const std::string& str) {
+                        std::vector<BluetoothAddress> addresses;
+                        std::istringstream stream { str };
+                        for (std::string address; std::getline(stream, address, ',');) {
+                            addresses.push_back(BluetoothAddressFromString(address));
+                        }
+                        return addresses;
+                    }),
+                    .serviceId = args.GetOrDefault<GattRegisteredService>(3, "", &ServiceIdFromString),
+                    .characteristicId = args.GetOrDefault<GattRegisteredCharacteristic>(4, "", &CharacteristicIdFromString),
+                    .tcpPort = args.GetOrDefault<std::optional<uint16_t>>(5, "502", [](const std::string& str) {
+                        return str == "-" ? std::nullopt : std::optional<uint16_t> { static_cast<uint16_t>(StringToInt(str)) };
+                    }),
+                    .portNumber = args.GetOrDefault<std::optional<unsigned int>>(6, "-", [](const std::string& str) {
+                        return str == "-" ? std::nullopt : std::optional<unsigned int> { static_cast<unsigned int>(StringToInt(str)) };
+                    }),
+                    .timeout = std::chrono::seconds(args.GetOrDefault<int>(7, "5", &StringToInt)),
+                    .baud = static_cast<unsigned int>(args.GetOrDefault<int>(8, "9600", &StringToInt)),
+                    .parity = args.GetOrDefault<Parity>(9, "even", &ParityFromString),
+                    .unitIds = args.GetOrDefault<std::vector<std::vector<uint8_t>>>(11, "", [](const std::string& str) {
+                        std::vector<std::vector<uint8_t>> unitIds;
+                        std::istringstream devices { str };
+                        for (std::string device; std::getline(devices, device, '/');) {
+                            auto &units = unitIds.emplace_back();
+                            std::istringstream stream { device };
+                            for (std::string unit; std::getline(stream, unit, ',');) {
+                                int unitId = StringToInt(unit);
+                                if (unitId < 1 || unitId > 247) {
+                                    throw std::invalid_argument("Invalid Modbus unit id: " + unit);
+                                }
+                                units.push_back(static_cast<uint8_t>(unitId));
+                            }
+                        }
+                        return unitIds;
+                    }),
+                    .options = ModbusGatewayOptions {
+                            .responseTimeout = std::chrono::milliseconds(args.GetOrDefault<int>(10, "1000", &StringToInt))
+                    }
+            }, sigintReceived);
+        } else if (action == "mqtt" && argc >= 6) {
+            MqttPublishSettings settings {
+                    .addresses = args.GetOrDefault<std::vector<BluetoothAddress>>(2, "", [](const std::string& str) {
+                        std::vector<BluetoothAddress> addresses;
+                        std::istringstream stream { str };
+                        for (std::string address; std::getline(stream, address, ',');) {
+                            addresses.push_back(BluetoothAddressFromString(address));
+                        }
+                        return addresses;
+                    }),
+                    .serviceId = args.GetOrDefault<GattRegisteredService>(3, "", &ServiceIdFromString),
+                    .characteristicIds = args.GetOrDefault<std::vector<GattRegisteredCharacteristic>>(4, "", &CharacteristicIdsFromString),
+                    .topic = args.GetStringOrDefault(6, "ble/{address}/{characteristic}"),
+                    .timeout = std::chrono::seconds(args.GetOrDefault<int>(9, "5", &StringToInt)),
+                    .options = MqttOptions {
+                            .clientId = args.GetStringOrDefault(10, "ble_serial"),
+                            .qos = args.GetOrDefault<MqttQoS>(7, "0", [](const std::string& str) {
+                                if (str == "0") {
+                                    return MqttQoS::AtMostOnce;
+                                } else if (str == "1") {
+                                    return MqttQoS::AtLeastOnce;
+                                }
+
+                                throw std::invalid_argument("Unsupported QoS: " + str);
+                            }),
+                            .inFlightWindow = static_cast<size_t>(args.GetOrDefault<int>(8, "16", &StringToInt))
+                    }
+            };
+
+            auto broker = args.GetStringOrDefault(5, "");
+            auto separator = broker.rfind(':');
+            if (separator != std::string::npos) {
+                settings.options.port = static_cast<uint16_t>(StringToInt(broker.substr(separator + 1)));
+                broker.resize(separator);
+            }
+            settings.options.host = broker;
+            settings.queue.spillDirectory = args.GetStringOrDefault(11, "");
+
+            signal(SIGINT, SigintHandler);
+            return MqttPublish(settings, sigintReceived);
+        } else if (action == "dfu" && argc >= 5) {
+            signal(SIGINT, SigintHandler);
+            return UploadFirmware(DfuSettings {
+                    .address = args.GetOrDefault<std::optional<BluetoothAddress>>(2, "", &DfuTargetFromString),
+                    .initPacket = args.GetStringOrDefault(3, ""),
+                    .firmware = args.GetStringOrDefault(4, ""),
+                    .timeout = std::chrono::seconds(args.GetOrDefault<int>(5, "5", &StringToInt)),
+                    .receiptInterval = static_cast<uint16_t>(args.GetOrDefault<int>(6, "12", &StringToInt)),
+                    .receiptWindow = static_cast<size_t>(args.GetOrDefault<int>(7, "2", &StringToInt))
+            }, sigintReceived);
+        } else if (action == "uuiddb" && argc >= 4) {
+            return BuildUuidDatabase(UuidDbSettings {
+                    .output = args.GetStringOrDefault(2, ""),
+                    .inputs = { argv + 3, argv + argc }
+            });
+        } else if (action == "bonds" && argc >= 4 && std::string_view { argv[2] } == "forget") {
+            return ForgetBond(args.GetOrDefault<BluetoothAddress>(3, "", &BluetoothAddressFromString));
+        } else if (action == "bonds") {
+            return ListBonds();
+        } else if (action == "adapters") {
+            return ListAdapters();
+        } else if (action == "multi" && argc >= 3) {
+            return Multi(
+                    args.GetStringOrDefault(2, ""),
+                    args.GetOrDefault<int>(3, "7", &StringToInt)
             );
         } else {
             PrintUsage(argv[0]);
@@ -265,6 +1179,9 @@ int main(int argc, char **argv)
     } catch (const COMException &e) {
         std::cerr << "COM error: " << e.what();
         return 1;
+    } catch (const IOException &e) {
+        std::cerr << "IO error: " << e.what();
+        return 1;
     }
     // @formatter:on
 }
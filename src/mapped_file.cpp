@@ -0,0 +1,70 @@
+#include <ble_serial/mapped_file.hpp>
+
+#include <utility>
+
+namespace BLE_Serial::IO
+{
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // IOException implementation                           //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    IOException::IOException(std::string message)
+            : m_message { std::move(message) }
+    {
+    }
+
+    const char *IOException::what() const noexcept
+    {
+        return m_message.c_str();
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // MappedFile implementation                            //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    MappedFile::~MappedFile()
+    {
+        Close();
+    }
+
+    MappedFile::MappedFile(MappedFile &&other) noexcept
+            : m_path { std::move(other.m_path) }, m_data { std::exchange(other.m_data, nullptr) }, m_size { std::exchange(other.m_size, 0) }
+    {
+    }
+
+    MappedFile &MappedFile::operator=(MappedFile &&other) noexcept
+    {
+        if (this != &other) {
+            Close();
+            m_path = std::move(other.m_path);
+            m_data = std::exchange(other.m_data, nullptr);
+            m_size = std::exchange(other.m_size, 0);
+        }
+
+        return *this;
+    }
+
+    uint8_t *MappedFile::Data() noexcept
+    {
+        return m_data;
+    }
+
+    const uint8_t *MappedFile::Data() const noexcept
+    {
+        return m_data;
+    }
+
+    size_t MappedFile::Size() const noexcept
+    {
+        return m_size;
+    }
+
+    const std::string &MappedFile::Path() const noexcept
+    {
+        return m_path;
+    }
+}
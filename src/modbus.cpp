@@ -0,0 +1,753 @@
+#include <ble_serial/modbus.hpp>
+#include <ble_serial/instrumentation.hpp>
+
+#include <algorithm>
+
+namespace BLE_Serial::Modbus
+{
+    using namespace BLE_Serial::Bluetooth;
+    using namespace BLE_Serial::COM;
+    using namespace BLE_Serial::IO;
+
+    namespace
+    {
+        /**
+         * Largest RTU frame: unit id, 253 bytes of PDU and the CRC
+         */
+        constexpr size_t c_maxFrameSize = 256;
+
+        /**
+         * Largest PDU that fits into both an RTU frame and a Modbus TCP ADU
+         */
+        constexpr size_t c_maxPduSize = 253;
+
+        constexpr size_t c_mbapHeaderSize = 7;
+
+        /**
+         * COM ports are polled, so the bytes are time-stamped up to this late and the silent interval is widened by it
+         */
+        constexpr std::chrono::microseconds c_portReadLatency { 2000 };
+
+        constexpr std::chrono::milliseconds c_portRefreshRate { 1 };
+
+        constexpr std::chrono::milliseconds c_acceptInterval { 200 };
+
+        constexpr std::chrono::milliseconds c_receiveInterval { 200 };
+
+        /**
+         * Slicing-by-2 tables, the second one advances the CRC over one more zero byte than the first
+         */
+        constexpr std::array<std::array<uint16_t, 256>, 2> c_crcTables = []() {
+            std::array<std::array<uint16_t, 256>, 2> tables {};
+
+            for (uint16_t i = 0; i < 256; i++) {
+                uint16_t crc = i;
+                for (int bit = 0; bit < 8; bit++) {
+                    crc = (crc & 1) != 0 ? static_cast<uint16_t>((crc >> 1) ^ 0xA001) : static_cast<uint16_t>(crc >> 1);
+                }
+                tables[0][i] = crc;
+            }
+
+            for (uint16_t i = 0; i < 256; i++) {
+                tables[1][i] = static_cast<uint16_t>((tables[0][i] >> 8) ^ tables[0][tables[0][i] & 0xFF]);
+            }
+
+            return tables;
+        }();
+
+        uint16_t ReadBigEndian(const uint8_t *data) noexcept
+        {
+            return static_cast<uint16_t>((data[0] << 8) | data[1]);
+        }
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // RTU framing implementation                           //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    uint16_t Crc16(const uint8_t *data, size_t size, uint16_t crc) noexcept
+    {
+        for (; size >= 2; data += 2, size -= 2) {
+            crc ^= static_cast<uint16_t>(data[0] | (data[1] << 8));
+            crc = static_cast<uint16_t>(c_crcTables[1][crc & 0xFF] ^ c_crcTables[0][crc >> 8]);
+        }
+
+        if (size != 0) {
+            crc = static_cast<uint16_t>((crc >> 8) ^ c_crcTables[0][(crc ^ data[0]) & 0xFF]);
+        }
+
+        return crc;
+    }
+
+    void AppendCrc(std::vector<uint8_t> &frame)
+    {
+        uint16_t crc = Crc16(frame.data(), frame.size());
+        frame.push_back(static_cast<uint8_t>(crc));
+        frame.push_back(static_cast<uint8_t>(crc >> 8));
+    }
+
+    bool CheckCrc(const uint8_t *frame, size_t size) noexcept
+    {
+        if (size < 4) {
+            return false;
+        }
+
+        uint16_t crc = Crc16(frame, size - 2);
+        return frame[size - 2] == static_cast<uint8_t>(crc) && frame[size - 1] == static_cast<uint8_t>(crc >> 8);
+    }
+
+    std::optional<size_t> ExpectedFrameLength(const uint8_t *frame, size_t size, ModbusFrameKind kind) noexcept
+    {
+        if (size < 2) {
+            return std::nullopt;
+        }
+
+        uint8_t function = frame[1];
+
+        // Lengths that depend on a byte count: the count's offset and the bytes around the counted data
+        auto counted = [frame, size](size_t offset, size_t overhead) -> std::optional<size_t> {
+            if (size <= offset) {
+                return std::nullopt;
+            }
+            return overhead + frame[offset];
+        };
+
+        if (kind == ModbusFrameKind::Request) {
+            switch (function) {
+                case 0x01: case 0x02: case 0x03: case 0x04: case 0x05: case 0x06:
+                    return 8;
+                case 0x07: case 0x0B: case 0x0C: case 0x11:
+                    return 4;
+                case 0x0F: case 0x10:
+                    return counted(6, 9);
+                case 0x16:
+                    return 10;
+                case 0x17:
+                    return counted(10, 13);
+                case 0x18:
+                    return 6;
+                default:
+                    return 0;
+            }
+        }
+
+        if ((function & 0x80) != 0) {
+            return 5;
+        }
+
+        switch (function) {
+            case 0x01: case 0x02: case 0x03: case 0x04: case 0x0C: case 0x11: case 0x17:
+                return counted(2, 5);
+            case 0x05: case 0x06: case 0x0B: case 0x0F: case 0x10:
+                return 8;
+            case 0x07:
+                return 5;
+            case 0x16:
+                return 10;
+            case 0x18:
+                if (size < 4) {
+                    return std::nullopt;
+                }
+                return 6 + ReadBigEndian(frame + 2);
+            default:
+                return 0;
+        }
+    }
+
+    std::chrono::microseconds InterFrameDelay(unsigned int baud) noexcept
+    {
+        // 11 bits per character: start, 8 data bits, parity or a second stop bit and the stop bit
+        auto delay = std::chrono::microseconds { baud == 0 ? 0 : 38'500'000 / baud };
+        return std::max(delay, std::chrono::microseconds { 1750 });
+    }
+
+    RtuFramer::RtuFramer(ModbusFrameKind kind, std::chrono::microseconds interFrameDelay, std::function<void(std::vector<uint8_t>)> listener)
+            : m_kind { kind }, m_interFrameDelay { interFrameDelay }, m_listener { std::move(listener) }
+    {
+        m_buffer.reserve(c_maxFrameSize);
+    }
+
+    void RtuFramer::Feed(const uint8_t *data, size_t size, std::chrono::steady_clock::time_point now)
+    {
+        if (!m_buffer.empty() && m_interFrameDelay.count() != 0 && now - m_lastByte >= m_interFrameDelay) {
+            // The silent interval ended the previous frame, whatever is left of it is incomplete
+            m_dropped++;
+            m_buffer.clear();
+        }
+
+        m_lastByte = now;
+        m_buffer.insert(m_buffer.end(), data, data + size);
+
+        while (!m_buffer.empty()) {
+            auto expected = ExpectedFrameLength(m_buffer.data(), m_buffer.size(), m_kind);
+            if (!expected) {
+                return;
+            }
+
+            if (*expected == 0) {
+                // Unknown function, the frame is complete once its CRC matches
+                if (CheckCrc(m_buffer.data(), m_buffer.size())) {
+                    m_listener(std::move(m_buffer));
+                    m_buffer = {};
+                    m_buffer.reserve(c_maxFrameSize);
+                } else if (m_buffer.size() >= c_maxFrameSize) {
+                    m_dropped++;
+                    m_buffer.clear();
+                }
+                return;
+            }
+
+            if (*expected > c_maxFrameSize) {
+                m_dropped++;
+                m_buffer.clear();
+                return;
+            }
+
+            if (m_buffer.size() < *expected) {
+                return;
+            }
+
+            if (CheckCrc(m_buffer.data(), *expected)) {
+                m_listener(std::vector<uint8_t> { m_buffer.begin(), m_buffer.begin() + static_cast<ptrdiff_t>(*expected) });
+            } else {
+                m_dropped++;
+            }
+
+            m_buffer.erase(m_buffer.begin(), m_buffer.begin() + static_cast<ptrdiff_t>(*expected));
+        }
+    }
+
+    void RtuFramer::Reset() noexcept
+    {
+        m_buffer.clear();
+    }
+
+    uint64_t RtuFramer::GetDroppedFrames() const noexcept
+    {
+        return m_dropped;
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // ModbusGateway implementation                         //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    ModbusGateway::ModbusGateway(ModbusGatewayOptions options)
+            : m_options { std::move(options) }
+    {
+    }
+
+    ModbusGateway::~ModbusGateway()
+    {
+        Stop();
+    }
+
+    void ModbusGateway::AddLink(IBluetoothGattCharacteristic &characteristic, std::vector<uint8_t> unitIds)
+    {
+        auto link = std::make_unique<Link>();
+        link->characteristic = &characteristic;
+        link->writeMode = HasProperty(characteristic.GetProperties(), GattCharacteristicProperty::WriteWithoutResponse) ? GattWriteMode::WithoutResponse : GattWriteMode::WithResponse;
+
+        // Notifications may split a response anywhere, so responses are framed by their length rather than by timing
+        link->framer.emplace(ModbusFrameKind::Response, std::chrono::microseconds { 0 }, [this, link = link.get()](std::vector<uint8_t> frame) {
+            link->response = std::move(frame);
+            m_condition.notify_all();
+        });
+
+        for (auto unitId : unitIds) {
+            m_routes[unitId] = link.get();
+        }
+
+        if (unitIds.empty()) {
+            m_defaultLink = link.get();
+        }
+
+        m_links.push_back(std::move(link));
+    }
+
+    void ModbusGateway::Start()
+    {
+        if (m_running) {
+            return;
+        }
+
+        {
+            std::unique_lock<std::mutex> lock { m_mutex };
+            m_exiting = false;
+            m_running = true;
+        }
+
+        for (auto &link : m_links) {
+            link->subscription = link->characteristic->Subscribe([this, link = link.get()](std::vector<uint8_t> data) {
+                std::unique_lock<std::mutex> lock { m_mutex };
+                link->framer->Feed(data.data(), data.size(), std::chrono::steady_clock::now());
+            });
+
+            link->thread = std::thread([this, link = link.get()]() { Serve(*link); });
+        }
+    }
+
+    void ModbusGateway::Stop()
+    {
+        {
+            std::unique_lock<std::mutex> lock { m_mutex };
+            if (!m_running) {
+                return;
+            }
+
+            m_running = false;
+            m_exiting = true;
+            m_condition.notify_all();
+        }
+
+        for (auto &link : m_links) {
+            link->thread.join();
+            link->characteristic->Unsubscribe(link->subscription);
+        }
+    }
+
+    void ModbusGateway::Submit(uint8_t unitId, std::vector<uint8_t> pdu, Completion completion)
+    {
+        m_requests.fetch_add(1, std::memory_order_relaxed);
+
+        if (pdu.empty() || pdu.size() > c_maxPduSize) {
+            m_rejected.fetch_add(1, std::memory_order_relaxed);
+            completion(ExceptionResponse(pdu, ModbusException::IllegalFunction));
+            return;
+        }
+
+        if (unitId == 0) {
+            Broadcast(std::move(pdu), std::move(completion));
+            return;
+        }
+
+        Link *link = m_routes[unitId] != nullptr ? m_routes[unitId] : m_defaultLink;
+
+        {
+            std::unique_lock<std::mutex> lock { m_mutex };
+
+            if (m_running && link != nullptr && link->queue.size() < m_options.maxPending) {
+                link->queue.push_back(Request { .unitId = unitId, .pdu = std::move(pdu), .completion = std::move(completion), .submitted = std::chrono::steady_clock::now() });
+                m_condition.notify_all();
+                return;
+            }
+        }
+
+        m_rejected.fetch_add(1, std::memory_order_relaxed);
+        Log::Write(Log::Severity::Warning, "Modbus request rejected", { { "unit", unitId }, { "routed", link != nullptr } }, m_options.logContext);
+        completion(ExceptionResponse(pdu, ModbusException::GatewayPathUnavailable));
+    }
+
+    void ModbusGateway::Broadcast(std::vector<uint8_t> pdu, Completion completion)
+    {
+        struct Fanout
+        {
+            std::mutex mutex {};
+            size_t remaining = 0;
+            std::vector<uint8_t> failure {};
+            Completion completion;
+        };
+
+        // Every link writes its own copy, the master hears back once, after the last of them
+        auto fanout = std::make_shared<Fanout>();
+        fanout->completion = std::move(completion);
+
+        auto linkCompletion = [fanout](std::vector<uint8_t> result) {
+            {
+                std::unique_lock<std::mutex> lock { fanout->mutex };
+                if (!result.empty() && fanout->failure.empty()) {
+                    fanout->failure = std::move(result);
+                }
+
+                if (--fanout->remaining != 0) {
+                    return;
+                }
+            }
+
+            fanout->completion(std::move(fanout->failure));
+        };
+
+        bool accepted = false;
+        size_t full = 0;
+
+        {
+            std::unique_lock<std::mutex> lock { m_mutex };
+
+            if (m_running && !m_links.empty()) {
+                accepted = true;
+                fanout->remaining = m_links.size();
+
+                auto submitted = std::chrono::steady_clock::now();
+                for (auto &link : m_links) {
+                    if (link->queue.size() < m_options.maxPending) {
+                        link->queue.push_back(Request { .unitId = 0, .pdu = pdu, .completion = linkCompletion, .submitted = submitted });
+                    } else {
+                        full++;
+                    }
+                }
+
+                m_condition.notify_all();
+            }
+        }
+
+        if (!accepted) {
+            m_rejected.fetch_add(1, std::memory_order_relaxed);
+            Log::Write(Log::Severity::Warning, "Modbus request rejected", { { "unit", 0 }, { "routed", false } }, m_options.logContext);
+            fanout->completion(ExceptionResponse(pdu, ModbusException::GatewayPathUnavailable));
+            return;
+        }
+
+        if (full != 0) {
+            m_rejected.fetch_add(1, std::memory_order_relaxed);
+            Log::Write(Log::Severity::Warning, "Modbus broadcast skipped full links", { { "links", full } }, m_options.logContext);
+        }
+
+        for (size_t i = 0; i < full; i++) {
+            linkCompletion(ExceptionResponse(pdu, ModbusException::GatewayPathUnavailable));
+        }
+    }
+
+    ModbusGatewayMetrics ModbusGateway::Metrics() const noexcept
+    {
+        uint64_t droppedFrames = 0;
+
+        {
+            std::unique_lock<std::mutex> lock { m_mutex };
+            for (auto &link : m_links) {
+                droppedFrames += link->framer->GetDroppedFrames();
+            }
+        }
+
+        uint64_t responses = m_responses.load(std::memory_order_relaxed);
+
+        return ModbusGatewayMetrics {
+                .requests = m_requests.load(std::memory_order_relaxed),
+                .responses = responses,
+                .exceptions = m_exceptions.load(std::memory_order_relaxed),
+                .timeouts = m_timeouts.load(std::memory_order_relaxed),
+                .rejected = m_rejected.load(std::memory_order_relaxed),
+                .droppedFrames = droppedFrames,
+                .averageLatency = std::chrono::microseconds { responses == 0 ? 0 : m_totalLatency.load(std::memory_order_relaxed) / responses }
+        };
+    }
+
+    void ModbusGateway::Serve(Link &link)
+    {
+        std::unique_lock<std::mutex> lock { m_mutex };
+
+        for (;;) {
+            m_condition.wait(lock, [this, &link]() { return m_exiting || !link.queue.empty(); });
+
+            if (m_exiting) {
+                break;
+            }
+
+            auto request = std::move(link.queue.front());
+            link.queue.pop_front();
+
+            std::vector<uint8_t> frame;
+            frame.reserve(1 + request.pdu.size() + 2);
+            frame.push_back(request.unitId);
+            frame.insert(frame.end(), request.pdu.begin(), request.pdu.end());
+            AppendCrc(frame);
+
+            std::optional<std::vector<uint8_t>> response;
+
+            for (unsigned int attempt = 0; attempt <= m_options.retries && !response && !m_exiting; attempt++) {
+                link.framer->Reset();
+                link.response.reset();
+                lock.unlock();
+
+                bool written = false;
+                try {
+                    BLE_SERIAL_TIMED_SCOPE("modbus.request");
+                    link.characteristic->Write(frame, link.writeMode);
+                    written = true;
+                } catch (const BluetoothException &e) {
+                    Log::Write(Log::Severity::Warning, "Modbus request write failed", { { "unit", request.unitId }, { "attempt", attempt }, { "error", e.what() } },
+                               m_options.logContext);
+                }
+
+                lock.lock();
+
+                if (written && request.unitId == 0) {
+                    // Broadcasts are never answered
+                    response.emplace();
+                    break;
+                }
+
+                auto deadline = std::chrono::steady_clock::now() + m_options.responseTimeout;
+
+                while (written && !response) {
+                    if (!m_condition.wait_until(lock, deadline, [this, &link]() { return m_exiting || link.response.has_value(); }) || m_exiting) {
+                        break;
+                    }
+
+                    // A late answer to a request that already timed out is not the answer to this one
+                    auto &candidate = *link.response;
+                    if (candidate[0] == request.unitId && (candidate[1] & 0x7F) == request.pdu[0]) {
+                        response.emplace(candidate.begin() + 1, candidate.end() - 2);
+                    }
+
+                    link.response.reset();
+                }
+
+                if (!response) {
+                    m_timeouts.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+
+            lock.unlock();
+
+            if (response) {
+                if (!response->empty()) {
+                    m_responses.fetch_add(1, std::memory_order_relaxed);
+                    if (((*response)[0] & 0x80) != 0) {
+                        m_exceptions.fetch_add(1, std::memory_order_relaxed);
+                    }
+                }
+
+                Complete(request, std::move(*response));
+            } else {
+                Log::Write(Log::Severity::Warning, "Modbus device did not respond", { { "unit", request.unitId }, { "function", request.pdu[0] } }, m_options.logContext);
+                Complete(request, ExceptionResponse(request.pdu, ModbusException::GatewayTargetFailedToRespond));
+            }
+
+            lock.lock();
+        }
+
+        // Nobody is going to serve the rest, the masters get an answer right away instead of waiting for their timeout
+        auto queue = std::move(link.queue);
+        link.queue.clear();
+        lock.unlock();
+
+        for (auto &request : queue) {
+            Complete(request, ExceptionResponse(request.pdu, ModbusException::GatewayPathUnavailable));
+        }
+    }
+
+    void ModbusGateway::Complete(Request &request, std::vector<uint8_t> pdu)
+    {
+        if (!pdu.empty()) {
+            auto latency = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - request.submitted);
+            m_totalLatency.fetch_add(static_cast<uint64_t>(latency.count()), std::memory_order_relaxed);
+        }
+
+        request.completion(std::move(pdu));
+    }
+
+    std::vector<uint8_t> ModbusGateway::ExceptionResponse(const std::vector<uint8_t> &pdu, ModbusException code)
+    {
+        uint8_t function = pdu.empty() ? 0 : pdu[0];
+        return { static_cast<uint8_t>(function | 0x80), static_cast<uint8_t>(code) };
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // ModbusRtuServer implementation                       //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    ModbusRtuServer::ModbusRtuServer(ModbusGateway &gateway, COMPort &port, unsigned int baud)
+            : m_gateway { gateway }, m_port { port }, m_framer { ModbusFrameKind::Request, InterFrameDelay(baud) + c_portReadLatency, [this](std::vector<uint8_t> frame) {
+                  uint8_t unitId = frame[0];
+
+                  m_gateway.Submit(unitId, std::vector<uint8_t> { frame.begin() + 1, frame.end() - 2 }, [this, unitId](std::vector<uint8_t> pdu) {
+                      if (pdu.empty()) {
+                          return;
+                      }
+
+                      std::vector<uint8_t> response;
+                      response.reserve(1 + pdu.size() + 2);
+                      response.push_back(unitId);
+                      response.insert(response.end(), pdu.begin(), pdu.end());
+                      AppendCrc(response);
+
+                      try {
+                          m_port.Write(response);
+                      } catch (const COMException &e) {
+                          Log::Write(Log::Severity::Warning, "Modbus response write failed", { { "unit", unitId }, { "error", e.what() } });
+                      }
+                  });
+              } }
+    {
+    }
+
+    ModbusRtuServer::~ModbusRtuServer()
+    {
+        Stop();
+    }
+
+    void ModbusRtuServer::Start()
+    {
+        if (m_running) {
+            return;
+        }
+
+        m_running = true;
+        m_previousRefreshRate = m_port.GetRefreshRate();
+        m_port.SetRefreshRate(c_portRefreshRate);
+
+        m_subscription = m_port.Subscribe([this](const std::vector<uint8_t> &data) {
+            std::unique_lock<std::mutex> lock { m_mutex };
+            m_framer.Feed(data.data(), data.size(), std::chrono::steady_clock::now());
+        });
+    }
+
+    void ModbusRtuServer::Stop()
+    {
+        if (!m_running) {
+            return;
+        }
+
+        m_running = false;
+        m_port.Unsubscribe(m_subscription);
+        m_port.SetRefreshRate(m_previousRefreshRate);
+    }
+
+    uint64_t ModbusRtuServer::GetDroppedFrames() const noexcept
+    {
+        std::unique_lock<std::mutex> lock { m_mutex };
+        return m_framer.GetDroppedFrames();
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // ModbusTcpServer implementation                       //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    ModbusTcpServer::ModbusTcpServer(ModbusGateway &gateway, uint16_t port, const std::string &bindAddress)
+            : m_gateway { gateway }, m_listener { port, bindAddress }
+    {
+    }
+
+    ModbusTcpServer::~ModbusTcpServer()
+    {
+        Stop();
+    }
+
+    void ModbusTcpServer::Start()
+    {
+        if (m_running.exchange(true)) {
+            return;
+        }
+
+        m_acceptThread = std::thread([this]() { AcceptClients(); });
+    }
+
+    void ModbusTcpServer::Stop()
+    {
+        if (!m_running.exchange(false)) {
+            return;
+        }
+
+        m_listener.Close();
+        m_acceptThread.join();
+
+        std::unique_lock<std::mutex> lock { m_mutex };
+        for (auto &client : m_clients) {
+            client->stream->Close();
+            client->thread.join();
+        }
+
+        m_clients.clear();
+    }
+
+    uint16_t ModbusTcpServer::GetPort() const noexcept
+    {
+        return m_listener.GetPort();
+    }
+
+    size_t ModbusTcpServer::GetClientCount() const noexcept
+    {
+        std::unique_lock<std::mutex> lock { m_mutex };
+        return static_cast<size_t>(std::count_if(m_clients.begin(), m_clients.end(), [](const auto &client) { return !client->finished.load(); }));
+    }
+
+    void ModbusTcpServer::AcceptClients()
+    {
+        while (m_running.load()) {
+            auto stream = m_listener.Accept(c_acceptInterval);
+
+            std::unique_lock<std::mutex> lock { m_mutex };
+
+            // Reap the clients that disconnected since the last round
+            for (auto it = m_clients.begin(); it != m_clients.end();) {
+                if ((*it)->finished.load()) {
+                    (*it)->thread.join();
+                    it = m_clients.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+
+            if (stream) {
+                Log::Write(Log::Severity::Info, "Modbus TCP client connected", { { "peer", stream->GetPeerName() } });
+
+                auto client = std::make_unique<Client>();
+                client->stream = std::move(stream);
+                client->thread = std::thread([this, client = client.get()]() { ServeClient(*client); });
+                m_clients.push_back(std::move(client));
+            }
+        }
+    }
+
+    void ModbusTcpServer::ServeClient(Client &client)
+    {
+        auto stream = client.stream;
+        std::vector<uint8_t> buffer;
+        uint8_t chunk[512];
+
+        while (m_running.load() && stream->IsOpen()) {
+            size_t received = stream->Receive(chunk, sizeof(chunk), c_receiveInterval);
+            buffer.insert(buffer.end(), chunk, chunk + received);
+
+            // Every complete ADU is submitted right away, without waiting for the responses to the previous ones
+            while (buffer.size() >= c_mbapHeaderSize) {
+                uint16_t transactionId = ReadBigEndian(buffer.data());
+                uint16_t protocolId = ReadBigEndian(buffer.data() + 2);
+                uint16_t length = ReadBigEndian(buffer.data() + 4);
+
+                if (protocolId != 0 || length < 2 || length > c_maxPduSize + 1) {
+                    Log::Write(Log::Severity::Warning, "Invalid Modbus TCP header, disconnecting", { { "peer", stream->GetPeerName() } });
+                    stream->Close();
+                    break;
+                }
+
+                if (buffer.size() < 6 + static_cast<size_t>(length)) {
+                    break;
+                }
+
+                uint8_t unitId = buffer[6];
+                std::vector<uint8_t> pdu { buffer.begin() + c_mbapHeaderSize, buffer.begin() + 6 + length };
+                buffer.erase(buffer.begin(), buffer.begin() + 6 + length);
+
+                m_gateway.Submit(unitId, std::move(pdu), [stream, transactionId, unitId](std::vector<uint8_t> response) {
+                    if (response.empty()) {
+                        return;
+                    }
+
+                    auto length = static_cast<uint16_t>(response.size() + 1);
+                    std::vector<uint8_t> adu {
+                            static_cast<uint8_t>(transactionId >> 8), static_cast<uint8_t>(transactionId), 0, 0,
+                            static_cast<uint8_t>(length >> 8), static_cast<uint8_t>(length), unitId
+                    };
+                    adu.insert(adu.end(), response.begin(), response.end());
+
+                    try {
+                        stream->Send(adu);
+                    } catch (const IOException &) {
+                        // The client is gone, so is its interest in the response
+                    }
+                });
+            }
+        }
+
+        Log::Write(Log::Severity::Info, "Modbus TCP client disconnected", { { "peer", stream->GetPeerName() } });
+        client.finished.store(true);
+    }
+}
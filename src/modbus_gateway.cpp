@@ -0,0 +1,104 @@
+#include "modbus_gateway.hpp"
+
+#include <iostream>
+#include <memory>
+#include <thread>
+
+using namespace BLE_Serial::Bluetooth;
+using namespace BLE_Serial::COM;
+using namespace BLE_Serial::Modbus;
+
+int Modbus(const ModbusSettings &settings, const std::atomic_bool &stop)
+{
+    if (!settings.tcpPort && !settings.portNumber) {
+        throw std::invalid_argument("Either a TCP port or a COM port has to be served");
+    }
+
+    if (settings.unitIds.size() > settings.addresses.size()) {
+        throw std::invalid_argument("More unit id groups than devices");
+    }
+
+    if (settings.addresses.size() - settings.unitIds.size() > 1) {
+        throw std::invalid_argument("Only a single device may serve the unit ids no other device serves");
+    }
+
+    std::vector<std::shared_ptr<IBluetoothConnection>> connections;
+    ModbusGateway gateway { settings.options };
+
+    for (size_t i = 0; i < settings.addresses.size(); i++) {
+        auto address = settings.addresses[i];
+        std::cout << "Connecting to " << BluetoothAddressToString(address) << " ..." << std::endl;
+
+        auto deviceOptional = IBluetoothService::GetService().FindDevice(address, settings.timeout);
+        if (!deviceOptional) {
+            throw BluetoothException("Device with address " + BluetoothAddressToString(address) + " couldn't be found");
+        }
+
+        auto connection = deviceOptional.value()->OpenConnection(settings.timeout);
+        connections.push_back(connection);
+
+        auto service = connection->GetService(GetServiceUUID(settings.serviceId));
+        if (!service) {
+            throw BluetoothException("Requested service couldn't be found");
+        }
+
+        service->FetchCharacteristics();
+
+        auto &characteristic = service->GetCharacteristic(GetCharacteristicUUID(settings.characteristicId));
+        if (!characteristic) {
+            throw BluetoothException("Requested characteristic couldn't be found");
+        }
+
+        gateway.AddLink(*characteristic, i < settings.unitIds.size() ? settings.unitIds[i] : std::vector<uint8_t> {});
+    }
+
+    gateway.Start();
+
+    std::unique_ptr<ModbusTcpServer> tcpServer;
+    if (settings.tcpPort) {
+        tcpServer = std::make_unique<ModbusTcpServer>(gateway, *settings.tcpPort);
+        tcpServer->Start();
+        std::cout << "Serving Modbus TCP on port " << tcpServer->GetPort() << std::endl;
+    }
+
+    std::unique_ptr<COMPort> port;
+    std::unique_ptr<ModbusRtuServer> rtuServer;
+    if (settings.portNumber) {
+        port = std::make_unique<COMPort>(*settings.portNumber, settings.baud, 8, STOP_BITS_ONE, settings.parity);
+        rtuServer = std::make_unique<ModbusRtuServer>(gateway, *port, settings.baud);
+        rtuServer->Start();
+        std::cout << "Serving Modbus RTU on COM" << *settings.portNumber << std::endl;
+    }
+
+    std::cout << "Gateway to " << settings.addresses.size() << " devices running, press Ctrl+C to stop" << std::endl;
+
+    while (!stop.load()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+
+    if (tcpServer) {
+        tcpServer->Stop();
+    }
+
+    if (rtuServer) {
+        rtuServer->Stop();
+        port->Close();
+    }
+
+    gateway.Stop();
+
+    auto metrics = gateway.Metrics();
+    std::cout << "Handled " << metrics.requests << " requests: " << metrics.responses << " responses (" << metrics.exceptions << " exceptions), "
+              << metrics.timeouts << " timeouts, " << metrics.rejected << " rejected, " << metrics.droppedFrames << " corrupted responses, average latency "
+              << metrics.averageLatency.count() << " us" << std::endl;
+
+    for (auto &connection : connections) {
+        try {
+            connection->Close();
+        } catch (const BluetoothException &ignored) {
+            // The link may be already dead
+        }
+    }
+
+    return 0;
+}
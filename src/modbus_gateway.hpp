@@ -0,0 +1,40 @@
+#ifndef BLE_SERIAL_SRC_MODBUS_GATEWAY_HPP_
+#define BLE_SERIAL_SRC_MODBUS_GATEWAY_HPP_
+
+#include <ble_serial/modbus.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <vector>
+
+/**
+ * @brief Settings of the modbus command, every device becomes a link of the gateway.
+ */
+struct ModbusSettings
+{
+    std::vector<BLE_Serial::Bluetooth::BluetoothAddress> addresses;
+    BLE_Serial::Bluetooth::GattRegisteredService serviceId;
+    BLE_Serial::Bluetooth::GattRegisteredCharacteristic characteristicId;
+    std::optional<uint16_t> tcpPort { 502 };          ///< Modbus TCP port, empty when no TCP clients are served
+    std::optional<unsigned int> portNumber {};        ///< COM port of an RTU master, empty when none is served
+    std::chrono::seconds timeout { 5 };
+    unsigned int baud = 9600;
+    BLE_Serial::COM::Parity parity = BLE_Serial::COM::PARITY_BITS_EVEN;
+    std::vector<std::vector<uint8_t>> unitIds {};     ///< unit ids of every device, in the order of the addresses
+    BLE_Serial::Modbus::ModbusGatewayOptions options {};
+};
+
+/**
+ * @brief Runs a Modbus gateway to the devices until interrupted.
+ *
+ * @param settings settings of the command
+ * @param stop flag that ends the command when set
+ *
+ * @return exit code of the application
+ *
+ * @throw std::invalid_argument when neither a TCP port nor a COM port is given or several devices lack unit ids
+ */
+int Modbus(const ModbusSettings &settings, const std::atomic_bool &stop);
+
+#endif // BLE_SERIAL_SRC_MODBUS_GATEWAY_HPP_
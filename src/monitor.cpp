@@ -0,0 +1,32 @@
+#include "monitor.hpp"
+#include "endpoint.hpp"
+
+#include <iostream>
+#include <thread>
+
+using namespace BLE_Serial::Bluetooth;
+using namespace BLE_Serial::Bridge;
+
+int Monitor(const MonitorSettings &settings, const std::atomic_bool &stop)
+{
+    auto endpoint = OpenEndpoint(settings.address, settings.serviceId, settings.characteristicId, settings.timeout);
+
+    TrafficMonitor monitor { settings.options, std::cout };
+    monitor.Start();
+
+    auto id = endpoint.characteristic->Subscribe([&monitor](std::vector<uint8_t> data) {
+        monitor.Record(TrafficDirection::Received, data.data(), data.size());
+    });
+
+    std::cout << "Monitoring, press Ctrl+C to stop" << std::endl;
+
+    while (!stop.load()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+
+    endpoint.characteristic->Unsubscribe(id);
+    monitor.Stop();
+    endpoint.connection->Close();
+
+    return 0;
+}
@@ -0,0 +1,32 @@
+#ifndef BLE_SERIAL_SRC_MONITOR_HPP_
+#define BLE_SERIAL_SRC_MONITOR_HPP_
+
+#include <ble_serial/bluetooth.hpp>
+#include <ble_serial/traffic_monitor.hpp>
+
+#include <atomic>
+#include <chrono>
+
+/**
+ * @brief Settings of the monitor command.
+ */
+struct MonitorSettings
+{
+    BLE_Serial::Bluetooth::BluetoothAddress address;
+    BLE_Serial::Bluetooth::GattRegisteredService serviceId;
+    BLE_Serial::Bluetooth::GattRegisteredCharacteristic characteristicId;
+    std::chrono::seconds timeout { 5 };
+    BLE_Serial::Bridge::TrafficMonitorOptions options {};
+};
+
+/**
+ * @brief Shows a live view of the notifications of a characteristic until interrupted.
+ *
+ * @param settings settings of the monitor
+ * @param stop flag that ends the monitor when set
+ *
+ * @return exit code of the application
+ */
+int Monitor(const MonitorSettings &settings, const std::atomic_bool &stop);
+
+#endif // BLE_SERIAL_SRC_MONITOR_HPP_
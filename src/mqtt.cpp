@@ -0,0 +1,524 @@
+#include <ble_serial/mqtt.hpp>
+#include <ble_serial/instrumentation.hpp>
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+namespace BLE_Serial::Mqtt
+{
+    using namespace BLE_Serial::Bluetooth;
+    using namespace BLE_Serial::IO;
+
+    namespace
+    {
+        constexpr uint8_t c_connect = 0x10;
+        constexpr uint8_t c_connack = 0x20;
+        constexpr uint8_t c_publish = 0x30;
+        constexpr uint8_t c_puback = 0x40;
+        constexpr uint8_t c_pingreq = 0xC0;
+        constexpr uint8_t c_disconnect = 0xE0;
+        constexpr uint8_t c_duplicateFlag = 0x08;
+
+        constexpr std::chrono::milliseconds c_receiveInterval { 200 };
+
+        /**
+         * How long @link MqttPublisher::Stop @endlink keeps sending and waiting for acknowledgements
+         */
+        constexpr std::chrono::milliseconds c_drainTimeout { 2000 };
+
+        void AppendRemainingLength(std::vector<uint8_t> &packet, size_t length)
+        {
+            do {
+                auto byte = static_cast<uint8_t>(length & 0x7F);
+                length >>= 7;
+                packet.push_back(length != 0 ? static_cast<uint8_t>(byte | 0x80) : byte);
+            } while (length != 0);
+        }
+
+        void AppendUInt16(std::vector<uint8_t> &packet, uint16_t value)
+        {
+            packet.push_back(static_cast<uint8_t>(value >> 8));
+            packet.push_back(static_cast<uint8_t>(value));
+        }
+
+        void AppendString(std::vector<uint8_t> &packet, const std::string &value)
+        {
+            AppendUInt16(packet, static_cast<uint16_t>(value.size()));
+            packet.insert(packet.end(), value.begin(), value.end());
+        }
+
+        void AppendPublish(std::vector<uint8_t> &packet, const std::string &topic, const std::vector<uint8_t> &payload, MqttQoS qos, uint16_t packetId)
+        {
+            size_t length = 2 + topic.size() + (qos == MqttQoS::AtMostOnce ? 0 : 2) + payload.size();
+
+            packet.push_back(static_cast<uint8_t>(c_publish | (static_cast<uint8_t>(qos) << 1)));
+            AppendRemainingLength(packet, length);
+            AppendString(packet, topic);
+
+            if (qos != MqttQoS::AtMostOnce) {
+                AppendUInt16(packet, packetId);
+            }
+
+            packet.insert(packet.end(), payload.begin(), payload.end());
+        }
+
+        /**
+         * Decodes the fixed header of a packet
+         *
+         * @return size of the fixed header and of the rest of the packet, an empty optional when more bytes are needed
+         */
+        std::optional<std::pair<size_t, size_t>> DecodeFixedHeader(const std::vector<uint8_t> &buffer)
+        {
+            size_t length = 0;
+
+            for (size_t i = 1; i < buffer.size() && i <= 4; i++) {
+                length |= static_cast<size_t>(buffer[i] & 0x7F) << (7 * (i - 1));
+                if ((buffer[i] & 0x80) == 0) {
+                    return std::make_pair(i + 1, length);
+                }
+            }
+
+            if (buffer.size() > 4) {
+                throw IOException("Malformed MQTT packet length");
+            }
+
+            return std::nullopt;
+        }
+
+        std::string ConnectReturnCodeToString(uint8_t code)
+        {
+            switch (code) {
+                case 1:
+                    return "unacceptable protocol version";
+                case 2:
+                    return "identifier rejected";
+                case 3:
+                    return "server unavailable";
+                case 4:
+                    return "bad user name or password";
+                case 5:
+                    return "not authorized";
+                default:
+                    return "return code " + std::to_string(code);
+            }
+        }
+    }
+
+    std::string FormatTopic(const std::string &pattern, BluetoothAddress address, GattRegisteredService serviceId, GattRegisteredCharacteristic characteristicId)
+    {
+        auto hex = [](uint32_t id) {
+            std::ostringstream stream;
+            stream << std::uppercase << std::hex << std::setw(4) << std::setfill('0') << id;
+            return stream.str();
+        };
+
+        std::string topic;
+        topic.reserve(pattern.size() + 32);
+
+        for (size_t i = 0; i < pattern.size(); i++) {
+            if (pattern[i] != '{') {
+                topic.push_back(pattern[i]);
+                continue;
+            }
+
+            auto end = pattern.find('}', i);
+            if (end == std::string::npos) {
+                throw std::invalid_argument("Unterminated placeholder in topic: " + pattern);
+            }
+
+            auto name = pattern.substr(i + 1, end - i - 1);
+            if (name == "address") {
+                topic += BluetoothAddressToString(address);
+            } else if (name == "service") {
+                topic += hex(static_cast<uint32_t>(serviceId));
+            } else if (name == "characteristic") {
+                topic += hex(static_cast<uint32_t>(characteristicId));
+            } else {
+                throw std::invalid_argument("Unknown placeholder in topic: {" + name + "}");
+            }
+
+            i = end;
+        }
+
+        if (topic.empty() || topic.size() > 0xFFFF || topic.find_first_of("+#") != std::string::npos) {
+            throw std::invalid_argument("Invalid topic: " + topic);
+        }
+
+        return topic;
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // MqttPublisher implementation                         //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    MqttPublisher::MqttPublisher(MqttOptions options)
+            : m_options { std::move(options) }
+    {
+        m_options.inFlightWindow = std::max<size_t>(m_options.inFlightWindow, 1);
+        m_options.queueLimit = std::max<size_t>(m_options.queueLimit, 1);
+    }
+
+    MqttPublisher::~MqttPublisher()
+    {
+        Stop();
+    }
+
+    void MqttPublisher::Start()
+    {
+        if (m_running) {
+            return;
+        }
+
+        auto stream = Connect();
+
+        std::unique_lock<std::mutex> lock { m_mutex };
+        m_stream = std::move(stream);
+        m_generation++;
+        m_exiting = false;
+        m_readerExiting = false;
+        m_running = true;
+
+        m_writerThread = std::thread([this]() { WriteMessages(); });
+        m_readerThread = std::thread([this]() { ReadAcknowledgements(); });
+    }
+
+    void MqttPublisher::Stop()
+    {
+        {
+            std::unique_lock<std::mutex> lock { m_mutex };
+            if (!m_running) {
+                return;
+            }
+
+            m_running = false;
+            m_exiting = true;
+            m_drainDeadline = std::chrono::steady_clock::now() + c_drainTimeout;
+            m_condition.notify_all();
+        }
+
+        m_writerThread.join();
+
+        {
+            std::unique_lock<std::mutex> lock { m_mutex };
+            m_readerExiting = true;
+            if (m_stream) {
+                m_stream->Close();
+            }
+            m_condition.notify_all();
+        }
+
+        m_readerThread.join();
+
+        std::unique_lock<std::mutex> lock { m_mutex };
+        m_stream.reset();
+    }
+
+    bool MqttPublisher::Publish(std::string topic, std::vector<uint8_t> payload)
+    {
+        BLE_SERIAL_TIMED_SCOPE("mqtt.publish");
+
+        std::unique_lock<std::mutex> lock { m_mutex };
+
+        // A full queue holds the producer back, that is how a slow broker reaches the notifications
+        bool room = m_condition.wait_for(lock, m_options.publishTimeout, [this]() { return !m_running || m_queue.size() < m_options.queueLimit; });
+
+        if (!room || !m_running) {
+            m_dropped++;
+            return false;
+        }
+
+        m_queue.push_back(Message { .topic = std::move(topic), .payload = std::move(payload) });
+        m_condition.notify_all();
+        return true;
+    }
+
+    MqttMetrics MqttPublisher::Metrics() const noexcept
+    {
+        std::unique_lock<std::mutex> lock { m_mutex };
+
+        return MqttMetrics {
+                .published = m_published,
+                .acknowledged = m_acknowledged,
+                .retransmitted = m_retransmitted,
+                .dropped = m_dropped,
+                .flushes = m_flushes,
+                .bytesSent = m_bytesSent,
+                .reconnects = m_reconnects,
+                .queued = m_queue.size(),
+                .inFlight = m_inFlight.size(),
+                .connected = m_stream != nullptr
+        };
+    }
+
+    std::shared_ptr<TcpStream> MqttPublisher::Connect()
+    {
+        std::shared_ptr<TcpStream> stream = TcpStream::Connect(m_options.host, m_options.port, m_options.connectTimeout);
+
+        uint8_t flags = 0x02; // clean session, unacknowledged messages are sent again by the client anyway
+        if (m_options.username) {
+            flags |= 0x80;
+        }
+        if (m_options.password) {
+            flags |= 0x40;
+        }
+
+        std::vector<uint8_t> body;
+        AppendString(body, "MQTT");
+        body.push_back(4);
+        body.push_back(flags);
+        AppendUInt16(body, static_cast<uint16_t>(m_options.keepAlive.count()));
+        AppendString(body, m_options.clientId);
+        if (m_options.username) {
+            AppendString(body, *m_options.username);
+        }
+        if (m_options.password) {
+            AppendString(body, *m_options.password);
+        }
+
+        std::vector<uint8_t> packet { c_connect };
+        AppendRemainingLength(packet, body.size());
+        packet.insert(packet.end(), body.begin(), body.end());
+        stream->Send(packet);
+
+        uint8_t connack[4];
+        size_t received = 0;
+        auto deadline = std::chrono::steady_clock::now() + m_options.connectTimeout;
+
+        while (received < sizeof(connack)) {
+            auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+            if (remaining.count() <= 0 || !stream->IsOpen()) {
+                throw IOException("MQTT broker " + stream->GetPeerName() + " did not accept the connection");
+            }
+
+            received += stream->Receive(connack + received, sizeof(connack) - received, remaining);
+        }
+
+        if (connack[0] != c_connack || connack[1] != 2) {
+            throw IOException("Unexpected response from MQTT broker " + stream->GetPeerName());
+        }
+
+        if (connack[3] != 0) {
+            throw IOException("MQTT broker refused the connection: " + ConnectReturnCodeToString(connack[3]));
+        }
+
+        return stream;
+    }
+
+    void MqttPublisher::WriteMessages()
+    {
+        auto keepAlive = m_options.keepAlive.count() == 0 ? std::chrono::steady_clock::duration::max() / 2 : std::chrono::steady_clock::duration { m_options.keepAlive } / 2;
+        auto lastSend = std::chrono::steady_clock::now();
+        std::vector<uint8_t> batch;
+        batch.reserve(m_options.batchBytes + 512);
+
+        auto canSend = [this]() {
+            return !m_queue.empty() && (m_options.qos == MqttQoS::AtMostOnce || m_inFlight.size() < m_options.inFlightWindow);
+        };
+
+        std::unique_lock<std::mutex> lock { m_mutex };
+
+        for (;;) {
+            batch.clear();
+            uint64_t published = 0;
+            uint64_t retransmitted = 0;
+
+            if (!m_stream) {
+                if (m_exiting) {
+                    break;
+                }
+
+                lock.unlock();
+
+                std::shared_ptr<TcpStream> stream;
+                try {
+                    stream = Connect();
+                } catch (const IOException &e) {
+                    Log::Write(Log::Severity::Warning, "MQTT reconnection failed", { { "error", e.what() } }, m_options.logContext);
+                }
+
+                lock.lock();
+
+                if (!stream) {
+                    m_condition.wait_for(lock, m_options.reconnectDelay, [this]() { return m_exiting; });
+                    continue;
+                }
+
+                m_stream = std::move(stream);
+                m_generation++;
+                m_reconnects++;
+                m_condition.notify_all();
+
+                Log::Write(Log::Severity::Info, "MQTT broker reconnected", { { "inFlight", m_inFlight.size() }, { "queued", m_queue.size() } }, m_options.logContext);
+
+                // The broker may or may not have received them, at least once means sending them again
+                for (auto &message : m_inFlight) {
+                    message.packet[0] |= c_duplicateFlag;
+                    batch.insert(batch.end(), message.packet.begin(), message.packet.end());
+                    retransmitted++;
+                }
+            } else {
+                auto pingDeadline = lastSend + keepAlive;
+                auto deadline = m_exiting ? std::min(pingDeadline, m_drainDeadline) : pingDeadline;
+
+                m_condition.wait_until(lock, deadline, [this, &canSend]() {
+                    return !m_stream || canSend() || (m_exiting && m_queue.empty() && m_inFlight.empty());
+                });
+
+                auto now = std::chrono::steady_clock::now();
+
+                if (m_exiting && ((m_queue.empty() && m_inFlight.empty()) || now >= m_drainDeadline)) {
+                    break;
+                }
+
+                if (!m_stream) {
+                    continue;
+                }
+
+                // Everything that is queued goes out with a single write
+                while (canSend() && batch.size() < m_options.batchBytes) {
+                    auto &message = m_queue.front();
+
+                    if (m_options.qos == MqttQoS::AtMostOnce) {
+                        AppendPublish(batch, message.topic, message.payload, m_options.qos, 0);
+                    } else {
+                        InFlightMessage inFlight { .packetId = NextPacketId(), .packet = {} };
+                        AppendPublish(inFlight.packet, message.topic, message.payload, m_options.qos, inFlight.packetId);
+                        batch.insert(batch.end(), inFlight.packet.begin(), inFlight.packet.end());
+                        m_inFlight.push_back(std::move(inFlight));
+                    }
+
+                    m_queue.pop_front();
+                    published++;
+                }
+
+                if (published != 0) {
+                    m_condition.notify_all();
+                } else if (now >= pingDeadline) {
+                    batch = { c_pingreq, 0 };
+                }
+            }
+
+            if (batch.empty()) {
+                continue;
+            }
+
+            auto stream = m_stream;
+            lock.unlock();
+
+            try {
+                BLE_SERIAL_TIMED_SCOPE("mqtt.flush");
+                stream->Send(batch);
+                lock.lock();
+
+                lastSend = std::chrono::steady_clock::now();
+                m_flushes++;
+                m_bytesSent += batch.size();
+                m_published += published;
+                m_retransmitted += retransmitted;
+            } catch (const IOException &e) {
+                lock.lock();
+                ConnectionLost(stream, e.what());
+            }
+        }
+
+        if (m_stream) {
+            auto stream = m_stream;
+            lock.unlock();
+
+            try {
+                stream->Send({ c_disconnect, 0 });
+            } catch (const IOException &) {
+                // Disconnecting anyway
+            }
+        }
+    }
+
+    void MqttPublisher::ReadAcknowledgements()
+    {
+        uint64_t generation = 0;
+        std::vector<uint8_t> buffer;
+        uint8_t chunk[256];
+
+        std::unique_lock<std::mutex> lock { m_mutex };
+
+        for (;;) {
+            m_condition.wait(lock, [this, &generation]() { return m_readerExiting.load() || (m_stream && m_generation != generation); });
+
+            if (m_readerExiting.load()) {
+                break;
+            }
+
+            auto stream = m_stream;
+            generation = m_generation;
+            buffer.clear();
+            lock.unlock();
+
+            std::string reason = "closed by the broker";
+
+            try {
+                while (!m_readerExiting.load() && stream->IsOpen()) {
+                    size_t received = stream->Receive(chunk, sizeof(chunk), c_receiveInterval);
+                    buffer.insert(buffer.end(), chunk, chunk + received);
+
+                    while (auto header = DecodeFixedHeader(buffer)) {
+                        auto [headerSize, length] = *header;
+                        if (buffer.size() < headerSize + length) {
+                            break;
+                        }
+
+                        if ((buffer[0] & 0xF0) == c_puback && length == 2) {
+                            auto packetId = static_cast<uint16_t>((buffer[headerSize] << 8) | buffer[headerSize + 1]);
+
+                            std::unique_lock<std::mutex> ackLock { m_mutex };
+                            auto it = std::find_if(m_inFlight.begin(), m_inFlight.end(), [packetId](const auto &message) { return message.packetId == packetId; });
+                            if (it != m_inFlight.end()) {
+                                m_inFlight.erase(it);
+                                m_acknowledged++;
+                                m_condition.notify_all();
+                            }
+                        }
+
+                        buffer.erase(buffer.begin(), buffer.begin() + static_cast<ptrdiff_t>(headerSize + length));
+                    }
+                }
+            } catch (const IOException &e) {
+                reason = e.what();
+            }
+
+            lock.lock();
+
+            if (!m_readerExiting.load()) {
+                ConnectionLost(stream, reason);
+            }
+        }
+    }
+
+    void MqttPublisher::ConnectionLost(const std::shared_ptr<TcpStream> &stream, const std::string &reason)
+    {
+        if (m_stream != stream) {
+            return;
+        }
+
+        stream->Close();
+        m_stream.reset();
+        m_condition.notify_all();
+
+        Log::Write(Log::Severity::Warning, "MQTT connection lost", { { "reason", reason }, { "inFlight", m_inFlight.size() }, { "queued", m_queue.size() } },
+                   m_options.logContext);
+    }
+
+    uint16_t MqttPublisher::NextPacketId()
+    {
+        for (;;) {
+            uint16_t packetId = m_nextPacketId++;
+
+            if (packetId != 0 && std::none_of(m_inFlight.begin(), m_inFlight.end(), [packetId](const auto &message) { return message.packetId == packetId; })) {
+                return packetId;
+            }
+        }
+    }
+}
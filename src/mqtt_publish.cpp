@@ -0,0 +1,259 @@
+#include "mqtt_publish.hpp"
+
+#include <ble_serial/spill_queue.hpp>
+
+#include <algorithm>
+#include <condition_variable>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+using namespace BLE_Serial::Bluetooth;
+using namespace BLE_Serial::Mqtt;
+
+namespace
+{
+    /**
+     * Queue between the notification callbacks and the publisher. The forwarder thread waits in
+     * MqttPublisher::Publish while the publisher's queue is full and the notifications pile up in the spill queue
+     * meanwhile, so a slow broker never holds up the thread that delivers the notifications.
+     *
+     * Every frame carries the index of its source in front of the payload.
+     */
+    class NotificationForwarder
+    {
+    public:
+        NotificationForwarder(MqttPublisher &publisher, std::vector<std::string> topics, BLE_Serial::Bridge::SpillQueueOptions options)
+                : m_publisher { publisher }, m_topics { std::move(topics) }, m_queue { std::move(options) }
+        {
+        }
+
+        ~NotificationForwarder()
+        {
+            Stop();
+        }
+
+        NotificationForwarder(const NotificationForwarder &) = delete;
+        NotificationForwarder &operator=(const NotificationForwarder &) = delete;
+
+        void Start()
+        {
+            m_exiting = false;
+            m_forwarderThread = std::thread([this]() { Forward(); });
+        }
+
+        /**
+         * Stops the forwarder thread, the notifications still queued are not published
+         */
+        void Stop()
+        {
+            if (!m_forwarderThread.joinable()) {
+                return;
+            }
+
+            {
+                std::unique_lock<std::mutex> lock { m_mutex };
+                m_exiting = true;
+                m_condition.notify_all();
+            }
+
+            m_forwarderThread.join();
+        }
+
+        void Offer(uint16_t source, const std::vector<uint8_t> &payload)
+        {
+            std::vector<uint8_t> frame;
+            frame.reserve(payload.size() + 2);
+            frame.push_back(static_cast<uint8_t>(source >> 8));
+            frame.push_back(static_cast<uint8_t>(source));
+            frame.insert(frame.end(), payload.begin(), payload.end());
+
+            try {
+                m_queue.Push(std::move(frame));
+            } catch (const BLE_Serial::IO::IOException &e) {
+                // Spilling failed, the notification is lost
+                BLE_Serial::Log::Write(BLE_Serial::Log::Severity::Error, "Notification lost, spilling failed", { { "size", payload.size() }, { "error", e.what() } });
+            }
+
+            std::unique_lock<std::mutex> lock { m_mutex };
+            m_condition.notify_all();
+        }
+
+        [[nodiscard]] BLE_Serial::Bridge::SpillQueueMetrics Metrics()
+        {
+            return m_queue.Metrics();
+        }
+
+    private:
+        void Forward()
+        {
+            std::vector<uint8_t> frame;
+
+            for (;;) {
+                {
+                    std::unique_lock<std::mutex> lock { m_mutex };
+                    m_condition.wait(lock, [this]() { return m_exiting || !m_queue.Empty(); });
+
+                    if (m_exiting) {
+                        return;
+                    }
+                }
+
+                if (!m_queue.Front(frame)) {
+                    continue;
+                }
+
+                size_t source = (static_cast<size_t>(frame[0]) << 8) | frame[1];
+                m_publisher.Publish(m_topics[source], std::vector<uint8_t>(frame.begin() + 2, frame.end()));
+                m_queue.Pop();
+            }
+        }
+
+        MqttPublisher &m_publisher;
+        std::vector<std::string> m_topics;
+        BLE_Serial::Bridge::SpillQueue m_queue;
+
+        std::mutex m_mutex {};
+        std::condition_variable m_condition {};
+        bool m_exiting = false;
+        std::thread m_forwarderThread {};
+    };
+}
+
+int MqttPublish(const MqttPublishSettings &settings, const std::atomic_bool &stop)
+{
+    struct Source
+    {
+        IBluetoothGattCharacteristic *characteristic;
+        std::string topic;
+        size_t subscription;
+    };
+
+    std::vector<std::shared_ptr<IBluetoothConnection>> connections;
+    std::vector<Source> sources;
+
+    auto closeConnections = [&connections]() {
+        for (auto &connection : connections) {
+            try {
+                connection->Close();
+            } catch (const BluetoothException &ignored) {
+                // The link may be already dead
+            }
+        }
+    };
+
+    // The devices connected before a failing one stay connected otherwise
+    try {
+        for (auto address : settings.addresses) {
+            std::cout << "Connecting to " << BluetoothAddressToString(address) << " ..." << std::endl;
+
+            auto deviceOptional = IBluetoothService::GetService().FindDevice(address, settings.timeout);
+            if (!deviceOptional) {
+                throw BluetoothException("Device with address " + BluetoothAddressToString(address) + " couldn't be found");
+            }
+
+            auto connection = deviceOptional.value()->OpenConnection(settings.timeout);
+            connections.push_back(connection);
+
+            auto service = connection->GetService(GetServiceUUID(settings.serviceId));
+            if (!service) {
+                throw BluetoothException("Requested service couldn't be found");
+            }
+
+            service->FetchCharacteristics();
+
+            for (auto characteristicId : settings.characteristicIds) {
+                auto &characteristic = service->GetCharacteristic(GetCharacteristicUUID(characteristicId));
+                if (!characteristic) {
+                    throw BluetoothException("Requested characteristic couldn't be found");
+                }
+
+                sources.push_back(Source {
+                        .characteristic = characteristic.get(),
+                        .topic = FormatTopic(settings.topic, address, settings.serviceId, characteristicId),
+                        .subscription = 0
+                });
+            }
+        }
+    } catch (...) {
+        closeConnections();
+        throw;
+    }
+
+    std::cout << "Connecting to MQTT broker " << settings.options.host << ":" << settings.options.port << " ..." << std::endl;
+
+    MqttPublisher publisher { settings.options };
+
+    try {
+        publisher.Start();
+    } catch (...) {
+        closeConnections();
+        throw;
+    }
+
+    std::vector<std::string> topics;
+    for (auto &source : sources) {
+        topics.push_back(source.topic);
+    }
+
+    NotificationForwarder forwarder { publisher, std::move(topics), settings.queue };
+    forwarder.Start();
+
+    size_t subscribed = 0;
+
+    try {
+        for (size_t i = 0; i < sources.size(); i++) {
+            auto &source = sources[i];
+            source.subscription = source.characteristic->Subscribe([&forwarder, i](std::vector<uint8_t> data) {
+                forwarder.Offer(static_cast<uint16_t>(i), data);
+            });
+            subscribed++;
+
+            std::cout << "Publishing to " << source.topic << std::endl;
+        }
+    } catch (...) {
+        // The listeners refer to the forwarder, they have to be gone before it is
+        for (size_t i = 0; i < subscribed; i++) {
+            try {
+                sources[i].characteristic->Unsubscribe(sources[i].subscription);
+            } catch (const BluetoothException &ignored) {
+                // The listener is removed before the CCCD write that failed
+            }
+        }
+
+        forwarder.Stop();
+        publisher.Stop();
+        closeConnections();
+        throw;
+    }
+
+    std::cout << "Press Ctrl+C to stop" << std::endl;
+
+    auto anyOpen = [&connections]() {
+        return std::any_of(connections.begin(), connections.end(), [](const auto &connection) { return connection->IsOpen(); });
+    };
+
+    while (!stop.load() && anyOpen()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+
+    bool interrupted = stop.load();
+
+    for (auto &source : sources) {
+        source.characteristic->Unsubscribe(source.subscription);
+    }
+
+    forwarder.Stop();
+    publisher.Stop();
+
+    auto queueMetrics = forwarder.Metrics();
+    auto metrics = publisher.Metrics();
+    std::cout << "Published " << metrics.published << " messages in " << metrics.flushes << " writes (" << metrics.bytesSent << " bytes), "
+              << metrics.acknowledged << " acknowledged, " << metrics.retransmitted << " retransmitted, " << metrics.dropped << " dropped, "
+              << metrics.reconnects << " reconnects, " << queueMetrics.dropped + queueMetrics.frames << " notifications never handed to the publisher" << std::endl;
+
+    closeConnections();
+
+    return interrupted ? 0 : 1;
+}
@@ -0,0 +1,36 @@
+#ifndef BLE_SERIAL_SRC_MQTT_PUBLISH_HPP_
+#define BLE_SERIAL_SRC_MQTT_PUBLISH_HPP_
+
+#include <ble_serial/mqtt.hpp>
+#include <ble_serial/spill_queue.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Settings of the mqtt command, the notifications of every characteristic of every device are published.
+ */
+struct MqttPublishSettings
+{
+    std::vector<BLE_Serial::Bluetooth::BluetoothAddress> addresses;
+    BLE_Serial::Bluetooth::GattRegisteredService serviceId;
+    std::vector<BLE_Serial::Bluetooth::GattRegisteredCharacteristic> characteristicIds;
+    std::string topic = "ble/{address}/{characteristic}";  ///< topic template, see @link BLE_Serial::Mqtt::FormatTopic @endlink
+    std::chrono::seconds timeout { 5 };
+    BLE_Serial::Mqtt::MqttOptions options {};
+    BLE_Serial::Bridge::SpillQueueOptions queue {};  ///< buffer of the notifications waiting for room in the publisher's queue
+};
+
+/**
+ * @brief Publishes notifications to an MQTT broker until interrupted or until every device is disconnected.
+ *
+ * @param settings settings of the command
+ * @param stop flag that ends the command when set
+ *
+ * @return exit code of the application
+ */
+int MqttPublish(const MqttPublishSettings &settings, const std::atomic_bool &stop);
+
+#endif // BLE_SERIAL_SRC_MQTT_PUBLISH_HPP_
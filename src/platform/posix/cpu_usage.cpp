@@ -0,0 +1,21 @@
+#include <ble_serial/cpu_usage.hpp>
+
+#include <ctime>
+
+namespace BLE_Serial::Bridge
+{
+    std::chrono::nanoseconds CpuUsage::ThreadTime() noexcept
+    {
+        timespec time {};
+        if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time) != 0) {
+            return std::chrono::nanoseconds { 0 };
+        }
+
+        return std::chrono::seconds { time.tv_sec } + std::chrono::nanoseconds { time.tv_nsec };
+    }
+
+    void CpuUsage::Calibrate() noexcept
+    {
+        // The thread CPU clock needs no calibration
+    }
+}
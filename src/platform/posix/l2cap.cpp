@@ -0,0 +1,253 @@
+#include <ble_serial/l2cap.hpp>
+#include <ble_serial/instrumentation.hpp>
+
+#include <bit>
+#include <cerrno>
+#include <cstring>
+#include <string>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+namespace BLE_Serial::Bluetooth
+{
+    namespace
+    {
+#ifdef __linux__
+        // BlueZ socket constants, from <bluetooth/bluetooth.h> and <bluetooth/l2cap.h> which are not always installed
+        constexpr int c_afBluetooth = 31;
+        constexpr int c_btProtoL2CAP = 0;
+        constexpr int c_solBluetooth = 274;
+        constexpr int c_btSendMtu = 12;
+        constexpr int c_btReceiveMtu = 13;
+        constexpr uint8_t c_addressLEPublic = 1;
+
+        struct SocketAddressL2CAP
+        {
+            sa_family_t family;
+            uint16_t psm;
+            uint8_t address[6];
+            uint16_t cid;
+            uint8_t addressType;
+        };
+
+        uint16_t ToLittleEndian(uint16_t value) noexcept
+        {
+            if constexpr (std::endian::native == std::endian::big) {
+                return static_cast<uint16_t>((value >> 8) | (value << 8));
+            }
+
+            return value;
+        }
+#endif
+
+        int PollSocket(int fd, short events, std::chrono::milliseconds timeout) noexcept
+        {
+            pollfd descriptor { .fd = fd, .events = events, .revents = 0 };
+
+            int result;
+            do {
+                result = poll(&descriptor, 1, static_cast<int>(timeout.count()));
+            } while (result < 0 && errno == EINTR);
+
+            return result <= 0 ? result : descriptor.revents;
+        }
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // L2CAPChannel implementation                          //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    std::unique_ptr<L2CAPChannel> L2CAPChannel::Connect(BluetoothAddress address, uint16_t psm, std::chrono::seconds timeout, L2CAPChannelOptions options)
+    {
+#ifdef __linux__
+        BLE_SERIAL_TIMED_SCOPE("l2cap.connect");
+
+        int fd = socket(c_afBluetooth, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, c_btProtoL2CAP);
+        if (fd < 0) {
+            throw BluetoothException(std::string { "Failed to create an L2CAP socket: " } + std::strerror(errno));
+        }
+
+        auto fail = [fd](const std::string &what) {
+            int error = errno;
+            close(fd);
+            throw BluetoothException(what + ": " + std::strerror(error));
+        };
+
+        SocketAddressL2CAP local {};
+        local.family = c_afBluetooth;
+        local.addressType = c_addressLEPublic;
+
+        if (bind(fd, reinterpret_cast<const sockaddr *>(&local), sizeof(local)) != 0) {
+            fail("Failed to bind the L2CAP socket");
+        }
+
+        // The MTU is announced in the connection request, so it has to be set before connecting
+        uint16_t mtu = options.mtu;
+        if (setsockopt(fd, c_solBluetooth, c_btReceiveMtu, &mtu, sizeof(mtu)) != 0) {
+            fail("Failed to set the L2CAP MTU");
+        }
+
+        SocketAddressL2CAP remote {};
+        remote.family = c_afBluetooth;
+        remote.psm = ToLittleEndian(psm);
+        remote.addressType = c_addressLEPublic;
+        for (size_t i = 0; i < sizeof(remote.address); i++) {
+            remote.address[i] = static_cast<uint8_t>(address >> (8 * i));
+        }
+
+        if (connect(fd, reinterpret_cast<const sockaddr *>(&remote), sizeof(remote)) != 0) {
+            if (errno != EINPROGRESS) {
+                fail("Failed to connect to PSM " + std::to_string(psm));
+            }
+
+            int events = PollSocket(fd, POLLOUT, std::chrono::duration_cast<std::chrono::milliseconds>(timeout));
+            if (events == 0) {
+                errno = ETIMEDOUT;
+                fail("Failed to connect to PSM " + std::to_string(psm));
+            }
+
+            int error = 0;
+            socklen_t length = sizeof(error);
+            if (events < 0 || getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length) != 0 || error != 0) {
+                errno = error != 0 ? error : errno;
+                fail("Failed to connect to PSM " + std::to_string(psm));
+            }
+        }
+
+        return std::make_unique<L2CAPChannel>(fd, options);
+#else
+        throw BluetoothException("L2CAP channels are only supported on Linux");
+#endif
+    }
+
+    L2CAPChannel::L2CAPChannel(intptr_t socket, L2CAPChannelOptions options)
+            : m_socket { socket }, m_options { options }, m_maxSduSize { options.mtu }
+    {
+        int fd = static_cast<int>(m_socket);
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+        // BlueZ grants the peer as many credits as fit into the receive buffer, so its size is the credit window
+        int receiveBuffer = static_cast<int>(m_options.credits) * m_options.mps;
+        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &receiveBuffer, sizeof(receiveBuffer));
+
+#ifdef __linux__
+        // Stand-in sockets have no Bluetooth options, the configured MTU applies to both directions then
+        uint16_t sendMtu = 0;
+        socklen_t length = sizeof(sendMtu);
+        if (getsockopt(fd, c_solBluetooth, c_btSendMtu, &sendMtu, &length) == 0 && sendMtu != 0) {
+            m_maxSduSize = sendMtu;
+        }
+#endif
+    }
+
+    L2CAPChannel::~L2CAPChannel()
+    {
+        UnsubscribeAll();
+        Close();
+        close(static_cast<int>(m_socket));
+    }
+
+    void L2CAPChannel::Send(const std::vector<uint8_t> &sdu)
+    {
+        BLE_SERIAL_TIMED_SCOPE("l2cap.send");
+
+        if (sdu.size() > m_maxSduSize) {
+            throw BluetoothException("SDU of " + std::to_string(sdu.size()) + " bytes exceeds the channel MTU of " + std::to_string(m_maxSduSize) + " bytes");
+        }
+
+        std::unique_lock<std::mutex> lock { m_sendMutex };
+        int fd = static_cast<int>(m_socket);
+        std::chrono::steady_clock::time_point stallStart {};
+        bool stalled = false;
+
+        for (;;) {
+            if (!m_open.load()) {
+                throw BluetoothException("The L2CAP channel is closed");
+            }
+
+            if (send(fd, sdu.data(), sdu.size(), MSG_DONTWAIT | MSG_NOSIGNAL) >= 0) {
+                break;
+            }
+
+            if (errno == EINTR) {
+                continue;
+            }
+
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                int error = errno;
+                m_open.store(false);
+                throw BluetoothException(std::string { "L2CAP send failed: " } + std::strerror(error));
+            }
+
+            // Out of credits, the socket becomes writable once the peer grants more
+            auto now = std::chrono::steady_clock::now();
+            if (!stalled) {
+                stalled = true;
+                stallStart = now;
+                m_creditStalls.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            auto remaining = m_options.sendTimeout - std::chrono::duration_cast<std::chrono::milliseconds>(now - stallStart);
+            if (remaining.count() <= 0 || PollSocket(fd, POLLOUT, remaining) == 0) {
+                m_stalledTime.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - stallStart).count(), std::memory_order_relaxed);
+                throw BluetoothException("The peer granted no L2CAP credits in time");
+            }
+        }
+
+        if (stalled) {
+            m_stalledTime.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - stallStart).count(), std::memory_order_relaxed);
+        }
+
+        m_sdusSent.fetch_add(1, std::memory_order_relaxed);
+        m_bytesSent.fetch_add(sdu.size(), std::memory_order_relaxed);
+        BLE_SERIAL_COUNT("l2cap.send.bytes", sdu.size());
+    }
+
+    bool L2CAPChannel::Receive(std::vector<uint8_t> &sdu, std::chrono::milliseconds timeout)
+    {
+        int fd = static_cast<int>(m_socket);
+
+        if (!m_open.load() || PollSocket(fd, POLLIN, timeout) <= 0) {
+            return false;
+        }
+
+        // Peeking with MSG_TRUNC returns the full length of the next SDU, so the buffer is sized exactly once
+        ssize_t length = recv(fd, nullptr, 0, MSG_PEEK | MSG_TRUNC | MSG_DONTWAIT);
+        if (length < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+            return false;
+        }
+
+        if (length <= 0 || static_cast<size_t>(length) > m_options.mtu) {
+            // Closed by the peer, failed or the peer broke the negotiated MTU, which ends the channel as well
+            m_open.store(false);
+            return false;
+        }
+
+        sdu.resize(static_cast<size_t>(length));
+        if (recv(fd, sdu.data(), sdu.size(), MSG_DONTWAIT) != length) {
+            m_open.store(false);
+            return false;
+        }
+
+        m_sdusReceived.fetch_add(1, std::memory_order_relaxed);
+        m_bytesReceived.fetch_add(sdu.size(), std::memory_order_relaxed);
+        return true;
+    }
+
+    void L2CAPChannel::Close()
+    {
+        // The descriptor stays valid until the destructor, so that a concurrent receive never touches a reused one
+        if (m_open.exchange(false)) {
+            shutdown(static_cast<int>(m_socket), SHUT_RDWR);
+        }
+    }
+}
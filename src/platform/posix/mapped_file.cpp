@@ -0,0 +1,126 @@
+#include <ble_serial/mapped_file.hpp>
+
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace BLE_Serial::IO
+{
+    namespace
+    {
+        /**
+         * Helper for mapping an already opened file, the descriptor is closed because the mapping keeps the file alive
+         */
+        uint8_t *MapDescriptor(int fd, size_t size, bool writable, const std::string &path)
+        {
+            void *data = mmap(nullptr, size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+            int error = errno;
+            close(fd);
+
+            if (data == MAP_FAILED) {
+                throw IOException("mmap failed for " + path + ": " + std::strerror(error));
+            }
+
+            return static_cast<uint8_t *>(data);
+        }
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // MappedFile implementation                            //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    MappedFile MappedFile::OpenReadOnly(const std::string &path)
+    {
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            throw IOException("Failed to open " + path + ": " + std::strerror(errno));
+        }
+
+        struct stat info {};
+        if (fstat(fd, &info) != 0 || info.st_size == 0) {
+            close(fd);
+            throw IOException("Cannot map empty file " + path);
+        }
+
+        MappedFile result;
+        result.m_path = path;
+        result.m_size = static_cast<size_t>(info.st_size);
+        result.m_data = MapDescriptor(fd, result.m_size, false, path);
+        madvise(result.m_data, result.m_size, MADV_SEQUENTIAL);
+        return result;
+    }
+
+    MappedFile MappedFile::Create(const std::string &path, size_t size)
+    {
+        int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            throw IOException("Failed to create " + path + ": " + std::strerror(errno));
+        }
+
+        if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+            int error = errno;
+            close(fd);
+            throw IOException("Failed to resize " + path + ": " + std::strerror(error));
+        }
+
+        MappedFile result;
+        result.m_path = path;
+        result.m_size = size;
+        result.m_data = MapDescriptor(fd, size, true, path);
+        return result;
+    }
+
+    void MappedFile::Close() noexcept
+    {
+        if (m_data != nullptr) {
+            munmap(m_data, m_size);
+            m_data = nullptr;
+            m_size = 0;
+        }
+    }
+
+    void MappedFile::Remove(const std::string &path) noexcept
+    {
+        unlink(path.c_str());
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // FileLock implementation                              //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    FileLock::FileLock(const std::string &path)
+    {
+        int fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            throw IOException("Failed to open " + path + ": " + std::strerror(errno));
+        }
+
+        int result;
+        do {
+            result = flock(fd, LOCK_EX);
+        } while (result != 0 && errno == EINTR);
+
+        if (result != 0) {
+            int error = errno;
+            close(fd);
+            throw IOException("Failed to lock " + path + ": " + std::strerror(error));
+        }
+
+        m_handle = fd;
+    }
+
+    FileLock::~FileLock()
+    {
+        // Closing the descriptor releases the lock
+        close(static_cast<int>(m_handle));
+    }
+}
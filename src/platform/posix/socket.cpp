@@ -0,0 +1,255 @@
+#include <ble_serial/socket.hpp>
+
+#include <cerrno>
+#include <cstring>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+namespace BLE_Serial::IO
+{
+    namespace
+    {
+        int PollSocket(int fd, short events, std::chrono::milliseconds timeout) noexcept
+        {
+            pollfd descriptor { .fd = fd, .events = events, .revents = 0 };
+
+            int result;
+            do {
+                result = poll(&descriptor, 1, static_cast<int>(timeout.count()));
+            } while (result < 0 && errno == EINTR);
+
+            return result <= 0 ? result : descriptor.revents;
+        }
+
+        std::string AddressToString(const sockaddr_storage &address)
+        {
+            char host[INET6_ADDRSTRLEN] = {};
+            uint16_t port = 0;
+
+            if (address.ss_family == AF_INET) {
+                auto &ipv4 = reinterpret_cast<const sockaddr_in &>(address);
+                inet_ntop(AF_INET, &ipv4.sin_addr, host, sizeof(host));
+                port = ntohs(ipv4.sin_port);
+            } else if (address.ss_family == AF_INET6) {
+                auto &ipv6 = reinterpret_cast<const sockaddr_in6 &>(address);
+                inet_ntop(AF_INET6, &ipv6.sin6_addr, host, sizeof(host));
+                port = ntohs(ipv6.sin6_port);
+            }
+
+            return std::string { host } + ":" + std::to_string(port);
+        }
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // TcpStream implementation                             //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    std::unique_ptr<TcpStream> TcpStream::Connect(const std::string &host, uint16_t port, std::chrono::milliseconds timeout)
+    {
+        addrinfo hints {};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+
+        addrinfo *addresses = nullptr;
+        if (int error = getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &addresses); error != 0) {
+            throw IOException("Failed to resolve " + host + ": " + gai_strerror(error));
+        }
+
+        std::string lastError = "no address";
+
+        for (auto address = addresses; address != nullptr; address = address->ai_next) {
+            int fd = socket(address->ai_family, address->ai_socktype | SOCK_CLOEXEC, address->ai_protocol);
+            if (fd < 0) {
+                lastError = std::strerror(errno);
+                continue;
+            }
+
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+            if (connect(fd, address->ai_addr, address->ai_addrlen) != 0 && errno != EINPROGRESS) {
+                lastError = std::strerror(errno);
+                close(fd);
+                continue;
+            }
+
+            int events = PollSocket(fd, POLLOUT, timeout);
+            int error = 0;
+            socklen_t length = sizeof(error);
+
+            if (events <= 0 || getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length) != 0 || error != 0) {
+                lastError = events == 0 ? "timed out" : std::strerror(error != 0 ? error : errno);
+                close(fd);
+                continue;
+            }
+
+            freeaddrinfo(addresses);
+            return std::make_unique<TcpStream>(fd);
+        }
+
+        freeaddrinfo(addresses);
+        throw IOException("Failed to connect to " + host + ":" + std::to_string(port) + ": " + lastError);
+    }
+
+    TcpStream::TcpStream(intptr_t socket)
+            : m_socket { socket }
+    {
+        int fd = static_cast<int>(m_socket);
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+        int noDelay = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+        sockaddr_storage peer {};
+        socklen_t length = sizeof(peer);
+        if (getpeername(fd, reinterpret_cast<sockaddr *>(&peer), &length) == 0) {
+            m_peerName = AddressToString(peer);
+        }
+    }
+
+    TcpStream::~TcpStream()
+    {
+        Close();
+        close(static_cast<int>(m_socket));
+    }
+
+    void TcpStream::Send(const uint8_t *data, size_t size)
+    {
+        std::unique_lock<std::mutex> lock { m_sendMutex };
+        int fd = static_cast<int>(m_socket);
+
+        while (size != 0) {
+            if (!m_open.load()) {
+                throw IOException("The stream is closed");
+            }
+
+            ssize_t sent = send(fd, data, size, MSG_NOSIGNAL);
+            if (sent < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    PollSocket(fd, POLLOUT, std::chrono::milliseconds(100));
+                    continue;
+                }
+
+                int error = errno;
+                m_open.store(false);
+                throw IOException(std::string { "Send failed: " } + std::strerror(error));
+            }
+
+            data += sent;
+            size -= static_cast<size_t>(sent);
+        }
+    }
+
+    size_t TcpStream::Receive(uint8_t *buffer, size_t size, std::chrono::milliseconds timeout)
+    {
+        int fd = static_cast<int>(m_socket);
+
+        if (!m_open.load() || PollSocket(fd, POLLIN, timeout) <= 0) {
+            return 0;
+        }
+
+        ssize_t received = recv(fd, buffer, size, 0);
+        if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+            return 0;
+        }
+
+        if (received <= 0) {
+            // Closed by the peer or failed
+            m_open.store(false);
+            return 0;
+        }
+
+        return static_cast<size_t>(received);
+    }
+
+    void TcpStream::Close()
+    {
+        // The descriptor stays valid until the destructor, so that a concurrent receive never touches a reused one
+        if (m_open.exchange(false)) {
+            shutdown(static_cast<int>(m_socket), SHUT_RDWR);
+        }
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // TcpListener implementation                           //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    TcpListener::TcpListener(uint16_t port, const std::string &bindAddress)
+            : m_socket { -1 }
+    {
+        sockaddr_in address {};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(port);
+        if (inet_pton(AF_INET, bindAddress.c_str(), &address.sin_addr) != 1) {
+            throw IOException("Invalid bind address " + bindAddress);
+        }
+
+        int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            throw IOException(std::string { "Failed to create a socket: " } + std::strerror(errno));
+        }
+
+        int reuse = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+        if (bind(fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0 || listen(fd, SOMAXCONN) != 0) {
+            int error = errno;
+            close(fd);
+            throw IOException("Failed to listen on port " + std::to_string(port) + ": " + std::strerror(error));
+        }
+
+        socklen_t length = sizeof(address);
+        getsockname(fd, reinterpret_cast<sockaddr *>(&address), &length);
+
+        m_socket = fd;
+        m_port = ntohs(address.sin_port);
+    }
+
+    TcpListener::~TcpListener()
+    {
+        Close();
+        close(static_cast<int>(m_socket));
+    }
+
+    std::unique_ptr<TcpStream> TcpListener::Accept(std::chrono::milliseconds timeout)
+    {
+        int fd = static_cast<int>(m_socket);
+
+        if (!m_open.load() || PollSocket(fd, POLLIN, timeout) <= 0 || !m_open.load()) {
+            return nullptr;
+        }
+
+        int client = accept(fd, nullptr, nullptr);
+        if (client < 0) {
+            return nullptr;
+        }
+
+        fcntl(client, F_SETFD, FD_CLOEXEC);
+        return std::make_unique<TcpStream>(client);
+    }
+
+    void TcpListener::Close()
+    {
+        if (m_open.exchange(false)) {
+            shutdown(static_cast<int>(m_socket), SHUT_RDWR);
+        }
+    }
+}
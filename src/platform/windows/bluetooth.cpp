@@ -1,11 +1,14 @@
 #include "bluetooth.hpp"
 
+#include <ble_serial/instrumentation.hpp>
+
 #define _SILENCE_CXX17_CODECVT_HEADER_DEPRECATION_WARNING // ugly :(
 
 #include <iostream>
 #include <algorithm>
 #include <codecvt>
 #include <locale>
+#include <shared_mutex>
 
 #ifdef _MSC_VER
 #   pragma comment(lib, "windowsapp")
@@ -49,19 +52,27 @@ namespace BLE_Serial::Bluetooth
         template<typename R>
         static R WaitWithTimeout(IAsyncOperation<R> &&task, std::chrono::seconds timeout)
         {
-            std::mutex mutex {};
-            std::condition_variable condition {};
+            BLE_SERIAL_TIMED_SCOPE("bluetooth.wait");
+
+            struct State
+            {
+                std::mutex mutex {};
+                std::condition_variable condition {};
+            };
+
+            // The completion handler may outlive this call when the operation times out, so the state is shared with it
+            auto state = std::make_shared<State>();
 
-            task.Completed([&condition, &mutex](const IAsyncOperation<R>& asyncInfo, AsyncStatus asyncStatus) {
-                std::unique_lock<std::mutex> lock { mutex };
-                condition.notify_all();
+            task.Completed([state](const IAsyncOperation<R>& asyncInfo, AsyncStatus asyncStatus) {
+                std::unique_lock<std::mutex> lock { state->mutex };
+                state->condition.notify_all();
             });
 
             const auto deadline = std::chrono::system_clock::now() + timeout;
 
             while (std::chrono::system_clock::now() < deadline && task.Status() == AsyncStatus::Started) {
-                std::unique_lock<std::mutex> lock { mutex };
-                condition.wait_until(lock, deadline);
+                std::unique_lock<std::mutex> lock { state->mutex };
+                state->condition.wait_until(lock, deadline, [&task]() { return task.Status() != AsyncStatus::Started; });
             }
 
             switch (task.Status()) {
@@ -75,6 +86,31 @@ namespace BLE_Serial::Bluetooth
                     throw BluetoothException("Operation timed out");
             }
         }
+
+        /**
+         * Pairings may wait for the user to confirm them, so they get more time than regular operations
+         */
+        constexpr std::chrono::seconds c_minimumPairingTimeout { 30 };
+
+        /**
+         * Helper for checking the status of GATT operations, telling the errors a pairing fixes apart
+         */
+        void CheckStatus(GattCommunicationStatus status, const IReference<uint8_t> &protocolError, const char *message)
+        {
+            if (status == GattCommunicationStatus::Success) {
+                return;
+            }
+
+            if (status == GattCommunicationStatus::ProtocolError && protocolError) {
+                auto error = protocolError.Value();
+                if (error == GattProtocolError::InsufficientAuthentication() || error == GattProtocolError::InsufficientAuthorization() ||
+                    error == GattProtocolError::InsufficientEncryption() || error == GattProtocolError::InsufficientEncryptionKeySize()) {
+                    throw BluetoothSecurityException(std::string { message } + ": the device requires a paired link, ATT error " + std::to_string(error));
+                }
+            }
+
+            throw BluetoothException(message);
+        }
     }
 
     //////////////////////////////////////////////////////////
@@ -103,20 +139,28 @@ namespace BLE_Serial::Bluetooth
     //////////////////////////////////////////////////////////
 
     template<typename Notify>
-    BluetoothLEAdvertisementWatcher WindowsBluetoothService::CreateDeviceWatcher(Notify &&notify)
+    BluetoothLEAdvertisementWatcher WindowsBluetoothService::CreateAdvertisementWatcher(Notify &&notify)
     {
         auto factory = winrt::get_activation_factory<BluetoothLEAdvertisementWatcher, IBluetoothLEAdvertisementWatcherFactory>();
         auto filter = BluetoothLEAdvertisementFilter {};
         auto watcher = factory.Create(filter);
 
-        watcher.Received([notify](const IBluetoothLEAdvertisementWatcher &watcher, const IBluetoothLEAdvertisementReceivedEventArgs &args) {
+        watcher.Received([notify](const IBluetoothLEAdvertisementWatcher &watcher, const BluetoothLEAdvertisementReceivedEventArgs &args) {
+            notify(args);
+        });
+
+        return watcher;
+    }
+
+    template<typename Notify>
+    BluetoothLEAdvertisementWatcher WindowsBluetoothService::CreateDeviceWatcher(Notify &&notify)
+    {
+        return CreateAdvertisementWatcher([this, notify](const BluetoothLEAdvertisementReceivedEventArgs &args) {
             auto name = args.Advertisement().LocalName();
-            auto device = std::unique_ptr<IBluetoothDevice>(new WindowsBluetoothDevice { args.BluetoothAddress(), std::wstring { name.empty() ? L"(unnamed)" : name }});
+            auto device = std::unique_ptr<IBluetoothDevice>(new WindowsBluetoothDevice { *this, args.BluetoothAddress(), std::wstring { name.empty() ? L"(unnamed)" : name }, args.RawSignalStrengthInDBm() });
 
             notify(std::move(device));
         });
-
-        return watcher;
     }
 
     void WindowsBluetoothService::Initialize()
@@ -152,60 +196,204 @@ namespace BLE_Serial::Bluetooth
 
     void WindowsBluetoothService::ScanDevices(std::vector<std::unique_ptr<IBluetoothDevice>> &output, std::chrono::seconds timeout)
     {
+        BLE_SERIAL_TIMED_SCOPE("bluetooth.scan");
+
         WINRT_CALL_BEGIN {
-            auto watcher = CreateDeviceWatcher([&output](std::unique_ptr<IBluetoothDevice> device) {
-                if (std::any_of(output.begin(), output.end(), [&device](const auto &current) {
+            struct Scan
+            {
+                std::mutex mutex {};
+                bool stopped = false;
+                std::vector<std::unique_ptr<IBluetoothDevice>> devices {};
+            };
+
+            // A callback already dispatched when the watcher stops may still run after this returns, so the callbacks
+            // share the scan instead of referring to this frame
+            auto scan = std::make_shared<Scan>();
+
+            // The watcher may deliver advertisements from multiple threadpool threads at once
+            auto watcher = CreateDeviceWatcher([scan](std::unique_ptr<IBluetoothDevice> device) {
+                std::unique_lock<std::mutex> lock { scan->mutex };
+
+                if (scan->stopped || std::any_of(scan->devices.begin(), scan->devices.end(), [&device](const auto &current) {
                     return device->GetDeviceAddress() == current->GetDeviceAddress();
                 })) {
                     // Do not duplicate devices
                     return;
                 }
 
-                output.emplace_back(reinterpret_cast<IBluetoothDevice *>(device.release()));
+                scan->devices.emplace_back(std::move(device));
             });
 
             watcher.Start();
             std::this_thread::sleep_for(timeout);
             watcher.Stop();
+
+            // Waits for the callbacks that are running, the later ones find the scan stopped
+            std::unique_lock<std::mutex> lock { scan->mutex };
+            scan->stopped = true;
+
+            for (auto &device : scan->devices) {
+                if (std::none_of(output.begin(), output.end(), [&device](const auto &current) {
+                    return device->GetDeviceAddress() == current->GetDeviceAddress();
+                })) {
+                    output.emplace_back(std::move(device));
+                }
+            }
         } WINRT_CALL_END;
     }
 
     std::optional<std::unique_ptr<IBluetoothDevice>> WindowsBluetoothService::FindDevice(BluetoothAddress address, std::chrono::seconds timelimit)
     {
+        BLE_SERIAL_TIMED_SCOPE("bluetooth.scan.find");
+
         WINRT_CALL_BEGIN {
-            std::optional<std::unique_ptr<IBluetoothDevice>> result;
-            std::mutex mutex;
-            std::condition_variable condition;
+            struct Search
+            {
+                std::mutex mutex {};
+                std::condition_variable condition {};
+                bool stopped = false;
+                std::optional<std::unique_ptr<IBluetoothDevice>> result {};
+            };
+
+            // Shared with the callbacks, which may still run after this returns
+            auto search = std::make_shared<Search>();
 
-            auto watcher = CreateDeviceWatcher([&](std::unique_ptr<IBluetoothDevice> device) {
+            auto watcher = CreateDeviceWatcher([search, address](std::unique_ptr<IBluetoothDevice> device) {
                 if (device->GetDeviceAddress() != address) {
                     return;
                 }
 
-                std::unique_lock<std::mutex> lock { mutex };
-                result = std::unique_ptr<IBluetoothDevice> { static_cast<IBluetoothDevice *>(device.release()) };
-                condition.notify_all();
+                std::unique_lock<std::mutex> lock { search->mutex };
+                if (search->stopped || search->result) {
+                    return;
+                }
+
+                search->result = std::move(device);
+                search->condition.notify_all();
             });
 
             watcher.Start();
 
             const auto deadline = std::chrono::system_clock::now() + timelimit;
 
-            while (std::chrono::system_clock::now() < deadline) {
-                std::unique_lock<std::mutex> lock { mutex };
-                condition.wait_until(lock, deadline);
+            {
+                std::unique_lock<std::mutex> lock { search->mutex };
+                search->condition.wait_until(lock, deadline, [&search]() { return search->result.has_value(); });
+            }
+
+            watcher.Stop();
+
+            std::unique_lock<std::mutex> lock { search->mutex };
+            search->stopped = true;
+            return std::move(search->result);
+        } WINRT_CALL_END;
+    }
+
+    void WindowsBluetoothService::WatchAdvertisements(const std::function<void(const BluetoothAdvertisement &)> &listener, const std::atomic_bool &stop)
+    {
+        BLE_SERIAL_TIMED_SCOPE("bluetooth.watch");
+
+        WINRT_CALL_BEGIN {
+            struct Watch
+            {
+                std::shared_mutex mutex {};
+                bool stopped = false;
+            };
+
+            // Shared with the callbacks, which may still run after this returns, they must not call the listener then
+            auto watch = std::make_shared<Watch>();
+
+            auto watcher = CreateAdvertisementWatcher([&listener, watch](const BluetoothLEAdvertisementReceivedEventArgs &args) {
+                // Shared, so that the threadpool keeps delivering in parallel while the watch only waits for them on exit
+                std::shared_lock<std::shared_mutex> lock { watch->mutex };
+                if (watch->stopped) {
+                    return;
+                }
 
-                if (result) {
-                    break;
+                BluetoothAdvertisement advertisement {
+                        .address = args.BluetoothAddress(),
+                        .rssi = args.RawSignalStrengthInDBm(),
+                        .extended = args.AdvertisementType() == BluetoothLEAdvertisementType::Extended,
+                        .manufacturerData = {}
+                };
+
+                for (const auto &section : args.Advertisement().ManufacturerData()) {
+                    auto buffer = section.Data();
+                    advertisement.manufacturerData.push_back(BluetoothManufacturerData {
+                            .companyId = section.CompanyId(),
+                            .data = std::vector<uint8_t> { buffer.data(), buffer.data() + buffer.Length() }
+                    });
                 }
+
+                BLE_SERIAL_COUNT("bluetooth.advertisements", 1);
+                listener(advertisement);
+            });
+
+            // Passive scanning is enough for manufacturer data and does not make the beacons send scan responses
+            watcher.ScanningMode(BluetoothLEScanningMode::Passive);
+
+            try {
+                watcher.AllowExtendedAdvertisements(true);
+            } catch (const winrt::hresult_error &ignored) {
+                // Windows before 10 2004 only reports legacy advertisements
+            }
+
+            watcher.Start();
+
+            while (!stop.load()) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
             }
 
             watcher.Stop();
 
-            return result;
+            // Waits for the callbacks that are running, the later ones find the watch stopped
+            std::unique_lock<std::shared_mutex> lock { watch->mutex };
+            watch->stopped = true;
         } WINRT_CALL_END;
     }
 
+    const std::string &WindowsBluetoothService::GetAdapterId() const noexcept
+    {
+        // There is only the service of the default radio, see GetPlatformBluetoothService
+        static const std::string c_defaultAdapter {};
+        return c_defaultAdapter;
+    }
+
+    size_t WindowsBluetoothService::GetActiveConnectionCount() const noexcept
+    {
+        return m_activeConnections.load(std::memory_order_relaxed);
+    }
+
+    uint64_t WindowsBluetoothService::GetTransferredBytes() const noexcept
+    {
+        return m_transferredBytes.load(std::memory_order_relaxed);
+    }
+
+    size_t WindowsBluetoothService::GetMaxConnectionCount() const noexcept
+    {
+        return m_maxConnections.load(std::memory_order_relaxed);
+    }
+
+    void WindowsBluetoothService::SetMaxConnectionCount(size_t count) noexcept
+    {
+        m_maxConnections.store(count, std::memory_order_relaxed);
+    }
+
+    void WindowsBluetoothService::ConnectionOpened() noexcept
+    {
+        m_activeConnections.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void WindowsBluetoothService::ConnectionClosed() noexcept
+    {
+        m_activeConnections.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void WindowsBluetoothService::BytesTransferred(size_t count) noexcept
+    {
+        m_transferredBytes.fetch_add(count, std::memory_order_relaxed);
+    }
+
 
     //////////////////////////////////////////////////////////
     //                                                      //
@@ -213,8 +401,8 @@ namespace BLE_Serial::Bluetooth
     //                                                      //
     //////////////////////////////////////////////////////////
 
-    WindowsBluetoothDevice::WindowsBluetoothDevice(BluetoothAddress deviceAddress, std::wstring deviceName)
-            : m_deviceAddress(deviceAddress), m_deviceName(std::move(deviceName))
+    WindowsBluetoothDevice::WindowsBluetoothDevice(WindowsBluetoothService &service, BluetoothAddress deviceAddress, std::wstring deviceName, int16_t signalStrength)
+            : m_service(service), m_deviceAddress(deviceAddress), m_deviceName(std::move(deviceName)), m_signalStrength(signalStrength)
     {}
 
     [[nodiscard]] BluetoothAddress WindowsBluetoothDevice::GetDeviceAddress() const noexcept
@@ -227,37 +415,79 @@ namespace BLE_Serial::Bluetooth
         return m_deviceName;
     }
 
+    [[nodiscard]] int16_t WindowsBluetoothDevice::GetSignalStrength() const noexcept
+    {
+        return m_signalStrength;
+    }
+
     [[nodiscard]] std::optional<std::shared_ptr<IBluetoothConnection>> WindowsBluetoothDevice::GetOpenConnection() const noexcept
     {
-        if (!m_openConnection) {
-            return std::nullopt;
-        }
+        return m_connection.Get();
+    }
 
-        if (!m_openConnection->IsOpen()) {
-            return std::nullopt;
-        }
+    [[nodiscard]] std::shared_ptr<IBluetoothConnection> WindowsBluetoothDevice::OpenConnection(std::chrono::seconds timeout)
+    {
+        // Concurrent callers share a single connection, each of them closes it once
+        return m_connection.Open([this, timeout]() -> std::shared_ptr<SharedBluetoothConnection> {
+            BLE_SERIAL_TIMED_SCOPE("bluetooth.connect");
+
+            WINRT_CALL_BEGIN {
+                auto device = WaitWithTimeout(BluetoothLEDevice::FromBluetoothAddressAsync(m_deviceAddress), timeout);
 
-        return m_openConnection;
+                GattDeviceServicesResult gattServices { nullptr };
+                {
+                    BLE_SERIAL_TIMED_SCOPE("bluetooth.discovery.services");
+                    gattServices = WaitWithTimeout(device.GetGattServicesAsync(), timeout);
+                }
+
+                if (gattServices.Status() != GattCommunicationStatus::Success) {
+                    throw BluetoothException("GetGattServicesAsync failed");
+                }
+
+                // The session keeps the link up between operations and reports the negotiated MTU
+                auto session = WaitWithTimeout(GattSession::FromDeviceIdAsync(device.BluetoothDeviceId()), timeout);
+                session.MaintainConnection(true);
+
+                auto connection = std::make_shared<WindowsBluetoothConnection>(m_service, std::move(device), std::move(session), timeout, std::move(gattServices.Services()),
+                                                                               m_signalStrength);
+
+                // A bonded device is paired again right away when the OS lost the bond, before any operation is refused
+                if (auto bondStore = IBluetoothService::GetBondStore()) {
+                    bondStore->Resume(*this, std::max(timeout, c_minimumPairingTimeout));
+                }
+
+                return connection;
+            } WINRT_CALL_END;
+        });
     }
 
-    [[nodiscard]] std::shared_ptr<IBluetoothConnection> WindowsBluetoothDevice::OpenConnection(std::chrono::seconds timeout)
+    bool WindowsBluetoothDevice::IsPaired(std::chrono::seconds timeout)
     {
-        if (m_openConnection) {
-            if (m_openConnection->IsOpen()) {
-                return m_openConnection;
-            } else {
-                m_openConnection.reset();
-            }
-        }
+        WINRT_CALL_BEGIN {
+            auto device = WaitWithTimeout(BluetoothLEDevice::FromBluetoothAddressAsync(m_deviceAddress), timeout);
+            return device && device.DeviceInformation().Pairing().IsPaired();
+        } WINRT_CALL_END;
+    }
 
+    void WindowsBluetoothDevice::Pair(PairingProtection protection, std::chrono::seconds timeout)
+    {
         WINRT_CALL_BEGIN {
             auto device = WaitWithTimeout(BluetoothLEDevice::FromBluetoothAddressAsync(m_deviceAddress), timeout);
-            auto gattServices = WaitWithTimeout(device.GetGattServicesAsync(), timeout);
-            if (gattServices.Status() != GattCommunicationStatus::Success) {
-                throw BluetoothException("GetGattServicesAsync failed");
+            if (!device) {
+                throw BluetoothException("Device with address " + BluetoothAddressToString(m_deviceAddress) + " couldn't be found");
+            }
+
+            auto pairing = device.DeviceInformation().Pairing();
+            if (pairing.IsPaired()) {
+                return;
             }
 
-            return std::make_shared<WindowsBluetoothConnection>(std::move(device), timeout, std::move(gattServices.Services()));
+            auto level = protection == PairingProtection::EncryptionAndAuthentication ? DevicePairingProtectionLevel::EncryptionAndAuthentication : DevicePairingProtectionLevel::Encryption;
+            auto result = WaitWithTimeout(pairing.PairAsync(level), timeout);
+
+            if (result.Status() != DevicePairingResultStatus::Paired && result.Status() != DevicePairingResultStatus::AlreadyPaired) {
+                throw BluetoothException("Pairing failed with status " + std::to_string(static_cast<int32_t>(result.Status())));
+            }
         } WINRT_CALL_END;
     }
 
@@ -267,13 +497,25 @@ namespace BLE_Serial::Bluetooth
     //                                                      //
     //////////////////////////////////////////////////////////
 
-    WindowsBluetoothConnection::WindowsBluetoothConnection(BluetoothLEDevice device, std::chrono::seconds timeout, const IVectorView<GattDeviceService> &services)
-            : m_device { std::move(device) }, m_timeout { timeout }, m_services {}
+    WindowsBluetoothConnection::WindowsBluetoothConnection(WindowsBluetoothService &service, BluetoothLEDevice device, GattSession session, std::chrono::seconds timeout,
+                                                           const IVectorView<GattDeviceService> &services, int16_t signalStrength)
+            : m_service { service }, m_counted { true }, m_device { std::move(device) }, m_session { std::move(session) }, m_signalStrength { signalStrength }, m_timeout { timeout }
     {
-        m_services.reserve(services.Size());
+        std::vector<std::shared_ptr<IBluetoothGattService>> gattServices;
+        gattServices.reserve(services.Size());
 
-        for (auto service : services) {
-            m_services.emplace_back(std::make_unique<WindowsBluetoothGattService>(service, m_timeout));
+        for (auto gattService : services) {
+            gattServices.emplace_back(std::make_shared<WindowsBluetoothGattService>(m_service, m_valueCache, gattService, m_timeout));
+        }
+
+        SetServices(std::move(gattServices));
+        m_service.ConnectionOpened();
+    }
+
+    WindowsBluetoothConnection::~WindowsBluetoothConnection()
+    {
+        if (m_counted.exchange(false)) {
+            m_service.ConnectionClosed();
         }
     }
 
@@ -282,30 +524,76 @@ namespace BLE_Serial::Bluetooth
         return m_device.ConnectionStatus() == BluetoothConnectionStatus::Connected;
     }
 
-    void WindowsBluetoothConnection::Close()
+    void WindowsBluetoothConnection::CloseLink()
     {
+        if (m_counted.exchange(false)) {
+            m_service.ConnectionClosed();
+        }
+
+        std::unique_lock<std::mutex> lock { m_mutex };
+
         WINRT_CALL_BEGIN {
-            m_services.clear();
+            for (auto &[id, token] : m_statusSubscribers) {
+                m_device.ConnectionStatusChanged(token);
+            }
+
+            m_statusSubscribers.clear();
+            m_valueCache->Clear();
+            m_session.Close();
             m_device.Close();
         } WINRT_CALL_END;
     }
 
-    [[nodiscard]] std::vector<std::unique_ptr<IBluetoothGattService>> &WindowsBluetoothConnection::GetServices()
+    [[nodiscard]] std::optional<int16_t> WindowsBluetoothConnection::GetSignalStrength() const noexcept
     {
-        return m_services;
+        // WinRT doesn't report the RSSI of an established link, the advertisement the device was found with is the best estimate
+        return m_signalStrength;
     }
 
-    std::unique_ptr<IBluetoothGattService> &WindowsBluetoothConnection::GetService(BluetoothUUID uuid)
+    size_t WindowsBluetoothConnection::SubscribeStatusChanged(std::function<void(bool)> listener)
     {
-        static std::unique_ptr<IBluetoothGattService> c_nullValue {};
+        std::unique_lock<std::mutex> lock { m_mutex };
+
+        WINRT_CALL_BEGIN {
+            auto token = m_device.ConnectionStatusChanged([f = std::move(listener)](const BluetoothLEDevice &sender, const IInspectable &) {
+                f(sender.ConnectionStatus() == BluetoothConnectionStatus::Connected);
+            });
+
+            size_t id = m_nextStatusSubscriberId++;
+            m_statusSubscribers.emplace(id, token);
+
+            return id;
+        } WINRT_CALL_END;
+    }
 
-        for (auto &service : m_services) {
-            if (service->GetUUID() == uuid) {
-                return service;
+    void WindowsBluetoothConnection::UnsubscribeStatusChanged(size_t id)
+    {
+        std::unique_lock<std::mutex> lock { m_mutex };
+
+        WINRT_CALL_BEGIN {
+            auto it = m_statusSubscribers.find(id);
+            if (it == m_statusSubscribers.end()) {
+                return;
             }
+
+            m_device.ConnectionStatusChanged(it->second);
+            m_statusSubscribers.erase(it);
+        } WINRT_CALL_END;
+    }
+
+    [[nodiscard]] size_t WindowsBluetoothConnection::GetMaxWriteSize() const noexcept
+    {
+        // 3 bytes of the PDU are taken by the ATT opcode and handle, 23 is the minimal MTU of the specification
+        try {
+            return std::max<size_t>(m_session.MaxPduSize(), 23) - 3;
+        } catch (const winrt::hresult_error &ignored) {
+            return 20;
         }
+    }
 
-        return c_nullValue;
+    [[nodiscard]] GattValueCache &WindowsBluetoothConnection::GetValueCache() noexcept
+    {
+        return *m_valueCache;
     }
 
     //////////////////////////////////////////////////////////
@@ -314,8 +602,8 @@ namespace BLE_Serial::Bluetooth
     //                                                      //
     //////////////////////////////////////////////////////////
 
-    WindowsBluetoothGattService::WindowsBluetoothGattService(GattDeviceService service, std::chrono::seconds timeout)
-            : m_service(std::move(service)), m_timeout { timeout }, m_uuid { GUIDToBluetoothUUID(m_service.Uuid()) }
+    WindowsBluetoothGattService::WindowsBluetoothGattService(WindowsBluetoothService &bluetoothService, std::shared_ptr<GattValueCache> valueCache, GattDeviceService service, std::chrono::seconds timeout)
+            : m_bluetoothService(bluetoothService), m_valueCache(std::move(valueCache)), m_service(std::move(service)), m_timeout { timeout }, m_uuid { GUIDToBluetoothUUID(m_service.Uuid()) }
     {
     }
 
@@ -338,6 +626,8 @@ namespace BLE_Serial::Bluetooth
     {
         static std::unique_ptr<IBluetoothGattCharacteristic> c_nullValue {};
 
+        std::unique_lock<std::mutex> lock { m_mutex };
+
         for (auto &characteristic : m_characteristics) {
             if (characteristic->GetUUID() == uuid) {
                 return characteristic;
@@ -349,6 +639,8 @@ namespace BLE_Serial::Bluetooth
 
     void WindowsBluetoothGattService::FetchCharacteristics()
     {
+        BLE_SERIAL_TIMED_SCOPE("bluetooth.discovery.characteristics");
+
         WINRT_CALL_BEGIN {
             auto characteristics = WaitWithTimeout(m_service.GetCharacteristicsAsync(BluetoothCacheMode::Uncached), m_timeout);
 
@@ -356,9 +648,16 @@ namespace BLE_Serial::Bluetooth
                 throw BluetoothException("Failed to fetch characteristics");
             }
 
-            m_characteristics.clear();
+            std::unique_lock<std::mutex> lock { m_mutex };
+
             for (auto characteristic : characteristics.Characteristics()) {
-                m_characteristics.emplace_back(std::make_unique<WindowsBluetoothGattCharacteristic>(std::move(characteristic), m_timeout));
+                auto uuid = GUIDToBluetoothUUID(characteristic.Uuid());
+                if (std::any_of(m_characteristics.begin(), m_characteristics.end(), [&uuid](const auto &current) { return current->GetUUID() == uuid; })) {
+                    // Keep the already known instance, so that pointers to it stay valid
+                    continue;
+                }
+
+                m_characteristics.emplace_back(std::make_unique<WindowsBluetoothGattCharacteristic>(m_bluetoothService, m_valueCache, std::move(characteristic), m_timeout));
             }
         } WINRT_CALL_END;
     }
@@ -369,8 +668,26 @@ namespace BLE_Serial::Bluetooth
     //                                                      //
     //////////////////////////////////////////////////////////
 
-    WindowsBluetoothGattCharacteristic::WindowsBluetoothGattCharacteristic(GattCharacteristic characteristic, std::chrono::seconds timeout)
-            : m_characteristic(std::move(characteristic)), m_timeout { timeout }, m_uuid { GUIDToBluetoothUUID(m_characteristic.Uuid()) }
+    template<typename Operation>
+    auto WindowsBluetoothGattCharacteristic::WithBond(Operation &&operation)
+    {
+        try {
+            return operation();
+        } catch (const BluetoothSecurityException &) {
+            auto bondStore = IBluetoothService::GetBondStore();
+            if (!bondStore) {
+                throw;
+            }
+
+            WindowsBluetoothDevice device { m_service, m_characteristic.Service().Device().BluetoothAddress(), {}, 0 };
+            bondStore->Pair(device, PairingProtection::Encryption, std::max(m_timeout, c_minimumPairingTimeout));
+        }
+
+        return operation();
+    }
+
+    WindowsBluetoothGattCharacteristic::WindowsBluetoothGattCharacteristic(WindowsBluetoothService &service, std::shared_ptr<GattValueCache> valueCache, GattCharacteristic characteristic, std::chrono::seconds timeout)
+            : m_service(service), m_valueCache(std::move(valueCache)), m_characteristic(std::move(characteristic)), m_timeout { timeout }, m_uuid { GUIDToBluetoothUUID(m_characteristic.Uuid()) }
     {
     }
 
@@ -384,89 +701,207 @@ namespace BLE_Serial::Bluetooth
         return static_cast<GattRegisteredCharacteristic>(m_uuid.custom);
     }
 
-    std::vector<uint8_t> WindowsBluetoothGattCharacteristic::Read()
+    [[nodiscard]] GattCharacteristicProperty WindowsBluetoothGattCharacteristic::GetProperties() const
+    {
+        // GattCharacteristicProperties uses the bit values from the specification
+        return static_cast<GattCharacteristicProperty>(static_cast<uint32_t>(m_characteristic.CharacteristicProperties()) & 0xFF);
+    }
+
+    [[nodiscard]] uint16_t WindowsBluetoothGattCharacteristic::GetHandle() const
+    {
+        return m_characteristic.AttributeHandle();
+    }
+
+    std::vector<GattPresentationFormat> WindowsBluetoothGattCharacteristic::GetPresentationFormats() const
     {
         WINRT_CALL_BEGIN {
-            auto result = WaitWithTimeout(m_characteristic.ReadValueAsync(), m_timeout);
+            // Read together with the characteristic, so this does not go over the air
+            std::vector<GattPresentationFormat> formats;
+            for (const auto &format : m_characteristic.PresentationFormats()) {
+                formats.push_back(GattPresentationFormat {
+                        .format = format.FormatType(),
+                        .exponent = static_cast<int8_t>(format.Exponent()),
+                        .unit = format.Unit(),
+                        .nameSpace = format.Namespace(),
+                        .description = format.Description()
+                });
+            }
+
+            return formats;
+        } WINRT_CALL_END;
+    }
 
-            if (result.Status() != GattCommunicationStatus::Success) {
-                throw BluetoothException("Failed to read value");
+    std::future<std::vector<uint8_t>> WindowsBluetoothGattCharacteristic::ReadAsync(GattReadMode mode)
+    {
+        auto promise = std::make_shared<std::promise<std::vector<uint8_t>>>();
+        auto future = promise->get_future();
+
+        if (mode == GattReadMode::Cached) {
+            if (auto cached = m_valueCache->Lookup(GetHandle())) {
+                promise->set_value(std::move(*cached));
+                return future;
             }
+        }
+
+        WINRT_CALL_BEGIN {
+            auto operation = m_characteristic.ReadValueAsync(BluetoothCacheMode::Uncached);
+
+            // The read may finish after the characteristic and its connection are gone, so the handler holds none of
+            // them. The service lives as long as the process.
+            std::weak_ptr<GattValueCache> valueCache = m_valueCache;
+            operation.Completed([&service = m_service, valueCache, handle = GetHandle(), promise](const IAsyncOperation<GattReadResult> &asyncInfo, AsyncStatus asyncStatus) {
+                try {
+                    if (asyncStatus != AsyncStatus::Completed) {
+                        throw BluetoothException("Failed to read value");
+                    }
+
+                    auto result = asyncInfo.GetResults();
+                    CheckStatus(result.Status(), result.ProtocolError(), "Failed to read value");
+
+                    auto value = result.Value();
+                    std::vector<uint8_t> data { value.data(), value.data() + value.Length() };
+                    BLE_SERIAL_COUNT("bluetooth.read.bytes", data.size());
+                    service.BytesTransferred(data.size());
+                    if (auto cache = valueCache.lock()) {
+                        cache->Store(handle, data);
+                    }
+
+                    promise->set_value(std::move(data));
+                } catch (const BluetoothException &) {
+                    promise->set_exception(std::current_exception());
+                } catch (const winrt::hresult_error &err) {
+                    promise->set_exception(std::make_exception_ptr(BluetoothException("Bluetooth error. Code: " + std::to_string(err.code()))));
+                }
+            });
+        } WINRT_CALL_END;
+
+        return future;
+    }
+
+    std::vector<uint8_t> WindowsBluetoothGattCharacteristic::Read(GattReadMode mode)
+    {
+        if (mode == GattReadMode::Cached) {
+            if (auto cached = m_valueCache->Lookup(GetHandle())) {
+                return std::move(*cached);
+            }
+        }
+
+        BLE_SERIAL_TIMED_SCOPE("bluetooth.read");
+
+        WINRT_CALL_BEGIN {
+            auto result = WithBond([this, mode]() {
+                // The cache of the system keeps the last value read or notified, however old it is
+                auto cacheMode = mode == GattReadMode::Cached ? BluetoothCacheMode::Cached : BluetoothCacheMode::Uncached;
+                auto result = WaitWithTimeout(m_characteristic.ReadValueAsync(cacheMode), m_timeout);
+                CheckStatus(result.Status(), result.ProtocolError(), "Failed to read value");
+                return result;
+            });
 
             auto value = result.Value();
             std::vector<uint8_t> data;
             data.reserve(value.Length());
             data.insert(std::end(data), value.data(), value.data() + value.Length());
+            BLE_SERIAL_COUNT("bluetooth.read.bytes", data.size());
+            m_service.BytesTransferred(data.size());
+            m_valueCache->Store(GetHandle(), data);
 
             return data;
         } WINRT_CALL_END;
     }
 
-    void WindowsBluetoothGattCharacteristic::Write(const std::vector<uint8_t> &data)
+    void WindowsBluetoothGattCharacteristic::Write(const std::vector<uint8_t> &data, GattWriteMode mode)
     {
+        BLE_SERIAL_TIMED_SCOPE("bluetooth.write");
+
+        // Invalidated on both sides of the write, a read finishing meanwhile may have stored the old value again
+        m_valueCache->Invalidate(GetHandle());
+
         WINRT_CALL_BEGIN {
-            winrt::Windows::Storage::Streams::DataWriter writer;
-            writer.WriteBytes(data);
+            auto option = mode == GattWriteMode::WithoutResponse ? GattWriteOption::WriteWithoutResponse : GattWriteOption::WriteWithResponse;
 
-            auto result = WaitWithTimeout(m_characteristic.WriteValueAsync(writer.DetachBuffer()), m_timeout);
+            WithBond([this, &data, option]() {
+                winrt::Windows::Storage::Streams::DataWriter writer;
+                writer.WriteBytes(data);
 
-            if (result != GattCommunicationStatus::Success) {
-                throw BluetoothException("Failed to write value");
-            }
+                auto result = WaitWithTimeout(m_characteristic.WriteValueWithResultAsync(writer.DetachBuffer(), option), m_timeout);
+                CheckStatus(result.Status(), result.ProtocolError(), "Failed to write value");
+            });
+
+            BLE_SERIAL_COUNT("bluetooth.write.bytes", data.size());
+            m_service.BytesTransferred(data.size());
+            m_valueCache->Invalidate(GetHandle());
         } WINRT_CALL_END;
     }
 
     size_t WindowsBluetoothGattCharacteristic::Subscribe(std::function<void(std::vector<uint8_t>)> listener)
     {
-        WINRT_CALL_BEGIN {
-            if (m_subscribers.empty()) {
-                auto result = WaitWithTimeout(m_characteristic.WriteClientCharacteristicConfigurationDescriptorAsync(GattClientCharacteristicConfigurationDescriptorValue::Notify), m_timeout);
+        std::unique_lock<std::mutex> lock { m_mutex };
 
-                if (result != GattCommunicationStatus::Success) {
-                    throw BluetoothException("Failed to write characteristic configuration");
-                }
+        WINRT_CALL_BEGIN {
+            if (!m_valueChanged) {
+                BLE_SERIAL_TIMED_SCOPE("bluetooth.cccd_write");
+                WithBond([this]() {
+                    auto result = WaitWithTimeout(m_characteristic.WriteClientCharacteristicConfigurationDescriptorWithResultAsync(GattClientCharacteristicConfigurationDescriptorValue::Notify),
+                                                  m_timeout);
+                    CheckStatus(result.Status(), result.ProtocolError(), "Failed to write characteristic configuration");
+                });
+
+                // Revoking the handler does not wait for a call already running on a pool thread, so the handler holds
+                // nothing of this characteristic and the removal of a listener waits for its calls instead
+                m_valueChanged = m_characteristic.ValueChanged([&service = m_service, valueCache = m_valueCache, listeners = m_listeners](const GattCharacteristic &sender, const GattValueChangedEventArgs &args) {
+                    auto value = args.CharacteristicValue();
+                    std::vector<uint8_t> vec;
+                    vec.reserve(value.Length());
+                    vec.insert(std::end(vec), value.data(), value.data() + value.Length());
+                    BLE_SERIAL_COUNT("bluetooth.notification.bytes", vec.size());
+                    service.BytesTransferred(vec.size());
+                    valueCache->Store(sender.AttributeHandle(), vec);
+
+                    listeners->Dispatch(vec);
+                });
             }
 
-            auto token = m_characteristic.ValueChanged([f = std::move(listener)](const GattCharacteristic &sender, const GattValueChangedEventArgs &args) {
-                auto value = args.CharacteristicValue();
-                std::vector<uint8_t> vec;
-                vec.reserve(value.Length());
-                vec.insert(std::end(vec), value.data(), value.data() + value.Length());
-
-                f(std::move(vec));
-            });
-
-            m_subscribers.push_back(token);
-
-            return m_subscribers.size() - 1;
+            return m_listeners->Add(std::move(listener));
         } WINRT_CALL_END;
     }
 
     void WindowsBluetoothGattCharacteristic::Unsubscribe(size_t id)
     {
+        // Waits for the calls of the listener without holding the lock, a listener may subscribe or unsubscribe itself
+        m_listeners->Remove(id);
+
+        std::unique_lock<std::mutex> lock { m_mutex };
+
         WINRT_CALL_BEGIN {
-            m_characteristic.ValueChanged(m_subscribers[id]);
-            m_subscribers.erase(m_subscribers.begin() + id);
+            if (!m_valueChanged || !m_listeners->Empty()) {
+                return;
+            }
 
-            if (m_subscribers.empty()) {
-                auto result = WaitWithTimeout(m_characteristic.WriteClientCharacteristicConfigurationDescriptorAsync(GattClientCharacteristicConfigurationDescriptorValue::None), m_timeout);
+            m_characteristic.ValueChanged(m_valueChanged);
+            m_valueChanged = {};
 
-                if (result != GattCommunicationStatus::Success) {
-                    throw BluetoothException("Failed to write characteristic configuration");
-                }
+            BLE_SERIAL_TIMED_SCOPE("bluetooth.cccd_write");
+            auto result = WaitWithTimeout(m_characteristic.WriteClientCharacteristicConfigurationDescriptorAsync(GattClientCharacteristicConfigurationDescriptorValue::None), m_timeout);
+
+            if (result != GattCommunicationStatus::Success) {
+                throw BluetoothException("Failed to write characteristic configuration");
             }
         } WINRT_CALL_END;
     }
 
     void WindowsBluetoothGattCharacteristic::UnsubscribeAll()
     {
+        m_listeners->Clear();
+
+        std::unique_lock<std::mutex> lock { m_mutex };
+
         WINRT_CALL_BEGIN {
-            for (auto &subscriber : m_subscribers) {
-                m_characteristic.ValueChanged(subscriber);
+            if (m_valueChanged) {
+                m_characteristic.ValueChanged(m_valueChanged);
+                m_valueChanged = {};
             }
 
-            m_subscribers.clear();
-
+            BLE_SERIAL_TIMED_SCOPE("bluetooth.cccd_write");
             auto result = WaitWithTimeout(m_characteristic.WriteClientCharacteristicConfigurationDescriptorAsync(GattClientCharacteristicConfigurationDescriptorValue::None), m_timeout);
 
             if (result != GattCommunicationStatus::Success) {
@@ -481,9 +916,54 @@ namespace BLE_Serial::Bluetooth
     //                                                      //
     //////////////////////////////////////////////////////////
 
+    std::vector<BluetoothAdapterInfo> GetPlatformBluetoothAdapters()
+    {
+        WINRT_CALL_BEGIN {
+            std::vector<BluetoothAdapterInfo> result;
+
+            auto defaultAdapter = WaitWithTimeout(BluetoothAdapter::GetDefaultAsync(), DefaultTimeout);
+            auto defaultId = defaultAdapter ? defaultAdapter.DeviceId() : winrt::hstring {};
+            auto devices = WaitWithTimeout(DeviceInformation::FindAllAsync(BluetoothAdapter::GetDeviceSelector()), DefaultTimeout);
+
+            for (auto info : devices) {
+                auto adapter = WaitWithTimeout(BluetoothAdapter::FromIdAsync(info.Id()), DefaultTimeout);
+                if (!adapter || !adapter.IsLowEnergySupported()) {
+                    continue;
+                }
+
+                result.push_back(BluetoothAdapterInfo {
+                        .id = g_wideStringToUtf8.to_bytes(std::wstring { info.Id() }),
+                        .address = adapter.BluetoothAddress(),
+                        .name = std::wstring { info.Name() },
+                        .isDefault = info.Id() == defaultId
+                });
+            }
+
+            return result;
+        } WINRT_CALL_END;
+    }
+
     IBluetoothService &GetPlatformLocalBluetoothService()
     {
-        static WindowsBluetoothService c_service;
+        static WindowsBluetoothService c_service {};
         return c_service;
     }
+
+    IBluetoothService &GetPlatformBluetoothService(const std::string &adapterId)
+    {
+        if (adapterId.empty()) {
+            return GetPlatformLocalBluetoothService();
+        }
+
+        auto adapters = GetPlatformBluetoothAdapters();
+        auto adapter = std::find_if(adapters.begin(), adapters.end(), [&adapterId](const auto &current) { return current.id == adapterId; });
+        if (adapter == adapters.end()) {
+            throw BluetoothException("Bluetooth adapter " + adapterId + " couldn't be found");
+        }
+
+        // WinRT always connects through the default radio and offers no way to pin a connection to another one, so
+        // every adapter is served by the local service; a service per adapter would only count connections the
+        // default radio actually carries and overstate the capacity
+        return GetPlatformLocalBluetoothService();
+    }
 }
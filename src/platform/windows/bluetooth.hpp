@@ -2,7 +2,13 @@
 #define BLE_SERIAL_SRC_PLATFORM_WINDOWS_BLUETOOTH_HPP_
 
 #include <ble_serial/bluetooth.hpp>
+#include <ble_serial/bond_store.hpp>
+#include <ble_serial/listeners.hpp>
 
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <utility>
 #include <vector>
@@ -39,7 +45,10 @@ namespace BLE_Serial::Bluetooth
     {
     private:
         template<typename Notify>
-        static BluetoothLEAdvertisementWatcher CreateDeviceWatcher(Notify &&notify);
+        BluetoothLEAdvertisementWatcher CreateAdvertisementWatcher(Notify &&notify);
+
+        template<typename Notify>
+        BluetoothLEAdvertisementWatcher CreateDeviceWatcher(Notify &&notify);
 
     public:
         void Initialize() override;
@@ -53,6 +62,38 @@ namespace BLE_Serial::Bluetooth
         void ScanDevices(std::vector<std::unique_ptr<IBluetoothDevice>> &output, std::chrono::seconds timeout) override;
 
         std::optional<std::unique_ptr<IBluetoothDevice>> FindDevice(BluetoothAddress address, std::chrono::seconds timelimit) override;
+
+        void WatchAdvertisements(const std::function<void(const BluetoothAdvertisement &)> &listener, const std::atomic_bool &stop) override;
+
+        [[nodiscard]] const std::string &GetAdapterId() const noexcept override;
+
+        [[nodiscard]] size_t GetActiveConnectionCount() const noexcept override;
+
+        [[nodiscard]] uint64_t GetTransferredBytes() const noexcept override;
+
+        [[nodiscard]] size_t GetMaxConnectionCount() const noexcept override;
+
+        void SetMaxConnectionCount(size_t count) noexcept override;
+
+        /**
+         * Called by connections opened through this service.
+         */
+        void ConnectionOpened() noexcept;
+
+        /**
+         * Called by connections opened through this service.
+         */
+        void ConnectionClosed() noexcept;
+
+        /**
+         * Called by characteristics every time data goes over the air.
+         */
+        void BytesTransferred(size_t count) noexcept;
+
+    private:
+        std::atomic<size_t> m_activeConnections { 0 };
+        std::atomic<uint64_t> m_transferredBytes { 0 };
+        std::atomic<size_t> m_maxConnections { 7 };
     };
 
 
@@ -62,42 +103,67 @@ namespace BLE_Serial::Bluetooth
     class WindowsBluetoothDevice : public IBluetoothDevice
     {
     public:
-        WindowsBluetoothDevice(BluetoothAddress deviceAddress, std::wstring deviceName);
+        WindowsBluetoothDevice(WindowsBluetoothService &service, BluetoothAddress deviceAddress, std::wstring deviceName, int16_t signalStrength);
 
         [[nodiscard]] BluetoothAddress GetDeviceAddress() const noexcept override;
 
         [[nodiscard]] const std::wstring &GetDeviceName() const noexcept override;
 
+        [[nodiscard]] int16_t GetSignalStrength() const noexcept override;
+
         [[nodiscard]] std::optional<std::shared_ptr<IBluetoothConnection>> GetOpenConnection() const noexcept override;
 
         [[nodiscard]] std::shared_ptr<IBluetoothConnection> OpenConnection(std::chrono::seconds timeout) override;
 
+        [[nodiscard]] bool IsPaired(std::chrono::seconds timeout) override;
+
+        void Pair(PairingProtection protection, std::chrono::seconds timeout) override;
+
     private:
+        WindowsBluetoothService &m_service;
         BluetoothAddress m_deviceAddress;
         std::wstring m_deviceName;
-        std::shared_ptr<WindowsBluetoothConnection> m_openConnection;
+        int16_t m_signalStrength;
+        SharedConnectionSlot m_connection {};
     };
 
     /**
      * IBluetoothConnection implementation using the Windows BLE API.
      */
-    class WindowsBluetoothConnection : public IBluetoothConnection
+    class WindowsBluetoothConnection : public SharedBluetoothConnection
     {
     public:
-        WindowsBluetoothConnection(BluetoothLEDevice device, std::chrono::seconds timeout, const IVectorView<GattDeviceService> &services);
+        WindowsBluetoothConnection(WindowsBluetoothService &service, BluetoothLEDevice device, GattSession session, std::chrono::seconds timeout, const IVectorView<GattDeviceService> &services,
+                                   int16_t signalStrength);
+
+        ~WindowsBluetoothConnection();
 
         [[nodiscard]] bool IsOpen() const noexcept override;
 
-        void Close() override;
+        [[nodiscard]] std::optional<int16_t> GetSignalStrength() const noexcept override;
+
+        size_t SubscribeStatusChanged(std::function<void(bool)> listener) override;
 
-        [[nodiscard]] std::vector<std::unique_ptr<IBluetoothGattService>> &GetServices() override;
+        void UnsubscribeStatusChanged(size_t id) override;
 
-        std::unique_ptr<IBluetoothGattService> &GetService(BluetoothUUID uuid) override;
+        [[nodiscard]] size_t GetMaxWriteSize() const noexcept override;
+
+        [[nodiscard]] GattValueCache &GetValueCache() noexcept override;
+
+    protected:
+        void CloseLink() override;
 
     private:
+        WindowsBluetoothService &m_service;
+        std::atomic<bool> m_counted;
         std::chrono::seconds m_timeout;
+        std::mutex m_mutex {};
         BluetoothLEDevice m_device;
-        std::vector<std::unique_ptr<IBluetoothGattService>> m_services;
+        GattSession m_session;
+        int16_t m_signalStrength;
+        size_t m_nextStatusSubscriberId = 0;
+        std::map<size_t, winrt::event_token> m_statusSubscribers {};
+        std::shared_ptr<GattValueCache> m_valueCache { std::make_shared<GattValueCache>() };  ///< shared with the reads still in flight
     };
 
     /**
@@ -106,7 +172,7 @@ namespace BLE_Serial::Bluetooth
     class WindowsBluetoothGattService : public IBluetoothGattService
     {
     public:
-        WindowsBluetoothGattService(GattDeviceService service, std::chrono::seconds timeout);
+        WindowsBluetoothGattService(WindowsBluetoothService &bluetoothService, std::shared_ptr<GattValueCache> valueCache, GattDeviceService service, std::chrono::seconds timeout);
 
         [[nodiscard]] BluetoothUUID GetUUID() const override;
 
@@ -119,9 +185,12 @@ namespace BLE_Serial::Bluetooth
         void FetchCharacteristics() override;
 
     private:
+        WindowsBluetoothService &m_bluetoothService;
+        std::shared_ptr<GattValueCache> m_valueCache;
         GattDeviceService m_service;
         std::chrono::seconds m_timeout;
         BluetoothUUID m_uuid;
+        std::mutex m_mutex {};
         std::vector<std::unique_ptr<IBluetoothGattCharacteristic>> m_characteristics {};
     };
 
@@ -131,15 +200,29 @@ namespace BLE_Serial::Bluetooth
     class WindowsBluetoothGattCharacteristic : public IBluetoothGattCharacteristic
     {
     public:
-        WindowsBluetoothGattCharacteristic(GattCharacteristic characteristic, std::chrono::seconds timeout);
+        WindowsBluetoothGattCharacteristic(WindowsBluetoothService &service, std::shared_ptr<GattValueCache> valueCache, GattCharacteristic characteristic, std::chrono::seconds timeout);
 
         [[nodiscard]] BluetoothUUID GetUUID() const override;
 
         [[nodiscard]] GattRegisteredCharacteristic GetRegisteredCharacteristicType() const override;
 
-        std::vector<uint8_t> Read() override;
+        [[nodiscard]] GattCharacteristicProperty GetProperties() const override;
+
+        [[nodiscard]] uint16_t GetHandle() const override;
+
+        [[nodiscard]] std::vector<GattPresentationFormat> GetPresentationFormats() const override;
+
+        using IBluetoothGattCharacteristic::Read;
+
+        std::vector<uint8_t> Read(GattReadMode mode) override;
+
+        using IBluetoothGattCharacteristic::ReadAsync;
+
+        std::future<std::vector<uint8_t>> ReadAsync(GattReadMode mode) override;
+
+        using IBluetoothGattCharacteristic::Write;
 
-        void Write(const std::vector<uint8_t> &data) override;
+        void Write(const std::vector<uint8_t> &data, GattWriteMode mode) override;
 
         size_t Subscribe(std::function<void(std::vector<uint8_t>)> listener) override;
 
@@ -148,10 +231,20 @@ namespace BLE_Serial::Bluetooth
         void UnsubscribeAll() override;
 
     private:
+        /**
+         * Runs an operation, pairing and retrying it once when the device refuses it on an unpaired link
+         */
+        template<typename Operation>
+        auto WithBond(Operation &&operation);
+
+        WindowsBluetoothService &m_service;
+        std::shared_ptr<GattValueCache> m_valueCache;
         GattCharacteristic m_characteristic;
         std::chrono::seconds m_timeout;
         BluetoothUUID m_uuid;
-        std::vector<winrt::event_token> m_subscribers;
+        std::mutex m_mutex {};
+        std::shared_ptr<IO::ListenerSet> m_listeners { std::make_shared<IO::ListenerSet>() };  ///< shared with the ValueChanged handler
+        winrt::event_token m_valueChanged {};                                                    ///< handler calling the listeners, set while notifying
     };
 
 }
@@ -1,4 +1,5 @@
 #include <ble_serial/com.hpp>
+#include <ble_serial/instrumentation.hpp>
 
 #include <windows.h>
 #include <string>
@@ -79,8 +80,11 @@ namespace BLE_Serial::COM
         }
     }
 
-    size_t COMPort::Write(std::vector<uint8_t> data)
+    size_t COMPort::Write(const std::vector<uint8_t> &data)
     {
+        BLE_SERIAL_TIMED_SCOPE("com.write");
+        std::unique_lock<std::mutex> lock { m_writeMutex };
+
         DWORD written;
         WriteFile(m_handle, data.data(), data.size(), &written, nullptr);
 
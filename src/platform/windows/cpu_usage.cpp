@@ -0,0 +1,75 @@
+#include <ble_serial/cpu_usage.hpp>
+
+#include <windows.h>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#include <intrin.h>
+#define BLE_SERIAL_CYCLE_TIME
+#endif
+
+namespace BLE_Serial::Bridge
+{
+    namespace
+    {
+        /**
+         * Helper returning the user and kernel time of the thread, only updated on every clock tick (15.6 ms by default)
+         */
+        std::chrono::nanoseconds TickedThreadTime() noexcept
+        {
+            FILETIME creation, exit, kernel, user;
+            if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user)) {
+                return std::chrono::nanoseconds { 0 };
+            }
+
+            // Both times are in 100 ns units
+            auto ticks = (static_cast<uint64_t>(kernel.dwHighDateTime) << 32 | kernel.dwLowDateTime) + (static_cast<uint64_t>(user.dwHighDateTime) << 32 | user.dwLowDateTime);
+            return std::chrono::nanoseconds { static_cast<int64_t>(ticks * 100) };
+        }
+
+#ifdef BLE_SERIAL_CYCLE_TIME
+        /**
+         * Helper measuring the rate of the time stamp counter the thread cycle times are counted in, once per process
+         */
+        double CyclesPerNanosecond() noexcept
+        {
+            static const double c_rate = []() {
+                LARGE_INTEGER frequency, start, end;
+                if (!QueryPerformanceFrequency(&frequency) || !QueryPerformanceCounter(&start)) {
+                    return 0.0;
+                }
+
+                uint64_t startCycles = __rdtsc();
+                Sleep(10);
+                QueryPerformanceCounter(&end);
+                uint64_t cycles = __rdtsc() - startCycles;
+
+                double elapsed = static_cast<double>(end.QuadPart - start.QuadPart) * 1e9 / static_cast<double>(frequency.QuadPart);
+                return elapsed > 0 ? static_cast<double>(cycles) / elapsed : 0.0;
+            }();
+
+            return c_rate;
+        }
+#endif
+    }
+
+    std::chrono::nanoseconds CpuUsage::ThreadTime() noexcept
+    {
+#ifdef BLE_SERIAL_CYCLE_TIME
+        // The cycle time is exact, where the thread times would miss most callbacks shorter than a clock tick
+        ULONG64 cycles = 0;
+        double rate = CyclesPerNanosecond();
+        if (rate > 0 && QueryThreadCycleTime(GetCurrentThread(), &cycles)) {
+            return std::chrono::nanoseconds { static_cast<int64_t>(static_cast<double>(cycles) / rate) };
+        }
+#endif
+
+        return TickedThreadTime();
+    }
+
+    void CpuUsage::Calibrate() noexcept
+    {
+#ifdef BLE_SERIAL_CYCLE_TIME
+        (void) CyclesPerNanosecond();
+#endif
+    }
+}
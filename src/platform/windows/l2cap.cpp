@@ -0,0 +1,44 @@
+#include <ble_serial/l2cap.hpp>
+
+namespace BLE_Serial::Bluetooth
+{
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // L2CAPChannel implementation                          //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    // WinRT only exposes GATT for LE devices, connection-oriented channels are not reachable from user mode
+
+    std::unique_ptr<L2CAPChannel> L2CAPChannel::Connect(BluetoothAddress, uint16_t, std::chrono::seconds, L2CAPChannelOptions)
+    {
+        throw BluetoothException("L2CAP channels are not supported on Windows");
+    }
+
+    L2CAPChannel::L2CAPChannel(intptr_t socket, L2CAPChannelOptions options)
+            : m_socket { socket }, m_options { options }, m_maxSduSize { options.mtu }
+    {
+        throw BluetoothException("L2CAP channels are not supported on Windows");
+    }
+
+    L2CAPChannel::~L2CAPChannel()
+    {
+        UnsubscribeAll();
+        Close();
+    }
+
+    void L2CAPChannel::Send(const std::vector<uint8_t> &)
+    {
+        throw BluetoothException("The L2CAP channel is closed");
+    }
+
+    bool L2CAPChannel::Receive(std::vector<uint8_t> &, std::chrono::milliseconds)
+    {
+        return false;
+    }
+
+    void L2CAPChannel::Close()
+    {
+        m_open.store(false);
+    }
+}
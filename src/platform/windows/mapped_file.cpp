@@ -0,0 +1,120 @@
+#include <ble_serial/mapped_file.hpp>
+
+#include <windows.h>
+
+namespace BLE_Serial::IO
+{
+    namespace
+    {
+        /**
+         * Helper for mapping an already opened file, the handles are closed because the view keeps the mapping alive
+         */
+        uint8_t *MapHandle(HANDLE file, size_t size, bool writable, const std::string &path)
+        {
+            HANDLE mapping = CreateFileMappingA(file, nullptr, writable ? PAGE_READWRITE : PAGE_READONLY,
+                                                static_cast<DWORD>(static_cast<uint64_t>(size) >> 32), static_cast<DWORD>(size & 0xFFFFFFFF), nullptr);
+            if (mapping == nullptr) {
+                CloseHandle(file);
+                throw IOException("CreateFileMapping failed for " + path + " with error " + std::to_string(GetLastError()));
+            }
+
+            void *view = MapViewOfFile(mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, size);
+            DWORD error = GetLastError();
+
+            CloseHandle(mapping);
+            CloseHandle(file);
+
+            if (view == nullptr) {
+                throw IOException("MapViewOfFile failed for " + path + " with error " + std::to_string(error));
+            }
+
+            return static_cast<uint8_t *>(view);
+        }
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // MappedFile implementation                            //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    MappedFile MappedFile::OpenReadOnly(const std::string &path)
+    {
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            throw IOException("Failed to open " + path);
+        }
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+            CloseHandle(file);
+            throw IOException("Cannot map empty file " + path);
+        }
+
+        MappedFile result;
+        result.m_path = path;
+        result.m_size = static_cast<size_t>(size.QuadPart);
+        result.m_data = MapHandle(file, result.m_size, false, path);
+        return result;
+    }
+
+    MappedFile MappedFile::Create(const std::string &path, size_t size)
+    {
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            throw IOException("Failed to create " + path);
+        }
+
+        MappedFile result;
+        result.m_path = path;
+        result.m_size = size;
+        result.m_data = MapHandle(file, size, true, path);
+        return result;
+    }
+
+    void MappedFile::Close() noexcept
+    {
+        if (m_data != nullptr) {
+            UnmapViewOfFile(m_data);
+            m_data = nullptr;
+            m_size = 0;
+        }
+    }
+
+    void MappedFile::Remove(const std::string &path) noexcept
+    {
+        DeleteFileA(path.c_str());
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // FileLock implementation                              //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    FileLock::FileLock(const std::string &path)
+    {
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            throw IOException("Failed to open " + path);
+        }
+
+        OVERLAPPED overlapped {};
+        if (!LockFileEx(file, LOCKFILE_EXCLUSIVE_LOCK, 0, MAXDWORD, MAXDWORD, &overlapped)) {
+            DWORD error = GetLastError();
+            CloseHandle(file);
+            throw IOException("Failed to lock " + path + " with error " + std::to_string(error));
+        }
+
+        m_handle = reinterpret_cast<intptr_t>(file);
+    }
+
+    FileLock::~FileLock()
+    {
+        auto file = reinterpret_cast<HANDLE>(m_handle);
+
+        OVERLAPPED overlapped {};
+        UnlockFileEx(file, 0, MAXDWORD, MAXDWORD, &overlapped);
+        CloseHandle(file);
+    }
+}
@@ -0,0 +1,259 @@
+#include <ble_serial/socket.hpp>
+
+#include <algorithm>
+#include <climits>
+#include <string>
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+
+#include <winsock2.h>
+#include <ws2tcpip.h>
+
+namespace BLE_Serial::IO
+{
+    namespace
+    {
+        /**
+         * Winsock has to be initialized once per process before any socket is created
+         */
+        void EnsureWinsock()
+        {
+            static const int c_startupResult = []() {
+                WSADATA data;
+                return WSAStartup(MAKEWORD(2, 2), &data);
+            }();
+
+            if (c_startupResult != 0) {
+                throw IOException("WSAStartup failed with error " + std::to_string(c_startupResult));
+            }
+        }
+
+        int PollSocket(SOCKET socket, short events, std::chrono::milliseconds timeout) noexcept
+        {
+            WSAPOLLFD descriptor { socket, events, 0 };
+            int result = WSAPoll(&descriptor, 1, static_cast<INT>(timeout.count()));
+            return result <= 0 ? result : descriptor.revents;
+        }
+
+        std::string AddressToString(const sockaddr_storage &address)
+        {
+            char host[INET6_ADDRSTRLEN] = {};
+            uint16_t port = 0;
+
+            if (address.ss_family == AF_INET) {
+                auto &ipv4 = reinterpret_cast<const sockaddr_in &>(address);
+                inet_ntop(AF_INET, &ipv4.sin_addr, host, sizeof(host));
+                port = ntohs(ipv4.sin_port);
+            } else if (address.ss_family == AF_INET6) {
+                auto &ipv6 = reinterpret_cast<const sockaddr_in6 &>(address);
+                inet_ntop(AF_INET6, &ipv6.sin6_addr, host, sizeof(host));
+                port = ntohs(ipv6.sin6_port);
+            }
+
+            return std::string { host } + ":" + std::to_string(port);
+        }
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // TcpStream implementation                             //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    std::unique_ptr<TcpStream> TcpStream::Connect(const std::string &host, uint16_t port, std::chrono::milliseconds timeout)
+    {
+        EnsureWinsock();
+
+        addrinfo hints {};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+
+        addrinfo *addresses = nullptr;
+        if (int error = getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &addresses); error != 0) {
+            throw IOException("Failed to resolve " + host + ": error " + std::to_string(error));
+        }
+
+        std::string lastError = "no address";
+
+        for (auto address = addresses; address != nullptr; address = address->ai_next) {
+            SOCKET socket = ::socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+            if (socket == INVALID_SOCKET) {
+                lastError = "error " + std::to_string(WSAGetLastError());
+                continue;
+            }
+
+            u_long nonBlocking = 1;
+            ioctlsocket(socket, FIONBIO, &nonBlocking);
+
+            if (connect(socket, address->ai_addr, static_cast<int>(address->ai_addrlen)) != 0 && WSAGetLastError() != WSAEWOULDBLOCK) {
+                lastError = "error " + std::to_string(WSAGetLastError());
+                closesocket(socket);
+                continue;
+            }
+
+            int events = PollSocket(socket, POLLOUT, timeout);
+            int error = 0;
+            int length = sizeof(error);
+
+            if (events <= 0 || getsockopt(socket, SOL_SOCKET, SO_ERROR, reinterpret_cast<char *>(&error), &length) != 0 || error != 0) {
+                lastError = events == 0 ? "timed out" : "error " + std::to_string(error != 0 ? error : WSAGetLastError());
+                closesocket(socket);
+                continue;
+            }
+
+            freeaddrinfo(addresses);
+            return std::make_unique<TcpStream>(static_cast<intptr_t>(socket));
+        }
+
+        freeaddrinfo(addresses);
+        throw IOException("Failed to connect to " + host + ":" + std::to_string(port) + ": " + lastError);
+    }
+
+    TcpStream::TcpStream(intptr_t socket)
+            : m_socket { socket }
+    {
+        auto handle = static_cast<SOCKET>(m_socket);
+
+        u_long nonBlocking = 1;
+        ioctlsocket(handle, FIONBIO, &nonBlocking);
+
+        BOOL noDelay = TRUE;
+        setsockopt(handle, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char *>(&noDelay), sizeof(noDelay));
+
+        sockaddr_storage peer {};
+        int length = sizeof(peer);
+        if (getpeername(handle, reinterpret_cast<sockaddr *>(&peer), &length) == 0) {
+            m_peerName = AddressToString(peer);
+        }
+    }
+
+    TcpStream::~TcpStream()
+    {
+        Close();
+        closesocket(static_cast<SOCKET>(m_socket));
+    }
+
+    void TcpStream::Send(const uint8_t *data, size_t size)
+    {
+        std::unique_lock<std::mutex> lock { m_sendMutex };
+        auto handle = static_cast<SOCKET>(m_socket);
+
+        while (size != 0) {
+            if (!m_open.load()) {
+                throw IOException("The stream is closed");
+            }
+
+            int sent = send(handle, reinterpret_cast<const char *>(data), static_cast<int>(std::min<size_t>(size, INT_MAX)), 0);
+            if (sent == SOCKET_ERROR) {
+                int error = WSAGetLastError();
+                if (error == WSAEWOULDBLOCK) {
+                    PollSocket(handle, POLLOUT, std::chrono::milliseconds(100));
+                    continue;
+                }
+
+                m_open.store(false);
+                throw IOException("Send failed with error " + std::to_string(error));
+            }
+
+            data += sent;
+            size -= static_cast<size_t>(sent);
+        }
+    }
+
+    size_t TcpStream::Receive(uint8_t *buffer, size_t size, std::chrono::milliseconds timeout)
+    {
+        auto handle = static_cast<SOCKET>(m_socket);
+
+        if (!m_open.load() || PollSocket(handle, POLLIN, timeout) <= 0) {
+            return 0;
+        }
+
+        int received = recv(handle, reinterpret_cast<char *>(buffer), static_cast<int>(std::min<size_t>(size, INT_MAX)), 0);
+        if (received == SOCKET_ERROR && WSAGetLastError() == WSAEWOULDBLOCK) {
+            return 0;
+        }
+
+        if (received <= 0) {
+            // Closed by the peer or failed
+            m_open.store(false);
+            return 0;
+        }
+
+        return static_cast<size_t>(received);
+    }
+
+    void TcpStream::Close()
+    {
+        // The socket stays valid until the destructor, so that a concurrent receive never touches a reused one
+        if (m_open.exchange(false)) {
+            shutdown(static_cast<SOCKET>(m_socket), SD_BOTH);
+        }
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // TcpListener implementation                           //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    TcpListener::TcpListener(uint16_t port, const std::string &bindAddress)
+            : m_socket { static_cast<intptr_t>(INVALID_SOCKET) }
+    {
+        EnsureWinsock();
+
+        sockaddr_in address {};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(port);
+        if (inet_pton(AF_INET, bindAddress.c_str(), &address.sin_addr) != 1) {
+            throw IOException("Invalid bind address " + bindAddress);
+        }
+
+        SOCKET socket = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if (socket == INVALID_SOCKET) {
+            throw IOException("Failed to create a socket, error " + std::to_string(WSAGetLastError()));
+        }
+
+        if (bind(socket, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0 || listen(socket, SOMAXCONN) != 0) {
+            int error = WSAGetLastError();
+            closesocket(socket);
+            throw IOException("Failed to listen on port " + std::to_string(port) + ", error " + std::to_string(error));
+        }
+
+        int length = sizeof(address);
+        getsockname(socket, reinterpret_cast<sockaddr *>(&address), &length);
+
+        m_socket = static_cast<intptr_t>(socket);
+        m_port = ntohs(address.sin_port);
+    }
+
+    TcpListener::~TcpListener()
+    {
+        Close();
+        closesocket(static_cast<SOCKET>(m_socket));
+    }
+
+    std::unique_ptr<TcpStream> TcpListener::Accept(std::chrono::milliseconds timeout)
+    {
+        auto handle = static_cast<SOCKET>(m_socket);
+
+        if (!m_open.load() || PollSocket(handle, POLLIN, timeout) <= 0 || !m_open.load()) {
+            return nullptr;
+        }
+
+        SOCKET client = accept(handle, nullptr, nullptr);
+        if (client == INVALID_SOCKET) {
+            return nullptr;
+        }
+
+        return std::make_unique<TcpStream>(static_cast<intptr_t>(client));
+    }
+
+    void TcpListener::Close()
+    {
+        if (m_open.exchange(false)) {
+            shutdown(static_cast<SOCKET>(m_socket), SD_BOTH);
+        }
+    }
+}
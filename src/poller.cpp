@@ -0,0 +1,164 @@
+#include <ble_serial/poller.hpp>
+#include <ble_serial/instrumentation.hpp>
+
+#include <algorithm>
+
+namespace BLE_Serial::Bridge
+{
+    using namespace BLE_Serial::Bluetooth;
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // Poller implementation                                //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    Poller::Poller(PollingOptions options, CpuUsage &usage, std::function<void(size_t, std::vector<uint8_t> &&)> listener)
+            : m_options { options }, m_usage { usage }, m_listener { std::move(listener) }
+    {
+    }
+
+    Poller::~Poller()
+    {
+        Stop();
+    }
+
+    size_t Poller::AddCharacteristic(IBluetoothGattCharacteristic &characteristic)
+    {
+        m_targets.push_back(Target {
+                .characteristic = &characteristic,
+                .lastValue = {},
+                .hasValue = false,
+                .interval = m_options.minInterval,
+                .due = std::chrono::steady_clock::now(),
+                .read = {}
+        });
+
+        return m_targets.size() - 1;
+    }
+
+    void Poller::Start()
+    {
+        if (m_thread.joinable() || m_targets.empty()) {
+            return;
+        }
+
+        m_exiting = false;
+        m_thread = std::thread([this]() { Run(); });
+    }
+
+    void Poller::Stop()
+    {
+        if (!m_thread.joinable()) {
+            return;
+        }
+
+        {
+            std::unique_lock<std::mutex> lock { m_mutex };
+            m_exiting = true;
+            m_condition.notify_all();
+        }
+
+        m_thread.join();
+    }
+
+    PollingMetrics Poller::Metrics() const noexcept
+    {
+        return PollingMetrics {
+                .reads = m_reads.load(std::memory_order_relaxed),
+                .changes = m_changes.load(std::memory_order_relaxed),
+                .errors = m_errors.load(std::memory_order_relaxed)
+        };
+    }
+
+    void Poller::Run()
+    {
+        CpuUsage::ThreadMeter meter { m_usage };
+        std::vector<size_t> due;
+
+        for (;;) {
+            meter.Update();
+
+            auto next = std::min_element(m_targets.begin(), m_targets.end(), [](const auto &lhs, const auto &rhs) { return lhs.due < rhs.due; })->due;
+
+            {
+                std::unique_lock<std::mutex> lock { m_mutex };
+                if (m_condition.wait_until(lock, next, [this]() { return m_exiting; })) {
+                    return;
+                }
+            }
+
+            BLE_SERIAL_TIMED_SCOPE("poller.round");
+
+            auto now = std::chrono::steady_clock::now();
+            due.clear();
+
+            // Issue all due reads first and only then wait for them, so they share the connection events
+            for (size_t i = 0; i < m_targets.size(); i++) {
+                auto &target = m_targets[i];
+                if (target.due > now) {
+                    continue;
+                }
+
+                if (target.read.valid()) {
+                    // A read that timed out is still in flight, another one would only queue up behind it
+                    if (target.read.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+                        target.due = now + target.interval;
+                        continue;
+                    }
+
+                    // Already counted as failed when it timed out
+                    try {
+                        (void) target.read.get();
+                    } catch (const BluetoothException &ignored) {
+                    }
+                }
+
+                try {
+                    // A cached value would hide changes the device did not notify, which polling is there to see
+                    target.read = target.characteristic->ReadAsync(GattReadMode::Uncached);
+                    due.push_back(i);
+                } catch (const BluetoothException &ignored) {
+                    m_errors.fetch_add(1, std::memory_order_relaxed);
+                    target.due = now + target.interval;
+                }
+            }
+
+            // The timeout bounds the whole round, reads that miss it stay with their target
+            auto deadline = std::chrono::steady_clock::now() + m_options.readTimeout;
+
+            for (size_t j = 0; j < due.size(); j++) {
+                auto &target = m_targets[due[j]];
+                bool changed = false;
+
+                try {
+                    if (target.read.wait_until(deadline) != std::future_status::ready) {
+                        throw BluetoothException("Read timed out");
+                    }
+
+                    auto value = target.read.get();
+                    m_reads.fetch_add(1, std::memory_order_relaxed);
+
+                    if (!target.hasValue || value != target.lastValue) {
+                        changed = true;
+                        target.hasValue = true;
+                        target.lastValue = value;
+                        m_changes.fetch_add(1, std::memory_order_relaxed);
+                        m_listener(due[j], std::move(value));
+                    }
+                } catch (const BluetoothException &ignored) {
+                    m_errors.fetch_add(1, std::memory_order_relaxed);
+                }
+
+                if (changed) {
+                    target.interval = m_options.minInterval;
+                } else {
+                    auto grown = std::chrono::milliseconds { static_cast<int64_t>(static_cast<double>(target.interval.count()) * m_options.backoff) + 1 };
+                    target.interval = std::min(grown, m_options.maxInterval);
+                }
+
+                target.due = std::chrono::steady_clock::now() + target.interval;
+            }
+        }
+    }
+}
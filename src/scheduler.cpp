@@ -0,0 +1,136 @@
+#include <ble_serial/scheduler.hpp>
+
+#include <algorithm>
+
+namespace BLE_Serial::Bridge
+{
+    namespace
+    {
+        /**
+         * Helper splitting the limits of the bridge's queue evenly between the lanes, so all of them together stay
+         * within what the user gave
+         */
+        SpillQueueOptions LaneOptions(const SpillQueueOptions &queueOptions) noexcept
+        {
+            auto options = queueOptions;
+            options.memoryLimit = queueOptions.memoryLimit / PriorityCount;
+
+            // Zero means no limit, a tiny limit must not turn into that
+            if (queueOptions.diskLimit != 0) {
+                options.diskLimit = std::max<size_t>(queueOptions.diskLimit / PriorityCount, 1);
+            }
+
+            return options;
+        }
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // WriteScheduler implementation                        //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    WriteScheduler::WriteScheduler(SchedulerOptions options, const SpillQueueOptions &queueOptions)
+            : m_options { std::move(options) }, m_lanes { SpillQueue { LaneOptions(queueOptions) }, SpillQueue { LaneOptions(queueOptions) }}
+    {
+        m_credits = m_options.weights[m_currentLane];
+    }
+
+    bool WriteScheduler::Push(const std::vector<uint8_t> &frame)
+    {
+        auto &lane = m_lanes[static_cast<size_t>(Classify(frame))];
+
+        if (m_options.packetSize == 0 || frame.size() <= m_options.packetSize) {
+            return lane.Push(frame);
+        }
+
+        bool result = true;
+        for (size_t offset = 0; offset < frame.size(); offset += m_options.packetSize) {
+            size_t end = std::min(frame.size(), offset + m_options.packetSize);
+            result &= lane.Push(std::vector<uint8_t> { frame.begin() + offset, frame.begin() + end });
+        }
+
+        return result;
+    }
+
+    Priority WriteScheduler::Classify(const std::vector<uint8_t> &frame) const noexcept
+    {
+        for (const auto &rule : m_options.rules) {
+            if (rule.maxLength != 0 && frame.size() > rule.maxLength) {
+                continue;
+            }
+
+            if (frame.size() < rule.prefix.size() || !std::equal(rule.prefix.begin(), rule.prefix.end(), frame.begin())) {
+                continue;
+            }
+
+            return rule.priority;
+        }
+
+        return m_options.defaultPriority;
+    }
+
+    std::optional<Priority> WriteScheduler::Front(std::vector<uint8_t> &output)
+    {
+        std::unique_lock<std::mutex> lock { m_mutex };
+
+        if (m_options.policy == SchedulingPolicy::StrictPriority) {
+            for (size_t i = 0; i < PriorityCount; i++) {
+                if (m_lanes[i].Front(output)) {
+                    return static_cast<Priority>(i);
+                }
+            }
+
+            return std::nullopt;
+        }
+
+        // Weighted round robin, the current lane keeps its turn until it runs out of credits or packets
+        for (size_t attempt = 0; attempt <= PriorityCount; attempt++) {
+            if (m_credits != 0 && m_lanes[m_currentLane].Front(output)) {
+                return static_cast<Priority>(m_currentLane);
+            }
+
+            m_currentLane = (m_currentLane + 1) % PriorityCount;
+            m_credits = std::max(1u, m_options.weights[m_currentLane]);
+        }
+
+        return std::nullopt;
+    }
+
+    void WriteScheduler::Pop(Priority lane)
+    {
+        std::unique_lock<std::mutex> lock { m_mutex };
+        m_lanes[static_cast<size_t>(lane)].Pop();
+
+        if (static_cast<size_t>(lane) == m_currentLane && m_credits != 0) {
+            m_credits--;
+        }
+    }
+
+    bool WriteScheduler::Empty()
+    {
+        return std::all_of(m_lanes.begin(), m_lanes.end(), [](auto &lane) { return lane.Empty(); });
+    }
+
+    SpillQueueMetrics WriteScheduler::Metrics(Priority lane)
+    {
+        return m_lanes[static_cast<size_t>(lane)].Metrics();
+    }
+
+    SpillQueueMetrics WriteScheduler::Metrics()
+    {
+        SpillQueueMetrics result {};
+
+        for (auto &lane : m_lanes) {
+            auto metrics = lane.Metrics();
+            result.frames += metrics.frames;
+            result.memoryBytes += metrics.memoryBytes;
+            result.diskBytes += metrics.diskBytes;
+            result.segments += metrics.segments;
+            result.dropped += metrics.dropped;
+            result.oldestAge = std::max(result.oldestAge, metrics.oldestAge);
+        }
+
+        return result;
+    }
+}
@@ -0,0 +1,421 @@
+#include "shell.hpp"
+
+#include <ble_serial/format.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace BLE_Serial::Bluetooth;
+using namespace BLE_Serial::Format;
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * Row of the handle table resolved when the session starts
+     */
+    struct HandleEntry
+    {
+        std::string serviceUUID;
+        std::string uuid;
+        uint16_t handle;
+        IBluetoothGattCharacteristic *characteristic;
+    };
+
+    /**
+     * Latencies collected by the "time" command
+     */
+    struct LatencyStats
+    {
+        size_t count = 0;
+        Clock::duration total {};
+        Clock::duration min = Clock::duration::max();
+        Clock::duration max = Clock::duration::min();
+
+        void Add(Clock::duration latency)
+        {
+            count++;
+            total += latency;
+            min = std::min(min, latency);
+            max = std::max(max, latency);
+        }
+    };
+
+    std::string FormatLatency(Clock::duration latency)
+    {
+        std::ostringstream stream;
+        stream << std::fixed << std::setprecision(2) << std::chrono::duration<double, std::milli>(latency).count() << " ms";
+        return stream.str();
+    }
+
+    std::string FormatProperties(GattCharacteristicProperty properties)
+    {
+        static const std::pair<GattCharacteristicProperty, const char *> c_names[] = {
+                { GattCharacteristicProperty::Read,                 "read" },
+                { GattCharacteristicProperty::Write,                "write" },
+                { GattCharacteristicProperty::WriteWithoutResponse, "write-nr" },
+                { GattCharacteristicProperty::Notify,               "notify" },
+                { GattCharacteristicProperty::Indicate,             "indicate" }
+        };
+
+        std::string result;
+        for (const auto &[property, name] : c_names) {
+            if (HasProperty(properties, property)) {
+                result += result.empty() ? "" : ",";
+                result += name;
+            }
+        }
+
+        return result;
+    }
+
+    bool EqualsIgnoreCase(std::string_view lhs, std::string_view rhs)
+    {
+        return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin(), [](char a, char b) {
+            return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b));
+        });
+    }
+
+    /**
+     * Interactive session over a single open connection
+     */
+    class ShellSession
+    {
+    public:
+        explicit ShellSession(std::shared_ptr<IBluetoothConnection> connection)
+                : m_connection { std::move(connection) }
+        {
+        }
+
+        ~ShellSession()
+        {
+            for (auto &[entry, id] : m_subscriptions) {
+                try {
+                    entry->characteristic->Unsubscribe(id);
+                } catch (const BluetoothException &ignored) {}
+            }
+        }
+
+        ShellSession(const ShellSession &) = delete;
+        ShellSession &operator=(const ShellSession &) = delete;
+
+        /**
+         * Fetches all characteristics and builds the handle table
+         */
+        void Discover()
+        {
+            auto &bluetooth = IBluetoothService::GetService();
+
+            for (auto &service : m_connection->GetServices()) {
+                service->FetchCharacteristics();
+
+                for (auto &characteristic : service->GetCachedCharacteristics()) {
+                    m_table.push_back(HandleEntry {
+                            .serviceUUID = bluetooth.UUIDToShortString(service->GetUUID()),
+                            .uuid = bluetooth.UUIDToShortString(characteristic->GetUUID()),
+                            .handle = characteristic->GetHandle(),
+                            .characteristic = characteristic.get()
+                    });
+                }
+            }
+
+            std::sort(m_table.begin(), m_table.end(), [](const auto &lhs, const auto &rhs) { return lhs.handle < rhs.handle; });
+        }
+
+        /**
+         * Executes a single command line, returns false when the session should end
+         */
+        bool Execute(const std::string &line)
+        {
+            std::istringstream stream { line };
+            std::string command;
+
+            if (!(stream >> command)) {
+                return true;
+            }
+
+            try {
+                if (command == "quit" || command == "exit") {
+                    return false;
+                } else if (command == "help") {
+                    PrintHelp();
+                } else if (command == "table") {
+                    PrintTable();
+                } else if (command == "read") {
+                    Read(Resolve(stream), false);
+                } else if (command == "hexdump") {
+                    Read(Resolve(stream), true);
+                } else if (command == "write") {
+                    auto &entry = Resolve(stream);
+                    Write(entry, ParseHex(RestOfLine(stream)));
+                } else if (command == "writestr") {
+                    auto &entry = Resolve(stream);
+                    auto text = RestOfLine(stream);
+                    Write(entry, std::vector<uint8_t> { text.begin(), text.end() });
+                } else if (command == "sub") {
+                    Subscribe(Resolve(stream));
+                } else if (command == "unsub") {
+                    Unsubscribe(Resolve(stream));
+                } else if (command == "cache") {
+                    Cache(stream);
+                } else if (command == "time") {
+                    Time(stream);
+                } else {
+                    Print("Unknown command " + command + ", type help for the list of commands\n");
+                }
+            } catch (const std::invalid_argument &e) {
+                Print(std::string { "Invalid argument: " } + e.what() + "\n");
+            } catch (const BluetoothException &e) {
+                Print(std::string { "Bluetooth error: " } + e.what() + "\n");
+            }
+
+            return true;
+        }
+
+        /**
+         * Prints a text, safe to call from notification threads
+         */
+        void Print(const std::string &text)
+        {
+            std::unique_lock<std::mutex> lock { m_outputMutex };
+            std::cout << text << std::flush;
+        }
+
+    private:
+        static std::string RestOfLine(std::istringstream &stream)
+        {
+            std::string rest;
+            std::getline(stream >> std::ws, rest);
+            return rest;
+        }
+
+        HandleEntry &Resolve(std::istringstream &stream)
+        {
+            std::string reference;
+            if (!(stream >> reference)) {
+                throw std::invalid_argument("A characteristic UUID or handle is required");
+            }
+
+            for (auto &entry : m_table) {
+                if (EqualsIgnoreCase(entry.uuid, reference)) {
+                    return entry;
+                }
+            }
+
+            size_t parsed = 0;
+            unsigned long handle = std::stoul(reference, &parsed, 0);
+            if (parsed == reference.size()) {
+                for (auto &entry : m_table) {
+                    if (entry.handle == handle) {
+                        return entry;
+                    }
+                }
+            }
+
+            throw std::invalid_argument("No characteristic matches " + reference);
+        }
+
+        void PrintHelp()
+        {
+            Print("Characteristics are referred to by their UUID or handle as shown by table\n"
+                  "\ttable - Prints the handle table\n"
+                  "\tread <char> - Reads the value and prints it as hex\n"
+                  "\thexdump <char> - Reads the value and prints its hexdump\n"
+                  "\twrite <char> <hex> - Writes hex bytes, i.e. write 0x0012 01 02 FF\n"
+                  "\twritestr <char> <text> - Writes the text as is\n"
+                  "\tsub <char> - Prints every notification of the characteristic\n"
+                  "\tunsub <char> - Stops printing the notifications\n"
+                  "\tcache [ttl_ms] - Sets the time to live of the value cache or prints its metrics\n"
+                  "\ttime <n> <command> - Runs a read or write command n times and prints its latency statistics\n"
+                  "\tquit - Ends the session\n");
+        }
+
+        void PrintTable()
+        {
+            std::ostringstream stream;
+            stream << "Handle  Service                               Characteristic                        Properties\n";
+
+            for (const auto &entry : m_table) {
+                stream << "0x" << std::hex << std::uppercase << std::setw(4) << std::setfill('0') << entry.handle << std::dec << std::setfill(' ') << "  "
+                       << std::left << std::setw(38) << entry.serviceUUID << std::setw(38) << entry.uuid << std::right
+                       << FormatProperties(entry.characteristic->GetProperties()) << "\n";
+            }
+
+            Print(stream.str());
+        }
+
+        Clock::duration Read(HandleEntry &entry, bool dump)
+        {
+            auto start = Clock::now();
+            auto value = entry.characteristic->Read();
+            auto latency = Clock::now() - start;
+
+            if (!m_quiet) {
+                std::ostringstream stream;
+                stream << entry.uuid << " (" << value.size() << " bytes, " << FormatLatency(latency) << ")";
+
+                if (dump) {
+                    stream << "\n";
+                    HexDump(stream, value.data(), value.size(), "\t");
+                } else {
+                    stream << ": " << ToHexString(value) << "\n";
+                }
+
+                Print(stream.str());
+            }
+
+            return latency;
+        }
+
+        Clock::duration Write(HandleEntry &entry, const std::vector<uint8_t> &data)
+        {
+            auto start = Clock::now();
+            entry.characteristic->Write(data);
+            auto latency = Clock::now() - start;
+
+            if (!m_quiet) {
+                Print("Written " + std::to_string(data.size()) + " bytes to " + entry.uuid + " (" + FormatLatency(latency) + ")\n");
+            }
+
+            return latency;
+        }
+
+        void Subscribe(HandleEntry &entry)
+        {
+            if (m_subscriptions.contains(&entry)) {
+                Print("Already subscribed to " + entry.uuid + "\n");
+                return;
+            }
+
+            auto start = Clock::now();
+            auto last = std::make_shared<std::atomic<Clock::rep>>(start.time_since_epoch().count());
+
+            auto id = entry.characteristic->Subscribe([this, &entry, last](std::vector<uint8_t> data) {
+                auto now = Clock::now();
+                auto previous = Clock::time_point { Clock::duration { last->exchange(now.time_since_epoch().count()) }};
+
+                Print("[" + entry.uuid + " +" + FormatLatency(now - previous) + "] " + ToHexString(data) + "\n");
+            });
+
+            m_subscriptions.emplace(&entry, id);
+            Print("Subscribed to " + entry.uuid + " (" + FormatLatency(Clock::now() - start) + ")\n");
+        }
+
+        void Unsubscribe(HandleEntry &entry)
+        {
+            auto it = m_subscriptions.find(&entry);
+            if (it == m_subscriptions.end()) {
+                Print("Not subscribed to " + entry.uuid + "\n");
+                return;
+            }
+
+            auto start = Clock::now();
+            entry.characteristic->Unsubscribe(it->second);
+            m_subscriptions.erase(it);
+
+            Print("Unsubscribed from " + entry.uuid + " (" + FormatLatency(Clock::now() - start) + ")\n");
+        }
+
+        void Cache(std::istringstream &stream)
+        {
+            auto &cache = m_connection->GetValueCache();
+
+            std::string ttl;
+            if (stream >> ttl) {
+                cache.SetTimeToLive(std::chrono::milliseconds(std::stoi(ttl)));
+            }
+
+            auto metrics = cache.Metrics();
+            Print("Value cache: ttl " + std::to_string(cache.GetTimeToLive().count()) + " ms, " + std::to_string(metrics.entries) + " entries, " +
+                  std::to_string(metrics.hits) + " hits, " + std::to_string(metrics.misses) + " misses, " + std::to_string(metrics.invalidations) + " invalidations\n");
+        }
+
+        void Time(std::istringstream &stream)
+        {
+            int count = 0;
+            std::string command;
+
+            if (!(stream >> count >> command) || count <= 0) {
+                throw std::invalid_argument("Usage: time <n> <read|hexdump|write|writestr> <char> [data]");
+            }
+
+            auto &entry = Resolve(stream);
+            std::vector<uint8_t> data;
+
+            if (command == "write") {
+                data = ParseHex(RestOfLine(stream));
+            } else if (command == "writestr") {
+                auto text = RestOfLine(stream);
+                data.assign(text.begin(), text.end());
+            } else if (command != "read" && command != "hexdump") {
+                throw std::invalid_argument("Only read and write commands can be timed");
+            }
+
+            LatencyStats stats {};
+            m_quiet = true;
+
+            try {
+                for (int i = 0; i < count; i++) {
+                    stats.Add(command == "read" || command == "hexdump" ? Read(entry, false) : Write(entry, data));
+                }
+            } catch (...) {
+                m_quiet = false;
+                throw;
+            }
+
+            m_quiet = false;
+            Print(std::to_string(stats.count) + " x " + command + " " + entry.uuid + ": min " + FormatLatency(stats.min) + ", avg " +
+                  FormatLatency(stats.total / static_cast<Clock::rep>(stats.count)) + ", max " + FormatLatency(stats.max) + "\n");
+        }
+
+        std::shared_ptr<IBluetoothConnection> m_connection;
+        std::vector<HandleEntry> m_table {};
+        std::map<HandleEntry *, size_t> m_subscriptions {};
+        std::mutex m_outputMutex {};
+        bool m_quiet = false;
+    };
+}
+
+int Shell(BluetoothAddress address, int timeout, std::istream &input)
+{
+    std::cout << "Connecting ..." << std::endl;
+
+    auto deviceOptional = IBluetoothService::GetService().FindDevice(address, std::chrono::seconds(timeout));
+    if (!deviceOptional) {
+        std::cerr << "Device with address: " << BluetoothAddressToString(address) << " couldn't be found. \n";
+        return 1;
+    }
+
+    auto start = Clock::now();
+    auto connection = deviceOptional.value()->OpenConnection(std::chrono::seconds(timeout));
+    std::cout << "Connected (" << FormatLatency(Clock::now() - start) << ")" << std::endl;
+
+    {
+        ShellSession session { connection };
+
+        start = Clock::now();
+        session.Discover();
+        std::cout << "Characteristics discovered (" << FormatLatency(Clock::now() - start) << "), type help for the list of commands" << std::endl;
+
+        std::string line;
+        for (;;) {
+            session.Print("> ");
+
+            if (!std::getline(input, line) || !session.Execute(line)) {
+                break;
+            }
+        }
+    }
+
+    std::cout << "Disconnecting..." << std::endl;
+    connection->Close();
+    return 0;
+}
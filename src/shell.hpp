@@ -0,0 +1,22 @@
+#ifndef BLE_SERIAL_SRC_SHELL_HPP_
+#define BLE_SERIAL_SRC_SHELL_HPP_
+
+#include <ble_serial/bluetooth.hpp>
+
+#include <istream>
+
+/**
+ * @brief Runs an interactive session over a single connection.
+ *
+ * The device is connected and its characteristics are discovered once, then commands are read from the input until
+ * it ends or "quit" is entered.
+ *
+ * @param address address of the device
+ * @param timeout timeout in seconds used for finding the device and for all the operations
+ * @param input stream the commands are read from
+ *
+ * @return exit code of the application
+ */
+int Shell(BLE_Serial::Bluetooth::BluetoothAddress address, int timeout, std::istream &input);
+
+#endif // BLE_SERIAL_SRC_SHELL_HPP_
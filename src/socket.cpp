@@ -0,0 +1,36 @@
+#include <ble_serial/socket.hpp>
+
+namespace BLE_Serial::IO
+{
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // TcpStream implementation                             //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    void TcpStream::Send(const std::vector<uint8_t> &data)
+    {
+        Send(data.data(), data.size());
+    }
+
+    bool TcpStream::IsOpen() const noexcept
+    {
+        return m_open.load();
+    }
+
+    const std::string &TcpStream::GetPeerName() const noexcept
+    {
+        return m_peerName;
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // TcpListener implementation                           //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    uint16_t TcpListener::GetPort() const noexcept
+    {
+        return m_port;
+    }
+}
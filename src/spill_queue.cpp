@@ -0,0 +1,174 @@
+#include <ble_serial/spill_queue.hpp>
+#include <ble_serial/instrumentation.hpp>
+
+#include <cstring>
+
+namespace BLE_Serial::Bridge
+{
+    namespace
+    {
+        /**
+         * Header stored in front of every spilled frame
+         */
+        struct SpilledFrameHeader
+        {
+            uint32_t size;
+            int64_t enqueued;
+        };
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // SpillQueue implementation                            //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    SpillQueue::SpillQueue(SpillQueueOptions options)
+            : m_options { std::move(options) }
+    {
+    }
+
+    SpillQueue::~SpillQueue()
+    {
+        for (auto &segment : m_segments) {
+            std::string path = segment.file.Path();
+            segment.file.Close();
+            IO::MappedFile::Remove(path);
+        }
+    }
+
+    bool SpillQueue::Push(std::vector<uint8_t> frame)
+    {
+        std::unique_lock<std::mutex> lock { m_mutex };
+        auto now = std::chrono::steady_clock::now();
+
+        // Frames may stay in memory only if nothing is waiting on the disk, otherwise they would overtake it
+        if (m_segments.empty() && m_memoryBytes + frame.size() <= m_options.memoryLimit) {
+            m_memoryBytes += frame.size();
+            m_memory.push_back(MemoryFrame { std::move(frame), now });
+            return true;
+        }
+
+        if (m_options.spillDirectory.empty() || frame.size() + sizeof(SpilledFrameHeader) > m_options.segmentSize ||
+            (m_options.diskLimit != 0 && m_diskBytes + frame.size() > m_options.diskLimit)) {
+            m_dropped++;
+            return false;
+        }
+
+        SpillFrame(frame, now);
+        return true;
+    }
+
+    bool SpillQueue::Front(std::vector<uint8_t> &output)
+    {
+        std::unique_lock<std::mutex> lock { m_mutex };
+
+        if (!m_memory.empty()) {
+            output.assign(m_memory.front().data.begin(), m_memory.front().data.end());
+            return true;
+        }
+
+        if (m_segments.empty() || m_segments.front().frames == 0) {
+            return false;
+        }
+
+        auto &segment = m_segments.front();
+        SpilledFrameHeader header {};
+        std::memcpy(&header, segment.file.Data() + segment.readOffset, sizeof(header));
+
+        const uint8_t *payload = segment.file.Data() + segment.readOffset + sizeof(header);
+        output.assign(payload, payload + header.size);
+        return true;
+    }
+
+    void SpillQueue::Pop()
+    {
+        std::unique_lock<std::mutex> lock { m_mutex };
+
+        if (!m_memory.empty()) {
+            m_memoryBytes -= m_memory.front().data.size();
+            m_memory.pop_front();
+            return;
+        }
+
+        if (m_segments.empty() || m_segments.front().frames == 0) {
+            return;
+        }
+
+        auto &segment = m_segments.front();
+        SpilledFrameHeader header {};
+        std::memcpy(&header, segment.file.Data() + segment.readOffset, sizeof(header));
+
+        segment.readOffset += sizeof(header) + header.size;
+        segment.frames--;
+        m_diskBytes -= header.size;
+        m_diskFrames--;
+
+        // The last segment is still being written to, it is only reused once drained
+        if (segment.frames == 0 && (m_segments.size() > 1 || m_diskFrames == 0)) {
+            std::string path = segment.file.Path();
+            segment.file.Close();
+            IO::MappedFile::Remove(path);
+            m_segments.pop_front();
+        }
+    }
+
+    bool SpillQueue::Empty()
+    {
+        std::unique_lock<std::mutex> lock { m_mutex };
+        return m_memory.empty() && m_diskFrames == 0;
+    }
+
+    SpillQueueMetrics SpillQueue::Metrics()
+    {
+        std::unique_lock<std::mutex> lock { m_mutex };
+        bool empty = m_memory.empty() && m_diskFrames == 0;
+
+        return SpillQueueMetrics {
+                .frames = m_memory.size() + m_diskFrames,
+                .memoryBytes = m_memoryBytes,
+                .diskBytes = m_diskBytes,
+                .segments = m_segments.size(),
+                .dropped = m_dropped,
+                .oldestAge = empty ? std::chrono::milliseconds { 0 } : std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - OldestEnqueueTime())
+        };
+    }
+
+    void SpillQueue::SpillFrame(const std::vector<uint8_t> &frame, std::chrono::steady_clock::time_point enqueued)
+    {
+        BLE_SERIAL_TIMED_SCOPE("queue.spill");
+        size_t required = sizeof(SpilledFrameHeader) + frame.size();
+
+        if (m_segments.empty() || m_segments.back().writeOffset + required > m_segments.back().file.Size()) {
+            std::string path = m_options.spillDirectory + "/ble_serial_spill_" + std::to_string(reinterpret_cast<uintptr_t>(this)) + "_" + std::to_string(m_nextSegmentId++) + ".seg";
+
+            Segment segment {};
+            segment.file = IO::MappedFile::Create(path, m_options.segmentSize);
+            m_segments.push_back(std::move(segment));
+        }
+
+        auto &segment = m_segments.back();
+        SpilledFrameHeader header { .size = static_cast<uint32_t>(frame.size()), .enqueued = enqueued.time_since_epoch().count() };
+
+        std::memcpy(segment.file.Data() + segment.writeOffset, &header, sizeof(header));
+        std::memcpy(segment.file.Data() + segment.writeOffset + sizeof(header), frame.data(), frame.size());
+
+        segment.writeOffset += required;
+        segment.frames++;
+        m_diskBytes += frame.size();
+        m_diskFrames++;
+    }
+
+    std::chrono::steady_clock::time_point SpillQueue::OldestEnqueueTime() const
+    {
+        if (!m_memory.empty()) {
+            return m_memory.front().enqueued;
+        }
+
+        const auto &segment = m_segments.front();
+        SpilledFrameHeader header {};
+        std::memcpy(&header, segment.file.Data() + segment.readOffset, sizeof(header));
+
+        return std::chrono::steady_clock::time_point { std::chrono::steady_clock::duration { header.enqueued }};
+    }
+}
@@ -0,0 +1,263 @@
+#include <ble_serial/stats.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace BLE_Serial::Bridge
+{
+    using namespace BLE_Serial::Bluetooth;
+    using namespace BLE_Serial::IO;
+
+    namespace
+    {
+        /**
+         * The sequence counter sits alone in the first cache line, the snapshot follows it
+         */
+        constexpr size_t c_snapshotOffset = 64;
+        constexpr size_t c_fileSize = c_snapshotOffset + sizeof(StatsSnapshot);
+        constexpr int c_readAttempts = 64;
+
+        uint64_t CurrentProcessId() noexcept
+        {
+#ifdef _WIN32
+            return static_cast<uint64_t>(_getpid());
+#else
+            return static_cast<uint64_t>(getpid());
+#endif
+        }
+
+        template<size_t Size>
+        void CopyName(char (&destination)[Size], const std::string &source) noexcept
+        {
+            size_t length = std::min(source.size(), Size - 1);
+            std::memcpy(destination, source.data(), length);
+            destination[length] = '\0';
+        }
+
+        std::atomic_ref<uint64_t> Sequence(const uint8_t *data) noexcept
+        {
+            // Only ever loaded through a read-only mapping, atomic_ref just has no const flavour before C++26
+            return std::atomic_ref<uint64_t> { *reinterpret_cast<uint64_t *>(const_cast<uint8_t *>(data)) };
+        }
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // StatsPublisher implementation                        //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    StatsPublisher::StatsPublisher(std::chrono::milliseconds interval)
+            : m_interval { interval }
+    {
+    }
+
+    StatsPublisher::~StatsPublisher()
+    {
+        Stop();
+    }
+
+    void StatsPublisher::AddBridge(const std::string &name, Bridge &bridge)
+    {
+        if (m_bridges.size() < StatsSnapshot::MaxBridges) {
+            m_bridges.push_back(BridgeEntry { .name = name, .bridge = &bridge });
+        }
+    }
+
+    void StatsPublisher::AddAdapter(const IBluetoothService &service)
+    {
+        if (m_adapters.size() < StatsSnapshot::MaxAdapters) {
+            m_adapters.push_back(&service);
+        }
+    }
+
+    void StatsPublisher::Start()
+    {
+        if (m_thread.joinable()) {
+            return;
+        }
+
+        std::error_code error;
+        std::filesystem::create_directories(GetStatsDirectory(), error);
+
+        auto path = (std::filesystem::path { GetStatsDirectory() } / (std::to_string(CurrentProcessId()) + ".stats")).string();
+        m_file = MappedFile::Create(path, c_fileSize);
+        Publish();
+
+        m_exiting = false;
+        m_thread = std::thread([this]() { Run(); });
+    }
+
+    void StatsPublisher::Stop()
+    {
+        if (m_thread.joinable()) {
+            {
+                std::unique_lock<std::mutex> lock { m_mutex };
+                m_exiting = true;
+                m_condition.notify_all();
+            }
+
+            m_thread.join();
+        }
+
+        if (m_file.Data() != nullptr) {
+            auto path = m_file.Path();
+            m_file.Close();
+            MappedFile::Remove(path);
+        }
+    }
+
+    void StatsPublisher::Run()
+    {
+        std::unique_lock<std::mutex> lock { m_mutex };
+
+        while (!m_condition.wait_for(lock, m_interval, [this]() { return m_exiting; })) {
+            lock.unlock();
+            Publish();
+            lock.lock();
+        }
+    }
+
+    void StatsPublisher::Publish()
+    {
+        StatsSnapshot snapshot {};
+        snapshot.magic = StatsSnapshot::Magic;
+        snapshot.version = StatsSnapshot::Version;
+        snapshot.pid = CurrentProcessId();
+        snapshot.publishedAt = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+        snapshot.bridgeCount = static_cast<uint32_t>(m_bridges.size());
+        snapshot.adapterCount = static_cast<uint32_t>(m_adapters.size());
+
+        for (size_t i = 0; i < m_bridges.size(); i++) {
+            auto &bridge = *m_bridges[i].bridge;
+            auto &record = snapshot.bridges[i];
+            auto metrics = bridge.GetMetrics().Snapshot();
+            auto usage = bridge.GetResourceUsage();
+            auto control = bridge.GetQueueMetrics(Priority::Control);
+            auto bulk = bridge.GetQueueMetrics(Priority::Bulk);
+
+            CopyName(record.name, m_bridges[i].name);
+            record.alive = bridge.IsAlive() ? 1 : 0;
+            record.polling = bridge.IsPolling() ? 1 : 0;
+            record.rssi = metrics.rssi;
+            record.notifications = metrics.notifications;
+            record.bytesReceived = metrics.bytesReceived;
+            record.writes = metrics.writes;
+            record.bytesSent = metrics.bytesSent;
+            record.writeErrors = metrics.writeErrors;
+            record.retries = metrics.retries;
+            record.heartbeatErrors = metrics.heartbeatErrors;
+            record.recoveries = metrics.recoveries;
+            record.writeLatencyP50 = static_cast<uint64_t>(metrics.writeLatencyP50.count());
+            record.writeLatencyP90 = static_cast<uint64_t>(metrics.writeLatencyP90.count());
+            record.writeLatencyP99 = static_cast<uint64_t>(metrics.writeLatencyP99.count());
+            record.controlFrames = control.frames;
+            record.bulkFrames = bulk.frames;
+            record.queuedBytes = control.memoryBytes + control.diskBytes + bulk.memoryBytes + bulk.diskBytes;
+            record.droppedFrames = control.dropped + bulk.dropped;
+            record.conflated = bridge.GetConflationMetrics().dropped;
+            record.threadCpuTime = static_cast<uint64_t>(usage.threadCpuTime.count());
+            record.callbackCpuTime = static_cast<uint64_t>(usage.callbackCpuTime.count());
+            record.memoryBytes = usage.MemoryBytes();
+            record.cacheBytes = usage.cacheBytes;
+        }
+
+        for (size_t i = 0; i < m_adapters.size(); i++) {
+            auto &record = snapshot.adapters[i];
+
+            CopyName(record.id, m_adapters[i]->GetAdapterId());
+            record.connections = m_adapters[i]->GetActiveConnectionCount();
+            record.maxConnections = m_adapters[i]->GetMaxConnectionCount();
+            record.transferredBytes = m_adapters[i]->GetTransferredBytes();
+        }
+
+        // Odd sequence numbers mark an update in progress
+        auto sequence = Sequence(m_file.Data());
+        uint64_t current = sequence.load(std::memory_order_relaxed);
+        sequence.store(current + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        std::memcpy(m_file.Data() + c_snapshotOffset, &snapshot, sizeof(snapshot));
+
+        sequence.store(current + 2, std::memory_order_release);
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // StatsReader implementation                           //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    StatsReader::StatsReader(const std::string &path)
+            : m_file { MappedFile::OpenReadOnly(path) }
+    {
+        StatsSnapshot snapshot {};
+        if (m_file.Size() < c_fileSize || !Read(snapshot)) {
+            throw IOException(path + " is not a stats snapshot");
+        }
+    }
+
+    bool StatsReader::Read(StatsSnapshot &snapshot) const noexcept
+    {
+        auto sequence = Sequence(m_file.Data());
+
+        for (int attempt = 0; attempt < c_readAttempts; attempt++) {
+            uint64_t before = sequence.load(std::memory_order_acquire);
+            if ((before & 1) != 0) {
+                std::this_thread::yield();
+                continue;
+            }
+
+            std::memcpy(&snapshot, m_file.Data() + c_snapshotOffset, sizeof(snapshot));
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            if (sequence.load(std::memory_order_relaxed) == before) {
+                return snapshot.magic == StatsSnapshot::Magic && snapshot.version == StatsSnapshot::Version;
+            }
+        }
+
+        return false;
+    }
+
+    const std::string &StatsReader::Path() const noexcept
+    {
+        return m_file.Path();
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // Discovery implementation                             //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    std::string GetStatsDirectory()
+    {
+        std::error_code error;
+        auto temp = std::filesystem::temp_directory_path(error);
+        return ((error ? std::filesystem::path { "." } : temp) / "ble_serial").string();
+    }
+
+    std::vector<std::string> FindPublishedStats()
+    {
+        std::vector<std::string> result;
+        std::error_code error;
+
+        for (const auto &entry : std::filesystem::directory_iterator { GetStatsDirectory(), error }) {
+            if (entry.path().extension() == ".stats") {
+                result.push_back(entry.path().string());
+            }
+        }
+
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+}
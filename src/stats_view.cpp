@@ -0,0 +1,177 @@
+#include "stats_view.hpp"
+
+#include <ble_serial/stats.hpp>
+
+#include <algorithm>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+using namespace BLE_Serial::Bridge;
+using namespace BLE_Serial::IO;
+
+namespace
+{
+    constexpr std::chrono::seconds c_staleAfter { 3 };
+
+    struct WatchedProcess
+    {
+        std::unique_ptr<StatsReader> reader;
+        std::unique_ptr<StatsSnapshot> previous = std::make_unique<StatsSnapshot>();
+        std::unique_ptr<StatsSnapshot> current = std::make_unique<StatsSnapshot>();
+        std::unique_ptr<StatsSnapshot> scratch = std::make_unique<StatsSnapshot>();
+        bool hasPrevious = false;
+    };
+
+    void EnableEscapeSequences()
+    {
+#ifdef _WIN32
+        HANDLE console = GetStdHandle(STD_OUTPUT_HANDLE);
+        DWORD mode = 0;
+        if (GetConsoleMode(console, &mode)) {
+            SetConsoleMode(console, mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING);
+        }
+#endif
+    }
+
+    double Rate(uint64_t current, uint64_t previous, double seconds)
+    {
+        return current >= previous && seconds > 0.0 ? static_cast<double>(current - previous) / seconds : 0.0;
+    }
+
+    std::string Milliseconds(uint64_t microseconds)
+    {
+        std::ostringstream stream;
+        stream << std::fixed << std::setprecision(1) << static_cast<double>(microseconds) / 1000.0;
+        return stream.str();
+    }
+
+    void RenderProcess(std::ostringstream &output, const WatchedProcess &process)
+    {
+        auto &current = *process.current;
+        auto &previous = *process.previous;
+
+        auto age = std::chrono::system_clock::now().time_since_epoch() - std::chrono::nanoseconds(current.publishedAt);
+        double seconds = process.hasPrevious ? static_cast<double>(current.publishedAt - previous.publishedAt) / 1e9 : 0.0;
+
+        output << "Process " << current.pid << " (updated " << std::fixed << std::setprecision(1) << std::chrono::duration<double>(age).count() << " s ago";
+        if (!std::filesystem::exists(process.reader->Path())) {
+            output << ", exited";
+        } else if (age > c_staleAfter) {
+            output << ", not responding";
+        }
+        output << ")\n";
+
+        output << "  " << std::left << std::setw(20) << "Bridge" << std::setw(10) << "State" << std::right
+               << std::setw(9) << "RX/s" << std::setw(11) << "RX KiB/s" << std::setw(9) << "TX/s" << std::setw(11) << "TX KiB/s"
+               << std::setw(11) << "Queue C/B" << std::setw(12) << "Queued KiB" << std::setw(22) << "Write p50/p90/p99 ms"
+               << std::setw(8) << "Errors" << std::setw(8) << "Retries" << std::setw(8) << "Recov" << std::setw(9) << "Dropped"
+               << std::setw(10) << "Conflated" << std::setw(6) << "RSSI" << std::setw(7) << "CPU %" << std::setw(10) << "Mem KiB" << "\n";
+
+        for (uint32_t i = 0; i < std::min<uint32_t>(current.bridgeCount, StatsSnapshot::MaxBridges); i++) {
+            auto &bridge = current.bridges[i];
+
+            // Rates are only known once the same bridge was seen in two different snapshots
+            const BridgeStatsRecord *before = process.hasPrevious && i < previous.bridgeCount ? &previous.bridges[i] : nullptr;
+            double window = before != nullptr ? seconds : 0.0;
+            auto rate = [before, window](uint64_t BridgeStatsRecord::*field, const BridgeStatsRecord &now) {
+                return before != nullptr ? Rate(now.*field, before->*field, window) : 0.0;
+            };
+
+            // CPU time over wall time, 100% is one core fully busy with the bridge
+            double cpu = before != nullptr ? (Rate(bridge.threadCpuTime, before->threadCpuTime, window) + Rate(bridge.callbackCpuTime, before->callbackCpuTime, window)) / 1e7 : 0.0;
+
+            std::ostringstream queue, latency;
+            queue << bridge.controlFrames << "/" << bridge.bulkFrames;
+            latency << Milliseconds(bridge.writeLatencyP50) << "/" << Milliseconds(bridge.writeLatencyP90) << "/" << Milliseconds(bridge.writeLatencyP99);
+
+            output << "  " << std::left << std::setw(20) << bridge.name << std::setw(10) << (bridge.alive != 0 ? (bridge.polling != 0 ? "polling" : "up") : "down")
+                   << std::right << std::fixed << std::setprecision(1)
+                   << std::setw(9) << rate(&BridgeStatsRecord::notifications, bridge)
+                   << std::setw(11) << rate(&BridgeStatsRecord::bytesReceived, bridge) / 1024.0
+                   << std::setw(9) << rate(&BridgeStatsRecord::writes, bridge)
+                   << std::setw(11) << rate(&BridgeStatsRecord::bytesSent, bridge) / 1024.0
+                   << std::setw(11) << queue.str() << std::setw(12) << static_cast<double>(bridge.queuedBytes) / 1024.0
+                   << std::setw(22) << latency.str() << std::setw(8) << (bridge.writeErrors + bridge.heartbeatErrors) << std::setw(8) << bridge.retries
+                   << std::setw(8) << bridge.recoveries << std::setw(9) << bridge.droppedFrames << std::setw(10) << bridge.conflated
+                   << std::setw(6) << bridge.rssi << std::setw(7) << cpu << std::setw(10) << static_cast<double>(bridge.memoryBytes) / 1024.0 << "\n";
+        }
+
+        if (current.adapterCount != 0) {
+            output << "  " << std::left << std::setw(40) << "Adapter" << std::right << std::setw(14) << "Connections" << std::setw(11) << "KiB/s" << "\n";
+        }
+
+        for (uint32_t i = 0; i < std::min<uint32_t>(current.adapterCount, StatsSnapshot::MaxAdapters); i++) {
+            auto &adapter = current.adapters[i];
+            double transferred = process.hasPrevious && i < previous.adapterCount ? Rate(adapter.transferredBytes, previous.adapters[i].transferredBytes, seconds) : 0.0;
+
+            std::ostringstream connections;
+            connections << adapter.connections << "/" << adapter.maxConnections;
+
+            output << "  " << std::left << std::setw(40) << (adapter.id[0] == '\0' ? "(default)" : adapter.id) << std::right
+                   << std::setw(14) << connections.str() << std::setw(11) << std::fixed << std::setprecision(1) << transferred / 1024.0 << "\n";
+        }
+
+        output << "\n";
+    }
+}
+
+int Stats(const StatsViewSettings &settings, const std::atomic_bool &stop)
+{
+    std::vector<std::string> paths;
+    if (settings.process.empty()) {
+        paths = FindPublishedStats();
+    } else {
+        paths.push_back((std::filesystem::path { GetStatsDirectory() } / (settings.process + ".stats")).string());
+    }
+
+    std::vector<WatchedProcess> processes;
+    for (const auto &path : paths) {
+        try {
+            processes.push_back(WatchedProcess { .reader = std::make_unique<StatsReader>(path) });
+        } catch (const IOException &) {
+            // Snapshots of exited processes may be removed while listing them
+            if (!settings.process.empty()) {
+                throw;
+            }
+        }
+    }
+
+    if (processes.empty()) {
+        std::cerr << "No running bridges found in " << GetStatsDirectory() << std::endl;
+        return 1;
+    }
+
+    EnableEscapeSequences();
+
+    std::ostringstream output;
+    while (!stop.load()) {
+        output.str("");
+        output << "\x1b[H\x1b[2J" << "ble_serial stats, refreshing every " << settings.refresh.count() << " ms, press Ctrl+C to stop\n\n";
+
+        for (auto &process : processes) {
+            if (process.reader->Read(*process.scratch) && process.scratch->publishedAt != process.current->publishedAt) {
+                process.hasPrevious = process.current->publishedAt != 0;
+                std::swap(process.previous, process.current);
+                std::swap(process.current, process.scratch);
+            }
+
+            if (process.current->publishedAt != 0) {
+                RenderProcess(output, process);
+            }
+        }
+
+        std::cout << output.str() << std::flush;
+        std::this_thread::sleep_for(settings.refresh);
+    }
+
+    return 0;
+}
@@ -0,0 +1,29 @@
+#ifndef BLE_SERIAL_SRC_STATS_VIEW_HPP_
+#define BLE_SERIAL_SRC_STATS_VIEW_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <string>
+
+/**
+ * @brief Settings of the stats command.
+ */
+struct StatsViewSettings
+{
+    std::string process {};                          ///< process id to watch, empty to watch every running bridge
+    std::chrono::milliseconds refresh { 1000 };      ///< how often the view is redrawn
+};
+
+/**
+ * @brief Shows a refreshing table of the metrics published by running bridges until interrupted.
+ *
+ * Only the shared memory snapshots of the bridges are read, the bridges themselves are never contacted.
+ *
+ * @param settings settings of the view
+ * @param stop flag that ends the view when set
+ *
+ * @return exit code of the application
+ */
+int Stats(const StatsViewSettings &settings, const std::atomic_bool &stop);
+
+#endif // BLE_SERIAL_SRC_STATS_VIEW_HPP_
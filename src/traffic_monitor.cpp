@@ -0,0 +1,229 @@
+#include <ble_serial/traffic_monitor.hpp>
+#include <ble_serial/format.hpp>
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <ctime>
+
+namespace BLE_Serial::Bridge
+{
+    namespace
+    {
+        void AppendInteger(std::string &output, uint64_t value)
+        {
+            char buffer[24];
+            auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+            output.append(buffer, result.ptr);
+        }
+
+        void AppendFixed(std::string &output, double value)
+        {
+            char buffer[32];
+            auto result = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::fixed, 2);
+            output.append(buffer, result.ptr);
+        }
+
+        void AppendMilliseconds(std::string &output, int64_t nanoseconds)
+        {
+            AppendFixed(output, static_cast<double>(nanoseconds) / 1e6);
+            output.append(" ms");
+        }
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // TrafficMonitor implementation                        //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    TrafficMonitor::TrafficMonitor(TrafficMonitorOptions options, std::ostream &output)
+            : m_options { options }, m_output { output }
+    {
+        m_pending.reserve(m_options.maxPending);
+        m_draining.reserve(m_options.maxPending);
+    }
+
+    TrafficMonitor::~TrafficMonitor()
+    {
+        Stop();
+    }
+
+    void TrafficMonitor::Start()
+    {
+        if (m_thread.joinable()) {
+            return;
+        }
+
+        m_exiting = false;
+        m_thread = std::thread([this]() { Run(); });
+    }
+
+    void TrafficMonitor::Stop()
+    {
+        if (!m_thread.joinable()) {
+            return;
+        }
+
+        {
+            std::unique_lock<std::mutex> lock { m_mutex };
+            m_exiting = true;
+            m_condition.notify_all();
+        }
+
+        m_thread.join();
+    }
+
+    void TrafficMonitor::Record(TrafficDirection direction, const uint8_t *data, size_t size, std::chrono::steady_clock::duration latency) noexcept
+    {
+        RecordHeader header {
+                .time = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count(),
+                .latency = std::chrono::duration_cast<std::chrono::nanoseconds>(latency).count(),
+                .size = static_cast<uint32_t>(size),
+                .direction = direction
+        };
+
+        std::unique_lock<std::mutex> lock { m_mutex };
+
+        if (m_pending.size() + sizeof(header) + size > m_options.maxPending) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        // Never reallocates, the buffer was reserved for the whole limit
+        auto offset = m_pending.size();
+        m_pending.resize(offset + sizeof(header) + size);
+        std::memcpy(m_pending.data() + offset, &header, sizeof(header));
+        std::memcpy(m_pending.data() + offset + sizeof(header), data, size);
+    }
+
+    void TrafficMonitor::Run()
+    {
+        auto lastRender = std::chrono::steady_clock::now();
+
+        for (;;) {
+            bool exiting;
+
+            {
+                std::unique_lock<std::mutex> lock { m_mutex };
+                m_condition.wait_for(lock, m_options.refresh, [this]() { return m_exiting; });
+
+                exiting = m_exiting;
+                m_draining.clear();
+                m_draining.swap(m_pending);
+            }
+
+            auto now = std::chrono::steady_clock::now();
+            Render(now - lastRender);
+            lastRender = now;
+
+            if (exiting) {
+                return;
+            }
+        }
+    }
+
+    void TrafficMonitor::Render(std::chrono::steady_clock::duration elapsed)
+    {
+        DirectionStats window[2] {};
+        m_text.clear();
+
+        for (size_t offset = 0; offset + sizeof(RecordHeader) <= m_draining.size();) {
+            RecordHeader header {};
+            std::memcpy(&header, m_draining.data() + offset, sizeof(header));
+            const uint8_t *data = m_draining.data() + offset + sizeof(header);
+            offset += sizeof(header) + header.size;
+
+            auto &total = m_stats[static_cast<size_t>(header.direction)];
+            auto &current = window[static_cast<size_t>(header.direction)];
+
+            AppendTimestamp(header.time);
+            m_text.append(header.direction == TrafficDirection::Received ? " RX " : " TX ");
+            AppendInteger(m_text, header.size);
+            m_text.append(" bytes");
+
+            if (header.latency != 0) {
+                m_text.append(" in ");
+                AppendMilliseconds(m_text, header.latency);
+                current.latencyCount++;
+                current.latencyTotal += header.latency;
+                current.latencyMax = std::max(current.latencyMax, header.latency);
+            } else if (total.lastTime != 0) {
+                m_text.append(" +");
+                AppendMilliseconds(m_text, header.time - total.lastTime);
+            }
+
+            m_text.push_back('\n');
+
+            if (m_options.hexdump) {
+                Format::HexDump(m_text, data, header.size, "    ");
+            }
+
+            total.lastTime = header.time;
+            total.packets++;
+            total.bytes += header.size;
+            current.packets++;
+            current.bytes += header.size;
+        }
+
+        uint64_t dropped = m_dropped.exchange(0, std::memory_order_relaxed);
+        if (window[0].packets == 0 && window[1].packets == 0 && dropped == 0) {
+            return;
+        }
+
+        double seconds = std::max(std::chrono::duration<double>(elapsed).count(), 0.001);
+        m_text.append("--");
+
+        for (size_t i = 0; i < 2; i++) {
+            m_text.append(i == 0 ? " RX " : " | TX ");
+            AppendFixed(m_text, static_cast<double>(window[i].packets) / seconds);
+            m_text.append(" pkt/s ");
+            AppendFixed(m_text, static_cast<double>(window[i].bytes) / 1024.0 / seconds);
+            m_text.append(" KiB/s");
+
+            if (window[i].latencyCount != 0) {
+                m_text.append(", latency avg ");
+                AppendMilliseconds(m_text, window[i].latencyTotal / static_cast<int64_t>(window[i].latencyCount));
+                m_text.append(" max ");
+                AppendMilliseconds(m_text, window[i].latencyMax);
+            }
+        }
+
+        if (dropped != 0) {
+            m_text.append(" | ");
+            AppendInteger(m_text, dropped);
+            m_text.append(" not shown");
+        }
+
+        m_text.push_back('\n');
+
+        m_output.write(m_text.data(), static_cast<std::streamsize>(m_text.size()));
+        m_output.flush();
+    }
+
+    void TrafficMonitor::AppendTimestamp(int64_t time)
+    {
+        int64_t second = time / 1000000000;
+
+        // Converting to the local time is expensive, it is done once per second
+        if (second != m_cachedSecond) {
+            m_cachedSecond = second;
+
+            std::time_t clock = static_cast<std::time_t>(second);
+            std::tm local {};
+#ifdef _WIN32
+            localtime_s(&local, &clock);
+#else
+            localtime_r(&clock, &local);
+#endif
+            std::strftime(m_cachedClock, sizeof(m_cachedClock), "%H:%M:%S", &local);
+        }
+
+        int milliseconds = static_cast<int>(time / 1000000 % 1000);
+        char fraction[3] = { static_cast<char>('0' + milliseconds / 100), static_cast<char>('0' + milliseconds / 10 % 10), static_cast<char>('0' + milliseconds % 10) };
+
+        m_text.append(m_cachedClock, 8);
+        m_text.push_back('.');
+        m_text.append(fraction, 3);
+    }
+}
@@ -0,0 +1,153 @@
+#include "transfer.hpp"
+#include "endpoint.hpp"
+
+#include <ble_serial/async_writer.hpp>
+#include <ble_serial/mapped_file.hpp>
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace BLE_Serial::Bluetooth;
+using namespace BLE_Serial::IO;
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    constexpr std::chrono::milliseconds c_progressInterval { 500 };
+    constexpr int c_maxWriteAttempts = 5;
+
+    void PrintProgress(uint64_t bytes, uint64_t total, Clock::duration elapsed, bool last)
+    {
+        double seconds = std::max(std::chrono::duration<double>(elapsed).count(), 0.001);
+
+        std::cout << "\r" << bytes;
+        if (total != 0) {
+            std::cout << "/" << total << " bytes (" << (bytes * 100 / total) << "%)";
+        } else {
+            std::cout << " bytes";
+        }
+
+        std::cout << std::fixed << std::setprecision(2) << ", " << static_cast<double>(bytes) / 1024.0 / seconds << " KiB/s   ";
+        std::cout << std::defaultfloat;
+
+        if (last) {
+            std::cout << "\nTransferred " << bytes << " bytes in " << std::fixed << std::setprecision(2) << seconds << " s" << std::defaultfloat << std::endl;
+        } else {
+            std::cout << std::flush;
+        }
+    }
+}
+
+int Send(const TransferSettings &settings, const std::atomic_bool &stop)
+{
+    auto file = MappedFile::OpenReadOnly(settings.file);
+    auto endpoint = OpenEndpoint(settings.address, settings.serviceId, settings.characteristicId, settings.timeout);
+    auto &characteristic = *endpoint.characteristic;
+
+    auto mode = settings.writeMode.value_or(HasProperty(characteristic.GetProperties(), GattCharacteristicProperty::WriteWithoutResponse)
+                                            ? GattWriteMode::WithoutResponse : GattWriteMode::WithResponse);
+    size_t chunkSize = endpoint.connection->GetMaxWriteSize();
+
+    std::cout << "Sending " << file.Size() << " bytes in chunks of " << chunkSize << " bytes "
+              << (mode == GattWriteMode::WithoutResponse ? "without" : "with") << " response" << std::endl;
+
+    std::vector<uint8_t> chunk;
+    chunk.reserve(chunkSize);
+
+    auto start = Clock::now();
+    auto lastProgress = start;
+    size_t offset = 0;
+
+    while (offset < file.Size() && !stop.load()) {
+        size_t size = std::min(chunkSize, file.Size() - offset);
+        chunk.assign(file.Data() + offset, file.Data() + offset + size);
+
+        // Writes without response fail when the controller's queue is full, give it a moment to drain
+        for (int attempt = 1;; attempt++) {
+            try {
+                characteristic.Write(chunk, mode);
+                break;
+            } catch (const BluetoothException &) {
+                if (mode == GattWriteMode::WithResponse || attempt == c_maxWriteAttempts) {
+                    throw;
+                }
+
+                std::this_thread::sleep_for(std::chrono::milliseconds(5 * attempt));
+            }
+        }
+
+        offset += size;
+
+        if (settings.rate != 0) {
+            std::this_thread::sleep_until(start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(static_cast<double>(offset) / static_cast<double>(settings.rate))));
+        }
+
+        auto now = Clock::now();
+        if (now - lastProgress >= c_progressInterval) {
+            lastProgress = now;
+            PrintProgress(offset, file.Size(), now - start, false);
+        }
+    }
+
+    PrintProgress(offset, file.Size(), Clock::now() - start, true);
+    endpoint.connection->Close();
+
+    return offset == file.Size() ? 0 : 1;
+}
+
+int Receive(const TransferSettings &settings, const std::atomic_bool &stop)
+{
+    AsyncFileWriter writer { settings.file };
+    auto endpoint = OpenEndpoint(settings.address, settings.serviceId, settings.characteristicId, settings.timeout);
+
+    std::atomic<uint64_t> received { 0 };
+    std::atomic<Clock::rep> lastActivity { 0 };
+    std::atomic_bool failed { false };
+
+    auto id = endpoint.characteristic->Subscribe([&](std::vector<uint8_t> data) {
+        try {
+            writer.Append(data.data(), data.size());
+        } catch (const IOException &) {
+            failed.store(true);
+        }
+
+        received.fetch_add(data.size());
+        lastActivity.store(Clock::now().time_since_epoch().count());
+    });
+
+    std::cout << "Receiving into " << settings.file << ", press Ctrl+C to stop" << std::endl;
+    auto start = Clock::now();
+
+    while (!stop.load() && !failed.load()) {
+        std::this_thread::sleep_for(c_progressInterval);
+
+        auto last = lastActivity.load();
+        if (settings.idleTimeout.count() != 0 && last != 0 && Clock::now() - Clock::time_point { Clock::duration { last }} >= settings.idleTimeout) {
+            break;
+        }
+
+        // The throughput is measured from the first notification
+        if (last != 0) {
+            PrintProgress(received.load(), 0, Clock::now() - start, false);
+        } else {
+            start = Clock::now();
+        }
+    }
+
+    endpoint.characteristic->Unsubscribe(id);
+    writer.Close();
+
+    PrintProgress(received.load(), 0, Clock::now() - start, true);
+    endpoint.connection->Close();
+
+    if (failed.load()) {
+        std::cerr << "Writing to " << settings.file << " failed" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,58 @@
+#ifndef BLE_SERIAL_SRC_TRANSFER_HPP_
+#define BLE_SERIAL_SRC_TRANSFER_HPP_
+
+#include <ble_serial/bluetooth.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <string>
+
+/**
+ * @brief Settings of a file transfer over a characteristic.
+ */
+struct TransferSettings
+{
+    BLE_Serial::Bluetooth::BluetoothAddress address;
+    BLE_Serial::Bluetooth::GattRegisteredService serviceId;
+    BLE_Serial::Bluetooth::GattRegisteredCharacteristic characteristicId;
+    std::string file;
+    std::chrono::seconds timeout { 5 };
+
+    /**
+     * Send only, write mode to use, the fastest one the characteristic supports if empty.
+     */
+    std::optional<BLE_Serial::Bluetooth::GattWriteMode> writeMode {};
+
+    /**
+     * Send only, at how many bytes per second the file should be sent, zero means as fast as possible.
+     */
+    size_t rate = 0;
+
+    /**
+     * Receive only, how long without notifications ends the transfer, zero waits until interrupted.
+     */
+    std::chrono::milliseconds idleTimeout { 0 };
+};
+
+/**
+ * @brief Sends a file to a characteristic in chunks of the maximum write size.
+ *
+ * @param settings settings of the transfer
+ * @param stop flag that interrupts the transfer when set
+ *
+ * @return exit code of the application
+ */
+int Send(const TransferSettings &settings, const std::atomic_bool &stop);
+
+/**
+ * @brief Writes all notifications of a characteristic to a file.
+ *
+ * @param settings settings of the transfer
+ * @param stop flag that ends the transfer when set
+ *
+ * @return exit code of the application
+ */
+int Receive(const TransferSettings &settings, const std::atomic_bool &stop);
+
+#endif // BLE_SERIAL_SRC_TRANSFER_HPP_
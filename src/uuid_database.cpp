@@ -0,0 +1,501 @@
+#include <ble_serial/uuid_database.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <unordered_set>
+
+namespace BLE_Serial::Gatt
+{
+    using namespace Bluetooth;
+
+    namespace
+    {
+        constexpr char c_magic[8] = { 'B', 'L', 'E', 'U', 'U', 'I', 'D', 'S' };
+        constexpr uint32_t c_version = 1;
+
+        /**
+         * Header at the start of the file, all offsets are from the start of the file
+         */
+        struct FileHeader
+        {
+            char magic[8];
+            uint32_t version;
+            uint32_t recordCount;
+            uint32_t uuidBucketCount;       ///< power of two
+            uint32_t nameBucketCount;       ///< power of two
+            uint64_t recordsOffset;
+            uint64_t uuidBucketsOffset;
+            uint64_t nameBucketsOffset;
+            uint64_t stringsOffset;
+            uint64_t stringsSize;
+        };
+
+        /**
+         * Fixed-size record, the name lives in the string area
+         */
+        struct FileRecord
+        {
+            BluetoothUUID uuid;
+            uint32_t uuidHash;
+            uint32_t nameHash;
+            uint32_t nameOffset;            ///< from the start of the string area
+            uint16_t nameLength;
+            uint8_t kind;
+            uint8_t reserved;
+        };
+
+        static_assert(sizeof(BluetoothUUID) == 16);
+        static_assert(sizeof(FileHeader) == 64);
+        static_assert(sizeof(FileRecord) == 32);
+
+        /**
+         * Bluetooth base UUID 00000000-0000-1000-8000-00805F9B34FB
+         */
+        constexpr BluetoothUUID c_baseUuid { 0x00000000, 0x0000, 0x1000, { 0x80, 0x00, 0x00, 0x80, 0x5F, 0x9B, 0x34, 0xFB } };
+
+        /**
+         * Buckets hold the index of the record plus one, zero marks an empty bucket
+         */
+        constexpr uint32_t c_emptyBucket = 0;
+
+        char ToLower(char c) noexcept
+        {
+            return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+        }
+
+        /**
+         * FNV-1a, optionally folding ASCII letters to lower case
+         */
+        uint32_t Hash(const void *data, size_t size, bool foldCase) noexcept
+        {
+            uint32_t hash = 2166136261u;
+            auto bytes = static_cast<const char *>(data);
+            for (size_t i = 0; i < size; i++) {
+                hash ^= static_cast<uint8_t>(foldCase ? ToLower(bytes[i]) : bytes[i]);
+                hash *= 16777619u;
+            }
+            return hash;
+        }
+
+        uint32_t HashUuid(const BluetoothUUID &uuid) noexcept
+        {
+            return Hash(&uuid, sizeof(uuid), false);
+        }
+
+        uint32_t HashName(std::string_view name) noexcept
+        {
+            return Hash(name.data(), name.size(), true);
+        }
+
+        bool EqualsIgnoreCase(std::string_view lhs, std::string_view rhs) noexcept
+        {
+            return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin(), [](char a, char b) { return ToLower(a) == ToLower(b); });
+        }
+
+        /**
+         * Smallest power of two keeping the load factor of the table at most a half
+         */
+        uint32_t BucketCount(size_t records)
+        {
+            uint32_t count = 16;
+            while (count < records * 2) {
+                count *= 2;
+            }
+            return count;
+        }
+
+        size_t AlignUp(size_t value) noexcept
+        {
+            return (value + 7) & ~static_cast<size_t>(7);
+        }
+
+        std::string_view Trim(std::string_view string) noexcept
+        {
+            while (!string.empty() && (string.front() == ' ' || string.front() == '\t')) {
+                string.remove_prefix(1);
+            }
+            while (!string.empty() && (string.back() == ' ' || string.back() == '\t' || string.back() == '\r')) {
+                string.remove_suffix(1);
+            }
+            return string;
+        }
+
+        std::string_view Unquote(std::string_view value) noexcept
+        {
+            if (value.size() >= 2 && (value.front() == '"' || value.front() == '\'') && value.back() == value.front()) {
+                return value.substr(1, value.size() - 2);
+            }
+            return value;
+        }
+
+        std::optional<UuidKind> KindFromString(std::string_view kind) noexcept
+        {
+            if (kind == "service") {
+                return UuidKind::Service;
+            } else if (kind == "characteristic") {
+                return UuidKind::Characteristic;
+            } else if (kind == "descriptor") {
+                return UuidKind::Descriptor;
+            }
+            return std::nullopt;
+        }
+
+        /**
+         * Entry of a YAML list while it is being read
+         */
+        struct PendingDefinition
+        {
+            size_t line = 0;
+            std::string uuid {};
+            std::string name {};
+            std::optional<UuidKind> kind {};
+            std::optional<UuidKind> idKind {};
+        };
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // Public functions                                     //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    std::optional<BluetoothUUID> ParseUuid(std::string_view string)
+    {
+        if (string.starts_with("0x") || string.starts_with("0X")) {
+            string.remove_prefix(2);
+        }
+
+        uint8_t digits[32];
+        size_t count = 0;
+        for (size_t i = 0; i < string.size(); i++) {
+            char c = string[i];
+            if (c == '-' && string.size() == 36 && (i == 8 || i == 13 || i == 18 || i == 23)) {
+                continue;
+            }
+
+            if (count == 32) {
+                return std::nullopt;
+            }
+
+            if (c >= '0' && c <= '9') {
+                digits[count++] = static_cast<uint8_t>(c - '0');
+            } else if (ToLower(c) >= 'a' && ToLower(c) <= 'f') {
+                digits[count++] = static_cast<uint8_t>(ToLower(c) - 'a' + 10);
+            } else {
+                return std::nullopt;
+            }
+        }
+
+        auto read = [&digits](size_t from, size_t length) {
+            uint32_t value = 0;
+            for (size_t i = from; i < from + length; i++) {
+                value = (value << 4) | digits[i];
+            }
+            return value;
+        };
+
+        if (count == 4 || count == 8) {
+            BluetoothUUID result = c_baseUuid;
+            result.custom = read(0, count);
+            return result;
+        }
+
+        if (count != 32 || (string.size() != 32 && string.size() != 36)) {
+            return std::nullopt;
+        }
+
+        BluetoothUUID result {};
+        result.custom = read(0, 8);
+        result.part2 = static_cast<uint16_t>(read(8, 4));
+        result.part3 = static_cast<uint16_t>(read(12, 4));
+        for (size_t i = 0; i < 8; i++) {
+            result.part4[i] = static_cast<uint8_t>(read(16 + i * 2, 2));
+        }
+        return result;
+    }
+
+    bool IsBaseUuid(const BluetoothUUID &uuid)
+    {
+        return uuid.part2 == c_baseUuid.part2 && uuid.part3 == c_baseUuid.part3 && memcmp(uuid.part4, c_baseUuid.part4, sizeof(uuid.part4)) == 0;
+    }
+
+    std::vector<UuidDefinition> ParseUuidDefinitions(std::istream &input, UuidKind kind, const std::string &source)
+    {
+        std::vector<UuidDefinition> result;
+        std::optional<PendingDefinition> pending;
+
+        auto flush = [&]() {
+            if (!pending) {
+                return;
+            }
+
+            auto location = source + ":" + std::to_string(pending->line);
+            if (pending->uuid.empty() || pending->name.empty()) {
+                throw std::invalid_argument(location + ": an entry needs both a uuid and a name");
+            }
+
+            auto uuid = ParseUuid(pending->uuid);
+            if (!uuid) {
+                throw std::invalid_argument(location + ": malformed uuid " + pending->uuid);
+            }
+
+            result.push_back(UuidDefinition { .uuid = *uuid, .kind = pending->kind.value_or(pending->idKind.value_or(kind)), .name = std::move(pending->name) });
+            pending.reset();
+        };
+
+        std::string line;
+        size_t lineNumber = 0;
+        while (std::getline(input, line)) {
+            lineNumber++;
+
+            auto content = Trim(line);
+            if (content.empty() || content.front() == '#') {
+                continue;
+            }
+
+            // A dash opens the next entry of the list
+            if (content.starts_with("- ") || content == "-") {
+                flush();
+                pending = PendingDefinition { .line = lineNumber };
+                content = Trim(content.substr(1));
+            }
+
+            auto colon = content.find(':');
+            if (!pending || colon == std::string_view::npos) {
+                continue;
+            }
+
+            auto key = Trim(content.substr(0, colon));
+            auto value = Unquote(Trim(content.substr(colon + 1)));
+
+            if (key == "uuid") {
+                pending->uuid = value;
+            } else if (key == "name") {
+                pending->name = value;
+            } else if (key == "kind") {
+                pending->kind = KindFromString(value);
+                if (!pending->kind) {
+                    throw std::invalid_argument(source + ":" + std::to_string(lineNumber) + ": unknown kind " + std::string { value });
+                }
+            } else if (key == "id") {
+                // i.e. org.bluetooth.characteristic.heart_rate_measurement
+                for (auto [prefix, idKind] : { std::pair { "org.bluetooth.service.", UuidKind::Service }, std::pair { "org.bluetooth.characteristic.", UuidKind::Characteristic },
+                                               std::pair { "org.bluetooth.descriptor.", UuidKind::Descriptor } }) {
+                    if (value.starts_with(prefix)) {
+                        pending->idKind = idKind;
+                    }
+                }
+            }
+        }
+
+        flush();
+        return result;
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // UuidDatabase implementation                          //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    void UuidDatabase::Write(const std::string &path, const std::vector<UuidDefinition> &definitions)
+    {
+        // The last definition of a UUID wins
+        std::vector<const UuidDefinition *> unique;
+        std::unordered_set<std::string> seen;
+        for (auto it = definitions.rbegin(); it != definitions.rend(); ++it) {
+            if (it->name.size() > UINT16_MAX) {
+                throw std::invalid_argument("Name of a uuid is too long: " + it->name.substr(0, 64) + "...");
+            }
+            if (seen.emplace(reinterpret_cast<const char *>(&it->uuid), sizeof(BluetoothUUID)).second) {
+                unique.push_back(&*it);
+            }
+        }
+        std::reverse(unique.begin(), unique.end());
+
+        size_t stringsSize = 0;
+        for (auto definition : unique) {
+            stringsSize += definition->name.size();
+        }
+
+        uint32_t uuidBucketCount = BucketCount(unique.size());
+        uint32_t nameBucketCount = BucketCount(unique.size());
+
+        FileHeader header {};
+        memcpy(header.magic, c_magic, sizeof(c_magic));
+        header.version = c_version;
+        header.recordCount = static_cast<uint32_t>(unique.size());
+        header.uuidBucketCount = uuidBucketCount;
+        header.nameBucketCount = nameBucketCount;
+        header.recordsOffset = sizeof(FileHeader);
+        header.uuidBucketsOffset = AlignUp(header.recordsOffset + unique.size() * sizeof(FileRecord));
+        header.nameBucketsOffset = AlignUp(header.uuidBucketsOffset + uuidBucketCount * sizeof(uint32_t));
+        header.stringsOffset = AlignUp(header.nameBucketsOffset + nameBucketCount * sizeof(uint32_t));
+        header.stringsSize = stringsSize;
+
+        // Built next to the target and renamed over it, so a failed build never leaves a torn database behind. On POSIX
+        // systems processes that have the old file mapped keep reading it, Windows refuses to replace a mapped file
+        auto temporaryPath = path + ".tmp";
+        {
+            auto file = IO::MappedFile::Create(temporaryPath, header.stringsOffset + std::max<size_t>(stringsSize, 1));
+            auto data = file.Data();
+            memcpy(data, &header, sizeof(header));
+
+            auto records = reinterpret_cast<FileRecord *>(data + header.recordsOffset);
+            auto uuidBuckets = reinterpret_cast<uint32_t *>(data + header.uuidBucketsOffset);
+            auto nameBuckets = reinterpret_cast<uint32_t *>(data + header.nameBucketsOffset);
+            auto strings = reinterpret_cast<char *>(data + header.stringsOffset);
+
+            uint32_t nameOffset = 0;
+            for (uint32_t i = 0; i < unique.size(); i++) {
+                auto &definition = *unique[i];
+                auto &record = records[i];
+
+                record.uuid = definition.uuid;
+                record.uuidHash = HashUuid(definition.uuid);
+                record.nameHash = HashName(definition.name);
+                record.nameOffset = nameOffset;
+                record.nameLength = static_cast<uint16_t>(definition.name.size());
+                record.kind = static_cast<uint8_t>(definition.kind);
+
+                memcpy(strings + nameOffset, definition.name.data(), definition.name.size());
+                nameOffset += static_cast<uint32_t>(definition.name.size());
+
+                // Linear probing, the tables are at most half full so a free bucket is always found
+                uint32_t bucket = record.uuidHash & (uuidBucketCount - 1);
+                while (uuidBuckets[bucket] != c_emptyBucket) {
+                    bucket = (bucket + 1) & (uuidBucketCount - 1);
+                }
+                uuidBuckets[bucket] = i + 1;
+
+                bucket = record.nameHash & (nameBucketCount - 1);
+                while (nameBuckets[bucket] != c_emptyBucket) {
+                    bucket = (bucket + 1) & (nameBucketCount - 1);
+                }
+                nameBuckets[bucket] = i + 1;
+            }
+        }
+
+        std::error_code error;
+        std::filesystem::rename(temporaryPath, path, error);
+        if (error) {
+            IO::MappedFile::Remove(temporaryPath);
+            throw IO::IOException("Failed to replace " + path + ": " + error.message());
+        }
+    }
+
+    UuidDatabase UuidDatabase::Open(const std::string &path)
+    {
+        UuidDatabase result;
+        result.m_file = IO::MappedFile::OpenReadOnly(path);
+
+        auto size = result.m_file.Size();
+        if (size < sizeof(FileHeader)) {
+            throw IO::IOException(path + " is not a uuid database");
+        }
+
+        auto &header = *reinterpret_cast<const FileHeader *>(result.m_file.Data());
+        if (memcmp(header.magic, c_magic, sizeof(c_magic)) != 0) {
+            throw IO::IOException(path + " is not a uuid database");
+        }
+        if (header.version != c_version) {
+            throw IO::IOException(path + " has unsupported version " + std::to_string(header.version) + ", rebuild it");
+        }
+
+        // Everything a lookup may touch must lie inside the file, the records themselves are checked when read
+        auto isPowerOfTwo = [](uint32_t value) { return value != 0 && (value & (value - 1)) == 0; };
+        auto fits = [size](uint64_t offset, uint64_t length) { return offset % 8 == 0 && offset <= size && length <= size - offset; };
+        if (!isPowerOfTwo(header.uuidBucketCount) || !isPowerOfTwo(header.nameBucketCount) || header.recordCount >= header.uuidBucketCount ||
+            header.recordCount >= header.nameBucketCount || !fits(header.recordsOffset, uint64_t { header.recordCount } * sizeof(FileRecord)) ||
+            !fits(header.uuidBucketsOffset, uint64_t { header.uuidBucketCount } * sizeof(uint32_t)) ||
+            !fits(header.nameBucketsOffset, uint64_t { header.nameBucketCount } * sizeof(uint32_t)) || !fits(header.stringsOffset, header.stringsSize)) {
+            throw IO::IOException(path + " is corrupted");
+        }
+
+        return result;
+    }
+
+    std::optional<UuidRecord> UuidDatabase::Find(const BluetoothUUID &uuid) const noexcept
+    {
+        if (!m_file.Data()) {
+            return std::nullopt;
+        }
+
+        auto data = m_file.Data();
+        auto &header = *reinterpret_cast<const FileHeader *>(data);
+        auto records = reinterpret_cast<const FileRecord *>(data + header.recordsOffset);
+        auto buckets = reinterpret_cast<const uint32_t *>(data + header.uuidBucketsOffset);
+
+        uint32_t hash = HashUuid(uuid);
+        uint32_t mask = header.uuidBucketCount - 1;
+        for (uint32_t bucket = hash & mask, probes = 0; probes <= mask; bucket = (bucket + 1) & mask, probes++) {
+            uint32_t index = buckets[bucket];
+            if (index == c_emptyBucket || index > header.recordCount) {
+                break;
+            }
+
+            auto &record = records[index - 1];
+            if (record.uuidHash == hash && uuid == record.uuid) {
+                return GetRecord(index - 1);
+            }
+        }
+
+        return std::nullopt;
+    }
+
+    std::optional<UuidRecord> UuidDatabase::FindByName(std::string_view name, UuidKind kind) const noexcept
+    {
+        if (!m_file.Data()) {
+            return std::nullopt;
+        }
+
+        auto data = m_file.Data();
+        auto &header = *reinterpret_cast<const FileHeader *>(data);
+        auto records = reinterpret_cast<const FileRecord *>(data + header.recordsOffset);
+        auto buckets = reinterpret_cast<const uint32_t *>(data + header.nameBucketsOffset);
+
+        // Names are not unique, i.e. a service and its characteristic may share one, so the whole run is searched
+        uint32_t hash = HashName(name);
+        uint32_t mask = header.nameBucketCount - 1;
+        uint32_t found = c_emptyBucket;
+        for (uint32_t bucket = hash & mask, probes = 0; probes <= mask; bucket = (bucket + 1) & mask, probes++) {
+            uint32_t index = buckets[bucket];
+            if (index == c_emptyBucket || index > header.recordCount) {
+                break;
+            }
+
+            auto &record = records[index - 1];
+            if (record.nameHash != hash || (kind != UuidKind::Other && record.kind != static_cast<uint8_t>(kind))) {
+                continue;
+            }
+
+            // The earliest record wins, the buckets of a run are not in the order of the records
+            if ((found == c_emptyBucket || index < found) && EqualsIgnoreCase(GetRecord(index - 1).name, name)) {
+                found = index;
+            }
+        }
+
+        return found == c_emptyBucket ? std::nullopt : std::make_optional(GetRecord(found - 1));
+    }
+
+    size_t UuidDatabase::Size() const noexcept
+    {
+        return m_file.Data() ? reinterpret_cast<const FileHeader *>(m_file.Data())->recordCount : 0;
+    }
+
+    UuidRecord UuidDatabase::GetRecord(uint32_t index) const noexcept
+    {
+        auto data = m_file.Data();
+        auto &header = *reinterpret_cast<const FileHeader *>(data);
+        auto &record = reinterpret_cast<const FileRecord *>(data + header.recordsOffset)[index];
+
+        std::string_view name {};
+        if (uint64_t { record.nameOffset } + record.nameLength <= header.stringsSize) {
+            name = { reinterpret_cast<const char *>(data + header.stringsOffset + record.nameOffset), record.nameLength };
+        }
+
+        return UuidRecord { .uuid = record.uuid, .kind = static_cast<UuidKind>(record.kind), .name = name };
+    }
+}
@@ -0,0 +1,103 @@
+#include "uuid_db.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+using namespace BLE_Serial::Bluetooth;
+using namespace BLE_Serial::Gatt;
+using namespace BLE_Serial::IO;
+
+namespace
+{
+    std::optional<UuidDatabase> g_uuidDatabase {}; // NOLINT(cert-err58-cpp)
+
+    /**
+     * Helper shared by the service and characteristic conversions
+     */
+    template<typename BuiltIn>
+    uint32_t IdFromString(const std::string &str, UuidKind kind, const char *what, BuiltIn &&builtIn)
+    {
+        // Plain hexadecimal ids keep working as they always did
+        try {
+            size_t parsed = 0;
+            auto id = std::stoul(str, &parsed, 16);
+            if (parsed == str.size() && id <= UINT32_MAX) {
+                return static_cast<uint32_t>(id);
+            }
+        } catch (const std::logic_error &ignored) {}
+
+        std::optional<BluetoothUUID> uuid = ParseUuid(str);
+        if (!uuid && g_uuidDatabase) {
+            if (auto record = g_uuidDatabase->FindByName(str, kind)) {
+                uuid = record->uuid;
+            }
+        }
+
+        if (uuid) {
+            if (!IsBaseUuid(*uuid)) {
+                throw std::invalid_argument(std::string { what } + " " + str + " is a 128-bit vendor UUID, only UUIDs based on the Bluetooth base UUID can be used");
+            }
+            return uuid->custom;
+        }
+
+        if (auto id = builtIn(str)) {
+            return static_cast<uint32_t>(*id);
+        }
+
+        throw std::invalid_argument(std::string { "Unknown " } + what + " " + str);
+    }
+}
+
+int BuildUuidDatabase(const UuidDbSettings &settings)
+{
+    std::vector<UuidDefinition> definitions;
+
+    for (auto &input : settings.inputs) {
+        std::ifstream stream { input };
+        if (!stream) {
+            throw IOException("Failed to open " + input);
+        }
+
+        auto parsed = ParseUuidDefinitions(stream, UuidKind::Other, input);
+        std::cout << input << ": " << parsed.size() << " uuids\n";
+        definitions.insert(definitions.end(), std::make_move_iterator(parsed.begin()), std::make_move_iterator(parsed.end()));
+    }
+
+    UuidDatabase::Write(settings.output, definitions);
+
+    auto database = UuidDatabase::Open(settings.output);
+    std::cout << "Wrote " << database.Size() << " uuids to " << settings.output << std::endl;
+    return 0;
+}
+
+void LoadUuidDatabase(const std::string &path)
+{
+    g_uuidDatabase = UuidDatabase::Open(path);
+}
+
+std::string DescribeUuid(const BluetoothUUID &uuid, const std::optional<std::string> &builtInName)
+{
+    if (g_uuidDatabase) {
+        if (auto record = g_uuidDatabase->Find(uuid)) {
+            return std::string { record->name };
+        }
+    }
+
+    // The built-in names are keyed by the short id, which only means something for base UUIDs
+    if (builtInName && IsBaseUuid(uuid)) {
+        return *builtInName;
+    }
+
+    return "unknown";
+}
+
+GattRegisteredService ServiceIdFromString(const std::string &str)
+{
+    return static_cast<GattRegisteredService>(IdFromString(str, UuidKind::Service, "service", &FindServiceByName));
+}
+
+GattRegisteredCharacteristic CharacteristicIdFromString(const std::string &str)
+{
+    return static_cast<GattRegisteredCharacteristic>(IdFromString(str, UuidKind::Characteristic, "characteristic", &FindCharacteristicByName));
+}
@@ -0,0 +1,73 @@
+#ifndef BLE_SERIAL_SRC_UUID_DB_HPP_
+#define BLE_SERIAL_SRC_UUID_DB_HPP_
+
+#include <ble_serial/uuid_database.hpp>
+
+#include <optional>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Settings of the uuiddb command.
+ */
+struct UuidDbSettings
+{
+    std::string output;               ///< path of the database to build
+    std::vector<std::string> inputs;  ///< YAML files in the order they are applied
+};
+
+/**
+ * @brief Compiles YAML definition files into a database that can be passed with --uuid-db.
+ *
+ * @param settings settings of the command
+ *
+ * @return exit code of the application
+ *
+ * @throw std::invalid_argument when an input is malformed
+ * @throw IOException when an input cannot be read or the database cannot be written
+ */
+int BuildUuidDatabase(const UuidDbSettings &settings);
+
+/**
+ * @brief Maps the database consulted by @link DescribeUuid @endlink and the id conversions.
+ *
+ * @param path path to the database
+ *
+ * @throw IOException when the database cannot be opened
+ */
+void LoadUuidDatabase(const std::string &path);
+
+/**
+ * @brief Names a UUID, preferring the loaded database over the built-in names.
+ *
+ * @param uuid the UUID
+ * @param builtInName name known to the library for the short id of the UUID
+ *
+ * @return the name or "unknown"
+ */
+std::string DescribeUuid(const BLE_Serial::Bluetooth::BluetoothUUID &uuid, const std::optional<std::string> &builtInName);
+
+/**
+ * @brief Converts a service argument, either a hexadecimal id, a UUID based on the Bluetooth base UUID or a name.
+ *
+ * @param str the argument
+ *
+ * @return the service id
+ *
+ * @throw std::invalid_argument when the argument names no known service or a vendor UUID
+ */
+BLE_Serial::Bluetooth::GattRegisteredService ServiceIdFromString(const std::string &str);
+
+/**
+ * @brief Converts a characteristic argument, either a hexadecimal id, a UUID based on the Bluetooth base UUID or a
+ * name.
+ *
+ * @param str the argument
+ *
+ * @return the characteristic id
+ *
+ * @throw std::invalid_argument when the argument names no known characteristic or a vendor UUID
+ */
+BLE_Serial::Bluetooth::GattRegisteredCharacteristic CharacteristicIdFromString(const std::string &str);
+
+#endif // BLE_SERIAL_SRC_UUID_DB_HPP_
@@ -0,0 +1,190 @@
+#include <ble_serial/aggregation.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+//////////////////////////////////////////////////////////
+//                                                      //
+// Platform stubs                                       //
+//                                                      //
+//////////////////////////////////////////////////////////
+
+namespace BLE_Serial::COM
+{
+    COMPort::COMPort(unsigned int, unsigned int, unsigned int, StopBits, Parity)
+            : m_handle { nullptr }
+    {
+    }
+
+    size_t COMPort::Read(uint8_t *, size_t)
+    {
+        return 0;
+    }
+
+    size_t COMPort::Write(const std::vector<uint8_t> &data)
+    {
+        return data.size();
+    }
+
+    void COMPort::Close()
+    {
+    }
+}
+
+using namespace BLE_Serial;
+
+namespace
+{
+    size_t g_failures = 0;
+
+    void Fail(const char *message)
+    {
+        g_failures++;
+        std::cerr << message << std::endl;
+    }
+
+    /**
+     * Helper feeding a reorder buffer with segments whose payload is their own sequence number
+     */
+    struct Reorder
+    {
+        std::vector<uint16_t> delivered {};
+        Bridge::ReorderBuffer buffer;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        explicit Reorder(size_t window)
+                : buffer { window, [this](std::vector<uint8_t> payload) { delivered.push_back(static_cast<uint16_t>(payload[0] | (payload[1] << 8))); } }
+        {
+        }
+
+        void Push(uint16_t sequence, std::chrono::milliseconds at = std::chrono::milliseconds(0))
+        {
+            buffer.Push(sequence, { static_cast<uint8_t>(sequence), static_cast<uint8_t>(sequence >> 8) }, start + at);
+        }
+    };
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // Reorder buffer                                       //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    void TestSynchronization()
+    {
+        // Joined in the middle of a stream, far from sequence number 0
+        Reorder reorder { 8 };
+        reorder.Push(40000);
+        reorder.Push(40002);
+        reorder.Push(40001);
+
+        if (reorder.delivered != std::vector<uint16_t> { 40000, 40001, 40002 }) {
+            Fail("Buffer did not synchronize to the first sequence number");
+        }
+
+        reorder.Push(40001);
+        auto metrics = reorder.buffer.Metrics();
+        if (metrics.duplicates != 1 || metrics.reordered != 1 || metrics.lost != 0) {
+            Fail("Delivered segment was not taken for a duplicate");
+        }
+    }
+
+    void TestWrap()
+    {
+        Reorder reorder { 8 };
+        reorder.Push(65534);
+        reorder.Push(0);
+        reorder.Push(65535);
+        reorder.Push(2);
+        reorder.Push(1);
+
+        if (reorder.delivered != std::vector<uint16_t> { 65534, 65535, 0, 1, 2 }) {
+            Fail("Segments around the wrap of the sequence numbers were delivered out of order");
+        }
+
+        if (reorder.buffer.GetHeldCount() != 0 || reorder.buffer.Metrics().duplicates != 0) {
+            Fail("Segments after the wrap were taken for duplicates");
+        }
+    }
+
+    void TestWindowOverflow()
+    {
+        Reorder reorder { 4 };
+        reorder.Push(10);
+        reorder.Push(12);
+        reorder.Push(13);
+        reorder.Push(14);
+
+        if (reorder.delivered != std::vector<uint16_t> { 10 } || reorder.buffer.GetHeldCount() != 3) {
+            Fail("Segments behind a missing one were not held");
+        }
+
+        // 15 no longer fits behind the missing 11, which is given up on
+        reorder.Push(15);
+
+        if (reorder.delivered != std::vector<uint16_t> { 10, 12, 13, 14, 15 } || reorder.buffer.GetHeldCount() != 0) {
+            Fail("Overflowing the window did not deliver the held segments");
+        }
+
+        auto metrics = reorder.buffer.Metrics();
+        if (metrics.lost != 1 || metrics.maxDepth != 3) {
+            Fail("Overflowing the window did not count the missing segment as lost");
+        }
+
+        // The late segment is behind the window now
+        reorder.Push(11);
+        if (reorder.buffer.Metrics().duplicates != 1 || reorder.delivered.size() != 5) {
+            Fail("Segment given up on was still delivered");
+        }
+    }
+
+    void TestGapExpiry()
+    {
+        using std::chrono::milliseconds;
+
+        Reorder reorder { 16 };
+        reorder.Push(0, milliseconds(0));
+        reorder.Push(3, milliseconds(10));
+        reorder.Push(2, milliseconds(20));
+
+        reorder.buffer.Expire(reorder.start + milliseconds(50), milliseconds(100));
+        if (reorder.delivered != std::vector<uint16_t> { 0 }) {
+            Fail("Gap was skipped before its timeout");
+        }
+
+        // The timeout counts from when the first held segment started waiting
+        reorder.buffer.Expire(reorder.start + milliseconds(110), milliseconds(100));
+        if (reorder.delivered != std::vector<uint16_t> { 0, 2, 3 } || reorder.buffer.Metrics().lost != 1) {
+            Fail("Expired gap did not release the held segments");
+        }
+
+        // A second gap waits for its own timeout
+        reorder.Push(6, milliseconds(120));
+        reorder.buffer.Expire(reorder.start + milliseconds(200), milliseconds(100));
+        if (reorder.delivered.size() != 3) {
+            Fail("Second gap was skipped before its timeout");
+        }
+
+        reorder.buffer.Expire(reorder.start + milliseconds(220), milliseconds(100));
+        if (reorder.delivered != std::vector<uint16_t> { 0, 2, 3, 6 } || reorder.buffer.Metrics().lost != 3) {
+            Fail("Second gap did not expire");
+        }
+    }
+}
+
+int main()
+{
+    TestSynchronization();
+    TestWrap();
+    TestWindowOverflow();
+    TestGapExpiry();
+
+    if (g_failures != 0) {
+        std::cerr << g_failures << " failures" << std::endl;
+        return 1;
+    }
+
+    std::cout << "Aggregation test passed" << std::endl;
+    return 0;
+}
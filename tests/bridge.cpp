@@ -0,0 +1,368 @@
+#include <ble_serial/bridge.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//////////////////////////////////////////////////////////
+//                                                      //
+// Platform stubs                                       //
+//                                                      //
+//////////////////////////////////////////////////////////
+
+namespace
+{
+    std::mutex g_portMutex;
+    std::deque<std::vector<uint8_t>> g_portInput;  ///< frames the stub port hands to its reader
+}
+
+namespace BLE_Serial::COM
+{
+    COMPort::COMPort(unsigned int, unsigned int, unsigned int, StopBits, Parity)
+            : m_handle { nullptr }
+    {
+    }
+
+    size_t COMPort::Read(uint8_t *buffer, size_t size)
+    {
+        std::unique_lock<std::mutex> lock { g_portMutex };
+        if (g_portInput.empty() || g_portInput.front().size() > size) {
+            return 0;
+        }
+
+        auto frame = std::move(g_portInput.front());
+        g_portInput.pop_front();
+        std::copy(frame.begin(), frame.end(), buffer);
+        return frame.size();
+    }
+
+    size_t COMPort::Write(const std::vector<uint8_t> &data)
+    {
+        return data.size();
+    }
+
+    void COMPort::Close()
+    {
+    }
+}
+
+using namespace BLE_Serial;
+
+namespace
+{
+    size_t g_failures = 0;
+
+    void Fail(const char *message)
+    {
+        g_failures++;
+        std::cerr << message << std::endl;
+    }
+
+    template<typename Condition>
+    bool WaitFor(Condition condition)
+    {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (!condition()) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                return false;
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        return true;
+    }
+
+    class FakeConnection : public Bluetooth::IBluetoothConnection
+    {
+    public:
+        std::atomic_bool open { true };
+
+        [[nodiscard]] bool IsOpen() const noexcept override
+        {
+            return open;
+        }
+
+        void Close() override
+        {
+            open = false;
+        }
+
+        [[nodiscard]] std::optional<int16_t> GetSignalStrength() const noexcept override
+        {
+            return std::nullopt;
+        }
+
+        size_t SubscribeStatusChanged(std::function<void(bool)>) override
+        {
+            return 0;
+        }
+
+        void UnsubscribeStatusChanged(size_t) override
+        {
+        }
+
+        [[nodiscard]] size_t GetMaxWriteSize() const noexcept override
+        {
+            return 20;
+        }
+
+        [[nodiscard]] Bluetooth::GattValueCache &GetValueCache() noexcept override
+        {
+            return m_valueCache;
+        }
+
+        [[nodiscard]] std::vector<std::shared_ptr<Bluetooth::IBluetoothGattService>> GetServices() override
+        {
+            return {};
+        }
+
+        [[nodiscard]] std::shared_ptr<Bluetooth::IBluetoothGattService> GetService(Bluetooth::BluetoothUUID) override
+        {
+            return nullptr;
+        }
+
+    private:
+        Bluetooth::GattValueCache m_valueCache {};
+    };
+
+    class FakeCharacteristic : public Bluetooth::IBluetoothGattCharacteristic
+    {
+    public:
+        std::atomic_bool readable { true };
+        std::atomic_bool writable { true };
+        std::atomic_size_t writes { 0 };
+
+        [[nodiscard]] Bluetooth::BluetoothUUID GetUUID() const override
+        {
+            return { 0x0000FFE1, 0x0000, 0x1000, { 0x80, 0x00, 0x00, 0x80, 0x5F, 0x9B, 0x34, 0xFB } };
+        }
+
+        [[nodiscard]] Bluetooth::GattRegisteredCharacteristic GetRegisteredCharacteristicType() const override
+        {
+            return static_cast<Bluetooth::GattRegisteredCharacteristic>(0xFFE1);
+        }
+
+        [[nodiscard]] Bluetooth::GattCharacteristicProperty GetProperties() const override
+        {
+            // Read, Write and Notify
+            return static_cast<Bluetooth::GattCharacteristicProperty>(0x1A);
+        }
+
+        [[nodiscard]] uint16_t GetHandle() const override
+        {
+            return 0x0010;
+        }
+
+        using IBluetoothGattCharacteristic::Read;
+
+        std::vector<uint8_t> Read(Bluetooth::GattReadMode) override
+        {
+            if (!readable) {
+                throw Bluetooth::BluetoothException("Unreachable");
+            }
+
+            return { 0x01 };
+        }
+
+        using IBluetoothGattCharacteristic::Write;
+
+        void Write(const std::vector<uint8_t> &, Bluetooth::GattWriteMode) override
+        {
+            if (!writable) {
+                throw Bluetooth::BluetoothException("Unreachable");
+            }
+
+            writes++;
+        }
+
+        size_t Subscribe(std::function<void(std::vector<uint8_t>)> listener) override
+        {
+            std::unique_lock<std::mutex> lock { m_mutex };
+            m_listener = std::move(listener);
+            return 1;
+        }
+
+        void Unsubscribe(size_t) override
+        {
+            UnsubscribeAll();
+        }
+
+        void UnsubscribeAll() override
+        {
+            std::unique_lock<std::mutex> lock { m_mutex };
+            m_listener = nullptr;
+        }
+
+        void Notify(std::vector<uint8_t> value)
+        {
+            std::unique_lock<std::mutex> lock { m_mutex };
+            if (m_listener) {
+                m_listener(std::move(value));
+            }
+        }
+
+    private:
+        std::mutex m_mutex {};
+        std::function<void(std::vector<uint8_t>)> m_listener {};
+    };
+
+    /**
+     * Helper running a bridge with a fast health monitor and counting its drops and recoveries
+     */
+    struct HealthFixture
+    {
+        std::shared_ptr<FakeConnection> connection { std::make_shared<FakeConnection>() };
+        FakeCharacteristic characteristic {};
+        COM::COMPort port { 1, 115200 };
+        std::unique_ptr<Bridge::Bridge> bridge;
+        std::atomic_size_t drops { 0 };
+        std::atomic_size_t recoveries { 0 };
+
+        explicit HealthFixture(Bridge::LinkHealthOptions health)
+        {
+            health.enabled = true;
+            health.checkInterval = std::chrono::milliseconds(5);
+
+            Bridge::BridgeOptions options {};
+            options.health = health;
+            options.retryInterval = std::chrono::milliseconds(5);
+            port.SetRefreshRate(std::chrono::milliseconds(1));
+
+            bridge = std::make_unique<Bridge::Bridge>(connection, characteristic, port, std::move(options));
+            bridge->OnDisconnected([this](const std::string &) { drops++; });
+            bridge->OnRecovered([this]() { recoveries++; });
+            bridge->Start();
+        }
+
+        ~HealthFixture()
+        {
+            bridge->Stop();
+        }
+    };
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // Link health                                          //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    void TestConnectionRecovery()
+    {
+        HealthFixture fixture { {} };
+
+        // Every outage is reported and every return of the connection as well
+        for (size_t outage = 1; outage <= 3; outage++) {
+            fixture.connection->open = false;
+            if (!WaitFor([&]() { return !fixture.bridge->IsAlive() && fixture.drops == outage; })) {
+                Fail("Closed connection was not reported as dead");
+                return;
+            }
+
+            fixture.connection->open = true;
+            if (!WaitFor([&]() { return fixture.bridge->IsAlive() && fixture.recoveries == outage; })) {
+                Fail("Reopened connection was not reported as recovered");
+                return;
+            }
+        }
+
+        if (fixture.bridge->GetMetrics().Snapshot().recoveries != 3) {
+            Fail("Recoveries are not counted in the link metrics");
+        }
+    }
+
+    void TestHeartbeatRecovery()
+    {
+        HealthFixture fixture { { .readHeartbeat = true, .maxConsecutiveErrors = 2 } };
+
+        fixture.characteristic.readable = false;
+        if (!WaitFor([&]() { return !fixture.bridge->IsAlive(); })) {
+            Fail("Failing heartbeats were not reported as a dead link");
+            return;
+        }
+
+        // The connection claims to be open all along, only a heartbeat going through proves the link again
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        if (fixture.bridge->IsAlive() || fixture.recoveries != 0) {
+            Fail("Link recovered while its heartbeats kept failing");
+        }
+
+        fixture.characteristic.readable = true;
+        if (!WaitFor([&]() { return fixture.bridge->IsAlive() && fixture.recoveries == 1; })) {
+            Fail("Link was not recovered by a successful heartbeat");
+        }
+
+        if (fixture.drops != 1) {
+            Fail("Link with failing heartbeats was reported dead more than once");
+        }
+    }
+
+    void TestWriteRecovery()
+    {
+        HealthFixture fixture { { .maxConsecutiveErrors = 2 } };
+
+        fixture.characteristic.writable = false;
+        {
+            std::unique_lock<std::mutex> lock { g_portMutex };
+            g_portInput.push_back({ 0x01, 0x02, 0x03 });
+        }
+
+        if (!WaitFor([&]() { return !fixture.bridge->IsAlive(); })) {
+            Fail("Failing writes were not reported as a dead link");
+            return;
+        }
+
+        // An open connection does not clear failed writes, the kept frame going through does
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        if (fixture.bridge->IsAlive()) {
+            Fail("Link recovered while its writes kept failing");
+        }
+
+        fixture.characteristic.writable = true;
+        if (!WaitFor([&]() { return fixture.bridge->IsAlive() && fixture.recoveries == 1 && fixture.characteristic.writes == 1; })) {
+            Fail("Link was not recovered by the retried write");
+        }
+    }
+
+    void TestInactivityRecovery()
+    {
+        HealthFixture fixture { { .inactivityTimeout = std::chrono::milliseconds(30) } };
+
+        if (!WaitFor([&]() { return !fixture.bridge->IsAlive(); })) {
+            Fail("Silent link was not reported as inactive");
+            return;
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        if (fixture.bridge->IsAlive()) {
+            Fail("Inactive link recovered without any data");
+        }
+
+        fixture.characteristic.Notify({ 0x42 });
+        if (!WaitFor([&]() { return fixture.bridge->IsAlive() && fixture.recoveries == 1; })) {
+            Fail("Inactive link was not recovered by a notification");
+        }
+    }
+}
+
+int main()
+{
+    TestConnectionRecovery();
+    TestHeartbeatRecovery();
+    TestWriteRecovery();
+    TestInactivityRecovery();
+
+    if (g_failures != 0) {
+        std::cerr << g_failures << " failures" << std::endl;
+        return 1;
+    }
+
+    std::cout << "Bridge test passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,447 @@
+#include <ble_serial/bluetooth.hpp>
+#include <ble_serial/com.hpp>
+#include <ble_serial/listeners.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+//////////////////////////////////////////////////////////
+//                                                      //
+// Platform stubs                                       //
+//                                                      //
+//////////////////////////////////////////////////////////
+
+namespace
+{
+    std::atomic_size_t g_comReaders { 0 };
+    std::atomic_size_t g_comReaderOverlaps { 0 };
+}
+
+namespace BLE_Serial::COM
+{
+    // A port that always has a byte to read, so the subscriber thread calls the listeners as often as it can
+    COMPort::COMPort(unsigned int, unsigned int, unsigned int, StopBits, Parity)
+            : m_handle { nullptr }
+    {
+    }
+
+    size_t COMPort::Read(uint8_t *buffer, size_t size)
+    {
+        // A second subscriber thread reading at the same time would split the data between their listeners
+        if (g_comReaders++ != 0) {
+            g_comReaderOverlaps++;
+        }
+
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+        buffer[0] = 0x55;
+        g_comReaders--;
+        return size > 0 ? 1 : 0;
+    }
+
+    size_t COMPort::Write(const std::vector<uint8_t> &data)
+    {
+        return data.size();
+    }
+
+    void COMPort::Close()
+    {
+    }
+}
+
+using namespace BLE_Serial;
+
+namespace
+{
+    std::atomic_size_t g_failures { 0 };
+
+    void Fail(const char *message)
+    {
+        if (g_failures++ == 0) {
+            std::cerr << message << std::endl;
+        }
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // COMPort listeners                                    //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    struct Listener
+    {
+        std::atomic_bool removed { false };       ///< set once Unsubscribe returned
+        std::atomic_size_t id { 0 };
+        std::atomic_bool subscribed { false };
+        std::atomic_bool removing { false };      ///< a call already started removing it
+        std::atomic_bool unsubscribed { false };  ///< the call removing it returned from the removal
+    };
+
+    void TestComListeners()
+    {
+        constexpr size_t threadCount = 4;
+        constexpr size_t iterations = 2000;
+
+        COM::COMPort port { 1, 115200 };
+        port.SetRefreshRate(std::chrono::milliseconds(1));
+
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < threadCount; i++) {
+            threads.emplace_back([&port, i]() {
+                for (size_t iteration = 0; iteration < iterations; iteration++) {
+                    auto listener = std::make_shared<Listener>();
+
+                    if ((iteration + i) % 2 == 0) {
+                        // Removed by another thread while the subscriber thread may be calling it
+                        size_t id = port.Subscribe([listener](const std::vector<uint8_t> &) {
+                            if (listener->removed) {
+                                Fail("COM listener called after Unsubscribe returned");
+                            }
+                        });
+
+                        std::this_thread::sleep_for(std::chrono::microseconds(50 * (iteration % 5)));
+                        port.Unsubscribe(id);
+                        listener->removed = true;
+                    } else {
+                        // Removes itself from within its first call
+                        auto *portPointer = &port;
+                        listener->id = port.Subscribe([listener, portPointer](const std::vector<uint8_t> &) {
+                            if (listener->removed) {
+                                Fail("COM listener called after it unsubscribed itself");
+                                return;
+                            }
+
+                            while (!listener->subscribed) {
+                                std::this_thread::yield();
+                            }
+
+                            portPointer->Unsubscribe(listener->id);
+                            listener->removed = true;
+                        });
+                        listener->subscribed = true;
+
+                        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+                        while (!listener->removed && std::chrono::steady_clock::now() < deadline) {
+                            std::this_thread::sleep_for(std::chrono::microseconds(100));
+                        }
+
+                        if (!listener->removed) {
+                            Fail("Self-unsubscribing COM listener was never called");
+                            port.Unsubscribe(listener->id);
+                            listener->removed = true;
+                        }
+                    }
+                }
+            });
+        }
+
+        for (auto &thread : threads) {
+            thread.join();
+        }
+
+        port.UnsubscribeAll();
+    }
+
+    void TestComRestart()
+    {
+        constexpr size_t iterations = 1000;
+
+        COM::COMPort port { 1, 115200 };
+        port.SetRefreshRate(std::chrono::milliseconds(1));
+
+        for (size_t iteration = 0; iteration < iterations; iteration++) {
+            auto stopped = std::make_shared<std::atomic_bool>(false);
+            auto *portPointer = &port;
+
+            // Stops the subscriber thread from within its listener, then subscribes again from here or from the
+            // listener itself while that thread may still be running
+            port.Subscribe([stopped, portPointer, iteration](const std::vector<uint8_t> &) {
+                if (stopped->exchange(true)) {
+                    return;
+                }
+
+                portPointer->UnsubscribeAll();
+
+                if (iteration % 3 == 0) {
+                    portPointer->Subscribe([](const std::vector<uint8_t> &) {});
+                }
+            });
+
+            while (!*stopped) {
+                std::this_thread::yield();
+            }
+
+            auto called = std::make_shared<std::atomic_bool>(false);
+            port.Subscribe([called](const std::vector<uint8_t> &) { *called = true; });
+
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+            while (!*called && std::chrono::steady_clock::now() < deadline) {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+
+            if (!*called) {
+                Fail("COM listener subscribed after UnsubscribeAll from a listener was never called");
+            }
+
+            port.UnsubscribeAll();
+        }
+
+        if (g_comReaderOverlaps != 0) {
+            Fail("Two COM subscriber threads read at the same time");
+        }
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // Characteristic listeners                             //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    void TestNotificationListeners()
+    {
+        constexpr size_t poolThreadCount = 4;
+        constexpr size_t threadCount = 4;
+        constexpr size_t iterations = 2000;
+
+        // Notifications of a characteristic arrive on any pool thread, several of them may dispatch at once
+        IO::ListenerSet listeners;
+        std::atomic_bool exiting { false };
+
+        std::vector<std::thread> poolThreads;
+        for (size_t i = 0; i < poolThreadCount; i++) {
+            poolThreads.emplace_back([&listeners, &exiting]() {
+                std::vector<uint8_t> value { 0x55 };
+
+                while (!exiting) {
+                    listeners.Dispatch(value);
+                    std::this_thread::sleep_for(std::chrono::microseconds(20));
+                }
+            });
+        }
+
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < threadCount; i++) {
+            threads.emplace_back([&listeners, i]() {
+                for (size_t iteration = 0; iteration < iterations; iteration++) {
+                    auto listener = std::make_shared<Listener>();
+
+                    if ((iteration + i) % 2 == 0) {
+                        size_t id = listeners.Add([listener](const std::vector<uint8_t> &) {
+                            if (listener->removed) {
+                                Fail("Notification listener called after Unsubscribe returned");
+                            }
+
+                            std::this_thread::sleep_for(std::chrono::microseconds(10));
+                        });
+
+                        std::this_thread::sleep_for(std::chrono::microseconds(50 * (iteration % 5)));
+                        listeners.Remove(id);
+                        listener->removed = true;
+                    } else {
+                        // Removes itself from within its first call, other pool threads may be calling it meanwhile
+                        auto *listenersPointer = &listeners;
+                        listener->id = listeners.Add([listener, listenersPointer](const std::vector<uint8_t> &) {
+                            if (listener->removed) {
+                                Fail("Notification listener called after it unsubscribed itself");
+                                return;
+                            }
+
+                            while (!listener->subscribed) {
+                                std::this_thread::yield();
+                            }
+
+                            if (!listener->removing.exchange(true)) {
+                                listenersPointer->Remove(listener->id);
+                                listener->unsubscribed = true;
+                            }
+                        });
+                        listener->subscribed = true;
+
+                        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+                        while (!listener->unsubscribed && std::chrono::steady_clock::now() < deadline) {
+                            std::this_thread::sleep_for(std::chrono::microseconds(100));
+                        }
+
+                        if (!listener->unsubscribed) {
+                            Fail("Self-unsubscribing notification listener was never called");
+                        }
+
+                        // Other pool threads may still be calling it, removing it again from here waits for them
+                        listeners.Remove(listener->id);
+                        listener->removed = true;
+                    }
+                }
+            });
+        }
+
+        for (auto &thread : threads) {
+            thread.join();
+        }
+
+        listeners.Clear();
+        exiting = true;
+
+        for (auto &thread : poolThreads) {
+            thread.join();
+        }
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // Shared connections                                   //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    constexpr Bluetooth::BluetoothUUID c_serviceUuid { 0x0000FFE0, 0x0000, 0x1000, { 0x80, 0x00, 0x00, 0x80, 0x5F, 0x9B, 0x34, 0xFB } };
+
+    class FakeService : public Bluetooth::IBluetoothGattService
+    {
+    public:
+        std::atomic_bool closed { false };
+
+        [[nodiscard]] Bluetooth::BluetoothUUID GetUUID() const override
+        {
+            return c_serviceUuid;
+        }
+
+        [[nodiscard]] Bluetooth::GattRegisteredService GetRegisteredServiceType() const override
+        {
+            return Bluetooth::GattRegisteredService::GenericAccess;
+        }
+
+        [[nodiscard]] std::vector<std::unique_ptr<Bluetooth::IBluetoothGattCharacteristic>> &GetCachedCharacteristics() override
+        {
+            return m_characteristics;
+        }
+
+        [[nodiscard]] std::unique_ptr<Bluetooth::IBluetoothGattCharacteristic> &GetCharacteristic(Bluetooth::BluetoothUUID) override
+        {
+            return m_missing;
+        }
+
+        void FetchCharacteristics() override
+        {
+        }
+
+    private:
+        std::vector<std::unique_ptr<Bluetooth::IBluetoothGattCharacteristic>> m_characteristics {};
+        std::unique_ptr<Bluetooth::IBluetoothGattCharacteristic> m_missing {};
+    };
+
+    std::atomic_size_t g_openedLinks { 0 };
+    std::atomic_size_t g_closedLinks { 0 };
+
+    class FakeConnection : public Bluetooth::SharedBluetoothConnection
+    {
+    public:
+        FakeConnection()
+        {
+            m_service = std::make_shared<FakeService>();
+            SetServices({ m_service });
+            g_openedLinks++;
+        }
+
+        [[nodiscard]] bool IsOpen() const noexcept override
+        {
+            return m_open;
+        }
+
+        [[nodiscard]] std::optional<int16_t> GetSignalStrength() const noexcept override
+        {
+            return std::nullopt;
+        }
+
+        size_t SubscribeStatusChanged(std::function<void(bool)>) override
+        {
+            return 0;
+        }
+
+        void UnsubscribeStatusChanged(size_t) override
+        {
+        }
+
+        [[nodiscard]] size_t GetMaxWriteSize() const noexcept override
+        {
+            return 20;
+        }
+
+        [[nodiscard]] Bluetooth::GattValueCache &GetValueCache() noexcept override
+        {
+            return m_valueCache;
+        }
+
+    protected:
+        void CloseLink() override
+        {
+            if (!m_open.exchange(false)) {
+                Fail("Connection link closed twice");
+            }
+
+            m_service->closed = true;
+            g_closedLinks++;
+        }
+
+    private:
+        std::atomic_bool m_open { true };
+        std::shared_ptr<FakeService> m_service;
+        Bluetooth::GattValueCache m_valueCache {};
+    };
+
+    void TestSharedConnections()
+    {
+        constexpr size_t threadCount = 8;
+        constexpr size_t iterations = 2000;
+
+        Bluetooth::SharedConnectionSlot slot;
+
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < threadCount; i++) {
+            threads.emplace_back([&slot]() {
+                for (size_t iteration = 0; iteration < iterations; iteration++) {
+                    auto connection = slot.Open([]() { return std::make_shared<FakeConnection>(); });
+
+                    // Another user closing the connection must leave the services of this one alone
+                    for (size_t use = 0; use < iteration % 4 + 1; use++) {
+                        auto service = std::static_pointer_cast<FakeService>(connection->GetService(c_serviceUuid));
+                        if (!service) {
+                            Fail("Service of a shared connection missing before its user closed it");
+                        } else if (service->closed) {
+                            Fail("Service of a shared connection closed while in use");
+                        }
+
+                        std::this_thread::yield();
+                    }
+
+                    connection->Close();
+                }
+            });
+        }
+
+        for (auto &thread : threads) {
+            thread.join();
+        }
+
+        if (g_openedLinks != g_closedLinks) {
+            Fail("Shared connection left open after all of its users closed it");
+        }
+    }
+}
+
+int main()
+{
+    TestComListeners();
+    TestComRestart();
+    TestNotificationListeners();
+    TestSharedConnections();
+
+    if (g_failures != 0) {
+        std::cerr << g_failures << " failures" << std::endl;
+        return 1;
+    }
+
+    std::cout << "Concurrency test passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,289 @@
+#include <ble_serial/dfu.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+using namespace BLE_Serial;
+
+namespace
+{
+    std::atomic_size_t g_failures { 0 };
+
+    void Fail(const char *message)
+    {
+        g_failures++;
+        std::cerr << message << std::endl;
+    }
+
+    std::vector<uint8_t> Pattern(size_t size, uint32_t seed)
+    {
+        std::vector<uint8_t> data(size);
+        for (auto &byte : data) {
+            seed = seed * 1103515245 + 12345;
+            byte = static_cast<uint8_t>(seed >> 16);
+        }
+
+        return data;
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // CRC-32                                               //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    uint32_t BitwiseCrc32(const uint8_t *data, size_t size)
+    {
+        uint32_t crc = ~0u;
+        for (size_t i = 0; i < size; i++) {
+            crc ^= data[i];
+            for (int bit = 0; bit < 8; bit++) {
+                crc = (crc & 1) != 0 ? (crc >> 1) ^ 0xEDB88320 : crc >> 1;
+            }
+        }
+
+        return ~crc;
+    }
+
+    void TestCrc32()
+    {
+        const uint8_t check[] = { '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+        if (Dfu::Crc32(check, sizeof(check)) != 0xCBF43926) {
+            Fail("CRC-32 of the check string is wrong");
+        }
+
+        // Covers the tables alone, the folding kernel with every tail length and unaligned starts
+        auto data = Pattern(4096 + 64, 1);
+        for (size_t offset = 0; offset < 4; offset++) {
+            for (size_t size = 0; size <= 300; size++) {
+                if (Dfu::Crc32(data.data() + offset, size) != BitwiseCrc32(data.data() + offset, size)) {
+                    Fail("CRC-32 does not match the bitwise reference");
+                    return;
+                }
+            }
+        }
+
+        if (Dfu::Crc32(data.data(), 4096) != BitwiseCrc32(data.data(), 4096)) {
+            Fail("CRC-32 of a whole object does not match the bitwise reference");
+        }
+
+        // Checksumming in parts gives the checksum of the whole
+        if (Dfu::Crc32(data.data() + 1000, 3096, Dfu::Crc32(data.data(), 1000)) != Dfu::Crc32(data.data(), 4096)) {
+            Fail("CRC-32 in parts does not match the CRC-32 of the whole");
+        }
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // Uploads                                              //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    /**
+     * Packet characteristic in front of the simulated one, stands in for a link that loses the connection or corrupts
+     * a packet
+     */
+    class FaultyPacket : public Bluetooth::IBluetoothGattCharacteristic
+    {
+    public:
+        size_t packets = 0;                ///< packets written so far
+        size_t bytes = 0;                  ///< bytes written so far
+        size_t stopAfter = SIZE_MAX;       ///< sets the stop flag once that many packets were written
+        size_t corruptPacket = SIZE_MAX;   ///< number of the packet whose first byte is flipped
+        std::atomic_bool stop { false };
+
+        explicit FaultyPacket(Bluetooth::IBluetoothGattCharacteristic &packet)
+                : m_packet { packet }
+        {
+        }
+
+        [[nodiscard]] Bluetooth::BluetoothUUID GetUUID() const override
+        {
+            return m_packet.GetUUID();
+        }
+
+        [[nodiscard]] Bluetooth::GattRegisteredCharacteristic GetRegisteredCharacteristicType() const override
+        {
+            return m_packet.GetRegisteredCharacteristicType();
+        }
+
+        [[nodiscard]] Bluetooth::GattCharacteristicProperty GetProperties() const override
+        {
+            return m_packet.GetProperties();
+        }
+
+        [[nodiscard]] uint16_t GetHandle() const override
+        {
+            return m_packet.GetHandle();
+        }
+
+        using IBluetoothGattCharacteristic::Read;
+
+        std::vector<uint8_t> Read(Bluetooth::GattReadMode mode) override
+        {
+            return m_packet.Read(mode);
+        }
+
+        using IBluetoothGattCharacteristic::Write;
+
+        void Write(const std::vector<uint8_t> &data, Bluetooth::GattWriteMode mode) override
+        {
+            auto written = data;
+            if (packets == corruptPacket) {
+                written[0] ^= 0xFF;
+            }
+
+            m_packet.Write(written, mode);
+            bytes += data.size();
+
+            if (++packets == stopAfter) {
+                stop = true;
+            }
+        }
+
+        size_t Subscribe(std::function<void(std::vector<uint8_t>)> listener) override
+        {
+            return m_packet.Subscribe(std::move(listener));
+        }
+
+        void Unsubscribe(size_t id) override
+        {
+            m_packet.Unsubscribe(id);
+        }
+
+        void UnsubscribeAll() override
+        {
+            m_packet.UnsubscribeAll();
+        }
+
+    private:
+        Bluetooth::IBluetoothGattCharacteristic &m_packet;
+    };
+
+    constexpr size_t c_packetSize = 20;
+    constexpr uint32_t c_objectSize = 1000;
+
+    const std::vector<uint8_t> c_initPacket = Pattern(140, 2);
+    const std::vector<uint8_t> c_firmware = Pattern(5000, 3);
+
+    /**
+     * Helper running an upload through the faulty packet characteristic
+     */
+    bool Upload(Dfu::SimulatedDfuTarget &target, FaultyPacket &packet, Dfu::DfuProgress &progress)
+    {
+        Dfu::SecureDfuClient client { target.GetControlPoint(), packet, Dfu::DfuOptions {
+                .packetSize = c_packetSize,
+                .progress = [&progress](const Dfu::DfuProgress &current) { progress = current; }
+        } };
+
+        return client.Upload(c_initPacket.data(), c_initPacket.size(), c_firmware.data(), c_firmware.size(), packet.stop);
+    }
+
+    void TestCleanUpload()
+    {
+        Dfu::SimulatedDfuTarget target { c_objectSize };
+        FaultyPacket packet { target.GetPacket() };
+        Dfu::DfuProgress progress {};
+
+        if (!Upload(target, packet, progress)) {
+            Fail("Clean upload was interrupted");
+            return;
+        }
+
+        if (target.GetInitPacket() != c_initPacket || target.GetFirmware() != c_firmware) {
+            Fail("Target does not hold the uploaded images");
+        }
+
+        if (progress.sent != c_firmware.size() || progress.objects != 5 || progress.retries != 0 || progress.resumed != 0) {
+            Fail("Progress of a clean upload is wrong");
+        }
+
+        if (packet.bytes != c_initPacket.size() + c_firmware.size()) {
+            Fail("Clean upload sent more than the images");
+        }
+    }
+
+    void TestResume()
+    {
+        Dfu::SimulatedDfuTarget target { c_objectSize };
+        Dfu::DfuProgress progress {};
+
+        // Interrupted in the middle of the third data object, 2100 bytes of the firmware in
+        size_t initPackets = (c_initPacket.size() + c_packetSize - 1) / c_packetSize;
+        {
+            FaultyPacket packet { target.GetPacket() };
+            packet.stopAfter = initPackets + 2100 / c_packetSize;
+
+            if (Upload(target, packet, progress)) {
+                Fail("Interrupted upload reported success");
+                return;
+            }
+        }
+
+        FaultyPacket packet { target.GetPacket() };
+        if (!Upload(target, packet, progress)) {
+            Fail("Resumed upload was interrupted");
+            return;
+        }
+
+        if (target.GetFirmware() != c_firmware) {
+            Fail("Target does not hold the firmware after resuming");
+        }
+
+        if (progress.resumed != 2100 || progress.sent != c_firmware.size()) {
+            Fail("Upload did not resume from the offset the target stopped at");
+        }
+
+        // Neither the init packet nor the data the target holds is sent again
+        if (packet.bytes != c_firmware.size() - 2100) {
+            Fail("Resumed upload sent data the target already held");
+        }
+    }
+
+    void TestCorruptedPacket()
+    {
+        Dfu::SimulatedDfuTarget target { c_objectSize };
+        FaultyPacket packet { target.GetPacket() };
+        Dfu::DfuProgress progress {};
+
+        // A packet in the middle of the second data object
+        size_t initPackets = (c_initPacket.size() + c_packetSize - 1) / c_packetSize;
+        packet.corruptPacket = initPackets + 1500 / c_packetSize;
+
+        if (!Upload(target, packet, progress)) {
+            Fail("Upload with a corrupted packet was interrupted");
+            return;
+        }
+
+        if (target.GetFirmware() != c_firmware) {
+            Fail("Target does not hold the firmware after the retry");
+        }
+
+        if (progress.retries != 1 || progress.objects != 5) {
+            Fail("Corrupted object was not sent again exactly once");
+        }
+
+        // Only the corrupted object is sent again, from its beginning
+        if (packet.bytes <= c_initPacket.size() + c_firmware.size() || packet.bytes > c_initPacket.size() + c_firmware.size() + c_objectSize) {
+            Fail("Retry sent more than the corrupted object");
+        }
+    }
+}
+
+int main()
+{
+    TestCrc32();
+    TestCleanUpload();
+    TestResume();
+    TestCorruptedPacket();
+
+    if (g_failures != 0) {
+        std::cerr << g_failures << " failures" << std::endl;
+        return 1;
+    }
+
+    std::cout << "DFU test passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,304 @@
+#include <ble_serial/l2cap.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace BLE_Serial;
+
+namespace
+{
+    std::atomic_size_t g_failures { 0 };
+
+    void Fail(const char *message)
+    {
+        g_failures++;
+        std::cerr << message << std::endl;
+    }
+
+    /**
+     * Helper connecting a channel to a raw SOCK_SEQPACKET socket standing in for the device
+     */
+    std::pair<std::unique_ptr<Bluetooth::L2CAPChannel>, int> OpenChannel(Bluetooth::L2CAPChannelOptions options = {})
+    {
+        int sockets[2];
+        if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sockets) != 0) {
+            Fail("Failed to create a socketpair");
+            return { nullptr, -1 };
+        }
+
+        return { std::make_unique<Bluetooth::L2CAPChannel>(sockets[0], options), sockets[1] };
+    }
+
+    std::vector<uint8_t> Pattern(size_t size, uint8_t seed)
+    {
+        std::vector<uint8_t> data(size);
+        for (size_t i = 0; i < size; i++) {
+            data[i] = static_cast<uint8_t>(seed + i * 7);
+        }
+
+        return data;
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // SDU boundaries                                       //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    void TestSduBoundaries()
+    {
+        auto [channel, peer] = OpenChannel();
+        if (!channel) {
+            return;
+        }
+
+        // Sent back to back, so a stream socket would merge them
+        const std::vector<std::vector<uint8_t>> sdus { Pattern(1, 1), Pattern(100, 2), Pattern(7, 3), Pattern(247, 4) };
+
+        std::mutex mutex;
+        std::condition_variable condition;
+        std::vector<std::vector<uint8_t>> received;
+
+        channel->Subscribe([&](const std::vector<uint8_t> &sdu) {
+            std::unique_lock<std::mutex> lock { mutex };
+            received.push_back(sdu);
+            condition.notify_all();
+        });
+
+        for (auto &sdu : sdus) {
+            send(peer, sdu.data(), sdu.size(), 0);
+        }
+
+        {
+            std::unique_lock<std::mutex> lock { mutex };
+            condition.wait_for(lock, std::chrono::seconds(5), [&]() { return received.size() >= sdus.size(); });
+
+            if (received != sdus) {
+                Fail("Received SDUs do not match the sent ones");
+            }
+        }
+
+        channel->UnsubscribeAll();
+
+        // The other direction keeps the boundaries as well
+        for (auto &sdu : sdus) {
+            channel->Send(sdu);
+        }
+
+        for (auto &sdu : sdus) {
+            std::vector<uint8_t> buffer(1024);
+            ssize_t length = recv(peer, buffer.data(), buffer.size(), 0);
+            buffer.resize(length < 0 ? 0 : static_cast<size_t>(length));
+
+            if (buffer != sdu) {
+                Fail("Peer received an SDU that does not match the sent one");
+            }
+        }
+
+        auto metrics = channel->Metrics();
+        if (metrics.sdusSent != sdus.size() || metrics.sdusReceived != sdus.size() || metrics.bytesSent != 355 || metrics.bytesReceived != 355) {
+            Fail("Channel metrics do not count the SDUs");
+        }
+
+        close(peer);
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // Large SDUs                                           //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    void TestLargeSdus()
+    {
+        auto [channel, peer] = OpenChannel({ .mtu = 60000 });
+        if (!channel) {
+            return;
+        }
+
+        int buffer = 256 * 1024;
+        setsockopt(peer, SOL_SOCKET, SO_SNDBUF, &buffer, sizeof(buffer));
+        setsockopt(peer, SOL_SOCKET, SO_RCVBUF, &buffer, sizeof(buffer));
+
+        auto sdu = Pattern(60000, 9);
+        send(peer, sdu.data(), sdu.size(), 0);
+
+        std::vector<uint8_t> received;
+        if (!channel->Receive(received, std::chrono::seconds(5)) || received != sdu) {
+            Fail("Large SDU was not received whole");
+        }
+
+        std::thread reader([peer, &sdu]() {
+            std::vector<uint8_t> received(65536);
+            ssize_t length = recv(peer, received.data(), received.size(), 0);
+            received.resize(length < 0 ? 0 : static_cast<size_t>(length));
+
+            if (received != sdu) {
+                Fail("Peer did not receive the large SDU whole");
+            }
+        });
+
+        channel->Send(sdu);
+        reader.join();
+
+        bool thrown = false;
+        try {
+            channel->Send(Pattern(60001, 0));
+        } catch (Bluetooth::BluetoothException &) {
+            thrown = true;
+        }
+
+        if (!thrown) {
+            Fail("SDU larger than the MTU was sent");
+        }
+
+        // An SDU breaking the MTU ends the channel
+        auto oversized = Pattern(60001, 0);
+        send(peer, oversized.data(), oversized.size(), 0);
+
+        if (channel->Receive(received, std::chrono::seconds(5)) || channel->IsOpen()) {
+            Fail("Channel accepted an SDU larger than its MTU");
+        }
+
+        close(peer);
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // Credit stalls                                        //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    void TestCreditStalls()
+    {
+        auto [channel, peer] = OpenChannel({ .sendTimeout = std::chrono::milliseconds(200) });
+        if (!channel) {
+            return;
+        }
+
+        // The peer reads nothing, so its buffer fills up like a device granting no more credits
+        auto sdu = Pattern(200, 5);
+        size_t sent = 0;
+        bool thrown = false;
+
+        try {
+            for (; sent < 100000; sent++) {
+                channel->Send(sdu);
+            }
+        } catch (Bluetooth::BluetoothException &) {
+            thrown = true;
+        }
+
+        auto metrics = channel->Metrics();
+        if (!thrown || metrics.creditStalls != 1 || metrics.stalledTime < std::chrono::milliseconds(200)) {
+            Fail("Send to a full peer did not stall and time out");
+        }
+
+        // Draining the peer grants the credits back, the stalled send then goes through
+        std::atomic_size_t drained { 0 };
+        std::thread reader([peer, &drained, sent]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+            std::vector<uint8_t> buffer(1024);
+            while (drained < sent + 1 && recv(peer, buffer.data(), buffer.size(), 0) > 0) {
+                drained++;
+            }
+        });
+
+        try {
+            channel->Send(sdu);
+        } catch (Bluetooth::BluetoothException &) {
+            Fail("Send did not resume once the peer drained its buffer");
+        }
+
+        reader.join();
+
+        metrics = channel->Metrics();
+        if (metrics.creditStalls != 2 || metrics.sdusSent != sent + 1) {
+            Fail("Credit stalls are not counted per stalled send");
+        }
+
+        close(peer);
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // Peer shutdown                                        //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    void TestPeerShutdown()
+    {
+        auto [channel, peer] = OpenChannel();
+        if (!channel) {
+            return;
+        }
+
+        std::atomic_size_t calls { 0 };
+        channel->Subscribe([&calls](const std::vector<uint8_t> &) { calls++; });
+
+        auto sdu = Pattern(10, 1);
+        send(peer, sdu.data(), sdu.size(), 0);
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (calls == 0 && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        shutdown(peer, SHUT_RDWR);
+
+        while (channel->IsOpen() && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        if (calls != 1 || channel->IsOpen()) {
+            Fail("Channel stayed open after the peer shut down");
+        }
+
+        bool thrown = false;
+        try {
+            channel->Send(sdu);
+        } catch (Bluetooth::BluetoothException &) {
+            thrown = true;
+        }
+
+        if (!thrown) {
+            Fail("Send on a closed channel did not throw");
+        }
+
+        // The subscriber thread idles on the closed channel and still stops promptly
+        auto start = std::chrono::steady_clock::now();
+        channel.reset();
+
+        if (std::chrono::steady_clock::now() - start > std::chrono::seconds(1)) {
+            Fail("Closed channel took too long to stop its subscriber thread");
+        }
+
+        close(peer);
+    }
+}
+
+int main()
+{
+    TestSduBoundaries();
+    TestLargeSdus();
+    TestCreditStalls();
+    TestPeerShutdown();
+
+    if (g_failures != 0) {
+        std::cerr << g_failures << " failures" << std::endl;
+        return 1;
+    }
+
+    std::cout << "L2CAP test passed" << std::endl;
+    return 0;
+}
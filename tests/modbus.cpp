@@ -0,0 +1,239 @@
+#include <ble_serial/modbus.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+//////////////////////////////////////////////////////////
+//                                                      //
+// Platform stubs                                       //
+//                                                      //
+//////////////////////////////////////////////////////////
+
+namespace BLE_Serial::COM
+{
+    COMPort::COMPort(unsigned int, unsigned int, unsigned int, StopBits, Parity)
+            : m_handle { nullptr }
+    {
+    }
+
+    size_t COMPort::Read(uint8_t *, size_t)
+    {
+        return 0;
+    }
+
+    size_t COMPort::Write(const std::vector<uint8_t> &data)
+    {
+        return data.size();
+    }
+
+    void COMPort::Close()
+    {
+    }
+}
+
+using namespace BLE_Serial;
+
+namespace
+{
+    size_t g_failures = 0;
+
+    void Fail(const char *message)
+    {
+        g_failures++;
+        std::cerr << message << std::endl;
+    }
+
+    /**
+     * Read holding registers, unit 1, 10 registers from address 0
+     */
+    const std::vector<uint8_t> c_readRequest { 0x01, 0x03, 0x00, 0x00, 0x00, 0x0A, 0xC5, 0xCD };
+
+    std::vector<uint8_t> WithCrc(std::vector<uint8_t> frame)
+    {
+        Modbus::AppendCrc(frame);
+        return frame;
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // CRC                                                  //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    uint16_t BitwiseCrc16(const uint8_t *data, size_t size)
+    {
+        uint16_t crc = 0xFFFF;
+        for (size_t i = 0; i < size; i++) {
+            crc ^= data[i];
+            for (int bit = 0; bit < 8; bit++) {
+                crc = (crc & 1) != 0 ? static_cast<uint16_t>((crc >> 1) ^ 0xA001) : static_cast<uint16_t>(crc >> 1);
+            }
+        }
+
+        return crc;
+    }
+
+    void TestCrc16()
+    {
+        if (WithCrc({ 0x01, 0x03, 0x00, 0x00, 0x00, 0x0A }) != c_readRequest) {
+            Fail("CRC of the read holding registers request is not C5 CD");
+        }
+
+        // Write single register, unit 17, 0x0003 to register 1: the specification's example
+        if (WithCrc({ 0x11, 0x06, 0x00, 0x01, 0x00, 0x03 }) != std::vector<uint8_t> { 0x11, 0x06, 0x00, 0x01, 0x00, 0x03, 0x9A, 0x9B }) {
+            Fail("CRC of the write single register request is not 9A 9B");
+        }
+
+        if (!Modbus::CheckCrc(c_readRequest.data(), c_readRequest.size())) {
+            Fail("CRC of a valid frame does not check");
+        }
+
+        auto corrupted = c_readRequest;
+        corrupted[3] ^= 0x01;
+        if (Modbus::CheckCrc(corrupted.data(), corrupted.size()) || Modbus::CheckCrc(c_readRequest.data(), 3)) {
+            Fail("CRC of a corrupted or too short frame checks");
+        }
+
+        // Odd lengths and checksums in parts take the paths around the two-byte steps
+        std::vector<uint8_t> data(257);
+        for (size_t i = 0; i < data.size(); i++) {
+            data[i] = static_cast<uint8_t>(i * 31 + 7);
+        }
+
+        for (size_t size = 0; size <= data.size(); size++) {
+            if (Modbus::Crc16(data.data(), size) != BitwiseCrc16(data.data(), size)) {
+                Fail("CRC does not match the bitwise reference");
+                return;
+            }
+        }
+
+        if (Modbus::Crc16(data.data() + 101, 156, Modbus::Crc16(data.data(), 101)) != BitwiseCrc16(data.data(), 257)) {
+            Fail("CRC in parts does not match the CRC of the whole");
+        }
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // RTU framing                                          //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    /**
+     * Helper collecting the frames of a framer
+     */
+    struct Framer
+    {
+        std::vector<std::vector<uint8_t>> frames {};
+        Modbus::RtuFramer framer;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        Framer(Modbus::ModbusFrameKind kind, std::chrono::microseconds interFrameDelay)
+                : framer { kind, interFrameDelay, [this](std::vector<uint8_t> frame) { frames.push_back(std::move(frame)); } }
+        {
+        }
+
+        void Feed(const std::vector<uint8_t> &data, std::chrono::microseconds at = std::chrono::microseconds(0))
+        {
+            framer.Feed(data.data(), data.size(), start + at);
+        }
+    };
+
+    void TestSplitFrames()
+    {
+        Framer framer { Modbus::ModbusFrameKind::Request, std::chrono::microseconds(0) };
+
+        for (auto byte : c_readRequest) {
+            framer.Feed({ byte });
+        }
+
+        // Read holding registers response with 2 registers, split inside its byte count
+        auto response = WithCrc({ 0x01, 0x03, 0x04, 0x00, 0x2A, 0x01, 0x00 });
+        Framer responses { Modbus::ModbusFrameKind::Response, std::chrono::microseconds(0) };
+        responses.Feed({ response.begin(), response.begin() + 2 });
+        responses.Feed({ response.begin() + 2, response.begin() + 5 });
+
+        if (!responses.frames.empty()) {
+            Fail("Partial response was framed");
+        }
+
+        responses.Feed({ response.begin() + 5, response.end() });
+
+        if (framer.frames != std::vector<std::vector<uint8_t>> { c_readRequest } || responses.frames != std::vector<std::vector<uint8_t>> { response }) {
+            Fail("Frame fed byte by byte was not reassembled");
+        }
+    }
+
+    void TestConcatenatedFrames()
+    {
+        Framer framer { Modbus::ModbusFrameKind::Request, std::chrono::microseconds(0) };
+
+        auto write = WithCrc({ 0x02, 0x10, 0x00, 0x10, 0x00, 0x02, 0x04, 0x00, 0x01, 0x00, 0x02 });
+        auto unknown = WithCrc({ 0x03, 0x41, 0x55, 0xAA });
+
+        // Two frames of known length and one whose length only the CRC tells, in a single read
+        std::vector<uint8_t> stream = c_readRequest;
+        stream.insert(stream.end(), write.begin(), write.end());
+        stream.insert(stream.end(), unknown.begin(), unknown.end());
+        framer.Feed(stream);
+
+        if (framer.frames != std::vector<std::vector<uint8_t>> { c_readRequest, write, unknown }) {
+            Fail("Concatenated frames were not cut apart");
+        }
+
+        // A corrupted frame is dropped without taking the next one with it
+        auto corrupted = c_readRequest;
+        corrupted[5] ^= 0xFF;
+        stream = corrupted;
+        stream.insert(stream.end(), c_readRequest.begin(), c_readRequest.end());
+        framer.frames.clear();
+        framer.Feed(stream);
+
+        if (framer.frames != std::vector<std::vector<uint8_t>> { c_readRequest } || framer.framer.GetDroppedFrames() != 1) {
+            Fail("Corrupted frame was not dropped on its own");
+        }
+    }
+
+    void TestInterFrameGap()
+    {
+        auto delay = Modbus::InterFrameDelay(9600);
+        if (delay != std::chrono::microseconds(4010) || Modbus::InterFrameDelay(115200) != std::chrono::microseconds(1750)) {
+            Fail("Inter-frame delay is not 3.5 characters with a floor of 1750 us");
+        }
+
+        Framer framer { Modbus::ModbusFrameKind::Request, delay };
+
+        // Bytes within the silent interval belong to the same frame
+        framer.Feed({ c_readRequest.begin(), c_readRequest.begin() + 4 });
+        framer.Feed({ c_readRequest.begin() + 4, c_readRequest.end() }, delay / 2);
+
+        if (framer.frames.size() != 1 || framer.framer.GetDroppedFrames() != 0) {
+            Fail("Frame with a pause shorter than the silent interval was dropped");
+        }
+
+        // A pause of the silent interval ends the partial frame, the next one is framed on its own
+        framer.Feed({ c_readRequest.begin(), c_readRequest.begin() + 5 }, delay * 2);
+        framer.Feed(c_readRequest, delay * 3);
+
+        if (framer.frames.size() != 2 || framer.frames[1] != c_readRequest || framer.framer.GetDroppedFrames() != 1) {
+            Fail("Partial frame was not dropped at the silent interval");
+        }
+    }
+}
+
+int main()
+{
+    TestCrc16();
+    TestSplitFrames();
+    TestConcatenatedFrames();
+    TestInterFrameGap();
+
+    if (g_failures != 0) {
+        std::cerr << g_failures << " failures" << std::endl;
+        return 1;
+    }
+
+    std::cout << "Modbus test passed" << std::endl;
+    return 0;
+}
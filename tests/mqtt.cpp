@@ -0,0 +1,400 @@
+#include <ble_serial/mqtt.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace BLE_Serial;
+
+namespace
+{
+    std::atomic_size_t g_failures { 0 };
+
+    void Fail(const char *message)
+    {
+        g_failures++;
+        std::cerr << message << std::endl;
+    }
+
+    template<typename Condition>
+    bool WaitFor(Condition condition)
+    {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (!condition()) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                return false;
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        return true;
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // Loopback broker                                      //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    struct Packet
+    {
+        uint8_t header;             ///< first byte of the fixed header, type and flags
+        std::vector<uint8_t> body;  ///< everything after the remaining length
+    };
+
+    struct Publish
+    {
+        bool duplicate;
+        uint16_t packetId;
+        std::string topic;
+        std::vector<uint8_t> payload;
+    };
+
+    bool ReceiveExactly(IO::TcpStream &stream, uint8_t *buffer, size_t size, std::chrono::steady_clock::time_point deadline)
+    {
+        size_t received = 0;
+
+        while (received < size) {
+            auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+            if (remaining.count() <= 0 || !stream.IsOpen()) {
+                return false;
+            }
+
+            received += stream.Receive(buffer + received, size - received, remaining);
+        }
+
+        return true;
+    }
+
+    /**
+     * Helper reading one packet the way a broker does
+     */
+    std::optional<Packet> ReceivePacket(IO::TcpStream &stream, std::chrono::milliseconds timeout = std::chrono::seconds(5))
+    {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        Packet packet { .header = 0, .body = {} };
+
+        if (!ReceiveExactly(stream, &packet.header, 1, deadline)) {
+            return std::nullopt;
+        }
+
+        size_t length = 0;
+        for (size_t shift = 0;; shift += 7) {
+            uint8_t byte;
+            if (!ReceiveExactly(stream, &byte, 1, deadline)) {
+                return std::nullopt;
+            }
+
+            length |= static_cast<size_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) {
+                break;
+            }
+        }
+
+        packet.body.resize(length);
+        if (length != 0 && !ReceiveExactly(stream, packet.body.data(), length, deadline)) {
+            return std::nullopt;
+        }
+
+        return packet;
+    }
+
+    std::optional<Publish> ReceivePublish(IO::TcpStream &stream)
+    {
+        auto packet = ReceivePacket(stream);
+        if (!packet || (packet->header & 0xF0) != 0x30) {
+            return std::nullopt;
+        }
+
+        auto &body = packet->body;
+        size_t topicLength = (static_cast<size_t>(body[0]) << 8) | body[1];
+        size_t offset = 2 + topicLength;
+
+        Publish publish {
+                .duplicate = (packet->header & 0x08) != 0,
+                .packetId = 0,
+                .topic = std::string(body.begin() + 2, body.begin() + static_cast<ptrdiff_t>(offset)),
+                .payload = {}
+        };
+
+        if ((packet->header & 0x06) != 0) {
+            publish.packetId = static_cast<uint16_t>((body[offset] << 8) | body[offset + 1]);
+            offset += 2;
+        }
+
+        publish.payload.assign(body.begin() + static_cast<ptrdiff_t>(offset), body.end());
+        return publish;
+    }
+
+    void SendPubAck(IO::TcpStream &stream, uint16_t packetId)
+    {
+        stream.Send({ 0x40, 2, static_cast<uint8_t>(packetId >> 8), static_cast<uint8_t>(packetId) });
+    }
+
+    /**
+     * Helper accepting a publisher and answering its CONNECT
+     */
+    std::unique_ptr<IO::TcpStream> AcceptClient(IO::TcpListener &listener, const std::string &clientId, uint8_t returnCode = 0)
+    {
+        auto stream = listener.Accept(std::chrono::seconds(5));
+        if (!stream) {
+            Fail("Publisher did not connect to the broker");
+            return nullptr;
+        }
+
+        auto connect = ReceivePacket(*stream);
+        if (!connect || connect->header != 0x10) {
+            Fail("Publisher did not start with a CONNECT");
+            return nullptr;
+        }
+
+        // Protocol name "MQTT", level 4, clean session flag, then the keep alive and the client id
+        const std::vector<uint8_t> prefix { 0x00, 0x04, 'M', 'Q', 'T', 'T', 0x04, 0x02 };
+        auto &body = connect->body;
+        if (body.size() < 12 || !std::equal(prefix.begin(), prefix.end(), body.begin()) ||
+            std::string(body.begin() + 12, body.end()) != clientId) {
+            Fail("CONNECT does not announce MQTT 3.1.1 with the client id");
+        }
+
+        stream->Send({ 0x20, 2, 0x00, returnCode });
+        return stream;
+    }
+
+    Mqtt::MqttOptions Options(const IO::TcpListener &listener)
+    {
+        return Mqtt::MqttOptions {
+                .host = "127.0.0.1",
+                .port = listener.GetPort(),
+                .clientId = "test",
+                .qos = Mqtt::MqttQoS::AtLeastOnce,
+                .inFlightWindow = 4,
+                .connectTimeout = std::chrono::milliseconds(2000),
+                .reconnectDelay = std::chrono::milliseconds(10)
+        };
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // Connecting                                           //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    void TestConnect()
+    {
+        IO::TcpListener listener { 0, "127.0.0.1" };
+
+        {
+            Mqtt::MqttPublisher publisher { Options(listener) };
+            std::thread broker([&listener]() {
+                auto stream = AcceptClient(listener, "test");
+                if (stream) {
+                    auto disconnect = ReceivePacket(*stream);
+                    if (!disconnect || disconnect->header != 0xE0) {
+                        Fail("Stopped publisher did not send a DISCONNECT");
+                    }
+                }
+            });
+
+            try {
+                publisher.Start();
+                if (!publisher.Metrics().connected) {
+                    Fail("Publisher is not connected after the CONNACK");
+                }
+            } catch (const IO::IOException &) {
+                Fail("Publisher did not accept the CONNACK");
+            }
+
+            publisher.Stop();
+            broker.join();
+        }
+
+        // A refused connection fails the start
+        Mqtt::MqttPublisher publisher { Options(listener) };
+        std::thread broker([&listener]() { AcceptClient(listener, "test", 5); });
+
+        bool thrown = false;
+        try {
+            publisher.Start();
+        } catch (const IO::IOException &) {
+            thrown = true;
+        }
+
+        broker.join();
+
+        if (!thrown) {
+            Fail("Publisher started although the broker refused the connection");
+        }
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // QoS 1                                                //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    void TestInFlightWindow()
+    {
+        IO::TcpListener listener { 0, "127.0.0.1" };
+        Mqtt::MqttPublisher publisher { Options(listener) };
+
+        std::unique_ptr<IO::TcpStream> stream;
+        std::thread broker([&]() { stream = AcceptClient(listener, "test"); });
+        publisher.Start();
+        broker.join();
+
+        if (!stream) {
+            return;
+        }
+
+        for (uint8_t i = 0; i < 10; i++) {
+            publisher.Publish("ble/test", { i });
+        }
+
+        // Only the window is sent while nothing is acknowledged
+        std::vector<Publish> received;
+        for (size_t i = 0; i < 4; i++) {
+            auto publish = ReceivePublish(*stream);
+            if (!publish) {
+                Fail("Broker did not receive the in-flight window");
+                return;
+            }
+
+            received.push_back(*publish);
+        }
+
+        if (ReceivePacket(*stream, std::chrono::milliseconds(100))) {
+            Fail("Publisher sent more messages than its in-flight window");
+        }
+
+        auto metrics = publisher.Metrics();
+        if (metrics.inFlight != 4 || metrics.queued != 6) {
+            Fail("Messages beyond the in-flight window are not kept queued");
+        }
+
+        // Every acknowledgement retires its message and makes room for another one
+        for (size_t acked = 0; acked < 10; acked++) {
+            auto &publish = received[acked];
+            if (publish.topic != "ble/test" || publish.payload != std::vector<uint8_t> { static_cast<uint8_t>(acked) } || publish.duplicate) {
+                Fail("Broker received the messages out of order");
+            }
+
+            SendPubAck(*stream, publish.packetId);
+
+            if (received.size() < 10) {
+                auto next = ReceivePublish(*stream);
+                if (!next) {
+                    Fail("Acknowledgement did not let the next message out");
+                    return;
+                }
+
+                received.push_back(*next);
+            }
+        }
+
+        if (!WaitFor([&]() { return publisher.Metrics().acknowledged == 10; }) || publisher.Metrics().inFlight != 0) {
+            Fail("Acknowledged messages are still in flight");
+        }
+
+        publisher.Stop();
+    }
+
+    void TestDuplicateResend()
+    {
+        IO::TcpListener listener { 0, "127.0.0.1" };
+        Mqtt::MqttPublisher publisher { Options(listener) };
+
+        std::unique_ptr<IO::TcpStream> stream;
+        std::thread broker([&]() { stream = AcceptClient(listener, "test"); });
+        publisher.Start();
+        broker.join();
+
+        if (!stream) {
+            return;
+        }
+
+        for (uint8_t i = 0; i < 6; i++) {
+            publisher.Publish("ble/test", { i });
+        }
+
+        std::vector<Publish> unacknowledged;
+        for (size_t i = 0; i < 4; i++) {
+            auto publish = ReceivePublish(*stream);
+            if (!publish) {
+                Fail("Broker did not receive the in-flight window");
+                return;
+            }
+
+            unacknowledged.push_back(*publish);
+        }
+
+        // The first message is acknowledged, which lets the fifth out, the broker drops the socket before acknowledging the others
+        SendPubAck(*stream, unacknowledged[0].packetId);
+        unacknowledged.erase(unacknowledged.begin());
+
+        auto fifth = ReceivePublish(*stream);
+        if (!fifth) {
+            Fail("Acknowledgement did not let the next message out");
+            return;
+        }
+
+        unacknowledged.push_back(*fifth);
+        stream->Close();
+
+        auto reconnected = AcceptClient(listener, "test");
+        if (!reconnected) {
+            return;
+        }
+
+        // The unacknowledged messages come first, flagged as duplicates with their packet ids kept
+        for (auto &expected : unacknowledged) {
+            auto publish = ReceivePublish(*reconnected);
+            if (!publish || !publish->duplicate || publish->packetId != expected.packetId || publish->payload != expected.payload) {
+                Fail("Unacknowledged message was not sent again as a duplicate");
+                return;
+            }
+
+            SendPubAck(*reconnected, publish->packetId);
+        }
+
+        auto queued = ReceivePublish(*reconnected);
+        if (!queued || queued->duplicate || queued->payload != std::vector<uint8_t> { 5 }) {
+            Fail("Queued message was not sent after the duplicates");
+            return;
+        }
+
+        SendPubAck(*reconnected, queued->packetId);
+
+        if (!WaitFor([&]() { return publisher.Metrics().acknowledged == 6; })) {
+            Fail("Resent messages were not retired by their acknowledgements");
+        }
+
+        auto metrics = publisher.Metrics();
+        if (metrics.reconnects != 1 || metrics.retransmitted != 4 || metrics.published != 6) {
+            Fail("Reconnection is not counted in the publisher metrics");
+        }
+
+        publisher.Stop();
+    }
+}
+
+int main()
+{
+    TestConnect();
+    TestInFlightWindow();
+    TestDuplicateResend();
+
+    if (g_failures != 0) {
+        std::cerr << g_failures << " failures" << std::endl;
+        return 1;
+    }
+
+    std::cout << "MQTT test passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,29 @@
+#include <ble_serial/bluetooth.hpp>
+
+#include <string>
+#include <vector>
+
+//////////////////////////////////////////////////////////
+//                                                      //
+// Platform stubs                                       //
+//                                                      //
+//////////////////////////////////////////////////////////
+
+// Only the Windows build provides the Bluetooth services, the tests run without any
+namespace BLE_Serial::Bluetooth
+{
+    IBluetoothService &GetPlatformLocalBluetoothService()
+    {
+        throw BluetoothException("No Bluetooth service in the tests");
+    }
+
+    IBluetoothService &GetPlatformBluetoothService(const std::string &)
+    {
+        throw BluetoothException("No Bluetooth service in the tests");
+    }
+
+    std::vector<BluetoothAdapterInfo> GetPlatformBluetoothAdapters()
+    {
+        return {};
+    }
+}
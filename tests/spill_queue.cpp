@@ -0,0 +1,166 @@
+#include <ble_serial/spill_queue.hpp>
+
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace BLE_Serial;
+
+namespace
+{
+    size_t g_failures = 0;
+
+    void Fail(const char *message)
+    {
+        g_failures++;
+        std::cerr << message << std::endl;
+    }
+
+    /**
+     * Frame number i, 50 to 149 bytes long and filled with its own number
+     */
+    std::vector<uint8_t> Frame(size_t i)
+    {
+        return std::vector<uint8_t>(50 + i * 37 % 100, static_cast<uint8_t>(i));
+    }
+
+    size_t CountFiles(const std::string &directory)
+    {
+        size_t count = 0;
+        for ([[maybe_unused]] auto &entry : std::filesystem::directory_iterator { directory }) {
+            count++;
+        }
+
+        return count;
+    }
+
+    //////////////////////////////////////////////////////////
+    //                                                      //
+    // Spilling                                             //
+    //                                                      //
+    //////////////////////////////////////////////////////////
+
+    void TestSpillAcrossSegments(const std::string &directory)
+    {
+        constexpr size_t frameCount = 300;
+
+        Bridge::SpillQueue queue { Bridge::SpillQueueOptions { .memoryLimit = 1000, .spillDirectory = directory, .segmentSize = 4096 } };
+
+        size_t memoryBytes = 0;
+        size_t diskBytes = 0;
+        size_t inMemory = 0;
+
+        for (size_t i = 0; i < frameCount; i++) {
+            auto frame = Frame(i);
+
+            // Everything after the first frame that did not fit goes to the disk, or it would overtake the spilled ones
+            if (diskBytes == 0 && memoryBytes + frame.size() <= 1000) {
+                memoryBytes += frame.size();
+                inMemory++;
+            } else {
+                diskBytes += frame.size();
+            }
+
+            if (!queue.Push(frame)) {
+                Fail("Frame was dropped although the disk has room");
+                return;
+            }
+        }
+
+        auto metrics = queue.Metrics();
+        if (metrics.frames != frameCount || metrics.memoryBytes != memoryBytes || metrics.diskBytes != diskBytes || metrics.dropped != 0) {
+            Fail("Queue metrics do not split the frames between the memory and the disk");
+        }
+
+        if (metrics.segments < 5 || CountFiles(directory) != metrics.segments) {
+            Fail("Spilled frames were not spread over several segment files");
+        }
+
+        // Drains in the order the frames were pushed, the byte counts shrinking with every frame
+        std::vector<uint8_t> frame;
+        size_t segments = metrics.segments;
+
+        for (size_t i = 0; i < frameCount; i++) {
+            if (!queue.Front(frame) || frame != Frame(i)) {
+                Fail("Frames were not drained in the order they were pushed");
+                return;
+            }
+
+            queue.Pop();
+
+            (i < inMemory ? memoryBytes : diskBytes) -= frame.size();
+            metrics = queue.Metrics();
+
+            if (metrics.frames != frameCount - i - 1 || metrics.memoryBytes != memoryBytes || metrics.diskBytes != diskBytes) {
+                Fail("Queue metrics do not follow the drained frames");
+                return;
+            }
+
+            if (metrics.segments > segments || CountFiles(directory) != metrics.segments) {
+                Fail("Drained segment files were not deleted");
+                return;
+            }
+
+            segments = metrics.segments;
+        }
+
+        if (!queue.Empty() || queue.Front(frame) || metrics.segments != 0 || CountFiles(directory) != 0) {
+            Fail("Drained queue is not empty");
+        }
+
+        // With the backlog gone, frames stay in memory again
+        queue.Push(Frame(0));
+        if (queue.Metrics().memoryBytes != Frame(0).size() || queue.Metrics().segments != 0) {
+            Fail("Frame was spilled after the disk backlog was drained");
+        }
+    }
+
+    void TestLimits(const std::string &directory)
+    {
+        // Without a spill directory frames beyond the memory limit are dropped
+        Bridge::SpillQueue memoryOnly { Bridge::SpillQueueOptions { .memoryLimit = 200 } };
+        memoryOnly.Push(std::vector<uint8_t>(150));
+        if (memoryOnly.Push(std::vector<uint8_t>(100)) || memoryOnly.Metrics().dropped != 1 || memoryOnly.Metrics().frames != 1) {
+            Fail("Frame beyond the memory limit was not dropped");
+        }
+
+        // The disk limit counts the payload bytes on the disk
+        Bridge::SpillQueue limited { Bridge::SpillQueueOptions { .memoryLimit = 100, .spillDirectory = directory, .segmentSize = 4096, .diskLimit = 300 } };
+        for (size_t i = 0; i < 4; i++) {
+            limited.Push(std::vector<uint8_t>(100, static_cast<uint8_t>(i)));
+        }
+
+        auto metrics = limited.Metrics();
+        if (metrics.frames != 4 || metrics.diskBytes != 300 || limited.Push(std::vector<uint8_t>(1)) || limited.Metrics().dropped != 1) {
+            Fail("Frame beyond the disk limit was not dropped");
+        }
+
+        // A frame larger than a segment never fits
+        if (limited.Push(std::vector<uint8_t>(5000)) || limited.Metrics().dropped != 2) {
+            Fail("Frame larger than a segment was not dropped");
+        }
+    }
+}
+
+int main()
+{
+    auto directory = (std::filesystem::temp_directory_path() / ("ble_serial_spill_test_" + std::to_string(getpid()))).string();
+    std::filesystem::create_directories(directory);
+
+    TestSpillAcrossSegments(directory);
+    TestLimits(directory);
+
+    std::filesystem::remove_all(directory);
+
+    if (g_failures != 0) {
+        std::cerr << g_failures << " failures" << std::endl;
+        return 1;
+    }
+
+    std::cout << "Spill queue test passed" << std::endl;
+    return 0;
+}